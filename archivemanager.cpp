@@ -0,0 +1,54 @@
+#include "archivemanager.h"
+#include "dbmanager.h"
+#include "idlemonitor.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QSettings>
+
+namespace {
+const int kCheckIntervalMs = 60 * 1000;   // 空闲检查间隔
+const int kNextBatchDelayMs = 200;        // 连续批次之间让出事件循环
+}
+
+ArchiveManager::ArchiveManager(QObject *parent)
+    : QObject(parent)
+{
+    QSettings settings;
+    m_retentionDays = settings.value("archive/days", 30).toInt();
+    m_batchSize = settings.value("archive/batchSize", 200).toInt();
+    m_idleThresholdMs = settings.value("archive/idleSeconds", 30).toInt() * 1000;
+
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &ArchiveManager::runBatch);
+}
+
+void ArchiveManager::start()
+{
+    IdleMonitor::instance();
+    m_timer.start(kCheckIntervalMs);
+    qDebug() << "归档策略：完成超过" << m_retentionDays << "天的任务，每批" << m_batchSize << "个";
+}
+
+void ArchiveManager::setRetentionDays(int days)
+{
+    m_retentionDays = qMax(0, days);
+    QSettings settings;
+    settings.setValue("archive/days", m_retentionDays);
+}
+
+void ArchiveManager::runBatch()
+{
+    if (m_retentionDays <= 0 || !IdleMonitor::instance()->isIdle(m_idleThresholdMs)) {
+        m_timer.start(kCheckIntervalMs);
+        return;
+    }
+
+    QDateTime cutoff = QDateTime::currentDateTime().addDays(-m_retentionDays);
+    int moved = DBManager::instance()->archiveCompletedTasks(cutoff, m_batchSize);
+    if (moved > 0) {
+        emit tasksArchived(moved);
+    }
+
+    // 一批满了说明可能还有剩余，稍后继续（仍需空闲）
+    m_timer.start(moved == m_batchSize ? kNextBatchDelayMs : kCheckIntervalMs);
+}
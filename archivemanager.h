@@ -0,0 +1,33 @@
+#ifndef ARCHIVEMANAGER_H
+#define ARCHIVEMANAGER_H
+
+#include <QObject>
+#include <QTimer>
+
+// 归档策略：用户空闲时，分批把完成超过 N 天的任务移入归档表
+// 配置保存在 QSettings 的 archive/ 分组下
+class ArchiveManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ArchiveManager(QObject *parent = nullptr);
+
+    void start();
+
+    int retentionDays() const { return m_retentionDays; }
+    void setRetentionDays(int days);   // 0 表示不自动归档
+
+signals:
+    void tasksArchived(int count);
+
+private slots:
+    void runBatch();
+
+private:
+    QTimer m_timer;
+    int m_retentionDays;
+    int m_batchSize;
+    int m_idleThresholdMs;
+};
+
+#endif // ARCHIVEMANAGER_H
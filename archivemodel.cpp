@@ -0,0 +1,80 @@
+#include "archivemodel.h"
+#include "dbmanager.h"
+#include <QDebug>
+
+namespace {
+const int kPageSize = 200;
+}
+
+ArchiveModel::ArchiveModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_hasMore(true)
+{
+}
+
+int ArchiveModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return 0;
+    return m_tasks.size();
+}
+
+int ArchiveModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return ColumnCount;
+}
+
+QVariant ArchiveModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_tasks.size() || role != Qt::DisplayRole)
+        return QVariant();
+
+    const Task &task = m_tasks.at(index.row());
+    switch (index.column()) {
+    case ColumnTitle: return task.title;
+    case ColumnDeadline: return task.deadline.toString("yyyy-MM-dd HH:mm");
+    case ColumnPriority:
+        return (task.priority == 0 ? "低" : (task.priority == 1 ? "中" : "高"));
+    default: return QVariant();
+    }
+}
+
+QVariant ArchiveModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+        switch (section) {
+        case ColumnTitle: return "任务标题";
+        case ColumnDeadline: return "截止时间";
+        case ColumnPriority: return "优先级";
+        default: return QVariant();
+        }
+    }
+    return QVariant();
+}
+
+bool ArchiveModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && m_hasMore;
+}
+
+void ArchiveModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid() || !m_hasMore) return;
+
+    // 以上一页最后一行为锚点继续读取
+    QString beforeDeadline;
+    int beforeId = -1;
+    if (!m_tasks.isEmpty()) {
+        beforeDeadline = m_tasks.last().deadline.toString("yyyy-MM-dd HH:mm");
+        beforeId = m_tasks.last().id;
+    }
+
+    QList<Task> page = DBManager::instance()->getArchivedTasks(kPageSize, beforeDeadline, beforeId);
+    m_hasMore = page.size() == kPageSize;
+    if (page.isEmpty()) return;
+
+    beginInsertRows(QModelIndex(), m_tasks.size(), m_tasks.size() + page.size() - 1);
+    m_tasks.append(page);
+    endInsertRows();
+    qDebug() << "加载归档任务" << page.size() << "个，已加载" << m_tasks.size();
+}
@@ -0,0 +1,36 @@
+#ifndef ARCHIVEMODEL_H
+#define ARCHIVEMODEL_H
+
+#include <QAbstractTableModel>
+#include "task.h"
+
+// 归档任务的只读模型，滚动到底部时才按页从数据库读取
+class ArchiveModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum ArchiveColumn {
+        ColumnTitle = 0,
+        ColumnDeadline,
+        ColumnPriority,
+        ColumnCount
+    };
+
+    explicit ArchiveModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    Task taskAt(int row) const { return m_tasks.value(row); }
+
+private:
+    QList<Task> m_tasks;
+    bool m_hasMore;
+};
+
+#endif // ARCHIVEMODEL_H
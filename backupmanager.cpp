@@ -0,0 +1,179 @@
+#include "backupmanager.h"
+#include "dbmanager.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <QTemporaryDir>
+
+namespace {
+const int kCheckIntervalMs = 10 * 60 * 1000;   // 检查是否到备份时间的间隔
+const char *const kTimestampFormat = "yyyyMMdd-HHmmss";
+const char *const kCompressedSuffix = ".qz";
+}
+
+BackupManager::BackupManager(QObject *parent)
+    : QObject(parent)
+{
+    QSettings settings;
+    m_intervalHours = settings.value("backup/intervalHours", 24).toInt();
+    m_keepCount = settings.value("backup/keep", 7).toInt();
+    m_compress = settings.value("backup/compress", false).toBool();
+    m_directory = settings.value("backup/directory").toString();
+
+    connect(&m_timer, &QTimer::timeout, this, &BackupManager::checkSchedule);
+}
+
+BackupManager::~BackupManager()
+{
+    if (m_thread) {
+        m_thread->stopThread();
+        m_thread->wait();
+    }
+}
+
+void BackupManager::start()
+{
+    m_timer.start(kCheckIntervalMs);
+    qDebug() << "备份策略：每" << m_intervalHours << "小时，保留" << m_keepCount << "份，目录" << backupDirectory();
+    // 启动后稍等片刻再检查，避开初始化时的集中读写
+    QTimer::singleShot(30 * 1000, this, &BackupManager::checkSchedule);
+}
+
+// 未设置时备份到数据库所在目录下的 backups 子目录
+QString BackupManager::backupDirectory() const
+{
+    if (!m_directory.isEmpty()) return m_directory;
+    return QFileInfo(DBManager::instance()->getDatabasePath()).absolutePath() + "/backups";
+}
+
+void BackupManager::setIntervalHours(int hours)
+{
+    m_intervalHours = qMax(0, hours);
+    QSettings settings;
+    settings.setValue("backup/intervalHours", m_intervalHours);
+}
+
+void BackupManager::setKeepCount(int count)
+{
+    m_keepCount = qMax(1, count);
+    QSettings settings;
+    settings.setValue("backup/keep", m_keepCount);
+    pruneOldBackups();
+}
+
+void BackupManager::setCompress(bool compress)
+{
+    m_compress = compress;
+    QSettings settings;
+    settings.setValue("backup/compress", m_compress);
+}
+
+void BackupManager::setBackupDirectory(const QString &dir)
+{
+    m_directory = dir;
+    QSettings settings;
+    settings.setValue("backup/directory", m_directory);
+}
+
+void BackupManager::checkSchedule()
+{
+    if (m_intervalHours <= 0 || isRunning()) return;
+
+    QSettings settings;
+    QDateTime last = settings.value("backup/last").toDateTime();
+    if (last.isValid() && last.secsTo(QDateTime::currentDateTime()) < qint64(m_intervalHours) * 3600) {
+        return;
+    }
+    backupNow();
+}
+
+bool BackupManager::backupNow()
+{
+    if (isRunning()) return false;
+
+    const QString source = DBManager::instance()->getDatabasePath();
+    QDir dir(backupDirectory());
+    if (!dir.exists() && !dir.mkpath(".")) {
+        qWarning() << "无法创建备份目录：" << dir.absolutePath();
+        emit backupFinished(false, "无法创建备份目录：" + dir.absolutePath());
+        return false;
+    }
+
+    QString fileName = QString("%1-%2.db")
+                           .arg(QFileInfo(source).completeBaseName(),
+                                QDateTime::currentDateTime().toString(kTimestampFormat));
+    if (m_compress) fileName += kCompressedSuffix;
+
+    m_thread = new BackupThread(source, dir.filePath(fileName), m_compress,
+                                DBManager::instance()->sqliteApiUsable(), this);
+    connect(m_thread, &BackupThread::backupFinished, this, &BackupManager::onBackupFinished);
+    connect(m_thread, &QThread::finished, m_thread, &QObject::deleteLater);
+    m_thread->start(QThread::LowPriority);
+    return true;
+}
+
+void BackupManager::onBackupFinished(bool ok, const QString &path, const QString &message)
+{
+    if (ok) {
+        QSettings settings;
+        settings.setValue("backup/last", QDateTime::currentDateTime());
+        pruneOldBackups();
+        emit backupFinished(true, message + "：" + QFileInfo(path).fileName());
+    } else {
+        emit backupFinished(false, message);
+    }
+}
+
+// 文件名中的时间戳可按字典序排序，保留最新的 m_keepCount 份
+void BackupManager::pruneOldBackups()
+{
+    const QString base = QFileInfo(DBManager::instance()->getDatabasePath()).completeBaseName();
+    QDir dir(backupDirectory());
+    QStringList files = dir.entryList({base + "-*.db", base + "-*.db" + kCompressedSuffix},
+                                      QDir::Files, QDir::Name | QDir::Reversed);
+    for (int i = m_keepCount; i < files.size(); ++i) {
+        if (dir.remove(files.at(i))) {
+            qDebug() << "删除过期备份：" << files.at(i);
+        }
+    }
+}
+
+bool BackupManager::restore(const QString &backupPath, QString *error)
+{
+    if (isRunning()) {
+        *error = "备份正在进行，请稍后再试";
+        return false;
+    }
+
+    QTemporaryDir tempDir;
+    QString plainPath = backupPath;
+    if (BackupThread::isCompressed(backupPath)) {
+        if (!tempDir.isValid()) {
+            *error = "无法创建临时目录";
+            return false;
+        }
+        plainPath = tempDir.filePath("restore.db");
+        if (!BackupThread::decompressFile(backupPath, plainPath, error)) return false;
+    }
+
+    // 覆盖正在使用的数据库只能通过备份API；驱动自带另一份 SQLite 时两份库的文件锁互不可见
+    if (!DBManager::instance()->sqliteApiUsable()) {
+        *error = "Qt 的 SQLite 驱动不是程序链接的那份 SQLite，无法在线恢复；请退出程序后用备份文件替换数据库文件";
+        return false;
+    }
+
+    // 恢复前做完整的 integrity_check，损坏的备份不会覆盖当前数据
+    if (!BackupThread::verifyDatabase(plainPath, false, error)) return false;
+
+    BackupThread::Stats stats;
+    if (!BackupThread::copyDatabase(plainPath, DBManager::instance()->getDatabasePath(), 0, 0,
+                                    nullptr, &stats, error)) {
+        return false;
+    }
+    qDebug() << "已从备份恢复：" << backupPath << "用时" << stats.elapsedMs << "ms";
+
+    // 旧版本程序做的备份结构较旧，恢复后升级到当前版本
+    return DBManager::instance()->upgradeSchema(error);
+}
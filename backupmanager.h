@@ -0,0 +1,52 @@
+#ifndef BACKUPMANAGER_H
+#define BACKUPMANAGER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include "backupthread.h"
+
+// 定时在线备份与恢复
+// 配置保存在 QSettings 的 backup/ 分组下；备份文件名带时间戳，超出保留份数的旧备份自动删除
+class BackupManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BackupManager(QObject *parent = nullptr);
+    ~BackupManager() override;
+
+    void start();
+    bool backupNow();               // 已有备份在进行时返回false
+    bool isRunning() const { return !m_thread.isNull(); }
+
+    // 先校验备份完整性，通过后用它覆盖当前数据库
+    bool restore(const QString &backupPath, QString *error);
+
+    int intervalHours() const { return m_intervalHours; }
+    int keepCount() const { return m_keepCount; }
+    bool compress() const { return m_compress; }
+    QString backupDirectory() const;
+    void setIntervalHours(int hours);   // 0 表示不自动备份
+    void setKeepCount(int count);
+    void setCompress(bool compress);
+    void setBackupDirectory(const QString &dir);
+
+signals:
+    void backupFinished(bool ok, const QString &message);
+
+private slots:
+    void checkSchedule();
+    void onBackupFinished(bool ok, const QString &path, const QString &message);
+
+private:
+    void pruneOldBackups();
+
+    QTimer m_timer;
+    QPointer<BackupThread> m_thread;
+    int m_intervalHours;
+    int m_keepCount;
+    bool m_compress;
+    QString m_directory;
+};
+
+#endif // BACKUPMANAGER_H
@@ -0,0 +1,287 @@
+#include "backupthread.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <sqlite3.h>
+
+namespace {
+const int kPagesPerStep = 64;           // 每步复制的页数（默认页大小4KB时为256KB）
+const int kStepDelayMs = 10;            // 两步之间让出锁的时间
+const int kBusyRetryMs = 20;            // 源库被写入占用时的重试间隔
+const int kCompressBlockSize = 1024 * 1024;
+const char kCompressMagic[] = "ZHSJBAK1";
+
+QString sqliteError(sqlite3 *db, const QString &what)
+{
+    return QString("%1：%2").arg(what, db ? QString::fromUtf8(sqlite3_errmsg(db)) : QString("内存不足"));
+}
+
+// 每个线程、每次调用使用独立的连接名
+QString driverConnectionName(const char *purpose)
+{
+    return QString("%1-%2").arg(purpose).arg(quintptr(QThread::currentThreadId()));
+}
+}
+
+BackupThread::BackupThread(const QString &sourcePath, const QString &targetPath, bool compress,
+                           bool useSqliteApi, QObject *parent)
+    : QThread(parent)
+    , m_sourcePath(sourcePath)
+    , m_targetPath(targetPath)
+    , m_compress(compress)
+    , m_useSqliteApi(useSqliteApi)
+    , m_isRunning(true)
+{
+}
+
+BackupThread::~BackupThread()
+{
+    stopThread();
+    wait();
+}
+
+void BackupThread::stopThread()
+{
+    m_isRunning = false;
+}
+
+void BackupThread::run()
+{
+    qDebug() << "开始在线备份：" << m_sourcePath << "->" << m_targetPath;
+
+    // 先写临时文件，全部成功后才改为正式文件名，避免留下不完整的备份
+    const QString partPath = m_targetPath + ".part";
+    const QString dbPath = m_compress ? partPath + ".db" : partPath;
+    QFile::remove(partPath);
+    QFile::remove(dbPath);
+
+    Stats stats;
+    QString error;
+    bool ok = (m_useSqliteApi
+                   ? copyDatabase(m_sourcePath, dbPath, kPagesPerStep, kStepDelayMs, &m_isRunning, &stats, &error)
+                   : vacuumDatabase(m_sourcePath, dbPath, &stats, &error))
+              && verifyDatabase(dbPath, true, &error);
+
+    if (ok && m_compress) {
+        ok = compressFile(dbPath, partPath, &error);
+        QFile::remove(dbPath);
+    }
+    if (ok) {
+        QFile::remove(m_targetPath);
+        if (!QFile::rename(partPath, m_targetPath)) {
+            error = "无法重命名备份文件：" + m_targetPath;
+            ok = false;
+        }
+    }
+    if (!ok) {
+        QFile::remove(dbPath);
+        QFile::remove(partPath);
+    }
+
+    if (ok) {
+        qDebug() << "备份完成：" << m_targetPath << "共" << stats.pages << "页，用时" << stats.elapsedMs
+                 << "ms，持锁累计" << stats.lockedMs << "ms（单步最长" << stats.maxStepMs
+                 << "ms），等待写入" << stats.busyMs << "ms";
+        emit backupFinished(true, m_targetPath,
+                            QString("备份完成，用时 %1 ms，单步最长持锁 %2 ms")
+                                .arg(stats.elapsedMs).arg(stats.maxStepMs));
+    } else {
+        qWarning() << "备份失败：" << error;
+        emit backupFinished(false, m_targetPath, error);
+    }
+}
+
+bool BackupThread::copyDatabase(const QString &from, const QString &to, int pagesPerStep, int stepDelayMs,
+                                const volatile bool *running, Stats *stats, QString *error)
+{
+    QElapsedTimer total;
+    total.start();
+
+    sqlite3 *source = nullptr;
+    sqlite3 *target = nullptr;
+    bool ok = false;
+
+    if (sqlite3_open_v2(from.toUtf8().constData(), &source, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        *error = sqliteError(source, "无法打开源数据库");
+    } else if (sqlite3_open_v2(to.toUtf8().constData(), &target,
+                               SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+        *error = sqliteError(target, "无法创建目标数据库");
+    } else {
+        // 恢复时目标是正在使用的数据库，允许等待其他连接短暂的写入
+        sqlite3_busy_timeout(target, 5000);
+
+        sqlite3_backup *backup = sqlite3_backup_init(target, "main", source, "main");
+        if (!backup) {
+            *error = sqliteError(target, "无法开始备份");
+        } else {
+            int rc;
+            do {
+                QElapsedTimer step;
+                step.start();
+                rc = sqlite3_backup_step(backup, pagesPerStep > 0 ? pagesPerStep : -1);
+                const qint64 stepMs = step.elapsed();
+
+                if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+                    stats->busyMs += stepMs + kBusyRetryMs;
+                    QThread::msleep(kBusyRetryMs);
+                } else {
+                    stats->lockedMs += stepMs;
+                    stats->maxStepMs = qMax(stats->maxStepMs, stepMs);
+                    if (rc == SQLITE_OK && stepDelayMs > 0) {
+                        QThread::msleep(stepDelayMs);
+                    }
+                }
+            } while ((rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) && (!running || *running));
+
+            stats->pages = sqlite3_backup_pagecount(backup);
+            sqlite3_backup_finish(backup);
+
+            if (rc == SQLITE_DONE) {
+                ok = true;
+            } else if (running && !*running) {
+                *error = "备份已取消";
+            } else {
+                *error = QString("备份复制失败：%1").arg(QString::fromUtf8(sqlite3_errstr(rc)));
+            }
+        }
+    }
+
+    sqlite3_close(target);
+    sqlite3_close(source);
+    stats->elapsedMs = total.elapsed();
+    return ok;
+}
+
+// 在驱动的连接上执行 VACUUM INTO，用于驱动自带的 SQLite 与程序链接的不是同一份的情况：
+// 不能再用 C API 打开正在使用的数据库文件。整个复制在一个读事务中完成，不能分步让出锁；
+// 数据库为 WAL 模式（DBManager 打开时设置）时读事务不阻塞写入，否则写入要等复制结束
+bool BackupThread::vacuumDatabase(const QString &from, const QString &to, Stats *stats, QString *error)
+{
+    QElapsedTimer total;
+    total.start();
+
+    bool ok = false;
+    const QString connection = driverConnectionName("backup");
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connection);
+        db.setDatabaseName(from);
+        db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+        if (!db.open()) {
+            *error = "无法打开源数据库：" + db.lastError().text();
+        } else {
+            QSqlQuery query(db);
+            if (query.exec("PRAGMA page_count") && query.next()) {
+                stats->pages = query.value(0).toInt();
+            }
+            if (!query.exec("PRAGMA journal_mode") || !query.next() || query.value(0).toString() != "wal") {
+                qWarning() << "源数据库不是 WAL 模式，复制期间的写入会被阻塞";
+            }
+            query.prepare("VACUUM INTO :path");
+            query.bindValue(":path", to);
+            ok = query.exec();
+            if (!ok) {
+                *error = "备份复制失败：" + query.lastError().text();
+            }
+            query.finish();
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connection);
+
+    stats->elapsedMs = total.elapsed();
+    stats->lockedMs = stats->elapsedMs;
+    stats->maxStepMs = stats->elapsedMs;
+    return ok;
+}
+
+// 通过驱动的连接检查，与 C API 是否可用无关
+bool BackupThread::verifyDatabase(const QString &path, bool quick, QString *error)
+{
+    bool ok = false;
+    const QString connection = driverConnectionName("verify");
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connection);
+        db.setDatabaseName(path);
+        db.setConnectOptions("QSQLITE_OPEN_READONLY");
+        if (!db.open()) {
+            *error = "无法打开备份：" + db.lastError().text();
+        } else {
+            QSqlQuery query(db);
+            if (!query.exec(quick ? "PRAGMA quick_check" : "PRAGMA integrity_check") || !query.next()) {
+                *error = "完整性检查失败：" + query.lastError().text();
+            } else if (query.value(0).toString() != "ok") {
+                *error = "备份已损坏：" + query.value(0).toString();
+            } else if (query.exec("SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = 'tasks'")
+                       && query.next() && query.value(0).toInt() == 1) {
+                ok = true;
+            } else {
+                *error = "该文件不是任务数据库的备份";
+            }
+            query.finish();
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connection);
+    return ok;
+}
+
+bool BackupThread::isCompressed(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) && file.read(sizeof(kCompressMagic) - 1) == kCompressMagic;
+}
+
+bool BackupThread::compressFile(const QString &from, const QString &to, QString *error)
+{
+    QFile in(from);
+    QFile out(to);
+    if (!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::WriteOnly)) {
+        *error = "无法打开文件进行压缩：" + to;
+        return false;
+    }
+
+    out.write(kCompressMagic, sizeof(kCompressMagic) - 1);
+    QDataStream stream(&out);
+    while (!in.atEnd()) {
+        stream << qCompress(in.read(kCompressBlockSize));
+        if (stream.status() != QDataStream::Ok) {
+            *error = "写入压缩文件失败：" + out.errorString();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BackupThread::decompressFile(const QString &from, const QString &to, QString *error)
+{
+    QFile in(from);
+    QFile out(to);
+    if (!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::WriteOnly)) {
+        *error = "无法打开文件进行解压：" + from;
+        return false;
+    }
+    if (in.read(sizeof(kCompressMagic) - 1) != kCompressMagic) {
+        *error = "不是压缩的备份文件：" + from;
+        return false;
+    }
+
+    QDataStream stream(&in);
+    while (!in.atEnd()) {
+        QByteArray block;
+        stream >> block;
+        QByteArray data = qUncompress(block);
+        if (stream.status() != QDataStream::Ok || data.isEmpty()) {
+            *error = "压缩的备份已损坏：" + from;
+            return false;
+        }
+        if (out.write(data) != data.size()) {
+            *error = "写入文件失败：" + out.errorString();
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef BACKUPTHREAD_H
+#define BACKUPTHREAD_H
+
+#include <QThread>
+#include <QString>
+
+// 在线备份线程
+// 通过SQLite备份API在独立连接上逐步复制数据库页，每步只复制少量页并随即释放读锁，
+// 期间界面线程的写入不会被长时间阻塞；若复制过程中源库被修改，SQLite会自动从头重新复制。
+// 备份API需要 Qt 驱动与程序链接的是同一份 SQLite，否则改为通过驱动的连接执行 VACUUM INTO。
+class BackupThread : public QThread
+{
+    Q_OBJECT
+public:
+    struct Stats {
+        int pages = 0;          // 数据库总页数
+        qint64 elapsedMs = 0;   // 复制总用时
+        qint64 lockedMs = 0;    // 持有源库读锁的累计时间（写入可能被阻塞的上限）
+        qint64 maxStepMs = 0;   // 单步持锁最长时间
+        qint64 busyMs = 0;      // 源库被写锁占用而等待的时间
+    };
+
+    BackupThread(const QString &sourcePath, const QString &targetPath, bool compress, bool useSqliteApi,
+                 QObject *parent = nullptr);
+    ~BackupThread() override;
+
+    void stopThread();
+
+    // pagesPerStep <= 0 时一步复制全部页；running 为空或一直为true时复制到结束
+    static bool copyDatabase(const QString &from, const QString &to, int pagesPerStep, int stepDelayMs,
+                             const volatile bool *running, Stats *stats, QString *error);
+    static bool vacuumDatabase(const QString &from, const QString &to, Stats *stats, QString *error);
+    // 完整性检查，并确认是本程序的数据库
+    static bool verifyDatabase(const QString &path, bool quick, QString *error);
+    // 分块 qCompress 的压缩格式，可流式处理任意大小的文件
+    static bool compressFile(const QString &from, const QString &to, QString *error);
+    static bool decompressFile(const QString &from, const QString &to, QString *error);
+    static bool isCompressed(const QString &path);
+
+signals:
+    void backupFinished(bool ok, const QString &path, const QString &message);
+
+protected:
+    void run() override;
+
+private:
+    QString m_sourcePath;
+    QString m_targetPath;
+    bool m_compress;
+    bool m_useSqliteApi;
+    volatile bool m_isRunning;
+};
+
+#endif // BACKUPTHREAD_H
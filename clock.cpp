@@ -0,0 +1,120 @@
+#include "clock.h"
+#include <QCoreApplication>
+#include <cmath>
+#include <limits>
+
+namespace {
+class SystemClock : public Clock
+{
+public:
+    using Clock::Clock;
+    qint64 nowMSecs() const override { return QDateTime::currentMSecsSinceEpoch(); }
+};
+}
+
+Clock *Clock::system()
+{
+    static SystemClock *clock = new SystemClock(QCoreApplication::instance());
+    return clock;
+}
+
+qint64 Clock::realMsFor(qint64 clockMs) const
+{
+    double r = rate();
+    if (r <= 0.0) return -1;
+    // 时间流速小于1时结果可能超出 qint64，超出范围的 double 转整数是未定义行为
+    const double realMs = std::ceil(clockMs / r);
+    if (realMs <= 0.0) return 0;
+    if (realMs >= double(std::numeric_limits<qint64>::max())) return std::numeric_limits<qint64>::max();
+    return qint64(realMs);
+}
+
+bool Clock::sleepUntil(qint64 targetMSecs, int maxRealMs)
+{
+    QElapsedTimer waited;
+    waited.start();
+
+    QMutexLocker locker(&m_waitMutex);
+    const quint64 interrupts = m_interrupts;
+    while (m_interrupts == interrupts) {
+        qint64 remaining = maxRealMs - waited.elapsed();
+        qint64 realMs = realMsFor(targetMSecs - nowMSecs());
+        if (realMs == 0 || remaining <= 0) return true;
+        // 暂停时只能等跳变或超时
+        qint64 waitMs = realMs < 0 ? remaining : qMin(realMs, remaining);
+        m_waitCondition.wait(&m_waitMutex, (unsigned long)waitMs);
+    }
+    return false;
+}
+
+void Clock::interrupt()
+{
+    QMutexLocker locker(&m_waitMutex);
+    ++m_interrupts;
+    m_waitCondition.wakeAll();
+}
+
+void Clock::notifyTimeChanged()
+{
+    {
+        QMutexLocker locker(&m_waitMutex);
+        m_waitCondition.wakeAll();
+    }
+    emit timeChanged();
+}
+
+SimulatedClock::SimulatedClock(const QDateTime &start, double rate, QObject *parent)
+    : Clock(parent)
+    , m_baseMSecs(start.toMSecsSinceEpoch())
+    , m_rate(qMax(0.0, rate))
+{
+    m_sinceBase.start();
+}
+
+qint64 SimulatedClock::nowLocked() const
+{
+    return m_baseMSecs + qint64(m_sinceBase.elapsed() * m_rate);
+}
+
+qint64 SimulatedClock::nowMSecs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return nowLocked();
+}
+
+double SimulatedClock::rate() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_rate;
+}
+
+void SimulatedClock::setRate(double rate)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_baseMSecs = nowLocked();
+        m_sinceBase.restart();
+        m_rate = qMax(0.0, rate);
+    }
+    notifyTimeChanged();
+}
+
+void SimulatedClock::setTime(const QDateTime &time)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_baseMSecs = time.toMSecsSinceEpoch();
+        m_sinceBase.restart();
+    }
+    notifyTimeChanged();
+}
+
+void SimulatedClock::advance(qint64 ms)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_baseMSecs = nowLocked() + ms;
+        m_sinceBase.restart();
+    }
+    notifyTimeChanged();
+}
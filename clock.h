@@ -0,0 +1,70 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
+
+// 可注入的时钟
+// 提醒线程、紧急度排序和界面中的截止时间检查都通过它取当前时间和等待，
+// 替换为 SimulatedClock 后可以跳到任意时间或以 N 倍速运行，用来回放大量截止时间。
+// 所有成员函数都是线程安全的。
+class Clock : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Clock(QObject *parent = nullptr) : QObject(parent) {}
+
+    static Clock *system();         // 真实时钟（进程内唯一）
+
+    virtual qint64 nowMSecs() const = 0;
+    virtual double rate() const { return 1.0; }     // 时钟时间与真实时间之比，0 表示暂停
+
+    QDateTime now() const { return QDateTime::fromMSecsSinceEpoch(nowMSecs()); }
+    qint64 nowSecs() const { return nowMSecs() / 1000; }
+    // 时钟前进 clockMs 需要的真实毫秒数；时钟暂停时返回 -1
+    qint64 realMsFor(qint64 clockMs) const;
+
+    // 阻塞当前线程，直到时钟到达 targetMSecs、真实时间已过 maxRealMs 或被 interrupt() 唤醒；
+    // 被唤醒时返回false。时钟跳变或变速时等待者会按新的时间重新计算
+    bool sleepUntil(qint64 targetMSecs, int maxRealMs);
+    void interrupt();
+
+signals:
+    void timeChanged();             // 时间跳变或速率变化（真实时钟不会发出）
+
+protected:
+    void notifyTimeChanged();
+
+private:
+    QMutex m_waitMutex;
+    QWaitCondition m_waitCondition;
+    quint64 m_interrupts = 0;
+};
+
+// 模拟时钟：now = 起点 + 真实经过时间 × 速率
+class SimulatedClock : public Clock
+{
+    Q_OBJECT
+public:
+    explicit SimulatedClock(const QDateTime &start, double rate = 1.0, QObject *parent = nullptr);
+
+    qint64 nowMSecs() const override;
+    double rate() const override;
+
+    void setRate(double rate);
+    void setTime(const QDateTime &time);
+    void advance(qint64 ms);
+
+private:
+    qint64 nowLocked() const;
+
+    mutable QMutex m_mutex;
+    qint64 m_baseMSecs;
+    double m_rate;
+    QElapsedTimer m_sinceBase;
+};
+
+#endif // CLOCK_H
@@ -0,0 +1,34 @@
+#include "dbchangewatcher.h"
+#include "dbmanager.h"
+#include <QDebug>
+
+DbChangeWatcher::DbChangeWatcher(QObject *parent)
+    : QObject(parent)
+    , m_lastVersion(-1)
+{
+    connect(&m_timer, &QTimer::timeout, this, &DbChangeWatcher::poll);
+}
+
+void DbChangeWatcher::start(int intervalMs)
+{
+    m_lastVersion = DBManager::instance()->dataVersion();
+    m_timer.start(intervalMs);
+    qDebug() << "数据库变化监视已启动，轮询间隔" << intervalMs << "ms";
+}
+
+void DbChangeWatcher::stop()
+{
+    m_timer.stop();
+}
+
+void DbChangeWatcher::poll()
+{
+    int version = DBManager::instance()->dataVersion();
+    if (version == -1 || version == m_lastVersion) {
+        return;
+    }
+
+    qDebug() << "检测到其他进程修改了数据库，data_version：" << m_lastVersion << "->" << version;
+    m_lastVersion = version;
+    emit databaseChanged();
+}
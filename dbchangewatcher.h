@@ -0,0 +1,29 @@
+#ifndef DBCHANGEWATCHER_H
+#define DBCHANGEWATCHER_H
+
+#include <QObject>
+#include <QTimer>
+
+// 轮询SQLite的 PRAGMA data_version，发现其他进程提交的修改时发出信号
+// 该PRAGMA只读取连接内的计数器，开销极小，可以高频轮询
+class DbChangeWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DbChangeWatcher(QObject *parent = nullptr);
+
+    void start(int intervalMs = 1000);
+    void stop();
+
+signals:
+    void databaseChanged();
+
+private slots:
+    void poll();
+
+private:
+    QTimer m_timer;
+    int m_lastVersion;
+};
+
+#endif // DBCHANGEWATCHER_H
@@ -4,7 +4,110 @@
 #include <QDebug>
 #include <QMutex>
 #include <QFileInfo>
+#include <QStringList>
 #include <QApplication>
+#include <QUuid>
+#include <QCryptographicHash>
+#include <QThread>
+#include <algorithm>
+#include <sqlite3.h>
+#include "tasksync.h"
+#include "taskfilter.h"
+#include "schemamigrator.h"
+#include "simhash.h"
+#include "metrics.h"
+
+namespace {
+// 列表只需要的列；描述按需单独读取
+const char *const kListColumns = "id, title, deadline, priority, isCompleted, parent_id";
+const char *const kFullColumns = "id, title, deadline, priority, isCompleted, parent_id, description, description_z";
+// 归档表没有父子关系
+const char *const kArchiveColumns = "id, title, deadline, priority, isCompleted";
+// 任务的标签，以逗号连接（标签名中不允许出现逗号）
+const char *const kTagsColumn =
+    "(SELECT group_concat(g.name, ',') FROM task_tags tt JOIN tags g ON g.id = tt.tag_id "
+    "WHERE tt.task_id = tasks.id) AS tags";
+
+// 数据库操作耗时，包含等待连接锁的时间
+Histogram *operationLatency(const char *op)
+{
+    return Metrics::histogram("zhsj_db_operation_seconds", "数据库操作耗时（含等待连接锁）",
+                              QString("op=\"%1\"").arg(op));
+}
+
+// taskFromQuery 需要读取的可选列
+enum TaskColumns {
+    BaseColumns = 0,
+    WithDescription = 0x1,
+    WithTags = 0x2,
+    WithParent = 0x4
+};
+
+// 键集分页的锚点。QtSql 把 null 的 QString 绑定为 SQL NULL，(deadline, id) > (NULL, -1) 不匹配任何行，
+// 所以第一页不加键集条件；之后的锚点（截止时间可能为空）也绑定为非 null 的字符串
+bool isFirstPage(const QString &afterDeadline, int afterId)
+{
+    return afterDeadline.isEmpty() && afterId < 0;
+}
+
+QString deadlineCursor(const QString &afterDeadline)
+{
+    return afterDeadline.isNull() ? QString("") : afterDeadline;
+}
+
+// 超过该字节数的描述压缩存储
+const int kDescriptionCompressThreshold = 1024;
+
+// 变更日志中的描述按与 tasks 表相同的规则存储：长描述为压缩后的 BLOB，其余为文本
+QVariant descriptionLogValue(const QString &text)
+{
+    QVariant plain, compressed;
+    DBManager::encodeDescription(text, &plain, &compressed);
+    return compressed.isNull() ? plain : compressed;
+}
+
+// 缓存的筛选预编译语句上限
+const int kMaxCachedFilterStatements = 32;
+
+// 从查询结果的当前行读取任务
+Task taskFromQuery(const QSqlQuery &query, int columns = BaseColumns)
+{
+    Task task;
+    task.id = query.value("id").toInt();
+    task.title = query.value("title").toString();
+    task.deadline = QDateTime::fromString(query.value("deadline").toString(), "yyyy-MM-dd HH:mm");
+    task.priority = query.value("priority").toInt();
+    task.isCompleted = query.value("isCompleted").toInt() == 1;
+    if (columns & WithDescription) {
+        task.description = DBManager::decodeDescription(query.value("description"),
+                                                        query.value("description_z"));
+        task.descriptionLoaded = true;
+    }
+    if (columns & WithTags) {
+        task.tags = DBManager::splitTags(query.value("tags").toString());
+    }
+    if (columns & WithParent) {
+        const QVariant parentId = query.value("parent_id");
+        task.parentId = parentId.isNull() ? -1 : parentId.toInt();
+    }
+    return task;
+}
+
+// 子任务汇总列，与 task_rollups 左连接（别名 r）读取；没有子任务的任务为空
+const char *const kRollupColumns =
+    "COALESCE(r.descendants, 0) AS descendants, COALESCE(r.completed, 0) AS completed, "
+    "r.earliest_deadline AS earliest_deadline";
+
+TaskRollup rollupFromQuery(const QSqlQuery &query)
+{
+    TaskRollup rollup;
+    rollup.descendants = query.value("descendants").toInt();
+    rollup.completed = query.value("completed").toInt();
+    rollup.earliestDeadline = QDateTime::fromString(query.value("earliest_deadline").toString(),
+                                                    "yyyy-MM-dd HH:mm");
+    return rollup;
+}
+}
 
 // 静态成员初始化
 DBManager* DBManager::m_instance = nullptr;
@@ -25,6 +128,11 @@ DBManager* DBManager::instance()
 // 构造函数
 DBManager::DBManager(QObject *parent) : QObject(parent)
 {
+    // 慢语句的查询计划不能在 SQLite 回调中获取，排到事件循环里补上
+    m_slowQueryLog = new SlowQueryLog(this);
+    connect(m_slowQueryLog, &SlowQueryLog::planNeeded, this, &DBManager::explainSlowQueries,
+            Qt::QueuedConnection);
+
     // 创建数据库连接
     m_db = QSqlDatabase::addDatabase("QSQLITE");
 
@@ -48,12 +156,21 @@ DBManager::DBManager(QObject *parent) : QObject(parent)
     m_db.setDatabaseName(defaultPath);
 }
 
+void DBManager::explainSlowQueries()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_db.isOpen()) {
+        m_slowQueryLog->explainPending(m_db);
+    }
+}
+
 // 设置数据库路径
 void DBManager::setDatabasePath(const QString& path)
 {
     QMutexLocker locker(&m_mutex);
 
     // 如果数据库已经打开，先关闭
+    m_filterStatements.clear();
     if (m_db.isOpen()) {
         m_db.close();
     }
@@ -78,12 +195,514 @@ void DBManager::setDatabasePath(const QString& path)
 // 析构函数
 DBManager::~DBManager()
 {
+    m_filterStatements.clear();
     if (m_db.isOpen()) {
         qDebug() << "关闭数据库连接";
         m_db.close();
     }
 }
 
+// 在指定schema（main或ATTACH的同步对端）中创建/检查所有表
+bool DBManager::createTables(QSqlQuery &query, const QString &schema)
+{
+    const QStringList statements = {
+        R"(
+        CREATE TABLE IF NOT EXISTS %1.tasks (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            title TEXT NOT NULL,
+            deadline TEXT NOT NULL,
+            priority INTEGER NOT NULL DEFAULT 0,
+            isCompleted INTEGER NOT NULL DEFAULT 0,
+            description TEXT
+        )
+        )",
+        // 任务依赖表
+        R"(
+        CREATE TABLE IF NOT EXISTS %1.task_dependencies (
+            blocker_id INTEGER NOT NULL,
+            blocked_id INTEGER NOT NULL,
+            PRIMARY KEY (blocker_id, blocked_id)
+        )
+        )",
+        "CREATE INDEX IF NOT EXISTS %1.idx_task_dependencies_blocked ON task_dependencies (blocked_id)",
+        // 键值表（副本ID等）
+        "CREATE TABLE IF NOT EXISTS %1.meta (key TEXT PRIMARY KEY, value TEXT)",
+        // 变更日志：version为本库内单调递增的序号，(origin_replica, origin_version)全局唯一
+        R"(
+        CREATE TABLE IF NOT EXISTS %1.change_log (
+            version INTEGER PRIMARY KEY AUTOINCREMENT,
+            origin_replica TEXT NOT NULL,
+            origin_version INTEGER,
+            task_uuid TEXT NOT NULL,
+            field TEXT NOT NULL,
+            value TEXT,
+            stamp INTEGER NOT NULL
+        )
+        )",
+        "CREATE UNIQUE INDEX IF NOT EXISTS %1.idx_change_log_origin ON change_log (origin_replica, origin_version)",
+        "CREATE INDEX IF NOT EXISTS %1.idx_change_log_field ON change_log (task_uuid, field, stamp)",
+        // 每个对端已拉取到的变更日志位置
+        R"(
+        CREATE TABLE IF NOT EXISTS %1.sync_peers (
+            peer_replica TEXT PRIMARY KEY,
+            pulled_version INTEGER NOT NULL DEFAULT 0
+        )
+        )"
+    };
+
+    for (const QString &statement : statements) {
+        if (!query.exec(statement.arg(schema))) {
+            qCritical() << "创建表失败：" << query.lastError().text();
+            return false;
+        }
+    }
+
+    // 旧数据库没有uuid列，补齐并为已有任务生成全局ID
+    // 旧任务的uuid只由本行内容（自增ID和标题）派生：从同一个旧文件复制出的多份数据库各自升级后，
+    // 同一个任务得到相同的uuid；复制之后各自新建的任务即使ID相同，标题不同也不会被当成同一个任务
+    if (!ensureColumn(query, schema, "tasks", "uuid", "TEXT")) {
+        return false;
+    }
+    if (!query.exec(QString("SELECT id, title FROM %1.tasks WHERE uuid IS NULL").arg(schema))) {
+        qCritical() << "初始化任务uuid失败：" << query.lastError().text();
+        return false;
+    }
+    QList<QPair<int, QString>> legacy;
+    while (query.next()) {
+        legacy.append(qMakePair(query.value(0).toInt(), query.value(1).toString()));
+    }
+    query.prepare(QString("UPDATE %1.tasks SET uuid = :uuid WHERE id = :id").arg(schema));
+    for (const auto &task : legacy) {
+        const QByteArray digest = QCryptographicHash::hash(task.second.toUtf8(), QCryptographicHash::Sha1);
+        query.bindValue(":uuid", QString("legacy-%1-%2").arg(task.first).arg(QString(digest.toHex().left(16))));
+        query.bindValue(":id", task.first);
+        if (!query.exec()) {
+            qCritical() << "初始化任务uuid失败：" << query.lastError().text();
+            return false;
+        }
+    }
+    if (!query.exec(QString("CREATE UNIQUE INDEX IF NOT EXISTS %1.idx_tasks_uuid ON tasks (uuid)").arg(schema))) {
+        qCritical() << "初始化任务uuid失败：" << query.lastError().text();
+        return false;
+    }
+
+    if (!ensureColumn(query, schema, "tasks", "description_z", "BLOB")) {
+        return false;
+    }
+
+    // 行版本号：由触发器维护，其他进程或脚本直接写表时同样生效，
+    // 使界面只需拉取 row_version 大于上次位置的行
+    if (!ensureColumn(query, schema, "tasks", "row_version", "INTEGER NOT NULL DEFAULT 0")) {
+        return false;
+    }
+
+    const QStringList versionStatements = {
+        "CREATE TABLE IF NOT EXISTS %1.row_clock (id INTEGER PRIMARY KEY CHECK (id = 1), value INTEGER NOT NULL)",
+        "INSERT OR IGNORE INTO %1.row_clock (id, value) VALUES (1, 0)",
+        "CREATE TABLE IF NOT EXISTS %1.deleted_tasks (id INTEGER PRIMARY KEY, row_version INTEGER NOT NULL)",
+        "CREATE INDEX IF NOT EXISTS %1.idx_tasks_row_version ON tasks (row_version)",
+        "CREATE INDEX IF NOT EXISTS %1.idx_deleted_tasks_row_version ON deleted_tasks (row_version)",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_insert_version AFTER INSERT ON tasks
+        BEGIN
+            UPDATE row_clock SET value = value + 1 WHERE id = 1;
+            UPDATE tasks SET row_version = (SELECT value FROM row_clock WHERE id = 1) WHERE id = NEW.id;
+            DELETE FROM deleted_tasks WHERE id = NEW.id;
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_update_version AFTER UPDATE ON tasks
+        WHEN NEW.row_version IS OLD.row_version
+        BEGIN
+            UPDATE row_clock SET value = value + 1 WHERE id = 1;
+            UPDATE tasks SET row_version = (SELECT value FROM row_clock WHERE id = 1) WHERE id = NEW.id;
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_delete_version AFTER DELETE ON tasks
+        BEGIN
+            UPDATE row_clock SET value = value + 1 WHERE id = 1;
+            INSERT OR REPLACE INTO deleted_tasks (id, row_version)
+            VALUES (OLD.id, (SELECT value FROM row_clock WHERE id = 1));
+        END
+        )"
+    };
+
+    for (const QString &statement : versionStatements) {
+        if (!query.exec(statement.arg(schema))) {
+            qCritical() << "创建行版本触发器失败：" << query.lastError().text();
+            return false;
+        }
+    }
+
+    // 完成时间与归档表：已完成且超过保留期的任务批量移入 tasks_archive，保持 tasks 表精简
+    if (!ensureColumn(query, schema, "tasks", "completed_at", "TEXT")) {
+        return false;
+    }
+
+    const QStringList archiveStatements = {
+        R"(
+        CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_completed_at AFTER UPDATE OF isCompleted ON tasks
+        WHEN NEW.isCompleted IS NOT OLD.isCompleted
+        BEGIN
+            UPDATE tasks
+            SET completed_at = CASE WHEN NEW.isCompleted = 1
+                                    THEN strftime('%Y-%m-%d %H:%M', 'now', 'localtime') END
+            WHERE id = NEW.id;
+        END
+        )",
+        "CREATE INDEX IF NOT EXISTS %1.idx_tasks_completed ON tasks (isCompleted, completed_at)",
+        R"(
+        CREATE TABLE IF NOT EXISTS %1.tasks_archive (
+            id INTEGER PRIMARY KEY,
+            uuid TEXT,
+            title TEXT NOT NULL,
+            deadline TEXT NOT NULL,
+            priority INTEGER NOT NULL DEFAULT 0,
+            isCompleted INTEGER NOT NULL DEFAULT 1,
+            description TEXT,
+            completed_at TEXT,
+            archived_at TEXT NOT NULL
+        )
+        )",
+        "CREATE INDEX IF NOT EXISTS %1.idx_tasks_archive_deadline ON tasks_archive (deadline, id)",
+        "CREATE UNIQUE INDEX IF NOT EXISTS %1.idx_tasks_archive_uuid ON tasks_archive (uuid)"
+    };
+
+    for (const QString &statement : archiveStatements) {
+        if (!query.exec(statement.arg(schema))) {
+            qCritical() << "创建归档表失败：" << query.lastError().text();
+            return false;
+        }
+    }
+
+    if (!ensureColumn(query, schema, "tasks_archive", "description_z", "BLOB")
+        || !ensureColumn(query, schema, "tasks_archive", "tags", "TEXT")) {
+        return false;
+    }
+
+    // 标签（多对多）。task_tags 的增删会刷新所属任务的 row_version，增量刷新能感知标签变化
+    const QStringList tagStatements = {
+        "CREATE TABLE IF NOT EXISTS %1.tags (id INTEGER PRIMARY KEY AUTOINCREMENT, name TEXT NOT NULL UNIQUE COLLATE NOCASE)",
+        R"(
+        CREATE TABLE IF NOT EXISTS %1.task_tags (
+            task_id INTEGER NOT NULL,
+            tag_id INTEGER NOT NULL,
+            PRIMARY KEY (task_id, tag_id)
+        )
+        )",
+        "CREATE INDEX IF NOT EXISTS %1.idx_task_tags_tag ON task_tags (tag_id)",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS %1.trg_task_tags_insert AFTER INSERT ON task_tags
+        BEGIN
+            UPDATE tasks SET row_version = row_version WHERE id = NEW.task_id;
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS %1.trg_task_tags_delete AFTER DELETE ON task_tags
+        BEGIN
+            UPDATE tasks SET row_version = row_version WHERE id = OLD.task_id;
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_delete_tags AFTER DELETE ON tasks
+        BEGIN
+            DELETE FROM task_tags WHERE task_id = OLD.id;
+        END
+        )"
+    };
+
+    for (const QString &statement : tagStatements) {
+        if (!query.exec(statement.arg(schema))) {
+            qCritical() << "创建标签表失败：" << query.lastError().text();
+            return false;
+        }
+    }
+
+    // 筛选条件常用的列建索引；保存的命名筛选
+    const QStringList filterStatements = {
+        "CREATE INDEX IF NOT EXISTS %1.idx_tasks_deadline ON tasks (deadline)",
+        "CREATE INDEX IF NOT EXISTS %1.idx_tasks_priority ON tasks (priority, deadline)",
+        "CREATE TABLE IF NOT EXISTS %1.saved_filters (name TEXT PRIMARY KEY, expression TEXT NOT NULL)"
+    };
+
+    for (const QString &statement : filterStatements) {
+        if (!query.exec(statement.arg(schema))) {
+            qCritical() << "创建筛选索引失败：" << query.lastError().text();
+            return false;
+        }
+    }
+
+    // 任务事件日志（只追加）与按天汇总。事件由触发器写入，同步和其他进程的修改同样会记录；
+    // 每插入一条事件即累加到当天的汇总行，趋势图只读汇总表
+    if (!ensureColumn(query, schema, "tasks", "created_at", "TEXT")
+        || !ensureColumn(query, schema, "tasks_archive", "created_at", "TEXT")) {
+        return false;
+    }
+
+    const QStringList eventStatements = {
+        R"(
+        CREATE TABLE IF NOT EXISTS %1.task_events (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            task_id INTEGER NOT NULL,
+            event TEXT NOT NULL,
+            at TEXT NOT NULL,
+            old_value TEXT,
+            new_value TEXT,
+            lead_secs INTEGER
+        )
+        )",
+        "CREATE INDEX IF NOT EXISTS %1.idx_task_events_task ON task_events (task_id, id)",
+        R"(
+        CREATE TABLE IF NOT EXISTS %1.daily_stats (
+            day TEXT PRIMARY KEY,
+            created INTEGER NOT NULL DEFAULT 0,
+            completed INTEGER NOT NULL DEFAULT 0,
+            reopened INTEGER NOT NULL DEFAULT 0,
+            rescheduled INTEGER NOT NULL DEFAULT 0,
+            deleted INTEGER NOT NULL DEFAULT 0,
+            overdue INTEGER,
+            lead_time_total INTEGER NOT NULL DEFAULT 0,
+            lead_time_count INTEGER NOT NULL DEFAULT 0
+        )
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_event_insert AFTER INSERT ON tasks
+        BEGIN
+            INSERT INTO task_events (task_id, event, at, new_value)
+            VALUES (NEW.id, 'created',
+                    COALESCE(NEW.created_at, strftime('%Y-%m-%d %H:%M:%S', 'now', 'localtime')),
+                    NEW.deadline);
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_event_completed AFTER UPDATE OF isCompleted ON tasks
+        WHEN NEW.isCompleted IS NOT OLD.isCompleted
+        BEGIN
+            INSERT INTO task_events (task_id, event, at, lead_secs)
+            VALUES (NEW.id,
+                    CASE WHEN NEW.isCompleted = 1 THEN 'completed' ELSE 'reopened' END,
+                    strftime('%Y-%m-%d %H:%M:%S', 'now', 'localtime'),
+                    CASE WHEN NEW.isCompleted = 1 AND NEW.created_at IS NOT NULL
+                         THEN strftime('%s', 'now', 'localtime') - strftime('%s', NEW.created_at) END);
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_event_deadline AFTER UPDATE OF deadline ON tasks
+        WHEN NEW.deadline IS NOT OLD.deadline
+        BEGIN
+            INSERT INTO task_events (task_id, event, at, old_value, new_value)
+            VALUES (NEW.id, 'rescheduled', strftime('%Y-%m-%d %H:%M:%S', 'now', 'localtime'),
+                    OLD.deadline, NEW.deadline);
+        END
+        )",
+        // 归档先写入 tasks_archive 再删除，不算作删除
+        R"(
+        CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_event_delete AFTER DELETE ON tasks
+        BEGIN
+            INSERT INTO task_events (task_id, event, at)
+            VALUES (OLD.id,
+                    CASE WHEN EXISTS (SELECT 1 FROM tasks_archive WHERE id = OLD.id)
+                         THEN 'archived' ELSE 'deleted' END,
+                    strftime('%Y-%m-%d %H:%M:%S', 'now', 'localtime'));
+        END
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS %1.trg_task_events_rollup AFTER INSERT ON task_events
+        BEGIN
+            INSERT OR IGNORE INTO daily_stats (day) VALUES (substr(NEW.at, 1, 10));
+            UPDATE daily_stats
+            SET created = created + (NEW.event = 'created'),
+                completed = completed + (NEW.event = 'completed'),
+                reopened = reopened + (NEW.event = 'reopened'),
+                rescheduled = rescheduled + (NEW.event = 'rescheduled'),
+                deleted = deleted + (NEW.event = 'deleted'),
+                lead_time_total = lead_time_total + COALESCE(NEW.lead_secs, 0),
+                lead_time_count = lead_time_count + (NEW.lead_secs IS NOT NULL)
+            WHERE day = substr(NEW.at, 1, 10);
+        END
+        )"
+    };
+
+    for (const QString &statement : eventStatements) {
+        if (!query.exec(statement.arg(schema))) {
+            qCritical() << "创建事件日志失败：" << query.lastError().text();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// 列不存在时追加
+bool DBManager::ensureColumn(QSqlQuery &query, const QString &schema, const QString &table,
+                             const QString &column, const QString &definition)
+{
+    if (!query.exec(QString("PRAGMA %1.table_info(%2)").arg(schema, table))) {
+        qCritical() << "读取表结构失败：" << query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        if (query.value("name").toString() == column) {
+            return true;
+        }
+    }
+
+    qDebug() << "为" << schema + "." + table << "添加列" << column;
+    if (!query.exec(QString("ALTER TABLE %1.%2 ADD COLUMN %3 %4").arg(schema, table, column, definition))) {
+        qCritical() << "添加列失败：" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// 较长的描述（常见为粘贴的日志）以 qCompress 压缩后存入 description_z
+void DBManager::encodeDescription(const QString &text, QVariant *plain, QVariant *compressed)
+{
+    QByteArray utf8 = text.toUtf8();
+    if (utf8.size() > kDescriptionCompressThreshold) {
+        *plain = QVariant();
+        *compressed = qCompress(utf8);
+    } else {
+        *plain = text;
+        *compressed = QVariant();
+    }
+}
+
+// 压缩此前以明文保存的长描述。后台数据迁移的一批，处理 id 区间 (fromId, toId]，与进度在同一事务中提交
+bool DBManager::compressDescriptions(QSqlQuery &query, qint64 fromId, qint64 toId)
+{
+    query.prepare("SELECT id, description FROM tasks "
+                  "WHERE id > :from AND id <= :to AND length(CAST(description AS BLOB)) > :threshold");
+    query.bindValue(":from", fromId);
+    query.bindValue(":to", toId);
+    query.bindValue(":threshold", kDescriptionCompressThreshold);
+    if (!query.exec()) {
+        qCritical() << "读取长描述失败：" << query.lastError().text();
+        return false;
+    }
+    QList<QPair<int, QString>> pending;
+    while (query.next()) {
+        pending.append(qMakePair(query.value(0).toInt(), query.value(1).toString()));
+    }
+
+    query.prepare("UPDATE tasks SET description = :plain, description_z = :compressed WHERE id = :id");
+    for (const auto &item : pending) {
+        QVariant plain, compressed;
+        encodeDescription(item.second, &plain, &compressed);
+        query.bindValue(":plain", plain);
+        query.bindValue(":compressed", compressed);
+        query.bindValue(":id", item.first);
+        if (!query.exec()) {
+            qCritical() << "压缩长描述失败：" << query.lastError().text();
+            return false;
+        }
+    }
+    if (!pending.isEmpty()) {
+        qDebug() << "已压缩" << pending.size() << "个长描述";
+    }
+    return true;
+}
+
+QString DBManager::decodeDescription(const QVariant &plain, const QVariant &compressed)
+{
+    if (!compressed.isNull()) {
+        return QString::fromUtf8(qUncompress(compressed.toByteArray()));
+    }
+    return plain.toString();
+}
+
+// 把任务的标签整体替换为 tags（调用方处于事务中）
+bool DBManager::writeTaskTags(QSqlQuery &query, const QString &schema, int taskId, const QStringList &tags)
+{
+    query.prepare(QString("DELETE FROM %1.task_tags WHERE task_id = :id").arg(schema));
+    query.bindValue(":id", taskId);
+    if (!query.exec()) {
+        qCritical() << "清除任务标签失败：" << query.lastError().text();
+        return false;
+    }
+
+    for (const QString &tag : tags) {
+        query.prepare(QString("INSERT OR IGNORE INTO %1.tags (name) VALUES (:name)").arg(schema));
+        query.bindValue(":name", tag);
+        if (!query.exec()) {
+            qCritical() << "写入标签失败：" << query.lastError().text();
+            return false;
+        }
+
+        query.prepare(QString("INSERT OR IGNORE INTO %1.task_tags (task_id, tag_id) "
+                              "SELECT :id, id FROM %1.tags WHERE name = :name").arg(schema));
+        query.bindValue(":id", taskId);
+        query.bindValue(":name", tag);
+        if (!query.exec()) {
+            qCritical() << "写入任务标签失败：" << query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+QStringList DBManager::splitTags(const QString &joined)
+{
+    QStringList tags = joined.split(',', Qt::SkipEmptyParts);
+    tags.sort(Qt::CaseInsensitive);
+    return tags;
+}
+
+// Qt 的 QSQLITE 插件通常自带一份 SQLite，与程序链接的 -lsqlite3 不是同一份库。
+// 这时驱动的 sqlite3* 句柄交给 C API 是未定义行为；用另一份库打开同一个数据库文件也不安全：
+// POSIX 文件锁按进程共享，一份库关闭文件时会释放另一份库持有的锁。
+// 版本相同的两份库 sqlite_source_id 也相同，所以改为检查进程级的状态是否共享：
+// 通过链接的库修改软堆上限，再从驱动的连接读回，只有同一份库才能读到修改后的值
+bool DBManager::sameSqliteLibrary(const QSqlDatabase &db, QString *error)
+{
+    QSqlQuery query(db);
+    if (!query.exec("SELECT sqlite_source_id()") || !query.next()) {
+        if (error) *error = "无法读取驱动的 SQLite 版本：" + query.lastError().text();
+        return false;
+    }
+    const QString driverSource = query.value(0).toString();
+    const QString linkedSource = QString::fromLatin1(sqlite3_sourceid());
+
+    bool shared = false;
+    if (driverSource == linkedSource) {
+        const sqlite3_int64 previous = sqlite3_soft_heap_limit64(-1);
+        const sqlite3_int64 probe = previous + 0x5a5a5;
+        sqlite3_soft_heap_limit64(probe);
+        shared = query.exec("PRAGMA soft_heap_limit") && query.next() && query.value(0).toLongLong() == probe;
+        query.finish();
+        sqlite3_soft_heap_limit64(previous);
+    }
+
+    if (!shared) {
+        if (error) {
+            *error = QString("Qt 的 SQLite 驱动（%1）与程序链接的 SQLite（%2）不是同一份库，"
+                             "需要使用 -system-sqlite 编译的 Qt")
+                         .arg(driverSource, linkedSource);
+        }
+        return false;
+    }
+    return true;
+}
+
+// 读取/创建某个schema的副本ID
+QString DBManager::loadReplicaId(QSqlQuery &query, const QString &schema)
+{
+    query.exec(QString("SELECT value FROM %1.meta WHERE key = 'replica_id'").arg(schema));
+    if (query.next()) {
+        return query.value(0).toString();
+    }
+
+    QString id = QUuid::createUuid().toString().remove('{').remove('}');
+    query.prepare(QString("INSERT INTO %1.meta (key, value) VALUES ('replica_id', :id)").arg(schema));
+    query.bindValue(":id", id);
+    if (!query.exec()) {
+        qCritical() << "写入副本ID失败：" << query.lastError().text();
+        return QString();
+    }
+    return id;
+}
+
 // 初始化数据库
 bool DBManager::initDatabase()
 {
@@ -99,51 +718,181 @@ bool DBManager::initDatabase()
     }
 
     qDebug() << "SQLite数据库打开成功！";
+    QString libraryError;
+    m_sqliteApiUsable = sameSqliteLibrary(m_db, &libraryError);
+    if (!m_sqliteApiUsable) {
+        qCritical() << libraryError << "：在线备份改用 VACUUM INTO，不能在线恢复";
+    }
+    m_slowQueryLog->attach(m_db);
 
-    // 创建表
+    // 删除留下的空闲页可以在空闲时增量归还；新建的库立即生效，已有的库在下一次 VACUUM 后生效
     QSqlQuery query;
-    QString createSql = R"(
-        CREATE TABLE IF NOT EXISTS tasks (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            title TEXT NOT NULL,
-            deadline TEXT NOT NULL,
-            priority INTEGER NOT NULL DEFAULT 0,
-            isCompleted INTEGER NOT NULL DEFAULT 0,
-            description TEXT
-        )
-    )";
+    if (!query.exec("PRAGMA auto_vacuum = INCREMENTAL")) {
+        qWarning() << "设置 auto_vacuum 失败：" << query.lastError().text();
+    }
+
+    // WAL 模式下读事务不阻塞写入：导出、查重和 VACUUM INTO 备份在独立连接上长时间读取时，界面照常写入。
+    // 该设置保存在数据库文件中，对之后打开它的所有连接生效
+    if (!query.exec("PRAGMA journal_mode = WAL") || !query.next() || query.value(0).toString() != "wal") {
+        qWarning() << "无法启用 WAL 模式，后台读取期间写入可能被阻塞：" << query.lastError().text();
+    }
+    query.finish();
+
+    // 按 user_version 升级数据库结构；耗时的数据迁移留给后台线程
+    QString error;
+    if (!SchemaMigrator::migrate(query, "main", &error)) {
+        return false;
+    }
+
+    qDebug() << "数据库结构版本：" << SchemaMigrator::latestVersion();
+
+    m_replicaId = loadReplicaId(query, "main");
+    if (m_replicaId.isEmpty()) {
+        return false;
+    }
+
+    // 没有变更记录的任务（变更日志出现之前的数据）补一份初始快照，stamp=0保证任何真实编辑都更新；
+    // 已压缩的长描述 description 为空，取 description_z 原样记录
+    query.prepare(R"(
+        INSERT INTO change_log (origin_replica, task_uuid, field, value, stamp)
+        SELECT :replica, t.uuid, f.field,
+               CASE f.field WHEN 'title' THEN t.title
+                            WHEN 'deadline' THEN t.deadline
+                            WHEN 'priority' THEN t.priority
+                            WHEN 'isCompleted' THEN t.isCompleted
+                            ELSE IFNULL(t.description, t.description_z) END,
+               0
+        FROM tasks t,
+             (SELECT 'title' AS field UNION ALL SELECT 'deadline' UNION ALL SELECT 'priority'
+              UNION ALL SELECT 'isCompleted' UNION ALL SELECT 'description') f
+        WHERE NOT EXISTS (SELECT 1 FROM change_log c WHERE c.task_uuid = t.uuid)
+    )");
+    query.bindValue(":replica", m_replicaId);
+    if (!query.exec() || !sealLocalChanges(query)) {
+        qCritical() << "初始化变更日志失败：" << query.lastError().text();
+        return false;
+    }
+
+    query.exec("SELECT IFNULL(MAX(stamp), 0) FROM change_log");
+    m_lastStamp = query.next() ? query.value(0).toLongLong() : 0;
+
+    qDebug() << "副本ID：" << m_replicaId;
+    return true;
+}
+
+// 替换数据库文件（如从备份恢复）后，把其结构升级到当前版本
+bool DBManager::upgradeSchema(QString *error)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        *error = "数据库未打开";
+        return false;
+    }
+    m_filterStatements.clear();
+    QSqlQuery query;
+    return SchemaMigrator::migrate(query, "main", error);
+}
+
+// 混合逻辑时钟：不小于当前毫秒时间，且严格递增
+qint64 DBManager::nextStamp()
+{
+    m_lastStamp = qMax(QDateTime::currentMSecsSinceEpoch(), m_lastStamp + 1);
+    return m_lastStamp;
+}
+
+// 记录一条本地字段变更（调用方持有m_mutex并处于事务中）
+bool DBManager::logChange(QSqlQuery &query, const QString &uuid, const QString &field,
+                          const QVariant &value, qint64 stamp)
+{
+    query.prepare(R"(
+        INSERT INTO change_log (origin_replica, task_uuid, field, value, stamp)
+        VALUES (:replica, :uuid, :field, :value, :stamp)
+    )");
+    query.bindValue(":replica", m_replicaId);
+    query.bindValue(":uuid", uuid);
+    query.bindValue(":field", field);
+    query.bindValue(":value", value);
+    query.bindValue(":stamp", stamp);
 
-    if (!query.exec(createSql)) {
-        qCritical() << "创建表失败：" << query.lastError().text();
+    if (!query.exec()) {
+        qCritical() << "写入变更日志失败：" << query.lastError().text();
         return false;
     }
+    return true;
+}
 
-    qDebug() << "tasks表创建/检查完成";
+// 本地变更的origin_version取其在本库的version
+bool DBManager::sealLocalChanges(QSqlQuery &query)
+{
+    query.prepare("UPDATE change_log SET origin_version = version "
+                  "WHERE origin_replica = :replica AND origin_version IS NULL");
+    query.bindValue(":replica", m_replicaId);
+    if (!query.exec()) {
+        qCritical() << "更新变更日志失败：" << query.lastError().text();
+        return false;
+    }
     return true;
 }
 
 // 添加任务
 bool DBManager::addTask(const Task& task)
 {
+    static Histogram *const latency = operationLatency("addTask");
+    MetricsTimer timer(latency);
     QMutexLocker locker(&m_mutex);
     if (!m_db.isOpen()) {
         qWarning() << "数据库未打开，无法添加任务";
         return false;
     }
 
+    QString uuid = QUuid::createUuid().toString().remove('{').remove('}');
+    QString deadline = task.deadline.toString("yyyy-MM-dd HH:mm");
+
+    QVariant description, descriptionZ;
+    encodeDescription(task.description, &description, &descriptionZ);
+
+    m_db.transaction();
     QSqlQuery query;
     query.prepare(R"(
-        INSERT INTO tasks (title, deadline, priority, isCompleted, description)
-        VALUES (:title, :deadline, :priority, :isCompleted, :description)
+        INSERT INTO tasks (title, deadline, priority, isCompleted, description, description_z, uuid, created_at,
+                           parent_id)
+        VALUES (:title, :deadline, :priority, :isCompleted, :description, :descriptionZ, :uuid,
+                strftime('%Y-%m-%d %H:%M:%S', 'now', 'localtime'), :parentId)
     )");
     query.bindValue(":title", task.title);
-    query.bindValue(":deadline", task.deadline.toString("yyyy-MM-dd HH:mm"));
+    query.bindValue(":deadline", deadline);
     query.bindValue(":priority", task.priority);
     query.bindValue(":isCompleted", task.isCompleted ? 1 : 0);
-    query.bindValue(":description", task.description);
+    query.bindValue(":description", description);
+    query.bindValue(":descriptionZ", descriptionZ);
+    query.bindValue(":uuid", uuid);
+    query.bindValue(":parentId", task.parentId == -1 ? QVariant() : QVariant(task.parentId));
 
     if (!query.exec()) {
         qCritical() << "添加任务失败：" << query.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+
+    int taskId = query.lastInsertId().toInt();
+    QStringList tags = task.tags;
+    tags.sort(Qt::CaseInsensitive);
+    if ((!tags.isEmpty() && !writeTaskTags(query, "main", taskId, tags))
+        || !writeFingerprint(query, taskId, SimHash::compute(task.title, task.description))) {
+        m_db.rollback();
+        return false;
+    }
+
+    qint64 stamp = nextStamp();
+    if ((!tags.isEmpty() && !logChange(query, uuid, "tags", tags.join(','), stamp))
+        || !logChange(query, uuid, "title", task.title, stamp)
+        || !logChange(query, uuid, "deadline", deadline, stamp)
+        || !logChange(query, uuid, "priority", task.priority, stamp)
+        || !logChange(query, uuid, "isCompleted", task.isCompleted ? 1 : 0, stamp)
+        || !logChange(query, uuid, "description", descriptionLogValue(task.description), stamp)
+        || !sealLocalChanges(query)
+        || !m_db.commit()) {
+        m_db.rollback();
         return false;
     }
 
@@ -154,6 +903,8 @@ bool DBManager::addTask(const Task& task)
 // 更新任务
 bool DBManager::updateTask(const Task& task)
 {
+    static Histogram *const latency = operationLatency("updateTask");
+    MetricsTimer timer(latency);
     QMutexLocker locker(&m_mutex);
     if (!m_db.isOpen()) {
         qWarning() << "数据库未打开，无法更新任务";
@@ -165,22 +916,11 @@ bool DBManager::updateTask(const Task& task)
         return false;
     }
 
+    m_db.transaction();
     QSqlQuery query;
-    query.prepare(R"(
-        UPDATE tasks
-        SET title = :title, deadline = :deadline, priority = :priority,
-            isCompleted = :isCompleted, description = :description
-        WHERE id = :id
-    )");
-    query.bindValue(":title", task.title);
-    query.bindValue(":deadline", task.deadline.toString("yyyy-MM-dd HH:mm"));
-    query.bindValue(":priority", task.priority);
-    query.bindValue(":isCompleted", task.isCompleted ? 1 : 0);
-    query.bindValue(":description", task.description);
-    query.bindValue(":id", task.id);
-
-    if (!query.exec()) {
-        qCritical() << "更新任务失败：" << query.lastError().text();
+    QString error;
+    if (!writeTaskUpdate(query, task, &error) || !sealLocalChanges(query) || !m_db.commit()) {
+        m_db.rollback();
         return false;
     }
 
@@ -188,36 +928,492 @@ bool DBManager::updateTask(const Task& task)
     return true;
 }
 
-// 删除任务
-bool DBManager::deleteTask(int taskId)
+// 在一个事务中更新多个任务，任意一个失败则全部回滚
+bool DBManager::updateTasks(const QList<Task> &tasks, QString *error)
 {
+    static Histogram *const latency = operationLatency("updateTasks");
+    MetricsTimer timer(latency);
     QMutexLocker locker(&m_mutex);
+    QString message;
     if (!m_db.isOpen()) {
-        qWarning() << "数据库未打开，无法删除任务";
-        return false;
-    }
-
+        message = "数据库未打开";
+    } else {
+        m_db.transaction();
+        QSqlQuery query;
+        bool ok = true;
+        for (const Task &task : tasks) {
+            if (!writeTaskUpdate(query, task, &message)) {
+                ok = false;
+                break;
+            }
+        }
+        if (ok && sealLocalChanges(query) && m_db.commit()) {
+            qDebug() << "批量更新任务成功：" << tasks.size() << "个";
+            return true;
+        }
+        if (message.isEmpty()) {
+            message = m_db.lastError().text();
+        }
+        m_db.rollback();
+    }
+
+    qCritical() << "批量更新任务失败：" << message;
+    if (error) *error = message;
+    return false;
+}
+
+// 只写入任务的完成状态（列表中勾选完成）。延迟写入时不能写回整个任务：
+// 排队期间其他进程或同步对其他字段的修改会被内存中的旧值覆盖
+bool DBManager::updateCompletion(const QList<QPair<int, bool>> &states, QString *error)
+{
+    static Histogram *const latency = operationLatency("updateCompletion");
+    MetricsTimer timer(latency);
+    QMutexLocker locker(&m_mutex);
+    QString message;
+    if (!m_db.isOpen()) {
+        message = "数据库未打开";
+    } else {
+        m_db.transaction();
+        QSqlQuery query;
+        const qint64 stamp = nextStamp();
+        bool ok = true;
+        for (const auto &state : states) {
+            query.prepare("SELECT uuid, isCompleted FROM tasks WHERE id = :id");
+            query.bindValue(":id", state.first);
+            if (!query.exec() || !query.next()) {
+                message = QString("找不到任务（ID %1），可能已被删除").arg(state.first);
+                ok = false;
+                break;
+            }
+            const QString uuid = query.value(0).toString();
+            if (query.value(1).toBool() == state.second) continue;
+
+            query.prepare("UPDATE tasks SET isCompleted = :isCompleted WHERE id = :id");
+            query.bindValue(":isCompleted", state.second ? 1 : 0);
+            query.bindValue(":id", state.first);
+            if (!query.exec() || !logChange(query, uuid, "isCompleted", state.second ? 1 : 0, stamp)) {
+                message = query.lastError().text();
+                ok = false;
+                break;
+            }
+        }
+        if (ok && sealLocalChanges(query) && m_db.commit()) {
+            qDebug() << "更新完成状态成功：" << states.size() << "个";
+            return true;
+        }
+        if (message.isEmpty()) {
+            message = m_db.lastError().text();
+        }
+        m_db.rollback();
+    }
+
+    qCritical() << "更新完成状态失败：" << message;
+    if (error) *error = message;
+    return false;
+}
+
+// 更新一个任务并记录变更日志（调用方持有锁并负责事务）
+bool DBManager::writeTaskUpdate(QSqlQuery &query, const Task &task, QString *error)
+{
+    // 读取旧值，只为实际变化的字段记录变更；只有要比较新描述时才读取（并解压）旧描述
+    query.prepare(QString("SELECT uuid, %1, %2 FROM tasks WHERE id = :id")
+                      .arg(task.descriptionLoaded ? kFullColumns : kListColumns, kTagsColumn));
+    query.bindValue(":id", task.id);
+    if (!query.exec() || !query.next()) {
+        qCritical() << "更新任务失败，找不到任务ID：" << task.id;
+        *error = QString("找不到任务（ID %1），可能已被删除").arg(task.id);
+        return false;
+    }
+
+    const QString uuid = query.value("uuid").toString();
+    QList<QPair<QString, QVariant>> fields = {
+        {"title", task.title},
+        {"deadline", task.deadline.toString("yyyy-MM-dd HH:mm")},
+        {"priority", task.priority},
+        {"isCompleted", task.isCompleted ? 1 : 0}
+    };
+    // 未加载描述的任务（例如列表中勾选完成）不改动描述
+    if (task.descriptionLoaded) {
+        fields.append(qMakePair(QString("description"), QVariant(task.description)));
+    }
+
+    const Task old = taskFromQuery(query, WithTags | WithParent
+                                              | (task.descriptionLoaded ? WithDescription : BaseColumns));
+    QList<QPair<QString, QVariant>> changed;
+    for (const auto &field : fields) {
+        QString oldValue = field.first == "description" ? old.description
+                                                        : query.value(field.first).toString();
+        if (oldValue != field.second.toString()) {
+            changed.append(field);
+        }
+    }
+
+    // 父子关系引用的是本库的任务ID，不写入变更日志、不参与同步。
+    // 只在变化时写入：移到自己的子任务下面等非法修改由触发器拒绝，错误信息随之返回
+    const bool parentChanged = task.parentId != old.parentId;
+    QString sql = R"(
+        UPDATE tasks
+        SET title = :title, deadline = :deadline, priority = :priority,
+            isCompleted = :isCompleted%1%2
+        WHERE id = :id
+    )";
+    query.prepare(sql.arg(task.descriptionLoaded
+                              ? ", description = :description, description_z = :descriptionZ"
+                              : "",
+                          parentChanged ? ", parent_id = :parentId" : ""));
+    query.bindValue(":title", task.title);
+    query.bindValue(":deadline", task.deadline.toString("yyyy-MM-dd HH:mm"));
+    query.bindValue(":priority", task.priority);
+    query.bindValue(":isCompleted", task.isCompleted ? 1 : 0);
+    if (task.descriptionLoaded) {
+        QVariant description, descriptionZ;
+        encodeDescription(task.description, &description, &descriptionZ);
+        query.bindValue(":description", description);
+        query.bindValue(":descriptionZ", descriptionZ);
+    }
+    if (parentChanged) {
+        query.bindValue(":parentId", task.parentId == -1 ? QVariant() : QVariant(task.parentId));
+    }
+    query.bindValue(":id", task.id);
+
+    if (!query.exec()) {
+        qCritical() << "更新任务失败：" << query.lastError().text();
+        *error = query.lastError().text();
+        return false;
+    }
+
+    QStringList tags = task.tags;
+    tags.sort(Qt::CaseInsensitive);
+    if (tags != old.tags) {
+        if (!writeTaskTags(query, "main", task.id, tags)) {
+            *error = query.lastError().text();
+            return false;
+        }
+        changed.append(qMakePair(QString("tags"), QVariant(tags.join(','))));
+    }
+
+    // 指纹只取决于标题和描述；只改了标题而没有加载描述时，才单独读取旧描述
+    const bool titleChanged = task.title != old.title;
+    const bool descriptionChanged = task.descriptionLoaded && task.description != old.description;
+    if (titleChanged || descriptionChanged) {
+        QString description = task.description;
+        if (!task.descriptionLoaded) {
+            query.prepare("SELECT description, description_z FROM tasks WHERE id = :id");
+            query.bindValue(":id", task.id);
+            if (!query.exec() || !query.next()) {
+                *error = query.lastError().text();
+                return false;
+            }
+            description = decodeDescription(query.value(0), query.value(1));
+        }
+        if (!writeFingerprint(query, task.id, SimHash::compute(task.title, description))) {
+            *error = query.lastError().text();
+            return false;
+        }
+    }
+
+    qint64 stamp = nextStamp();
+    for (const auto &field : changed) {
+        const QVariant value = field.first == "description" ? descriptionLogValue(field.second.toString())
+                                                            : field.second;
+        if (!logChange(query, uuid, field.first, value, stamp)) {
+            *error = query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+// 删除任务
+bool DBManager::deleteTask(int taskId)
+{
+    static Histogram *const latency = operationLatency("deleteTask");
+    MetricsTimer timer(latency);
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        qWarning() << "数据库未打开，无法删除任务";
+        return false;
+    }
+
     if (taskId == -1) {
         qWarning() << "无效的任务ID";
         return false;
     }
 
+    m_db.transaction();
     QSqlQuery query;
+    QString error;
+    if (!writeTaskDelete(query, taskId, &error) || !sealLocalChanges(query)) {
+        m_db.rollback();
+        return false;
+    }
+
+    if (!m_db.commit()) {
+        qCritical() << "提交删除失败：" << m_db.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+
+    qDebug() << "删除任务成功，ID：" << taskId;
+    return true;
+}
+
+// 在一个事务中删除多个任务，任意一个失败则全部回滚
+bool DBManager::deleteTasks(const QList<int> &taskIds, QString *error)
+{
+    static Histogram *const latency = operationLatency("deleteTasks");
+    MetricsTimer timer(latency);
+    QMutexLocker locker(&m_mutex);
+    QString message;
+    if (!m_db.isOpen()) {
+        message = "数据库未打开";
+    } else {
+        m_db.transaction();
+        QSqlQuery query;
+        bool ok = true;
+        for (int taskId : taskIds) {
+            if (!writeTaskDelete(query, taskId, &message)) {
+                ok = false;
+                break;
+            }
+        }
+        if (ok && sealLocalChanges(query) && m_db.commit()) {
+            qDebug() << "批量删除任务成功：" << taskIds.size() << "个";
+            return true;
+        }
+        if (message.isEmpty()) {
+            message = m_db.lastError().text();
+        }
+        m_db.rollback();
+    }
+
+    qCritical() << "批量删除任务失败：" << message;
+    if (error) *error = message;
+    return false;
+}
+
+// 删除一个任务及其依赖，并记录墓碑（调用方持有锁并负责事务）
+bool DBManager::writeTaskDelete(QSqlQuery &query, int taskId, QString *error)
+{
+    query.prepare("SELECT uuid FROM tasks WHERE id = :id");
+    query.bindValue(":id", taskId);
+    QString uuid;
+    if (query.exec() && query.next()) {
+        uuid = query.value(0).toString();
+    }
+
     query.prepare("DELETE FROM tasks WHERE id = :id");
     query.bindValue(":id", taskId);
 
     if (!query.exec()) {
         qCritical() << "删除任务失败：" << query.lastError().text();
+        *error = query.lastError().text();
         return false;
     }
 
-    qDebug() << "删除任务成功，ID：" << taskId;
+    // 同时清理与该任务相关的依赖
+    query.prepare("DELETE FROM task_dependencies WHERE blocker_id = :blocker OR blocked_id = :blocked");
+    query.bindValue(":blocker", taskId);
+    query.bindValue(":blocked", taskId);
+    if (!query.exec()) {
+        qWarning() << "清理任务依赖失败：" << query.lastError().text();
+    }
+
+    // 删除记为墓碑，同步时优先于字段修改
+    if (!uuid.isEmpty() && !logChange(query, uuid, "deleted", 1, nextStamp())) {
+        *error = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// 保存任务的 SimHash 指纹（SQLite 整数有符号，按位原样存储）
+bool DBManager::writeFingerprint(QSqlQuery &query, int taskId, quint64 fingerprint)
+{
+    query.prepare("INSERT OR REPLACE INTO task_fingerprints (task_id, simhash) VALUES (:id, :simhash)");
+    query.bindValue(":id", taskId);
+    query.bindValue(":simhash", qint64(fingerprint));
+    if (!query.exec()) {
+        qCritical() << "保存任务指纹失败：" << query.lastError().text();
+        return false;
+    }
     return true;
 }
 
+// 与指纹距离不超过 maxDistance 的任务，按距离升序
+// 只要有一段完全相同即为候选，各段都走表达式索引（与迁移中建索引的表达式一致），不扫描全表
+QList<QPair<int, int>> DBManager::findNearDuplicates(quint64 fingerprint, int excludeId, int maxDistance) const
+{
+    static Histogram *const latency = operationLatency("findNearDuplicates");
+    MetricsTimer timer(latency);
+    QMutexLocker locker(&m_mutex);
+    QList<QPair<int, int>> result;
+    if (!m_db.isOpen()) return result;
+
+    QStringList conditions;
+    for (int i = 0; i < SimHash::kBands; ++i) {
+        conditions << (i == 0 ? QString("(simhash & 255) = :b0")
+                              : QString("((simhash >> %1) & 255) = :b%2").arg(i * SimHash::kBandBits).arg(i));
+    }
+    QSqlQuery query;
+    query.prepare("SELECT task_id, simhash FROM task_fingerprints WHERE " + conditions.join(" OR "));
+    for (int i = 0; i < SimHash::kBands; ++i) {
+        query.bindValue(QString(":b%1").arg(i), SimHash::band(fingerprint, i));
+    }
+    if (!query.exec()) {
+        qWarning() << "查找相似任务失败：" << query.lastError().text();
+        return result;
+    }
+    while (query.next()) {
+        int taskId = query.value(0).toInt();
+        int distance = SimHash::distance(fingerprint, quint64(query.value(1).toLongLong()));
+        if (taskId != excludeId && distance <= maxDistance) {
+            result.append(qMakePair(taskId, distance));
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const QPair<int, int> &a, const QPair<int, int> &b) {
+        return a.second < b.second || (a.second == b.second && a.first < b.first);
+    });
+    return result;
+}
+
+// 把 mergedIds 合并到 keepId：标签取并集，优先级取最高，描述为空时取第一个非空的描述；
+// 被合并的任务删除（记墓碑），edges 为调用方检查过无环的、改挂到保留任务上的依赖
+bool DBManager::mergeTasks(int keepId, const QList<int> &mergedIds,
+                           const QList<QPair<int, int>> &edges, QString *error)
+{
+    static Histogram *const latency = operationLatency("mergeTasks");
+    MetricsTimer timer(latency);
+    QMutexLocker locker(&m_mutex);
+    QString message;
+    if (!m_db.isOpen()) {
+        message = "数据库未打开";
+    } else {
+        m_db.transaction();
+        QSqlQuery query;
+        bool ok = true;
+
+        Task keep;
+        QList<Task> merged;
+        query.prepare(QString("SELECT %1, %2 FROM tasks WHERE id = :id").arg(kFullColumns, kTagsColumn));
+        for (int taskId : QList<int>{keepId} + mergedIds) {
+            query.bindValue(":id", taskId);
+            if (!query.exec() || !query.next()) {
+                message = QString("找不到任务（ID %1），可能已被删除").arg(taskId);
+                ok = false;
+                break;
+            }
+            Task task = taskFromQuery(query, WithDescription | WithTags | WithParent);
+            if (taskId == keepId) {
+                keep = task;
+            } else {
+                merged.append(task);
+            }
+        }
+
+        if (ok) {
+            for (const Task &task : merged) {
+                for (const QString &tag : task.tags) {
+                    if (!keep.tags.contains(tag, Qt::CaseInsensitive)) keep.tags.append(tag);
+                }
+                keep.priority = qMax(keep.priority, task.priority);
+                if (keep.description.isEmpty()) keep.description = task.description;
+            }
+            ok = writeTaskUpdate(query, keep, &message);
+        }
+        for (int i = 0; ok && i < merged.size(); ++i) {
+            ok = writeTaskDelete(query, merged.at(i).id, &message);
+        }
+        if (ok) {
+            query.prepare("INSERT OR IGNORE INTO task_dependencies (blocker_id, blocked_id) VALUES (:blocker, :blocked)");
+            for (const auto &edge : edges) {
+                query.bindValue(":blocker", edge.first);
+                query.bindValue(":blocked", edge.second);
+                if (!query.exec()) {
+                    message = query.lastError().text();
+                    ok = false;
+                    break;
+                }
+            }
+        }
+
+        if (ok && sealLocalChanges(query) && m_db.commit()) {
+            qDebug() << "合并任务成功：" << mergedIds << "->" << keepId;
+            return true;
+        }
+        if (message.isEmpty()) {
+            message = m_db.lastError().text();
+        }
+        m_db.rollback();
+    }
+
+    qCritical() << "合并任务失败：" << message;
+    if (error) *error = message;
+    return false;
+}
+
+// 与另一个数据库文件双向同步。在独立连接上进行，不持有主连接的锁，可在后台线程调用
+bool DBManager::syncWithDatabase(const QString &peerPath, QString *summary)
+{
+    static Histogram *const latency = operationLatency("syncWithDatabase");
+    MetricsTimer timer(latency);
+    QString databasePath;
+    QString replicaId;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_db.isOpen()) {
+            qWarning() << "数据库未打开，无法同步";
+            return false;
+        }
+        databasePath = m_db.databaseName();
+        replicaId = m_replicaId;
+    }
+
+    QString connectionName = QString("sync_%1").arg(quintptr(QThread::currentThreadId()));
+    TaskSync::Result result;
+    bool ok = false;
+    qint64 maxStamp = 0;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(databasePath);
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+        if (db.open()) {
+            TaskSync sync(db, replicaId);
+            ok = sync.run(peerPath, &result);
+
+            // 对端的时间戳可能比本地时钟更新
+            QSqlQuery query(db);
+            if (query.exec("SELECT IFNULL(MAX(stamp), 0) FROM change_log") && query.next()) {
+                maxStamp = query.value(0).toLongLong();
+            }
+            query.finish();
+            db.close();
+        } else {
+            result.error = "无法打开数据库：" + db.lastError().text();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_lastStamp = qMax(m_lastStamp, maxStamp);
+    }
+
+    if (summary) {
+        *summary = ok ? QString("拉取变更：%1 条（应用 %2 条）\n推送变更：%3 条（应用 %4 条）\n冲突（已按时间戳裁决）：%5 条")
+                            .arg(result.pulled).arg(result.appliedLocal)
+                            .arg(result.pushed).arg(result.appliedRemote)
+                            .arg(result.conflicts)
+                      : result.error;
+    }
+    return ok;
+}
+
 // 获取所有任务
-QList<Task> DBManager::getAllTasks() const
+QList<Task> DBManager::getAllTasks(bool withDescriptions) const
 {
+    static Histogram *const latency = operationLatency("getAllTasks");
+    MetricsTimer timer(latency);
     QMutexLocker locker(&m_mutex);
     QList<Task> tasks;
 
@@ -226,23 +1422,449 @@ QList<Task> DBManager::getAllTasks() const
         return tasks;
     }
 
-    QSqlQuery query("SELECT * FROM tasks ORDER BY deadline ASC");
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    query.exec(QString("SELECT %1, %2 FROM tasks ORDER BY deadline ASC")
+                   .arg(withDescriptions ? kFullColumns : kListColumns, kTagsColumn));
 
     while (query.next()) {
-        Task task;
-        task.id = query.value("id").toInt();
-        task.title = query.value("title").toString();
-        task.deadline = QDateTime::fromString(query.value("deadline").toString(), "yyyy-MM-dd HH:mm");
-        task.priority = query.value("priority").toInt();
-        task.isCompleted = query.value("isCompleted").toInt() == 1;
-        task.description = query.value("description").toString();
-        tasks.append(task);
+        tasks.append(taskFromQuery(query, WithTags | WithParent
+                                              | (withDescriptions ? WithDescription : BaseColumns)));
     }
 
     qDebug() << "获取到" << tasks.size() << "个任务";
     return tasks;
 }
 
+// 按 (deadline, id) 键集分页读取任务，供后台导出等使用自己连接的场景
+// afterDeadline/afterId 为上一页最后一行的位置，初始传空字符串和-1；读取后更新为本页最后一行
+bool DBManager::fetchTaskPage(QSqlQuery &query, int limit, bool withDescriptions,
+                              QString *afterDeadline, int *afterId, QList<Task> *tasks)
+{
+    const bool firstPage = isFirstPage(*afterDeadline, *afterId);
+    query.setForwardOnly(true);
+    query.prepare(QString(R"(
+        SELECT %1, %2 FROM tasks
+        WHERE %3
+        ORDER BY deadline ASC, id ASC
+        LIMIT :limit
+    )").arg(withDescriptions ? kFullColumns : kListColumns, kTagsColumn,
+            firstPage ? "1" : "(deadline, id) > (:deadline, :id)"));
+    if (!firstPage) {
+        query.bindValue(":deadline", deadlineCursor(*afterDeadline));
+        query.bindValue(":id", *afterId);
+    }
+    query.bindValue(":limit", limit);
+
+    if (!query.exec()) {
+        qCritical() << "分页读取任务失败：" << query.lastError().text();
+        return false;
+    }
+
+    while (query.next()) {
+        tasks->append(taskFromQuery(query, WithTags | WithParent
+                                               | (withDescriptions ? WithDescription : BaseColumns)));
+        *afterDeadline = query.value("deadline").toString();
+        *afterId = query.value("id").toInt();
+    }
+    query.finish();
+    return true;
+}
+
+// SQLite的data_version：仅当其他连接（其他进程）提交了修改时才会变化
+int DBManager::dataVersion() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        return -1;
+    }
+
+    QSqlQuery query("PRAGMA data_version");
+    return query.next() ? query.value(0).toInt() : -1;
+}
+
+// 当前行版本号
+qint64 DBManager::currentRowVersion() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        return 0;
+    }
+
+    QSqlQuery query("SELECT value FROM row_clock WHERE id = 1");
+    return query.next() ? query.value(0).toLongLong() : 0;
+}
+
+// 获取 sinceVersion 之后新增/修改的任务和被删除的任务ID
+bool DBManager::getChangesSince(qint64 sinceVersion, QList<Task> *changed,
+                                QList<int> *deletedIds, qint64 *newVersion) const
+{
+    static Histogram *const latency = operationLatency("getChangesSince");
+    MetricsTimer timer(latency);
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        qWarning() << "数据库未打开，无法获取变更";
+        return false;
+    }
+
+    // 先读版本号：之后的并发写入会在下一次增量中再次出现，不会丢失
+    QSqlQuery query("SELECT value FROM row_clock WHERE id = 1");
+    *newVersion = query.next() ? query.value(0).toLongLong() : sinceVersion;
+
+    query.prepare(QString("SELECT %1, %2 FROM tasks WHERE row_version > :version ORDER BY deadline ASC")
+                      .arg(kListColumns, kTagsColumn));
+    query.bindValue(":version", sinceVersion);
+    if (!query.exec()) {
+        qCritical() << "获取变更任务失败：" << query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        changed->append(taskFromQuery(query, WithTags | WithParent));
+    }
+
+    query.prepare("SELECT id FROM deleted_tasks WHERE row_version > :version");
+    query.bindValue(":version", sinceVersion);
+    if (!query.exec()) {
+        qCritical() << "获取已删除任务失败：" << query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        deletedIds->append(query.value(0).toInt());
+    }
+
+    qDebug() << "增量变更：" << changed->size() << "个修改，" << deletedIds->size() << "个删除";
+    return true;
+}
+
+// 把完成时间早于 cutoff 的任务移入归档表（一批最多 batchSize 个），返回移动的数量。
+// 归档表不保存父子关系，属于某个任务树的任务不归档，以免父任务的进度随之改变
+int DBManager::archiveCompletedTasks(const QDateTime &cutoff, int batchSize)
+{
+    static Histogram *const latency = operationLatency("archiveCompletedTasks");
+    MetricsTimer timer(latency);
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        qWarning() << "数据库未打开，无法归档任务";
+        return -1;
+    }
+
+    QSqlQuery query;
+    query.prepare(R"(
+        SELECT id FROM tasks
+        WHERE isCompleted = 1 AND COALESCE(completed_at, deadline) < :cutoff
+          AND parent_id IS NULL AND NOT EXISTS (SELECT 1 FROM tasks c WHERE c.parent_id = tasks.id)
+        LIMIT :limit
+    )");
+    query.bindValue(":cutoff", cutoff.toString("yyyy-MM-dd HH:mm"));
+    query.bindValue(":limit", batchSize);
+    if (!query.exec()) {
+        qCritical() << "查询待归档任务失败：" << query.lastError().text();
+        return -1;
+    }
+
+    QStringList ids;
+    while (query.next()) {
+        ids << QString::number(query.value(0).toInt());
+    }
+    if (ids.isEmpty()) {
+        return 0;
+    }
+
+    // ID来自上面的整数查询，可以直接拼入SQL
+    const QString idList = ids.join(',');
+    m_db.transaction();
+    bool ok = query.exec(QString(R"(
+        INSERT OR REPLACE INTO tasks_archive
+            (id, uuid, title, deadline, priority, isCompleted, description, description_z,
+             completed_at, archived_at, tags, created_at)
+        SELECT id, uuid, title, deadline, priority, isCompleted, description, description_z,
+               completed_at, strftime('%Y-%m-%d %H:%M', 'now', 'localtime'), %2, created_at
+        FROM tasks WHERE id IN (%1)
+    )").arg(idList, kTagsColumn))
+              && query.exec(QString("DELETE FROM tasks WHERE id IN (%1)").arg(idList))
+              // 与删除任务一样清理相关的依赖，依赖图中不会留下指向已归档任务的边
+              && query.exec(QString("DELETE FROM task_dependencies WHERE blocker_id IN (%1) OR blocked_id IN (%1)")
+                                .arg(idList));
+
+    if (!ok || !m_db.commit()) {
+        qCritical() << "归档任务失败：" << query.lastError().text();
+        m_db.rollback();
+        return -1;
+    }
+
+    qDebug() << "已归档" << ids.size() << "个已完成任务";
+    return ids.size();
+}
+
+// 按截止时间倒序分页读取归档任务（键集分页，翻页开销与归档总量无关）
+QList<Task> DBManager::getArchivedTasks(int limit, const QString &beforeDeadline, int beforeId) const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<Task> tasks;
+
+    if (!m_db.isOpen()) {
+        qWarning() << "数据库未打开，无法获取归档任务";
+        return tasks;
+    }
+
+    QSqlQuery query;
+    if (beforeDeadline.isEmpty()) {
+        query.prepare(QString("SELECT %1 FROM tasks_archive ORDER BY deadline DESC, id DESC LIMIT :limit")
+                          .arg(kArchiveColumns));
+    } else {
+        query.prepare(QString(R"(
+            SELECT %1 FROM tasks_archive
+            WHERE deadline < :deadline OR (deadline = :deadline2 AND id < :id)
+            ORDER BY deadline DESC, id DESC
+            LIMIT :limit
+        )").arg(kArchiveColumns));
+        query.bindValue(":deadline", beforeDeadline);
+        query.bindValue(":deadline2", beforeDeadline);
+        query.bindValue(":id", beforeId);
+    }
+    query.bindValue(":limit", limit);
+
+    if (!query.exec()) {
+        qCritical() << "获取归档任务失败：" << query.lastError().text();
+        return tasks;
+    }
+
+    while (query.next()) {
+        tasks.append(taskFromQuery(query));
+    }
+    return tasks;
+}
+
+// 记录当天当前的逾期任务数（逾期是状态而不是事件，定时采样，当天最后一次采样为准）
+bool DBManager::updateOverdueRollup()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) return false;
+
+    const QDateTime now = QDateTime::currentDateTime();
+    const QString day = now.toString("yyyy-MM-dd");
+    QSqlQuery query;
+    query.prepare("INSERT OR IGNORE INTO daily_stats (day) VALUES (:day)");
+    query.bindValue(":day", day);
+    bool ok = query.exec();
+    if (ok) {
+        query.prepare(R"(
+            UPDATE daily_stats
+            SET overdue = (SELECT COUNT(*) FROM tasks WHERE isCompleted = 0 AND deadline < :now)
+            WHERE day = :day
+        )");
+        query.bindValue(":now", now.toString("yyyy-MM-dd HH:mm"));
+        query.bindValue(":day", day);
+        ok = query.exec();
+    }
+    if (!ok) {
+        qWarning() << "更新逾期统计失败：" << query.lastError().text();
+    }
+    return ok;
+}
+
+// 按天读取汇总，from 无效时从最早一天开始
+QList<DailyStats> DBManager::getDailyStats(const QDate &from, const QDate &to) const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<DailyStats> stats;
+    if (!m_db.isOpen()) return stats;
+
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    query.prepare(R"(
+        SELECT day, created, completed, reopened, rescheduled, deleted, overdue,
+               lead_time_total, lead_time_count
+        FROM daily_stats
+        WHERE day >= :from AND day <= :to
+        ORDER BY day
+    )");
+    query.bindValue(":from", from.isValid() ? from.toString("yyyy-MM-dd") : QString(""));
+    query.bindValue(":to", to.toString("yyyy-MM-dd"));
+    if (!query.exec()) {
+        qCritical() << "读取每日统计失败：" << query.lastError().text();
+        return stats;
+    }
+
+    while (query.next()) {
+        DailyStats day;
+        day.day = QDate::fromString(query.value(0).toString(), "yyyy-MM-dd");
+        day.created = query.value(1).toInt();
+        day.completed = query.value(2).toInt();
+        day.reopened = query.value(3).toInt();
+        day.rescheduled = query.value(4).toInt();
+        day.deleted = query.value(5).toInt();
+        day.overdue = query.value(6).isNull() ? -1 : query.value(6).toInt();
+        day.leadTimeTotalSecs = query.value(7).toLongLong();
+        day.leadTimeCount = query.value(8).toInt();
+        stats.append(day);
+    }
+    return stats;
+}
+
+int DBManager::archivedTaskCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        return 0;
+    }
+
+    QSqlQuery query("SELECT COUNT(*) FROM tasks_archive");
+    return query.next() ? query.value(0).toInt() : 0;
+}
+
+bool DBManager::getDatabaseStats(DatabaseStats *stats) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        return false;
+    }
+
+    QSqlQuery query;
+    auto pragma = [&query](const char *name) -> qint64 {
+        query.exec(QString("PRAGMA %1").arg(name));
+        return query.next() ? query.value(0).toLongLong() : 0;
+    };
+    stats->pageSize = pragma("page_size");
+    stats->pageCount = pragma("page_count");
+    stats->freePages = pragma("freelist_count");
+    stats->autoVacuum = int(pragma("auto_vacuum"));
+    query.finish();
+    stats->fileBytes = QFileInfo(m_db.databaseName()).size();
+    return true;
+}
+
+// PRAGMA optimize 只为查询计划器认为统计信息过期的表执行 ANALYZE；
+// analysis_limit 让 ANALYZE 每个索引只抽样有限的行，耗时不再随表大小增长
+bool DBManager::optimizeDatabase(int analysisLimit)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        return false;
+    }
+
+    QSqlQuery query;
+    if (!query.exec(QString("PRAGMA analysis_limit = %1").arg(analysisLimit))
+        || !query.exec("PRAGMA optimize")) {
+        qWarning() << "PRAGMA optimize 失败：" << query.lastError().text();
+        return false;
+    }
+    while (query.next()) {}
+    return true;
+}
+
+// 把末尾最多 pages 个空闲页归还给文件系统（需 auto_vacuum=INCREMENTAL），持有写锁的时间与页数成正比
+int DBManager::incrementalVacuum(int pages)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        return -1;
+    }
+
+    QSqlQuery query;
+    query.exec("PRAGMA freelist_count");
+    qint64 before = query.next() ? query.value(0).toLongLong() : 0;
+
+    // 该PRAGMA每执行一步释放一页，而它不返回列，驱动可能只执行第一步；
+    // 因此在一个事务内反复执行直到达到目标，文件在提交时一次截断
+    const qint64 target = qMax<qint64>(0, before - pages);
+    qint64 current = before;
+    m_db.transaction();
+    while (current > target) {
+        if (!query.exec(QString("PRAGMA incremental_vacuum(%1)").arg(current - target))) {
+            qWarning() << "增量回收失败：" << query.lastError().text();
+            m_db.rollback();
+            return -1;
+        }
+        while (query.next()) {}
+        query.exec("PRAGMA freelist_count");
+        qint64 remaining = query.next() ? query.value(0).toLongLong() : current;
+        if (remaining >= current) break;   // 没有进展（如 auto_vacuum 未生效）
+        current = remaining;
+    }
+    query.finish();
+    if (!m_db.commit()) {
+        qWarning() << "增量回收提交失败：" << m_db.lastError().text();
+        m_db.rollback();
+        return -1;
+    }
+    return int(before - current);
+}
+
+// 需要统计信息的表：有索引的用户表
+QStringList DBManager::tablesToAnalyze() const
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList tables;
+    if (!m_db.isOpen()) {
+        return tables;
+    }
+
+    QSqlQuery query(R"(
+        SELECT DISTINCT tbl_name FROM sqlite_master
+        WHERE type = 'index' AND tbl_name NOT LIKE 'sqlite_%'
+        ORDER BY tbl_name
+    )");
+    while (query.next()) {
+        tables << query.value(0).toString();
+    }
+    return tables;
+}
+
+bool DBManager::analyzeTable(const QString &table, int analysisLimit)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        return false;
+    }
+
+    QSqlQuery query;
+    if (!query.exec(QString("PRAGMA analysis_limit = %1").arg(analysisLimit))
+        || !query.exec(QString("ANALYZE \"%1\"").arg(table))) {
+        qWarning() << "ANALYZE" << table << "失败：" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// 整库重建。auto_vacuum 模式只有重建后才会生效，旧数据库需要执行一次
+bool DBManager::vacuumDatabase()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        return false;
+    }
+
+    // VACUUM 要求连接上没有正在执行的语句
+    m_filterStatements.clear();
+    QSqlQuery query;
+    query.exec("PRAGMA auto_vacuum = INCREMENTAL");
+    if (!query.exec("VACUUM")) {
+        qWarning() << "VACUUM 失败：" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// 按需读取单个任务的描述（选中任务时调用）
+QString DBManager::getTaskDescription(int taskId) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen() || taskId == -1) {
+        return QString();
+    }
+
+    QSqlQuery query;
+    query.prepare("SELECT description, description_z FROM tasks WHERE id = :id");
+    query.bindValue(":id", taskId);
+    if (!query.exec()) {
+        qCritical() << "读取任务描述失败：" << query.lastError().text();
+        return QString();
+    }
+
+    return query.next() ? decodeDescription(query.value(0), query.value(1)) : QString();
+}
+
 // 按ID查任务
 Task DBManager::getTaskById(int taskId) const
 {
@@ -260,7 +1882,7 @@ Task DBManager::getTaskById(int taskId) const
     }
 
     QSqlQuery query;
-    query.prepare("SELECT * FROM tasks WHERE id = :id");
+    query.prepare(QString("SELECT %1, %2 FROM tasks WHERE id = :id").arg(kFullColumns, kTagsColumn));
     query.bindValue(":id", taskId);
 
     if (!query.exec()) {
@@ -269,12 +1891,7 @@ Task DBManager::getTaskById(int taskId) const
     }
 
     if (query.next()) {
-        task.id = query.value("id").toInt();
-        task.title = query.value("title").toString();
-        task.deadline = QDateTime::fromString(query.value("deadline").toString(), "yyyy-MM-dd HH:mm");
-        task.priority = query.value("priority").toInt();
-        task.isCompleted = query.value("isCompleted").toInt() == 1;
-        task.description = query.value("description").toString();
+        task = taskFromQuery(query, WithDescription | WithTags | WithParent);
         qDebug() << "查询到任务：" << task.title << "(ID:" << task.id << ")";
     } else {
         qDebug() << "未找到任务ID：" << taskId;
@@ -282,3 +1899,327 @@ Task DBManager::getTaskById(int taskId) const
 
     return task;
 }
+
+// 执行筛选表达式，返回匹配的任务ID（按截止时间排序）
+// 同一 WHERE 子句的预编译语句会被缓存，之后每次只重新绑定参数
+bool DBManager::queryTaskIds(const TaskFilter &filter, QVector<int> *ids) const
+{
+    static Histogram *const latency = operationLatency("queryTaskIds");
+    MetricsTimer timer(latency);
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen() || !filter.isValid()) {
+        return false;
+    }
+
+    const QString where = filter.isEmpty() ? QString("1") : filter.whereClause();
+    QSharedPointer<QSqlQuery> statement = m_filterStatements.value(where);
+    if (!statement) {
+        // 临时输入的表达式各不相同，缓存只保留有限条
+        if (m_filterStatements.size() >= kMaxCachedFilterStatements) {
+            m_filterStatements.clear();
+        }
+        statement.reset(new QSqlQuery);
+        statement->setForwardOnly(true);
+        if (!statement->prepare(QString("SELECT id FROM tasks WHERE %1 ORDER BY deadline ASC").arg(where))) {
+            qCritical() << "编译筛选条件失败：" << statement->lastError().text() << where;
+            return false;
+        }
+        m_filterStatements.insert(where, statement);
+    }
+
+    QSqlQuery &query = *statement;
+    const QVariantList values = filter.bindValues(QDateTime::currentDateTime());
+    for (int i = 0; i < values.size(); ++i) {
+        query.bindValue(QString(":f%1").arg(i), values.at(i));
+    }
+    if (!query.exec()) {
+        qCritical() << "执行筛选失败：" << query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        ids->append(query.value(0).toInt());
+    }
+    // 释放读锁，避免影响之后的写事务和 DETACH
+    query.finish();
+    return true;
+}
+
+bool DBManager::queryTaskIds(const TaskFilter &filter, const QList<int> &candidates, QVector<int> *ids) const
+{
+    // 每批的ID个数，远低于 SQLite 的语句长度限制
+    static const int kCandidateBatch = 500;
+    static Histogram *const latency = operationLatency("queryTaskIdsIn");
+    MetricsTimer timer(latency);
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen() || !filter.isValid()) {
+        return false;
+    }
+
+    // ID 由程序给出，直接写入语句；候选集合每次不同，不进预编译语句缓存
+    const QString where = filter.isEmpty() ? QString("1") : filter.whereClause();
+    const QVariantList values = filter.bindValues(QDateTime::currentDateTime());
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    for (int from = 0; from < candidates.size(); from += kCandidateBatch) {
+        QStringList batch;
+        for (int i = from; i < qMin(from + kCandidateBatch, candidates.size()); ++i) {
+            batch << QString::number(candidates.at(i));
+        }
+        if (!query.prepare(QString("SELECT id FROM tasks WHERE (%1) AND id IN (%2)").arg(where, batch.join(',')))) {
+            qCritical() << "编译筛选条件失败：" << query.lastError().text() << where;
+            return false;
+        }
+        for (int i = 0; i < values.size(); ++i) {
+            query.bindValue(QString(":f%1").arg(i), values.at(i));
+        }
+        if (!query.exec()) {
+            qCritical() << "执行筛选失败：" << query.lastError().text();
+            return false;
+        }
+        while (query.next()) {
+            ids->append(query.value(0).toInt());
+        }
+        query.finish();
+    }
+    return true;
+}
+
+QList<QPair<QString, QString>> DBManager::getSavedFilters() const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<QPair<QString, QString>> filters;
+    if (!m_db.isOpen()) {
+        return filters;
+    }
+
+    QSqlQuery query("SELECT name, expression FROM saved_filters ORDER BY name");
+    while (query.next()) {
+        filters.append(qMakePair(query.value(0).toString(), query.value(1).toString()));
+    }
+    return filters;
+}
+
+bool DBManager::saveFilter(const QString &name, const QString &expression)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        qWarning() << "数据库未打开，无法保存筛选";
+        return false;
+    }
+
+    QSqlQuery query;
+    query.prepare("INSERT OR REPLACE INTO saved_filters (name, expression) VALUES (:name, :expression)");
+    query.bindValue(":name", name);
+    query.bindValue(":expression", expression);
+    if (!query.exec()) {
+        qCritical() << "保存筛选失败：" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool DBManager::deleteSavedFilter(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        return false;
+    }
+
+    QSqlQuery query;
+    query.prepare("DELETE FROM saved_filters WHERE name = :name");
+    query.bindValue(":name", name);
+    if (!query.exec()) {
+        qCritical() << "删除筛选失败：" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// 添加任务依赖（环检测由调用方在内存依赖图中完成）
+bool DBManager::addDependency(int blockerId, int blockedId)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        qWarning() << "数据库未打开，无法添加依赖";
+        return false;
+    }
+
+    if (blockerId == -1 || blockedId == -1 || blockerId == blockedId) {
+        qWarning() << "无效的依赖：" << blockerId << "->" << blockedId;
+        return false;
+    }
+
+    QSqlQuery query;
+    query.prepare(R"(
+        INSERT OR IGNORE INTO task_dependencies (blocker_id, blocked_id)
+        VALUES (:blocker, :blocked)
+    )");
+    query.bindValue(":blocker", blockerId);
+    query.bindValue(":blocked", blockedId);
+
+    if (!query.exec()) {
+        qCritical() << "添加依赖失败：" << query.lastError().text();
+        return false;
+    }
+
+    qDebug() << "添加依赖成功：" << blockerId << "->" << blockedId;
+    return true;
+}
+
+// 删除任务依赖
+bool DBManager::removeDependency(int blockerId, int blockedId)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_db.isOpen()) {
+        qWarning() << "数据库未打开，无法删除依赖";
+        return false;
+    }
+
+    QSqlQuery query;
+    query.prepare("DELETE FROM task_dependencies WHERE blocker_id = :blocker AND blocked_id = :blocked");
+    query.bindValue(":blocker", blockerId);
+    query.bindValue(":blocked", blockedId);
+
+    if (!query.exec()) {
+        qCritical() << "删除依赖失败：" << query.lastError().text();
+        return false;
+    }
+
+    qDebug() << "删除依赖成功：" << blockerId << "->" << blockedId;
+    return true;
+}
+
+// 获取所有依赖
+QList<QPair<int, int>> DBManager::getAllDependencies() const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<QPair<int, int>> dependencies;
+
+    if (!m_db.isOpen()) {
+        qWarning() << "数据库未打开，无法获取依赖";
+        return dependencies;
+    }
+
+    QSqlQuery query("SELECT blocker_id, blocked_id FROM task_dependencies");
+
+    while (query.next()) {
+        dependencies.append(qMakePair(query.value(0).toInt(), query.value(1).toInt()));
+    }
+
+    qDebug() << "获取到" << dependencies.size() << "条依赖";
+    return dependencies;
+}
+
+// 按 (deadline, id) 键集分页读取 parentId 的直接子任务（-1 为顶层任务）及其子树汇总。
+// 只读一层：展开有上千个子任务的节点时只读取当前一页，不涉及其他分支
+QList<QPair<Task, TaskRollup>> DBManager::getChildTasks(int parentId, int limit, const QString &afterDeadline,
+                                                        int afterId) const
+{
+    static Histogram *const latency = operationLatency("getChildTasks");
+    MetricsTimer timer(latency);
+    QMutexLocker locker(&m_mutex);
+    QList<QPair<Task, TaskRollup>> children;
+
+    if (!m_db.isOpen()) {
+        qWarning() << "数据库未打开，无法获取子任务";
+        return children;
+    }
+
+    const bool firstPage = isFirstPage(afterDeadline, afterId);
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    query.prepare(QString(R"(
+        SELECT %1, %2, %3 FROM tasks
+        LEFT JOIN task_rollups r ON r.task_id = tasks.id
+        WHERE %4 AND %5
+        ORDER BY deadline ASC, id ASC
+        LIMIT :limit
+    )").arg(kListColumns, kTagsColumn, kRollupColumns,
+            parentId == -1 ? "parent_id IS NULL" : "parent_id = :parent",
+            firstPage ? "1" : "(deadline, id) > (:deadline, :id)"));
+    if (parentId != -1) {
+        query.bindValue(":parent", parentId);
+    }
+    if (!firstPage) {
+        query.bindValue(":deadline", deadlineCursor(afterDeadline));
+        query.bindValue(":id", afterId);
+    }
+    query.bindValue(":limit", limit);
+
+    if (!query.exec()) {
+        qCritical() << "获取子任务失败：" << query.lastError().text();
+        return children;
+    }
+
+    while (query.next()) {
+        children.append(qMakePair(taskFromQuery(query, WithTags | WithParent), rollupFromQuery(query)));
+    }
+    return children;
+}
+
+// 读取一组任务的子树汇总；没有子任务的任务不在结果中
+QHash<int, TaskRollup> DBManager::getRollups(const QList<int> &taskIds) const
+{
+    QMutexLocker locker(&m_mutex);
+    QHash<int, TaskRollup> rollups;
+
+    if (!m_db.isOpen() || taskIds.isEmpty()) {
+        return rollups;
+    }
+
+    // ID为整数，可以直接拼入SQL
+    QStringList ids;
+    ids.reserve(taskIds.size());
+    for (int taskId : taskIds) {
+        ids << QString::number(taskId);
+    }
+
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    if (!query.exec(QString("SELECT task_id, %1 FROM task_rollups r WHERE task_id IN (%2)")
+                        .arg(kRollupColumns, ids.join(',')))) {
+        qCritical() << "获取子任务汇总失败：" << query.lastError().text();
+        return rollups;
+    }
+
+    while (query.next()) {
+        rollups.insert(query.value("task_id").toInt(), rollupFromQuery(query));
+    }
+    return rollups;
+}
+
+// 一组任务的全部后代（不含这些任务本身），用于选择父任务时排除会成环的候选
+QList<int> DBManager::getDescendantIds(const QList<int> &taskIds) const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<int> descendants;
+
+    if (!m_db.isOpen() || taskIds.isEmpty()) {
+        return descendants;
+    }
+
+    QStringList ids;
+    ids.reserve(taskIds.size());
+    for (int taskId : taskIds) {
+        ids << QString::number(taskId);
+    }
+
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    if (!query.exec(QString(R"(
+        WITH RECURSIVE subtree(id) AS (
+            SELECT id FROM tasks WHERE parent_id IN (%1)
+            UNION
+            SELECT t.id FROM tasks t JOIN subtree s ON t.parent_id = s.id
+        )
+        SELECT id FROM subtree
+    )").arg(ids.join(',')))) {
+        qCritical() << "获取后代任务失败：" << query.lastError().text();
+        return descendants;
+    }
+
+    while (query.next()) {
+        descendants.append(query.value(0).toInt());
+    }
+    return descendants;
+}
@@ -6,8 +6,40 @@
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QList>
+#include <QPair>
 #include <QMutex>
+#include <QHash>
+#include <QSharedPointer>
+#include <QVector>
+#include <QDate>
 #include "task.h"
+#include "slowquerylog.h"
+
+class TaskFilter;
+
+// 一天的任务事件汇总（daily_stats 表的一行）
+struct DailyStats {
+    QDate day;
+    int created = 0;
+    int completed = 0;
+    int reopened = 0;
+    int rescheduled = 0;
+    int deleted = 0;
+    int overdue = -1;               // 当天最后一次采样的逾期任务数，-1 表示未采样
+    qint64 leadTimeTotalSecs = 0;   // 当天完成的任务从创建到完成的总用时
+    int leadTimeCount = 0;
+};
+
+// 数据库文件的空间使用情况
+struct DatabaseStats {
+    qint64 fileBytes = 0;
+    qint64 pageSize = 0;
+    qint64 pageCount = 0;
+    qint64 freePages = 0;           // 空闲页（已删除数据留下的空洞）
+    int autoVacuum = 0;             // 0=NONE 1=FULL 2=INCREMENTAL
+
+    double freeRatio() const { return pageCount > 0 ? double(freePages) / pageCount : 0.0; }
+};
 
 class DBManager : public QObject
 {
@@ -17,24 +49,114 @@ public:
     ~DBManager() override;
 
     bool initDatabase();
+    bool upgradeSchema(QString *error);
     bool addTask(const Task& task);
     bool updateTask(const Task& task);
+    bool updateTasks(const QList<Task> &tasks, QString *error = nullptr);
+    bool updateCompletion(const QList<QPair<int, bool>> &states, QString *error = nullptr);
     bool deleteTask(int taskId);
-    QList<Task> getAllTasks() const;
+    bool deleteTasks(const QList<int> &taskIds, QString *error = nullptr);
+    QList<Task> getAllTasks(bool withDescriptions = false) const;
     Task getTaskById(int taskId) const;
+    QString getTaskDescription(int taskId) const;
+
+    // 外部修改检测与增量读取
+    int dataVersion() const;
+    qint64 currentRowVersion() const;
+    bool getChangesSince(qint64 sinceVersion, QList<Task> *changed,
+                         QList<int> *deletedIds, qint64 *newVersion) const;
+
+    // 归档：已完成的旧任务移入 tasks_archive
+    int archiveCompletedTasks(const QDateTime &cutoff, int batchSize);
+    QList<Task> getArchivedTasks(int limit, const QString &beforeDeadline = QString(), int beforeId = -1) const;
+    int archivedTaskCount() const;
+
+    // 事件日志的按天汇总
+    bool updateOverdueRollup();
+    QList<DailyStats> getDailyStats(const QDate &from, const QDate &to) const;
+
+    // 空闲维护：每个调用只执行一小步，由调用方控制节奏
+    bool getDatabaseStats(DatabaseStats *stats) const;
+    bool optimizeDatabase(int analysisLimit);
+    int incrementalVacuum(int pages);           // 返回释放的页数，-1表示失败
+    QStringList tablesToAnalyze() const;
+    bool analyzeTable(const QString &table, int analysisLimit);
+    bool vacuumDatabase();                      // 整库重建，只在库很小时使用
+
+    // 近似重复：按 SimHash 指纹分段查找候选，返回 (任务ID, 汉明距离)
+    QList<QPair<int, int>> findNearDuplicates(quint64 fingerprint, int excludeId, int maxDistance) const;
+    bool mergeTasks(int keepId, const QList<int> &mergedIds,
+                    const QList<QPair<int, int>> &edges, QString *error = nullptr);
+
+    // 任务依赖（blockerId 阻塞 blockedId）
+    bool addDependency(int blockerId, int blockedId);
+    bool removeDependency(int blockerId, int blockedId);
+    QList<QPair<int, int>> getAllDependencies() const;
+
+    // 子任务（parent_id 树）：逐层分页读取，进度等汇总由触发器维护
+    QList<QPair<Task, TaskRollup>> getChildTasks(int parentId, int limit, const QString &afterDeadline = QString(),
+                                                 int afterId = -1) const;
+    QHash<int, TaskRollup> getRollups(const QList<int> &taskIds) const;
+    QList<int> getDescendantIds(const QList<int> &taskIds) const;
+
+    // 筛选表达式与保存的命名筛选
+    bool queryTaskIds(const TaskFilter &filter, QVector<int> *ids) const;
+    // 只在 candidates 中求值，用于少量任务修改后增量更新筛选结果
+    bool queryTaskIds(const TaskFilter &filter, const QList<int> &candidates, QVector<int> *ids) const;
+    QList<QPair<QString, QString>> getSavedFilters() const;
+    bool saveFilter(const QString &name, const QString &expression);
+    bool deleteSavedFilter(const QString &name);
+
     bool isDatabaseOpen() const { return m_db.isOpen(); }
+    // Qt 的 SQLite 驱动与程序链接的 sqlite3 是同一份库时，才能用 C API 打开正在使用的数据库文件
+    bool sqliteApiUsable() const { return m_sqliteApiUsable; }
+    // 主连接上超过阈值的语句及其查询计划
+    SlowQueryLog *slowQueryLog() const { return m_slowQueryLog; }
+
+    // 与另一个数据库文件（共享盘、U盘等）交换自上次同步以来的变更；使用独立连接，界面应在后台线程调用
+    bool syncWithDatabase(const QString &peerPath, QString *summary = nullptr);
+    QString replicaId() const { return m_replicaId; }
+
+    static bool sameSqliteLibrary(const QSqlDatabase &db, QString *error = nullptr);
+    static bool createTables(QSqlQuery &query, const QString &schema);
+    static bool ensureColumn(QSqlQuery &query, const QString &schema, const QString &table,
+                             const QString &column, const QString &definition);
+    static QString loadReplicaId(QSqlQuery &query, const QString &schema);
+    static void encodeDescription(const QString &text, QVariant *plain, QVariant *compressed);
+    static bool compressDescriptions(QSqlQuery &query, qint64 fromId, qint64 toId);
+    static QString decodeDescription(const QVariant &plain, const QVariant &compressed);
+    static bool writeTaskTags(QSqlQuery &query, const QString &schema, int taskId, const QStringList &tags);
+    static QStringList splitTags(const QString &joined);
+    static bool writeFingerprint(QSqlQuery &query, int taskId, quint64 fingerprint);
+    static bool fetchTaskPage(QSqlQuery &query, int limit, bool withDescriptions,
+                              QString *afterDeadline, int *afterId, QList<Task> *tasks);
 
     // 设置数据库路径
     void setDatabasePath(const QString& path);
     QString getDatabasePath() const { return m_db.databaseName(); }
 
+private slots:
+    void explainSlowQueries();
+
 private:
     explicit DBManager(QObject *parent = nullptr);
 
+    qint64 nextStamp();
+    bool writeTaskUpdate(QSqlQuery &query, const Task &task, QString *error);
+    bool writeTaskDelete(QSqlQuery &query, int taskId, QString *error);
+    bool logChange(QSqlQuery &query, const QString &uuid, const QString &field,
+                   const QVariant &value, qint64 stamp);
+    bool sealLocalChanges(QSqlQuery &query);
+
     static DBManager* m_instance;
     static QMutex m_instanceMutex;
     QSqlDatabase m_db;
     mutable QMutex m_mutex;
+    QString m_replicaId;
+    SlowQueryLog *m_slowQueryLog;
+    bool m_sqliteApiUsable = false;
+    qint64 m_lastStamp = 0;
+    mutable QHash<QString, QSharedPointer<QSqlQuery>> m_filterStatements;   // WHERE子句 -> 预编译语句
 };
 
 #endif // DBMANAGER_H
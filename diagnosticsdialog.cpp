@@ -0,0 +1,180 @@
+#include "diagnosticsdialog.h"
+#include "metrics.h"
+#include "metricsexporter.h"
+#include "dbmanager.h"
+#include <QApplication>
+#include <QClipboard>
+#include <QDialogButtonBox>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLocale>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace {
+enum Column {
+    ColumnName = 0,
+    ColumnValue,
+    ColumnMean,
+    ColumnP50,
+    ColumnP90,
+    ColumnP99,
+    ColumnMax,
+    ColumnCount
+};
+}
+
+DiagnosticsDialog::DiagnosticsDialog(MetricsExporter *exporter, QWidget *parent)
+    : QDialog(parent)
+    , m_exporter(exporter)
+{
+    setWindowTitle("运行诊断");
+    resize(860, 520);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    m_tree = new QTreeWidget(this);
+    m_tree->setColumnCount(ColumnCount);
+    m_tree->setHeaderLabels({"指标", "值 / 次数", "平均", "p50", "p90", "p99", "最大"});
+    m_tree->header()->setSectionResizeMode(ColumnName, QHeaderView::Stretch);
+    m_tree->header()->setStretchLastSection(false);
+    m_tree->setUniformRowHeights(true);
+    layout->addWidget(m_tree, 1);
+
+    m_fileLabel = new QLabel(this);
+    m_fileLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    layout->addWidget(m_fileLabel);
+
+    // 慢语句日志：超过阈值的语句连同查询计划保存在内存中，需要时导出
+    QHBoxLayout *slowLayout = new QHBoxLayout;
+    m_thresholdSpin = new QSpinBox(this);
+    m_thresholdSpin->setRange(0, 60 * 1000);
+    m_thresholdSpin->setSuffix(" ms");
+    m_thresholdSpin->setValue(DBManager::instance()->slowQueryLog()->thresholdMs());
+    m_thresholdSpin->setEnabled(DBManager::instance()->slowQueryLog()->isAttached());
+    m_slowQueryLabel = new QLabel(this);
+    QPushButton *dumpButton = new QPushButton("导出慢语句日志...", this);
+    slowLayout->addWidget(new QLabel("慢语句阈值：", this));
+    slowLayout->addWidget(m_thresholdSpin);
+    slowLayout->addWidget(m_slowQueryLabel, 1);
+    slowLayout->addWidget(dumpButton);
+    layout->addLayout(slowLayout);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    QPushButton *writeButton = new QPushButton("立即写入指标文件", this);
+    writeButton->setEnabled(m_exporter != nullptr);
+    QPushButton *copyButton = new QPushButton("复制为 Prometheus 文本", this);
+    buttonLayout->addWidget(writeButton);
+    buttonLayout->addWidget(copyButton);
+    buttonLayout->addStretch();
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    buttonLayout->addWidget(buttons);
+    layout->addLayout(buttonLayout);
+
+    connect(writeButton, &QPushButton::clicked, this, &DiagnosticsDialog::writeFile);
+    connect(copyButton, &QPushButton::clicked, this, &DiagnosticsDialog::copyText);
+    connect(dumpButton, &QPushButton::clicked, this, &DiagnosticsDialog::dumpSlowQueries);
+    connect(m_thresholdSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, [](int ms) {
+        DBManager::instance()->slowQueryLog()->setThresholdMs(ms);
+    });
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(&m_timer, &QTimer::timeout, this, &DiagnosticsDialog::reload);
+
+    if (m_exporter) {
+        m_fileLabel->setText(m_exporter->intervalSecs() > 0
+                                 ? QString("每 %1 秒写入：%2").arg(m_exporter->intervalSecs()).arg(m_exporter->filePath())
+                                 : QString("未开启定时写入（metrics/intervalSecs 为 0）"));
+    }
+
+    reload();
+    m_tree->expandAll();
+    for (int column = ColumnValue; column < ColumnCount; ++column) {
+        m_tree->resizeColumnToContents(column);
+    }
+    m_timer.start(1000);
+}
+
+// 同一族有多个标签时作为父节点的子项显示
+QTreeWidgetItem *DiagnosticsDialog::itemFor(const QString &name, const QString &labels, const QString &help)
+{
+    const QString key = name + '{' + labels + '}';
+    QTreeWidgetItem *item = m_items.value(key);
+    if (item) return item;
+
+    if (labels.isEmpty()) {
+        item = new QTreeWidgetItem(m_tree, {name});
+    } else {
+        QTreeWidgetItem *family = m_items.value(name);
+        if (!family) {
+            family = new QTreeWidgetItem(m_tree, {name});
+            family->setToolTip(ColumnName, help);
+            family->setExpanded(true);
+            m_items.insert(name, family);
+        }
+        item = new QTreeWidgetItem(family, {labels});
+    }
+    item->setToolTip(ColumnName, help);
+    for (int column = ColumnValue; column < ColumnCount; ++column) {
+        item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+    }
+    m_items.insert(key, item);
+    return item;
+}
+
+void DiagnosticsDialog::reload()
+{
+    const QLocale locale;
+    SlowQueryLog *slowQueries = DBManager::instance()->slowQueryLog();
+    m_slowQueryLabel->setText(slowQueries->isAttached()
+                                  ? QString("已记录 %1 条（保留最近 %2 条）").arg(slowQueries->size()).arg(slowQueries->capacity())
+                                  : "慢语句日志不可用：" + slowQueries->unavailableReason());
+    for (const Metrics::Sample &sample : Metrics::samples()) {
+        QTreeWidgetItem *item = itemFor(sample.name, sample.labels, sample.help);
+        if (sample.type != Metrics::HistogramType) {
+            const bool bytes = sample.name.endsWith("_bytes");
+            item->setText(ColumnValue, bytes ? locale.formattedDataSize(sample.value) : locale.toString(sample.value));
+            continue;
+        }
+
+        const Histogram::Summary &summary = sample.summary;
+        item->setText(ColumnValue, locale.toString(summary.count));
+        if (summary.count == 0) continue;
+        item->setText(ColumnMean, Metrics::formatMicros(summary.sumMicros / summary.count));
+        item->setText(ColumnP50, Metrics::formatMicros(summary.p50Micros));
+        item->setText(ColumnP90, Metrics::formatMicros(summary.p90Micros));
+        item->setText(ColumnP99, Metrics::formatMicros(summary.p99Micros));
+        item->setText(ColumnMax, Metrics::formatMicros(summary.maxMicros));
+    }
+}
+
+void DiagnosticsDialog::writeFile()
+{
+    QString error;
+    if (m_exporter->writeNow(&error)) {
+        m_fileLabel->setText("已写入：" + m_exporter->filePath());
+    } else {
+        m_fileLabel->setText(QString("写入 %1 失败：%2").arg(m_exporter->filePath(), error));
+    }
+}
+
+void DiagnosticsDialog::dumpSlowQueries()
+{
+    QString path = QFileDialog::getSaveFileName(this, "导出慢语句日志", "slow-queries.txt", "文本文件 (*.txt)");
+    if (path.isEmpty()) return;
+
+    QString error;
+    if (DBManager::instance()->slowQueryLog()->dump(path, &error)) {
+        m_fileLabel->setText("慢语句日志已导出：" + path);
+    } else {
+        m_fileLabel->setText(QString("导出 %1 失败：%2").arg(path, error));
+    }
+}
+
+void DiagnosticsDialog::copyText()
+{
+    QApplication::clipboard()->setText(Metrics::toPrometheusText());
+    m_fileLabel->setText("已复制到剪贴板");
+}
@@ -0,0 +1,40 @@
+#ifndef DIAGNOSTICSDIALOG_H
+#define DIAGNOSTICSDIALOG_H
+
+#include <QDialog>
+#include <QHash>
+#include <QTimer>
+
+class QLabel;
+class QSpinBox;
+class QTreeWidget;
+class QTreeWidgetItem;
+class MetricsExporter;
+
+// 运行指标：计数器、仪表的当前值和各耗时直方图的次数、分位数，打开期间每秒刷新；
+// 另可调整慢语句阈值并把慢语句日志导出到文件
+class DiagnosticsDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit DiagnosticsDialog(MetricsExporter *exporter, QWidget *parent = nullptr);
+
+private slots:
+    void reload();
+    void writeFile();
+    void copyText();
+    void dumpSlowQueries();
+
+private:
+    QTreeWidgetItem *itemFor(const QString &name, const QString &labels, const QString &help);
+
+    MetricsExporter *m_exporter;
+    QTreeWidget *m_tree;
+    QLabel *m_fileLabel;
+    QLabel *m_slowQueryLabel;
+    QSpinBox *m_thresholdSpin;
+    QTimer m_timer;
+    QHash<QString, QTreeWidgetItem *> m_items;     // 按"名称{标签}"原地更新，保留展开状态
+};
+
+#endif // DIAGNOSTICSDIALOG_H
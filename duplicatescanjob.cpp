@@ -0,0 +1,200 @@
+#include "duplicatescanjob.h"
+#include "dbmanager.h"
+#include "simhash.h"
+#include <QDebug>
+#include <QFuture>
+#include <QPair>
+#include <QQueue>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThreadPool>
+#include <QVariant>
+#include <QtConcurrent>
+
+namespace {
+const int kPageSize = 5000;     // 每次读取并作为一个分块计算指纹的任务数
+
+struct ScanRow {
+    int id = -1;
+    QString title;
+    QVariant description;       // 原始列，解压在线程池中进行
+    QVariant descriptionZ;
+    bool hasStored = false;
+    quint64 stored = 0;
+};
+
+struct ScanChunk {
+    QVector<QPair<int, quint64>> fingerprints;
+    QVector<QPair<int, quint64>> stale;     // 需要写回的指纹
+};
+
+ScanChunk computeChunk(const QVector<ScanRow> &rows)
+{
+    ScanChunk chunk;
+    chunk.fingerprints.reserve(rows.size());
+    for (const ScanRow &row : rows) {
+        QString description = DBManager::decodeDescription(row.description, row.descriptionZ);
+        quint64 fingerprint = SimHash::compute(row.title, description);
+        chunk.fingerprints.append(qMakePair(row.id, fingerprint));
+        if (!row.hasStored || row.stored != fingerprint) {
+            chunk.stale.append(qMakePair(row.id, fingerprint));
+        }
+    }
+    return chunk;
+}
+}
+
+DuplicateScanJob::DuplicateScanJob(int maxDistance, QObject *parent)
+    : QThread(parent)
+    , m_maxDistance(maxDistance)
+    , m_databasePath(DBManager::instance()->getDatabasePath())
+{
+}
+
+DuplicateScanJob::~DuplicateScanJob()
+{
+    cancel();
+    wait();
+}
+
+void DuplicateScanJob::cancel()
+{
+    m_cancelled.storeRelaxed(1);
+}
+
+void DuplicateScanJob::run()
+{
+    qDebug() << "查重线程开始，最大距离：" << m_maxDistance;
+
+    QString connectionName = QString("duplicates_%1").arg(quintptr(this));
+    qint64 scanned = 0;
+    int updated = 0;
+    QString error;
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(m_databasePath);
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+        if (db.open()) {
+            ok = scanAll(db, &scanned, &updated, &error);
+            db.close();
+        } else {
+            error = "无法打开数据库：" + db.lastError().text();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    if (m_cancelled.loadRelaxed()) {
+        emit scanFinished(false, "查重已取消");
+    } else if (ok) {
+        qDebug() << "查重完成：" << scanned << "个任务，更新指纹" << updated << "个，" << m_groups.size() << "组";
+        QString message = QString("已检查 %1 个任务，发现 %2 组相似任务").arg(scanned).arg(m_groups.size());
+        if (m_truncatedBuckets > 0) {
+            message += QString("\n有 %1 个分桶中相近的任务过多，只比较了其中一部分，可能还有未发现的相似任务")
+                           .arg(m_truncatedBuckets);
+        }
+        emit scanFinished(true, message);
+    } else {
+        qWarning() << "查重失败：" << error;
+        emit scanFinished(false, error);
+    }
+}
+
+bool DuplicateScanJob::scanAll(const QSqlDatabase &db, qint64 *scanned, int *updated, QString *error)
+{
+    QSqlQuery query(db);
+
+    qint64 total = 0;
+    if (query.exec("SELECT COUNT(*) FROM tasks") && query.next()) {
+        total = query.value(0).toLongLong();
+    }
+    query.finish();
+
+    QVector<QPair<int, quint64>> fingerprints;
+    fingerprints.reserve(int(total));
+
+    // 计算在线程池中进行，写回按提交顺序在本线程进行；排队的分块数有上限
+    const int maxPending = qMax(2, QThread::idealThreadCount() * 2);
+    QQueue<QFuture<ScanChunk>> pending;
+    bool ok = true;
+
+    auto collectOldest = [&]() {
+        ScanChunk chunk = pending.dequeue().result();
+        fingerprints += chunk.fingerprints;
+        if (!ok || chunk.stale.isEmpty()) return;
+
+        if (!query.exec("BEGIN IMMEDIATE")) {
+            *error = "无法开始写入指纹：" + query.lastError().text();
+            ok = false;
+            return;
+        }
+        for (const auto &item : chunk.stale) {
+            if (!DBManager::writeFingerprint(query, item.first, item.second)) {
+                *error = "写入指纹失败：" + query.lastError().text();
+                query.exec("ROLLBACK");
+                ok = false;
+                return;
+            }
+        }
+        if (!query.exec("COMMIT")) {
+            *error = "写入指纹失败：" + query.lastError().text();
+            query.exec("ROLLBACK");
+            ok = false;
+            return;
+        }
+        *updated += chunk.stale.size();
+    };
+
+    int afterId = 0;
+    while (ok && !m_cancelled.loadRelaxed()) {
+        query.prepare(R"(
+            SELECT t.id, t.title, t.description, t.description_z, f.simhash
+            FROM tasks t LEFT JOIN task_fingerprints f ON f.task_id = t.id
+            WHERE t.id > :after
+            ORDER BY t.id
+            LIMIT :limit
+        )");
+        query.bindValue(":after", afterId);
+        query.bindValue(":limit", kPageSize);
+        if (!query.exec()) {
+            *error = "读取任务失败：" + query.lastError().text();
+            ok = false;
+            break;
+        }
+
+        QVector<ScanRow> rows;
+        rows.reserve(kPageSize);
+        while (query.next()) {
+            ScanRow row;
+            row.id = query.value(0).toInt();
+            row.title = query.value(1).toString();
+            row.description = query.value(2);
+            row.descriptionZ = query.value(3);
+            row.hasStored = !query.value(4).isNull();
+            row.stored = quint64(query.value(4).toLongLong());
+            rows.append(row);
+        }
+        query.finish();
+        if (rows.isEmpty()) break;
+        afterId = rows.last().id;
+
+        pending.enqueue(QtConcurrent::run(QThreadPool::globalInstance(), [rows]() {
+            return computeChunk(rows);
+        }));
+        *scanned += rows.size();
+
+        while (pending.size() >= maxPending) {
+            collectOldest();
+        }
+        emit progress(*scanned, qMax(total, *scanned));
+    }
+
+    while (!pending.isEmpty()) {
+        collectOldest();
+    }
+
+    if (!ok || m_cancelled.loadRelaxed()) return false;
+
+    m_groups = SimHash::findGroups(fingerprints, m_maxDistance, &m_truncatedBuckets);
+    return true;
+}
@@ -0,0 +1,43 @@
+#ifndef DUPLICATESCANJOB_H
+#define DUPLICATESCANJOB_H
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QList>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVector>
+
+// 后台全库查重
+// 使用独立的数据库连接按 id 分页读取任务，每页交给全局线程池并行计算 SimHash 指纹，
+// 与已保存的指纹不一致（其他进程或同步改过的任务、旧版本建的任务）时顺带写回。
+// 全部指纹读完后按16位分段分桶聚类，只比较同桶的指纹，百万级任务也无需两两比较。
+class DuplicateScanJob : public QThread
+{
+    Q_OBJECT
+public:
+    explicit DuplicateScanJob(int maxDistance, QObject *parent = nullptr);
+    ~DuplicateScanJob() override;
+
+    void cancel();
+    // 扫描结束后有效：每组为若干相似任务的ID
+    QList<QVector<int>> groups() const { return m_groups; }
+
+signals:
+    void progress(qint64 done, qint64 total);
+    void scanFinished(bool ok, const QString &message);
+
+protected:
+    void run() override;
+
+private:
+    bool scanAll(const QSqlDatabase &db, qint64 *scanned, int *updated, QString *error);
+
+    int m_maxDistance;
+    QString m_databasePath;
+    QAtomicInt m_cancelled;
+    QList<QVector<int>> m_groups;
+    int m_truncatedBuckets = 0;         // 查重时只比较了部分指纹的分桶数
+};
+
+#endif // DUPLICATESCANJOB_H
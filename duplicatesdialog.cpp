@@ -0,0 +1,168 @@
+#include "duplicatesdialog.h"
+#include "duplicatescanjob.h"
+#include "simhash.h"
+#include "taskmodel.h"
+#include <QDialogButtonBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace {
+const int kMaxShownGroups = 2000;   // 列表中最多显示的组数，合并后可重新扫描
+const int kTaskIdRole = Qt::UserRole + 1;
+}
+
+DuplicatesDialog::DuplicatesDialog(TaskModel *model, QWidget *parent)
+    : QDialog(parent)
+    , m_model(model)
+{
+    setWindowTitle("查找重复任务");
+    resize(720, 520);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    m_statusLabel = new QLabel(this);
+    layout->addWidget(m_statusLabel);
+    m_progressBar = new QProgressBar(this);
+    layout->addWidget(m_progressBar);
+
+    m_tree = new QTreeWidget(this);
+    m_tree->setHeaderLabels({"标题", "截止时间", "优先级", "状态"});
+    m_tree->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    layout->addWidget(m_tree, 1);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    m_rescanButton = new QPushButton("重新扫描", this);
+    m_mergeButton = new QPushButton("合并该组", this);
+    m_mergeButton->setToolTip("组内其他任务并入选中的任务（未选中任务时并入第一个），标签取并集，优先级取最高");
+    buttonLayout->addWidget(m_rescanButton);
+    buttonLayout->addWidget(m_mergeButton);
+    buttonLayout->addStretch();
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    buttonLayout->addWidget(buttons);
+    layout->addLayout(buttonLayout);
+
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(m_rescanButton, &QPushButton::clicked, this, &DuplicatesDialog::startScan);
+    connect(m_mergeButton, &QPushButton::clicked, this, &DuplicatesDialog::mergeCurrentGroup);
+    connect(m_tree, &QTreeWidget::currentItemChanged, this, &DuplicatesDialog::updateButtons);
+    connect(m_tree, &QTreeWidget::itemDoubleClicked, this, [this](QTreeWidgetItem *item) {
+        int taskId = item->data(0, kTaskIdRole).toInt();
+        if (taskId > 0) emit taskActivated(taskId);
+    });
+
+    startScan();
+}
+
+DuplicatesDialog::~DuplicatesDialog()
+{
+    // 任务线程的析构会取消并等待扫描结束
+    delete m_job;
+}
+
+void DuplicatesDialog::startScan()
+{
+    if (m_job) return;
+
+    m_model->flushPendingWrites();
+    m_tree->clear();
+    m_statusLabel->setText("正在扫描...");
+    m_progressBar->setRange(0, 0);
+    m_progressBar->show();
+
+    m_job = new DuplicateScanJob(SimHash::kDefaultMaxDistance);
+    connect(m_job, &DuplicateScanJob::progress, this, [this](qint64 done, qint64 total) {
+        m_progressBar->setRange(0, 100);
+        m_progressBar->setValue(total > 0 ? int(done * 100 / total) : 0);
+        m_statusLabel->setText(QString("正在扫描... %1 / %2").arg(done).arg(total));
+    });
+    connect(m_job, &DuplicateScanJob::scanFinished, this, &DuplicatesDialog::onScanFinished);
+    m_job->start();
+    updateButtons();
+}
+
+void DuplicatesDialog::onScanFinished(bool ok, const QString &message)
+{
+    const QList<QVector<int>> groups = m_job->groups();
+    m_job->wait();
+    delete m_job;
+    m_job = nullptr;
+
+    m_progressBar->hide();
+    m_statusLabel->setText(message);
+    if (!ok) {
+        updateButtons();
+        return;
+    }
+
+    static const QStringList priorities = {"低", "中", "高"};
+    int shown = 0;
+    for (const QVector<int> &group : groups) {
+        if (shown >= kMaxShownGroups) break;
+
+        // 扫描期间被删除或归档的任务不再列出
+        QList<Task> tasks;
+        for (int taskId : group) {
+            Task task = m_model->getTaskById(taskId);
+            if (task.id != -1) tasks.append(task);
+        }
+        if (tasks.size() < 2) continue;
+
+        QTreeWidgetItem *groupItem = new QTreeWidgetItem(m_tree);
+        groupItem->setText(0, QString("%1（%2 个）").arg(tasks.first().title).arg(tasks.size()));
+        for (const Task &task : tasks) {
+            QTreeWidgetItem *item = new QTreeWidgetItem(groupItem);
+            item->setText(0, task.title);
+            item->setText(1, task.deadline.toString("yyyy-MM-dd HH:mm"));
+            item->setText(2, priorities.value(task.priority));
+            item->setText(3, task.isCompleted ? "已完成" : "未完成");
+            item->setData(0, kTaskIdRole, task.id);
+        }
+        groupItem->setExpanded(shown < 50);
+        ++shown;
+    }
+    if (groups.size() > shown) {
+        m_statusLabel->setText(message + QString("，显示前 %1 组").arg(shown));
+    }
+    updateButtons();
+}
+
+void DuplicatesDialog::mergeCurrentGroup()
+{
+    QTreeWidgetItem *current = m_tree->currentItem();
+    if (!current) return;
+    QTreeWidgetItem *groupItem = current->parent() ? current->parent() : current;
+    QTreeWidgetItem *keepItem = current->parent() ? current : groupItem->child(0);
+
+    const int keepId = keepItem->data(0, kTaskIdRole).toInt();
+    QList<int> mergedIds;
+    for (int i = 0; i < groupItem->childCount(); ++i) {
+        int taskId = groupItem->child(i)->data(0, kTaskIdRole).toInt();
+        if (taskId != keepId) mergedIds.append(taskId);
+    }
+
+    QString prompt = QString("将把其余 %1 个任务合并到“%2”并删除，确定吗？")
+                         .arg(mergedIds.size()).arg(keepItem->text(0));
+    if (QMessageBox::question(this, "确认", prompt, QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes) {
+        return;
+    }
+
+    QString error;
+    if (!m_model->mergeTasks(keepId, mergedIds, &error)) {
+        QMessageBox::warning(this, "错误", "合并失败：" + error);
+        return;
+    }
+    delete groupItem;
+    m_statusLabel->setText(QString("已合并 %1 个任务").arg(mergedIds.size()));
+    updateButtons();
+}
+
+void DuplicatesDialog::updateButtons()
+{
+    m_rescanButton->setEnabled(!m_job);
+    m_mergeButton->setEnabled(!m_job && m_tree->currentItem());
+}
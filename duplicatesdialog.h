@@ -0,0 +1,40 @@
+#ifndef DUPLICATESDIALOG_H
+#define DUPLICATESDIALOG_H
+
+#include <QDialog>
+
+class QLabel;
+class QProgressBar;
+class QPushButton;
+class QTreeWidget;
+class DuplicateScanJob;
+class TaskModel;
+
+// 查找重复任务：后台全库扫描后按组列出相似任务，可把一组合并为一个任务
+class DuplicatesDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit DuplicatesDialog(TaskModel *model, QWidget *parent = nullptr);
+    ~DuplicatesDialog() override;
+
+signals:
+    void taskActivated(int taskId);
+
+private slots:
+    void startScan();
+    void onScanFinished(bool ok, const QString &message);
+    void mergeCurrentGroup();
+    void updateButtons();
+
+private:
+    TaskModel *m_model;
+    DuplicateScanJob *m_job = nullptr;
+    QLabel *m_statusLabel;
+    QProgressBar *m_progressBar;
+    QTreeWidget *m_tree;
+    QPushButton *m_rescanButton;
+    QPushButton *m_mergeButton;
+};
+
+#endif // DUPLICATESDIALOG_H
@@ -0,0 +1,157 @@
+#include "exportjob.h"
+#include "dbmanager.h"
+#include "metrics.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QQueue>
+#include <QSaveFile>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+namespace {
+const int kPageSize = 2000;     // 每次读取并作为一个分块格式化的任务数
+}
+
+ExportJob::ExportJob(TaskExporter *exporter, const QString &fileName, QObject *parent)
+    : QThread(parent)
+    , m_exporter(exporter)
+    , m_fileName(fileName)
+    , m_databasePath(DBManager::instance()->getDatabasePath())
+{
+}
+
+ExportJob::~ExportJob()
+{
+    cancel();
+    wait();
+}
+
+void ExportJob::cancel()
+{
+    m_cancelled.storeRelaxed(1);
+}
+
+void ExportJob::run()
+{
+    static Histogram *const latency = Metrics::histogram("zhsj_export_seconds", "导出一个文件的耗时");
+    static Counter *const exportedTasks = Metrics::counter("zhsj_exported_tasks_total", "已导出的任务数");
+    static Counter *const failures = Metrics::counter("zhsj_export_failures_total", "失败或取消的导出次数");
+    qDebug() << "导出线程开始：" << m_exporter->name() << m_fileName;
+    QElapsedTimer timer;
+    timer.start();
+
+    QString connectionName = QString("export_%1").arg(quintptr(this));
+    qint64 exported = 0;
+    QString error;
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(m_databasePath);
+        db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+        if (db.open()) {
+            ok = exportAll(db, &exported, &error);
+            db.close();
+        } else {
+            error = "无法打开数据库：" + db.lastError().text();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    latency->record(quint64(timer.nsecsElapsed() / 1000));
+    if (ok && !m_cancelled.loadRelaxed())
+        exportedTasks->add(quint64(exported));
+    else
+        failures->add();
+
+    if (m_cancelled.loadRelaxed()) {
+        emit exportFinished(false, "导出已取消");
+    } else if (ok) {
+        emit exportFinished(true, QString("已导出 %1 个任务到：%2").arg(exported).arg(m_fileName));
+    } else {
+        qWarning() << "导出失败：" << error;
+        emit exportFinished(false, error);
+    }
+}
+
+bool ExportJob::exportAll(const QSqlDatabase &db, qint64 *exported, QString *error)
+{
+    QSqlQuery query(db);
+
+    qint64 total = 0;
+    if (query.exec("SELECT COUNT(*) FROM tasks") && query.next()) {
+        total = query.value(0).toLongLong();
+    }
+    query.finish();
+    if (m_exporter->maxRows() > 0 && total > m_exporter->maxRows()) {
+        *error = QString("任务数 %1 超过%2格式的上限 %3 行").arg(total).arg(m_exporter->name()).arg(m_exporter->maxRows());
+        return false;
+    }
+
+    // 先写临时文件，成功后才替换目标文件；失败或取消时不会留下不完整的文件
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *error = "无法创建文件：" + m_fileName;
+        return false;
+    }
+    if (!m_exporter->begin(&file, error)) {
+        file.cancelWriting();
+        return false;
+    }
+
+    // 已提交但尚未写入的分块；写入按提交顺序进行，队列满时等待最早的分块
+    const int maxPending = qMax(2, QThread::idealThreadCount() * 2);
+    QQueue<QFuture<QByteArray>> pending;
+    const TaskExporter *exporter = m_exporter.data();
+    bool ok = true;
+
+    auto writeOldest = [&]() {
+        QByteArray chunk = pending.dequeue().result();
+        if (ok && !m_exporter->writeChunk(&file, chunk, error)) {
+            ok = false;
+        }
+    };
+
+    QString afterDeadline;
+    int afterId = -1;
+    qint64 submitted = 0;
+    while (ok && !m_cancelled.loadRelaxed()) {
+        QList<Task> page;
+        if (!DBManager::fetchTaskPage(query, kPageSize, m_exporter->needsDescriptions(),
+                                      &afterDeadline, &afterId, &page)) {
+            *error = "读取任务失败：" + query.lastError().text();
+            ok = false;
+            break;
+        }
+        if (page.isEmpty()) break;
+
+        const qint64 firstRow = submitted;
+        pending.enqueue(QtConcurrent::run(QThreadPool::globalInstance(), [exporter, page, firstRow]() {
+            return exporter->formatChunk(page, firstRow);
+        }));
+        submitted += page.size();
+
+        while (pending.size() >= maxPending) {
+            writeOldest();
+        }
+        emit progress(submitted, qMax(total, submitted));
+    }
+
+    // 取消或出错时也要等已提交的分块结束，它们引用着 exporter
+    while (!pending.isEmpty()) {
+        writeOldest();
+    }
+
+    if (ok && !m_cancelled.loadRelaxed() && m_exporter->finish(&file, error) && file.commit()) {
+        *exported = submitted;
+        return true;
+    }
+    if (ok && error->isEmpty() && !m_cancelled.loadRelaxed()) {
+        *error = "写入文件失败：" + file.errorString();
+    }
+    file.cancelWriting();
+    return false;
+}
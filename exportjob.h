@@ -0,0 +1,40 @@
+#ifndef EXPORTJOB_H
+#define EXPORTJOB_H
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QScopedPointer>
+#include <QSqlDatabase>
+#include <QString>
+#include "taskexporter.h"
+
+// 后台导出线程
+// 使用独立的数据库连接按键集分页读取任务，每页交给全局线程池并行格式化，
+// 再按提交顺序写入文件。排队中的分块数有上限，导出任意数量的任务内存占用都是有界的。
+class ExportJob : public QThread
+{
+    Q_OBJECT
+public:
+    // 接管 exporter 的所有权
+    ExportJob(TaskExporter *exporter, const QString &fileName, QObject *parent = nullptr);
+    ~ExportJob() override;
+
+    void cancel();
+
+signals:
+    void progress(qint64 done, qint64 total);
+    void exportFinished(bool ok, const QString &message);
+
+protected:
+    void run() override;
+
+private:
+    bool exportAll(const QSqlDatabase &db, qint64 *exported, QString *error);
+
+    QScopedPointer<TaskExporter> m_exporter;
+    QString m_fileName;
+    QString m_databasePath;
+    QAtomicInt m_cancelled;
+};
+
+#endif // EXPORTJOB_H
@@ -0,0 +1,34 @@
+#include "idlemonitor.h"
+#include <QCoreApplication>
+#include <QEvent>
+
+IdleMonitor* IdleMonitor::instance()
+{
+    // 由应用对象持有，随其一同销毁
+    static IdleMonitor* monitor = new IdleMonitor(QCoreApplication::instance());
+    return monitor;
+}
+
+IdleMonitor::IdleMonitor(QObject *parent)
+    : QObject(parent)
+{
+    m_lastActivity.start();
+    if (QCoreApplication::instance()) {
+        QCoreApplication::instance()->installEventFilter(this);
+    }
+}
+
+bool IdleMonitor::eventFilter(QObject *watched, QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::KeyPress:
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseMove:
+    case QEvent::Wheel:
+        m_lastActivity.restart();
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
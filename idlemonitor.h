@@ -0,0 +1,26 @@
+#ifndef IDLEMONITOR_H
+#define IDLEMONITOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+
+// 记录用户最后一次键盘/鼠标操作的时间，供后台维护任务判断空闲
+class IdleMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    static IdleMonitor* instance();
+
+    qint64 idleMsecs() const { return m_lastActivity.elapsed(); }
+    bool isIdle(qint64 thresholdMs) const { return idleMsecs() >= thresholdMs; }
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    explicit IdleMonitor(QObject *parent = nullptr);
+
+    QElapsedTimer m_lastActivity;
+};
+
+#endif // IDLEMONITOR_H
@@ -0,0 +1,88 @@
+#include "intervalindex.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+void IntervalIndex::clear()
+{
+    m_lanes.clear();
+    m_laneById.clear();
+    m_size = 0;
+    m_minStart = 0;
+    m_maxEnd = 0;
+}
+
+void IntervalIndex::build(QVector<Interval> intervals, qint64 minGap)
+{
+    clear();
+    if (intervals.isEmpty()) return;
+
+    std::sort(intervals.begin(), intervals.end(), [](const Interval &a, const Interval &b) {
+        return a.start < b.start || (a.start == b.start && a.id < b.id);
+    });
+
+    // 按起点扫描，放入最早空出的行（行数即最大重叠数，为最优）
+    using LaneEnd = std::pair<qint64, int>; // (行内最后区间的结束时间, 行号)
+    std::priority_queue<LaneEnd, std::vector<LaneEnd>, std::greater<LaneEnd>> freeAt;
+    int maxId = 0;
+    m_minStart = intervals.first().start;
+    m_maxEnd = intervals.first().end;
+
+    for (const Interval &interval : intervals) {
+        int lane;
+        if (!freeAt.empty() && freeAt.top().first + minGap <= interval.start) {
+            lane = freeAt.top().second;
+            freeAt.pop();
+        } else {
+            lane = m_lanes.size();
+            m_lanes.append(QVector<Interval>());
+        }
+        m_lanes[lane].append(interval);
+        freeAt.push({interval.end, lane});
+
+        maxId = qMax(maxId, interval.id);
+        m_maxEnd = qMax(m_maxEnd, interval.end);
+    }
+
+    m_laneById = QVector<int>(maxId + 1, -1);
+    for (int lane = 0; lane < m_lanes.size(); ++lane) {
+        for (const Interval &interval : m_lanes.at(lane)) {
+            if (interval.id >= 0) m_laneById[interval.id] = lane;
+        }
+    }
+    m_size = intervals.size();
+}
+
+void IntervalIndex::query(int lane, qint64 from, qint64 to, qint64 resolution, QVector<Interval> *out) const
+{
+    if (lane < 0 || lane >= m_lanes.size()) return;
+    const QVector<Interval> &items = m_lanes.at(lane);
+
+    // 行内区间互不重叠，结束时间同样有序
+    auto it = std::lower_bound(items.begin(), items.end(), from,
+                               [](const Interval &a, qint64 t) { return a.end < t; });
+    while (it != items.end() && it->start <= to) {
+        out->append(*it);
+        qint64 next = it->start + resolution;
+        ++it;
+        if (resolution > 0 && it != items.end() && it->start < next) {
+            it = std::lower_bound(it, items.end(), next,
+                                  [](const Interval &a, qint64 t) { return a.start < t; });
+        }
+    }
+}
+
+const IntervalIndex::Interval *IntervalIndex::itemAt(int lane, qint64 time, qint64 tolerance) const
+{
+    if (lane < 0 || lane >= m_lanes.size()) return nullptr;
+    const QVector<Interval> &items = m_lanes.at(lane);
+
+    auto it = std::lower_bound(items.begin(), items.end(), time - tolerance,
+                               [](const Interval &a, qint64 t) { return a.end < t; });
+    if (it != items.end() && it->start <= time + tolerance) {
+        return &*it;
+    }
+    return nullptr;
+}
@@ -0,0 +1,44 @@
+#ifndef INTERVALINDEX_H
+#define INTERVALINDEX_H
+
+#include <QVector>
+#include <QtGlobal>
+
+// 时间区间索引：构建时把区间贪心分配到互不重叠的"行"（lane）中，
+// 每行内的区间起止时间都有序，查询某行在 [from, to] 内的区间只需一次二分查找。
+// 时间线视图据此只访问可见行、可见时间段内的区间，开销与任务总数无关。
+class IntervalIndex
+{
+public:
+    struct Interval {
+        qint64 start = 0;
+        qint64 end = 0;
+        int id = -1;
+    };
+
+    // minGap：同一行中相邻区间之间至少留出的间隔
+    void build(QVector<Interval> intervals, qint64 minGap = 0);
+    void clear();
+
+    int laneCount() const { return m_lanes.size(); }
+    int size() const { return m_size; }
+    qint64 minStart() const { return m_minStart; }
+    qint64 maxEnd() const { return m_maxEnd; }
+
+    // 按时间顺序返回 lane 中与 [from, to] 相交的区间。
+    // resolution > 0 时，起点距上一个返回区间起点不足 resolution 的区间被跳过（缩小显示时它们会被完全覆盖），
+    // 因此返回数量不超过 (to - from) / resolution + 1
+    void query(int lane, qint64 from, qint64 to, qint64 resolution, QVector<Interval> *out) const;
+    // 查找 lane 中覆盖 time（允许 tolerance 误差）的区间，没有时返回 nullptr
+    const Interval *itemAt(int lane, qint64 time, qint64 tolerance = 0) const;
+    int laneOf(int id) const { return m_laneById.value(id, -1); }
+
+private:
+    QVector<QVector<Interval>> m_lanes;
+    QVector<int> m_laneById;   // 任务ID -> 行，ID超出范围时为 -1
+    int m_size = 0;
+    qint64 m_minStart = 0;
+    qint64 m_maxEnd = 0;
+};
+
+#endif // INTERVALINDEX_H
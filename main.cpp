@@ -6,6 +6,8 @@
 #include <QDir>
 #include <QFile>
 #include <QStandardPaths>
+#include <QCommandLineParser>
+#include "clock.h"
 
 bool checkDatabaseDrivers() {
     qDebug() << "检查可用数据库驱动：";
@@ -38,13 +40,32 @@ int main(int argc, char *argv[])
     // 设置应用信息
     QApplication::setApplicationName("个人任务管理系统");
     QApplication::setApplicationVersion("1.0");
+    QApplication::setOrganizationName("zhsj");  // QSettings 存储位置
 
     qDebug() << "=== 应用程序启动 ===";
 
+    // 模拟时钟：用于快速回放截止时间和提醒，例如 --clock-start "2025-01-01 08:00" --clock-rate 600
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption clockStartOption("clock-start", "模拟时钟的起始时间（yyyy-MM-dd HH:mm）", "time");
+    QCommandLineOption clockRateOption("clock-rate", "模拟时钟相对真实时间的倍速", "rate");
+    parser.addOption(clockStartOption);
+    parser.addOption(clockRateOption);
+    parser.process(a);
+
     try {
         MainWindow w;
         qDebug() << "主窗口创建完成";
 
+        if (parser.isSet(clockStartOption) || parser.isSet(clockRateOption)) {
+            QDateTime start = QDateTime::fromString(parser.value(clockStartOption), "yyyy-MM-dd HH:mm");
+            double rate = parser.isSet(clockRateOption) ? parser.value(clockRateOption).toDouble() : 1.0;
+            SimulatedClock *clock = new SimulatedClock(start.isValid() ? start : QDateTime::currentDateTime(),
+                                                       rate, &a);
+            w.setClock(clock);
+            qDebug() << "使用模拟时钟：" << clock->now() << rate << "倍速";
+        }
+
         w.show();
         qDebug() << "主窗口显示完成，进入事件循环";
 
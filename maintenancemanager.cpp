@@ -0,0 +1,206 @@
+#include "maintenancemanager.h"
+#include "idlemonitor.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QLocale>
+#include <QSettings>
+
+namespace {
+const int kCheckIntervalMs = 5 * 60 * 1000;      // 检查是否需要维护的间隔
+const int kStepDelayMs = 100;                    // 两步之间让出事件循环和写锁
+const int kStepBudgetMs = 50;                    // 单步持有写锁的目标上限
+const int kMinVacuumPages = 16;
+const int kMaxVacuumPages = 4096;
+const int kInitialVacuumPages = 256;
+const int kAnalysisLimit = 1000;                 // ANALYZE 每个索引最多抽样的行数
+const qint64 kMaxConvertBytes = 16 * 1024 * 1024; // 超过该大小的旧库不做整库 VACUUM
+const double kConvertFreeRatio = 0.1;
+
+QString formatSize(qint64 bytes)
+{
+    return QLocale().formattedDataSize(bytes);
+}
+}
+
+MaintenanceManager::MaintenanceManager(QObject *parent)
+    : QObject(parent)
+{
+    QSettings settings;
+    m_intervalHours = settings.value("maintenance/intervalHours", 24).toInt();
+    m_idleThresholdMs = settings.value("maintenance/idleSeconds", 120).toInt() * 1000;
+    m_analyzeDays = settings.value("maintenance/analyzeDays", 7).toInt();
+
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &MaintenanceManager::runStep);
+}
+
+void MaintenanceManager::start()
+{
+    IdleMonitor::instance();
+    schedule(kCheckIntervalMs);
+    qDebug() << "数据库维护：每" << m_intervalHours << "小时，空闲" << m_idleThresholdMs / 1000 << "秒后执行";
+}
+
+bool MaintenanceManager::runNow()
+{
+    if (isRunning()) return false;
+    m_manual = true;
+    begin();
+    schedule(0);
+    return true;
+}
+
+QDateTime MaintenanceManager::lastRun() const
+{
+    QSettings settings;
+    return settings.value("maintenance/last").toDateTime();
+}
+
+QString MaintenanceManager::lastSummary() const
+{
+    QSettings settings;
+    return settings.value("maintenance/lastSummary").toString();
+}
+
+void MaintenanceManager::schedule(int delayMs)
+{
+    m_timer.start(delayMs);
+}
+
+void MaintenanceManager::begin()
+{
+    m_step = StepOptimize;
+    m_before = DatabaseStats();
+    DBManager::instance()->getDatabaseStats(&m_before);
+    m_pendingTables.clear();
+    m_vacuumPages = kInitialVacuumPages;
+    m_analyzedTables = 0;
+    m_reclaimedPages = 0;
+    m_maxStepMs = 0;
+    m_converted = false;
+    qDebug() << "开始数据库维护：文件" << formatSize(m_before.fileBytes)
+             << "空闲页" << m_before.freePages << "/" << m_before.pageCount;
+}
+
+void MaintenanceManager::runStep()
+{
+    if (m_step == StepIdle) {
+        QDateTime last = lastRun();
+        bool due = m_intervalHours > 0
+                   && (!last.isValid() || last.addSecs(qint64(m_intervalHours) * 3600) <= QDateTime::currentDateTime());
+        if (!due || !IdleMonitor::instance()->isIdle(m_idleThresholdMs)) {
+            schedule(kCheckIntervalMs);
+            return;
+        }
+        begin();
+    } else if (!m_manual && !IdleMonitor::instance()->isIdle(m_idleThresholdMs)) {
+        // 用户回来了：保留进度，空闲后继续
+        schedule(kCheckIntervalMs);
+        return;
+    }
+
+    DBManager *db = DBManager::instance();
+    QElapsedTimer timer;
+    timer.start();
+
+    switch (m_step) {
+    case StepIdle:
+        break;
+    case StepOptimize:
+        db->optimizeDatabase(kAnalysisLimit);
+        m_step = StepConvert;
+        break;
+    case StepConvert:
+        if (m_before.autoVacuum != 2 && m_before.fileBytes <= kMaxConvertBytes
+            && m_before.freeRatio() >= kConvertFreeRatio) {
+            m_converted = db->vacuumDatabase();
+        } else if (m_before.autoVacuum != 2) {
+            qDebug() << "数据库未启用增量回收，且文件较大或空洞较少，跳过整库 VACUUM";
+        }
+        m_step = StepVacuum;
+        break;
+    case StepVacuum: {
+        DatabaseStats stats;
+        if (m_converted || !db->getDatabaseStats(&stats) || stats.autoVacuum != 2 || stats.freePages == 0) {
+            m_step = StepAnalyze;
+            break;
+        }
+        int freed = db->incrementalVacuum(m_vacuumPages);
+        if (freed <= 0) {
+            m_step = StepAnalyze;
+            break;
+        }
+        m_reclaimedPages += freed;
+        // 按本步耗时调整下一步的页数，使单步持锁时间保持在预算附近
+        qint64 elapsed = timer.elapsed();
+        if (elapsed > kStepBudgetMs) {
+            m_vacuumPages = qMax(kMinVacuumPages, m_vacuumPages / 2);
+        } else if (elapsed < kStepBudgetMs / 4) {
+            m_vacuumPages = qMin(kMaxVacuumPages, m_vacuumPages * 2);
+        }
+        break;
+    }
+    case StepAnalyze: {
+        // PRAGMA optimize 已处理明显过期的统计；完整的 ANALYZE 按天数间隔执行，每步一张表
+        QSettings settings;
+        QDateTime lastAnalyze = settings.value("maintenance/lastAnalyze").toDateTime();
+        if (m_analyzedTables == 0 && m_pendingTables.isEmpty()) {
+            if (m_analyzeDays > 0
+                && (!lastAnalyze.isValid() || lastAnalyze.addDays(m_analyzeDays) <= QDateTime::currentDateTime())) {
+                m_pendingTables = db->tablesToAnalyze();
+            }
+            if (m_pendingTables.isEmpty()) {
+                m_step = StepFinish;
+                break;
+            }
+        }
+        if (!m_pendingTables.isEmpty()) {
+            QString table = m_pendingTables.takeFirst();
+            if (db->analyzeTable(table, kAnalysisLimit)) {
+                ++m_analyzedTables;
+            }
+        }
+        if (m_pendingTables.isEmpty()) {
+            settings.setValue("maintenance/lastAnalyze", QDateTime::currentDateTime());
+            m_step = StepFinish;
+        }
+        break;
+    }
+    case StepFinish:
+        finish();
+        return;
+    }
+
+    qint64 elapsed = timer.elapsed();
+    m_maxStepMs = qMax(m_maxStepMs, elapsed);
+    if (elapsed > kStepBudgetMs) {
+        qDebug() << "维护步骤" << int(m_step) << "用时" << elapsed << "ms";
+    }
+    schedule(kStepDelayMs);
+}
+
+void MaintenanceManager::finish()
+{
+    DatabaseStats after;
+    DBManager::instance()->getDatabaseStats(&after);
+    qint64 reclaimed = qMax<qint64>(0, m_before.fileBytes - after.fileBytes);
+
+    QString summary = QString("数据库 %1，空闲页 %2%（%3 页），本次回收 %4%5，分析 %6 张表，单步最长 %7 ms")
+                          .arg(formatSize(after.fileBytes))
+                          .arg(after.freeRatio() * 100, 0, 'f', 1)
+                          .arg(after.freePages)
+                          .arg(formatSize(reclaimed))
+                          .arg(m_converted ? "（已整库重建并启用增量回收）" : "")
+                          .arg(m_analyzedTables)
+                          .arg(m_maxStepMs);
+    qDebug() << "数据库维护完成：" << summary << "增量回收" << m_reclaimedPages << "页";
+
+    QSettings settings;
+    settings.setValue("maintenance/last", QDateTime::currentDateTime());
+    settings.setValue("maintenance/lastSummary", summary);
+
+    m_step = StepIdle;
+    m_manual = false;
+    schedule(kCheckIntervalMs);
+    emit maintenanceFinished(summary);
+}
@@ -0,0 +1,63 @@
+#ifndef MAINTENANCEMANAGER_H
+#define MAINTENANCEMANAGER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QStringList>
+#include <QTimer>
+#include "dbmanager.h"
+
+// 空闲时的数据库维护：PRAGMA optimize、增量回收空闲页、ANALYZE
+// 每一步都很小并单独计时（增量回收的页数按耗时自适应），步与步之间让出事件循环和写锁；
+// 用户恢复操作时暂停，空闲后从暂停处继续。配置保存在 QSettings 的 maintenance/ 分组下
+class MaintenanceManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MaintenanceManager(QObject *parent = nullptr);
+
+    void start();
+    bool runNow();                  // 不等空闲和间隔立即开始；已在进行时返回false
+    bool isRunning() const { return m_step != StepIdle; }
+
+    QDateTime lastRun() const;
+    QString lastSummary() const;
+
+signals:
+    void maintenanceFinished(const QString &summary);
+
+private slots:
+    void runStep();
+
+private:
+    enum Step {
+        StepIdle,
+        StepOptimize,
+        StepConvert,     // 旧数据库切换到 auto_vacuum=INCREMENTAL（需要整库 VACUUM，只对小库执行）
+        StepVacuum,
+        StepAnalyze,
+        StepFinish
+    };
+
+    void begin();
+    void finish();
+    void schedule(int delayMs);
+
+    QTimer m_timer;
+    Step m_step = StepIdle;
+    bool m_manual = false;
+    int m_intervalHours;
+    int m_idleThresholdMs;
+    int m_analyzeDays;
+
+    // 本次运行的状态
+    DatabaseStats m_before;
+    QStringList m_pendingTables;
+    int m_vacuumPages = 0;
+    int m_analyzedTables = 0;
+    qint64 m_reclaimedPages = 0;
+    qint64 m_maxStepMs = 0;
+    bool m_converted = false;
+};
+
+#endif // MAINTENANCEMANAGER_H
@@ -3,7 +3,6 @@
 #include <QMessageBox>
 #include <QDateTime>
 #include <QFileDialog>
-#include <QTextStream>
 #include <QMenu>
 #include <QCursor>
 #include <QDebug>
@@ -11,13 +10,49 @@
 #include <QStatusBar>
 #include <QTimer>
 #include <QApplication>
+#include <QInputDialog>
+#include <QDialog>
+#include <QVBoxLayout>
+#include <QLabel>
+#include <QTableView>
+#include <QHeaderView>
+#include <QTreeView>
+#include <QScrollBar>
+#include <QSet>
+#include <QProgressDialog>
+#include <QScopedPointer>
 #include "dbmanager.h"
+#include "archivemodel.h"
+#include "taskexporter.h"
+#include "trendsdialog.h"
+#include "nextuppanel.h"
+#include "duplicatesdialog.h"
+#include "diagnosticsdialog.h"
+#include "simhash.h"
+#include <QCheckBox>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QLocale>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
+    , m_clock(Clock::system())
     , m_taskModel(nullptr)
+    , m_proxyModel(nullptr)
+    , m_treeModel(nullptr)
     , m_reminderThread(nullptr)
+    , m_dbWatcher(nullptr)
+    , m_archiveManager(nullptr)
+    , m_exportJob(nullptr)
+    , m_syncJob(nullptr)
+    , m_backupManager(nullptr)
+    , m_migrationThread(nullptr)
+    , m_maintenanceManager(nullptr)
+    , m_metricsExporter(nullptr)
 {
     qDebug() << "MainWindow构造函数开始";
     ui->setupUi(this);
@@ -56,27 +91,105 @@ void MainWindow::initializeApplication()
         // 2. 初始化任务模型
         qDebug() << "正在初始化任务模型...";
         m_taskModel = new TaskModel(this);
-        ui->tableView_Tasks->setModel(m_taskModel);
+        m_taskModel->setClock(m_clock);
+        m_proxyModel = new TaskFilterProxyModel(m_taskModel, this);
+        ui->tableView_Tasks->setModel(m_proxyModel);
 
         // 设置列宽
         ui->tableView_Tasks->setColumnWidth(0, 200);
         ui->tableView_Tasks->setColumnWidth(1, 150);
         ui->tableView_Tasks->setColumnWidth(2, 80);
         ui->tableView_Tasks->setColumnWidth(3, 80);
+        ui->tableView_Tasks->setColumnWidth(4, 150);
+        // 点击表头排序；初始不排序，保持模型的截止时间顺序
+        ui->tableView_Tasks->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+        ui->tableView_Tasks->setSortingEnabled(true);
+        ui->timelineView->setModel(m_taskModel);
+        m_treeModel = new TaskTreeModel(m_taskModel, this);
+        ui->treeView_Tasks->setModel(m_treeModel);
+        ui->treeView_Tasks->setColumnWidth(TaskTreeModel::ColumnTitle, 250);
+        ui->treeView_Tasks->setColumnWidth(TaskTreeModel::ColumnDeadline, 150);
+        ui->treeView_Tasks->setColumnWidth(TaskTreeModel::ColumnPriority, 60);
+        ui->treeView_Tasks->setColumnWidth(TaskTreeModel::ColumnProgress, 120);
+        reloadSavedFilters();
 
         // 3. 连接信号
         connect(ui->tableView_Tasks->selectionModel(), &QItemSelectionModel::selectionChanged,
                 this, &MainWindow::onSelectionChanged);
         connect(ui->tableView_Tasks, &QTableView::doubleClicked,
                 this, &MainWindow::onTableDoubleClicked);
+        ui->tableView_Tasks->setContextMenuPolicy(Qt::CustomContextMenu);
+        connect(ui->tableView_Tasks, &QTableView::customContextMenuRequested,
+                this, &MainWindow::onTableContextMenu);
 
         if (m_taskModel) {
-            connect(m_taskModel, &TaskModel::taskDataChanged,
-                    this, &MainWindow::onTaskDataChanged);
+            connect(m_taskModel, &TaskModel::writeFailed,
+                    this, &MainWindow::onTaskWriteFailed);
         }
+        connect(ui->timelineView, &TimelineView::taskActivated,
+                this, &MainWindow::onTimelineTaskActivated);
+        ui->treeView_Tasks->setContextMenuPolicy(Qt::CustomContextMenu);
+        connect(ui->treeView_Tasks, &QTreeView::customContextMenuRequested,
+                this, &MainWindow::onTreeContextMenu);
+        connect(ui->treeView_Tasks, &QTreeView::doubleClicked, this, [this](const QModelIndex &index) {
+            onTimelineTaskActivated(m_treeModel->taskIdAt(index));
+        });
+        // 视图只会自动加载顶层的下一页，展开的子任务列表滚动到底部时由这里继续加载
+        connect(ui->treeView_Tasks->verticalScrollBar(), &QScrollBar::valueChanged, this, [this](int value) {
+            if (value < ui->treeView_Tasks->verticalScrollBar()->maximum()) return;
+            QWidget *viewport = ui->treeView_Tasks->viewport();
+            m_treeModel->fetchMoreAround(ui->treeView_Tasks->indexAt(QPoint(0, viewport->height() - 1)));
+        });
+
+        // 紧急度最高的未完成任务
+        NextUpPanel *nextUpPanel = new NextUpPanel(m_taskModel, this);
+        addDockWidget(Qt::RightDockWidgetArea, nextUpPanel);
+        connect(nextUpPanel, &NextUpPanel::taskActivated,
+                this, &MainWindow::onTimelineTaskActivated);
+
+        // 监视其他进程对数据库的修改，增量刷新
+        m_dbWatcher = new DbChangeWatcher(this);
+        connect(m_dbWatcher, &DbChangeWatcher::databaseChanged,
+                this, &MainWindow::onDatabaseChanged);
+        m_dbWatcher->start();
+
+        // 空闲时归档已完成的旧任务
+        m_archiveManager = new ArchiveManager(this);
+        connect(m_archiveManager, &ArchiveManager::tasksArchived,
+                this, &MainWindow::onTasksArchived);
+        m_archiveManager->start();
+
+        // 逾期数按小时采样到当天的汇总行
+        DBManager::instance()->updateOverdueRollup();
+        QTimer *rollupTimer = new QTimer(this);
+        connect(rollupTimer, &QTimer::timeout, this, []() {
+            DBManager::instance()->updateOverdueRollup();
+        });
+        rollupTimer->start(60 * 60 * 1000);
+
+        // 定时在线备份
+        m_backupManager = new BackupManager(this);
+        connect(m_backupManager, &BackupManager::backupFinished,
+                this, &MainWindow::onBackupFinished);
+        m_backupManager->start();
+
+        // 空闲时整理数据库
+        m_maintenanceManager = new MaintenanceManager(this);
+        connect(m_maintenanceManager, &MaintenanceManager::maintenanceFinished, this,
+                [this](const QString &summary) {
+                    ui->statusbar->showMessage("数据库维护完成：" + summary, 5000);
+                });
+        m_maintenanceManager->start();
+
+        // 定时写出运行指标文件
+        m_metricsExporter = new MetricsExporter(this);
+        m_metricsExporter->start();
+
+        // 结构升级登记的数据迁移在后台分批完成，不阻塞启动
+        startDataMigrations();
 
         // 4. 设置表单默认值
-        ui->dateTimeEdit_Deadline->setDateTime(QDateTime::currentDateTime().addSecs(3600));
+        ui->dateTimeEdit_Deadline->setDateTime(m_clock->now().addSecs(3600));
         ui->comboBox_Priority->setCurrentIndex(1);
 
         // 5. 延迟启动提醒线程
@@ -85,7 +198,8 @@ void MainWindow::initializeApplication()
                 m_reminderThread = new ReminderThread(this);
                 connect(m_reminderThread, &ReminderThread::taskReminder,
                         this, &MainWindow::onTaskReminder);
-                m_reminderThread->setTasks(m_taskModel->getAllTasks());
+                m_reminderThread->setSnapshotSource(m_taskModel->snapshotSource());
+                m_reminderThread->setClock(m_clock);
                 m_reminderThread->start();
                 qDebug() << "提醒线程已启动";
             }
@@ -121,10 +235,17 @@ void MainWindow::initializeUIWithoutDatabase()
     ui->btnDeleteTask->setEnabled(false);
     ui->btnRefresh->setEnabled(false);
     ui->btnStats->setEnabled(false);
+    ui->btnTrends->setEnabled(false);
     ui->btnExport->setEnabled(false);
 
     ui->tableView_Tasks->setEnabled(false);
     ui->tableView_Tasks->setToolTip("数据库不可用");
+    ui->timelineView->setEnabled(false);
+    ui->treeView_Tasks->setEnabled(false);
+    ui->lineEdit_Query->setEnabled(false);
+    ui->comboBox_SavedFilters->setEnabled(false);
+    ui->btnSaveFilter->setEnabled(false);
+    ui->btnDeleteFilter->setEnabled(false);
 
     ui->statusbar->showMessage("数据库不可用，功能受限", 5000);
 }
@@ -133,6 +254,11 @@ MainWindow::~MainWindow()
 {
     qDebug() << "MainWindow析构函数开始";
 
+    // 提交列表中尚未落盘的修改
+    if (m_taskModel) {
+        m_taskModel->flushPendingWrites();
+    }
+
     if (m_reminderThread) {
         qDebug() << "停止提醒线程...";
         m_reminderThread->stopThread();
@@ -141,10 +267,31 @@ MainWindow::~MainWindow()
         qDebug() << "提醒线程已停止";
     }
 
+    stopDataMigrations();
+
+    if (m_exportJob) {
+        qDebug() << "取消正在进行的导出...";
+        m_exportJob->cancel();
+        m_exportJob->wait();
+    }
+
+    if (m_syncJob) {
+        qDebug() << "等待同步完成...";
+        m_syncJob->wait();
+    }
+
     delete ui;
     qDebug() << "MainWindow析构函数结束";
 }
 
+void MainWindow::setClock(Clock *clock)
+{
+    m_clock = clock;
+    if (m_taskModel) {
+        m_taskModel->setClock(clock);
+    }
+}
+
 void MainWindow::on_btnAddTask_clicked()
 {
     if (!m_taskModel) {
@@ -161,7 +308,7 @@ void MainWindow::on_btnAddTask_clicked()
         QMessageBox::warning(this, "警告", "任务标题不能为空！");
         return;
     }
-    if (deadline < QDateTime::currentDateTime()) {
+    if (deadline < m_clock->now()) {
         QMessageBox::warning(this, "警告", "截止时间不能早于当前时间！");
         return;
     }
@@ -172,6 +319,27 @@ void MainWindow::on_btnAddTask_clicked()
     task.priority = priority;
     task.isCompleted = false;
     task.description = description;
+    task.descriptionLoaded = true;
+    task.tags = TagIndex::parseTags(ui->lineEdit_Tags->text());
+
+    // 指纹相近的已有任务只作提示，由用户决定是否仍然添加
+    QList<QPair<int, int>> similar = DBManager::instance()->findNearDuplicates(
+        SimHash::compute(task.title, task.description), -1, SimHash::kDefaultMaxDistance);
+    if (!similar.isEmpty()) {
+        QStringList titles;
+        for (const auto &item : similar) {
+            Task existing = m_taskModel->getTaskById(item.first);
+            if (existing.id == -1) continue;
+            titles << QString("%1（%2）").arg(existing.title, existing.deadline.toString("yyyy-MM-dd HH:mm"));
+            if (titles.size() >= 3) break;
+        }
+        if (!titles.isEmpty()
+            && QMessageBox::question(this, "可能重复",
+                                     "可能与已有任务重复：\n" + titles.join('\n') + "\n\n仍然添加吗？",
+                                     QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes) {
+            return;
+        }
+    }
 
     m_taskModel->addTask(task);
 
@@ -201,7 +369,7 @@ void MainWindow::on_btnEditTask_clicked()
         QMessageBox::warning(this, "警告", "任务标题不能为空！");
         return;
     }
-    if (deadline < QDateTime::currentDateTime()) {
+    if (deadline < m_clock->now()) {
         QMessageBox::warning(this, "警告", "截止时间不能早于当前时间！");
         return;
     }
@@ -216,6 +384,8 @@ void MainWindow::on_btnEditTask_clicked()
     task.deadline = deadline;
     task.priority = priority;
     task.description = description;
+    task.descriptionLoaded = true;
+    task.tags = TagIndex::parseTags(ui->lineEdit_Tags->text());
 
     m_taskModel->updateTask(task);
 
@@ -230,19 +400,26 @@ void MainWindow::on_btnDeleteTask_clicked()
         return;
     }
 
-    int taskId = getSelectedTaskId();
-    if (taskId == -1) {
+    QList<int> taskIds = getSelectedTaskIds();
+    if (taskIds.isEmpty()) {
         QMessageBox::warning(this, "警告", "请先选中要删除的任务！");
         return;
     }
 
-    if (QMessageBox::question(this, "确认", "确定要删除该任务吗？",
+    QString prompt = taskIds.size() == 1
+                         ? QString("确定要删除该任务吗？")
+                         : QString("确定要删除选中的 %1 个任务吗？").arg(taskIds.size());
+    if (QMessageBox::question(this, "确认", prompt,
                               QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes) {
         return;
     }
 
-    m_taskModel->removeTask(taskId);
-    QMessageBox::information(this, "成功", "任务删除成功！");
+    QString error;
+    if (!m_taskModel->removeTasks(taskIds, &error)) {
+        QMessageBox::warning(this, "错误", "删除任务失败：" + error);
+        return;
+    }
+    ui->statusbar->showMessage(QString("已删除 %1 个任务").arg(taskIds.size()), 3000);
     clearInputForm();
 }
 
@@ -272,18 +449,18 @@ void MainWindow::on_btnStats_clicked()
         return;
     }
 
-    QList<Task> allTasks = m_taskModel->getAllTasks();
-    int total = allTasks.size();
+    TaskSnapshot::Ptr snapshot = m_taskModel->snapshot();
+    int total = snapshot->size();
     int completed = 0;
     int highPriority = 0;
     int upcoming = 0;
-    QDateTime now = QDateTime::currentDateTime();
+    QDateTime now = m_clock->now();
 
-    for (const auto &task : allTasks) {
+    snapshot->forEach([&](const Task &task) {
         if (task.isCompleted) completed++;
         if (task.priority == 2) highPriority++;
         if (!task.isCompleted && task.deadline > now) upcoming++;
-    }
+    });
 
     QString completionRate = (total > 0) ?
                                  QString::number((completed * 100.0) / total, 'f', 1) : "0.0";
@@ -304,86 +481,83 @@ void MainWindow::on_btnStats_clicked()
     QMessageBox::information(this, "任务统计", statsText);
 }
 
+void MainWindow::on_btnTrends_clicked()
+{
+    if (!m_taskModel) {
+        QMessageBox::warning(this, "错误", "数据库不可用，无法查看趋势");
+        return;
+    }
+
+    // 汇总由触发器随写入维护，落盘排队中的修改后即可读取
+    m_taskModel->flushPendingWrites();
+    DBManager::instance()->updateOverdueRollup();
+    TrendsDialog dialog(this);
+    dialog.exec();
+}
+
 void MainWindow::on_btnExport_clicked()
 {
     if (!m_taskModel) {
         QMessageBox::warning(this, "错误", "数据库不可用，无法导出");
         return;
     }
+    if (m_exportJob) {
+        QMessageBox::information(this, "提示", "已有导出正在进行");
+        return;
+    }
+
+    m_taskModel->flushPendingWrites();
 
     QMenu menu(this);
-    QAction *csvAction = menu.addAction("导出为CSV");
-    QAction *textAction = menu.addAction("导出为文本");
+    for (const QString &format : TaskExporter::formats()) {
+        QScopedPointer<TaskExporter> exporter(TaskExporter::create(format));
+        if (!exporter) continue;
+        menu.addAction("导出为" + exporter->name())->setData(format);
+    }
     QAction *selected = menu.exec(QCursor::pos());
 
-    if (selected == csvAction) {
-        exportToExcel();
-    } else if (selected == textAction) {
-        exportToText();
+    if (selected) {
+        exportTasks(selected->data().toString());
     }
 }
 
-void MainWindow::exportToExcel()
+void MainWindow::exportTasks(const QString &format)
 {
-    if (!m_taskModel) return;
-
-    QString fileName = QFileDialog::getSaveFileName(this, "导出CSV",
-                                                    QDir::homePath() + "/任务列表.csv",
-                                                    "CSV文件 (*.csv)");
-    if (fileName.isEmpty()) return;
-
-    QFile file(fileName);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QTextStream stream(&file);
-        stream << "ID,标题,截止时间,优先级,完成状态,描述\n";
-        QList<Task> tasks = m_taskModel->getAllTasks();
-        for (const auto &task : tasks) {
-            stream << task.id << ","
-                   << "\"" << task.title << "\","
-                   << task.deadline.toString("yyyy-MM-dd HH:mm") << ","
-                   << task.priority << ","
-                   << (task.isCompleted ? "已完成" : "未完成") << ","
-                   << "\"" << task.description << "\"\n";
-        }
-        file.close();
-        QMessageBox::information(this, "成功", "数据已导出到：" + fileName);
-    } else {
-        QMessageBox::warning(this, "错误", "无法创建文件：" + fileName);
+    TaskExporter *exporter = TaskExporter::create(format);
+    if (!exporter) return;
+
+    QString fileName = QFileDialog::getSaveFileName(this, "导出" + exporter->name(),
+                                                    QDir::homePath() + "/任务列表." + exporter->defaultSuffix(),
+                                                    exporter->fileFilter());
+    if (fileName.isEmpty()) {
+        delete exporter;
+        return;
     }
-}
 
-void MainWindow::exportToText()
-{
-    if (!m_taskModel) return;
-
-    QString fileName = QFileDialog::getSaveFileName(this, "导出文本",
-                                                    QDir::homePath() + "/任务列表.txt",
-                                                    "文本文件 (*.txt)");
-    if (fileName.isEmpty()) return;
-
-    QFile file(fileName);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QTextStream stream(&file);
-        stream << "任务列表报表\n";
-        stream << "生成时间：" << QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm") << "\n";
-        stream << "=================================\n\n";
-        QList<Task> tasks = m_taskModel->getAllTasks();
-        for (const auto &task : tasks) {
-            stream << "ID: " << task.id << "\n";
-            stream << "标题: " << task.title << "\n";
-            stream << "截止时间: " << task.deadline.toString("yyyy-MM-dd HH:mm") << "\n";
-            stream << "优先级: " << (task.priority == 0 ? "低" : (task.priority == 1 ? "中" : "高")) << "\n";
-            stream << "完成状态: " << (task.isCompleted ? "已完成" : "未完成") << "\n";
-            if (!task.description.isEmpty()) {
-                stream << "描述: " << task.description << "\n";
-            }
-            stream << "---------------------------------\n";
+    // 格式化和写文件都在后台进行，界面只显示进度
+    m_exportJob = new ExportJob(exporter, fileName, this);
+    QProgressDialog *progressDialog = new QProgressDialog("正在导出...", "取消", 0, 100, this);
+    progressDialog->setWindowModality(Qt::WindowModal);
+    progressDialog->setMinimumDuration(500);
+    progressDialog->setAttribute(Qt::WA_DeleteOnClose);
+
+    connect(progressDialog, &QProgressDialog::canceled, m_exportJob, &ExportJob::cancel);
+    connect(m_exportJob, &ExportJob::progress, progressDialog, [progressDialog](qint64 done, qint64 total) {
+        progressDialog->setValue(total > 0 ? int(done * 100 / total) : 0);
+        progressDialog->setLabelText(QString("正在导出... %1 / %2").arg(done).arg(total));
+    });
+    connect(m_exportJob, &ExportJob::exportFinished, this, [this, progressDialog](bool ok, const QString &message) {
+        progressDialog->close();
+        if (ok) {
+            QMessageBox::information(this, "成功", message);
+        } else {
+            QMessageBox::warning(this, "导出失败", message);
         }
-        file.close();
-        QMessageBox::information(this, "成功", "数据已导出到：" + fileName);
-    } else {
-        QMessageBox::warning(this, "错误", "无法创建文件：" + fileName);
-    }
+    });
+    connect(m_exportJob, &QThread::finished, m_exportJob, &QObject::deleteLater);
+    connect(m_exportJob, &QObject::destroyed, this, [this]() { m_exportJob = nullptr; });
+
+    m_exportJob->start();
 }
 
 void MainWindow::onTaskReminder(const Task &task)
@@ -395,11 +569,17 @@ void MainWindow::onTaskReminder(const Task &task)
                                  .arg(task.deadline.toString("yyyy-MM-dd HH:mm")));
 }
 
-void MainWindow::onTaskDataChanged()
+void MainWindow::onTaskWriteFailed(const QString &message)
+{
+    QMessageBox::warning(this, "保存失败", message);
+}
+
+void MainWindow::onDatabaseChanged()
 {
-    qDebug() << "任务数据变化，更新提醒线程...";
-    if (m_reminderThread && m_taskModel) {
-        m_reminderThread->setTasks(m_taskModel->getAllTasks());
+    if (!m_taskModel) return;
+
+    if (m_taskModel->applyDatabaseChanges()) {
+        ui->statusbar->showMessage("已同步其他程序对数据库的修改", 3000);
     }
 }
 
@@ -427,7 +607,9 @@ void MainWindow::onSelectionChanged(const QItemSelection &selected, const QItemS
     ui->lineEdit_Title->setText(task.title);
     ui->dateTimeEdit_Deadline->setDateTime(task.deadline);
     ui->comboBox_Priority->setCurrentIndex(task.priority);
-    ui->textEdit_Description->setText(task.description);
+    ui->lineEdit_Tags->setText(task.tags.join(" "));
+    // 描述不随列表加载，选中时再读取
+    ui->textEdit_Description->setText(DBManager::instance()->getTaskDescription(taskId));
 
     qDebug() << "选中任务：" << task.title;
 }
@@ -451,6 +633,277 @@ void MainWindow::onTableDoubleClicked(const QModelIndex &index)
     }
 }
 
+void MainWindow::onTableContextMenu(const QPoint &pos)
+{
+    if (!m_taskModel) return;
+
+    QModelIndex index = ui->tableView_Tasks->indexAt(pos);
+    if (!index.isValid()) return;
+
+    // 右键点在已选中的行上时保留多选，否则只选中该行
+    if (!ui->tableView_Tasks->selectionModel()->isRowSelected(index.row(), index.parent())) {
+        ui->tableView_Tasks->selectRow(index.row());
+    }
+    QList<int> taskIds = getSelectedTaskIds();
+    if (taskIds.isEmpty()) return;
+
+    QMenu menu(this);
+    QAction *completeAction = menu.addAction("标记为已完成");
+    QAction *uncompleteAction = menu.addAction("标记为未完成");
+    QMenu *priorityMenu = menu.addMenu("设置优先级");
+    QList<QAction *> priorityActions;
+    for (const QString &name : QStringList{"低", "中", "高"}) {
+        priorityActions << priorityMenu->addAction(name);
+    }
+    QAction *shiftAction = menu.addAction("截止时间顺延...");
+    QAction *deleteAction = menu.addAction(taskIds.size() == 1 ? "删除任务"
+                                                                : "删除选中的任务");
+
+    menu.addSeparator();
+    QAction *subtaskAction = taskIds.size() == 1 ? menu.addAction("添加子任务...") : nullptr;
+    QAction *moveUnderAction = menu.addAction("设为子任务...");
+    QAction *detachAction = menu.addAction("移出父任务");
+    bool hasParent = false;
+    for (int id : taskIds) {
+        hasParent = hasParent || m_taskModel->getTaskById(id).parentId != -1;
+    }
+    detachAction->setEnabled(hasParent);
+
+    // 依赖操作只对单个任务有意义
+    QAction *addAction = nullptr;
+    QAction *removeAction = nullptr;
+    QAction *pathAction = nullptr;
+    int taskId = taskIds.size() == 1 ? taskIds.first() : -1;
+    if (taskId != -1) {
+        menu.addSeparator();
+        addAction = menu.addAction("添加前置任务...");
+        removeAction = menu.addAction("移除前置任务...");
+        pathAction = menu.addAction("查看关键路径");
+        removeAction->setEnabled(!m_taskModel->dependencyGraph().blockersOf(taskId).isEmpty());
+    }
+
+    QAction *selected = menu.exec(ui->tableView_Tasks->viewport()->mapToGlobal(pos));
+    if (!selected) return;
+
+    if (selected == completeAction || selected == uncompleteAction) {
+        bool completed = selected == completeAction;
+        updateSelectedTasks(taskIds, selected->text(),
+                            [completed](Task &task) { task.isCompleted = completed; });
+    } else if (priorityActions.contains(selected)) {
+        int priority = priorityActions.indexOf(selected);
+        updateSelectedTasks(taskIds, "设置优先级为" + selected->text(),
+                            [priority](Task &task) { task.priority = priority; });
+    } else if (selected == shiftAction) {
+        bool ok = false;
+        int days = QInputDialog::getInt(this, "截止时间顺延", "顺延天数（负数表示提前）：",
+                                        1, -365, 365, 1, &ok);
+        if (!ok || days == 0) return;
+        updateSelectedTasks(taskIds, QString("截止时间顺延 %1 天").arg(days),
+                            [days](Task &task) { task.deadline = task.deadline.addDays(days); });
+    } else if (selected == deleteAction) {
+        on_btnDeleteTask_clicked();
+    } else if (selected == subtaskAction) {
+        addSubtaskFor(taskIds.first());
+    } else if (selected == moveUnderAction) {
+        moveTasksUnder(taskIds);
+    } else if (selected == detachAction) {
+        updateSelectedTasks(taskIds, "移出父任务", [](Task &task) { task.parentId = -1; });
+    } else if (selected == addAction) {
+        addDependencyForTask(taskId);
+    } else if (selected == removeAction) {
+        removeDependencyForTask(taskId);
+    } else if (selected == pathAction) {
+        showCriticalPath(taskId);
+    }
+}
+
+// 批量修改选中任务：一次确认、一个事务、一次分组的模型更新
+void MainWindow::updateSelectedTasks(const QList<int> &taskIds, const QString &actionName,
+                                     const std::function<void(Task &)> &change)
+{
+    if (taskIds.size() > 1
+        && QMessageBox::question(this, "确认",
+                                 QString("确定要对选中的 %1 个任务执行“%2”吗？")
+                                     .arg(taskIds.size()).arg(actionName),
+                                 QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes) {
+        return;
+    }
+
+    QList<Task> tasks;
+    tasks.reserve(taskIds.size());
+    for (int taskId : taskIds) {
+        Task task = m_taskModel->getTaskById(taskId);
+        if (task.id == -1) continue;
+        change(task);  // 列表缓存不含描述，descriptionLoaded为false时不会改动描述
+        tasks.append(task);
+    }
+    if (tasks.isEmpty()) return;
+
+    QString error;
+    if (!m_taskModel->updateTasks(tasks, &error)) {
+        QMessageBox::warning(this, "错误", "批量修改失败：" + error);
+        return;
+    }
+    ui->statusbar->showMessage(QString("已对 %1 个任务执行“%2”").arg(tasks.size()).arg(actionName),
+                               3000);
+}
+
+void MainWindow::addDependencyForTask(int taskId)
+{
+    const TaskDependencyGraph &graph = m_taskModel->dependencyGraph();
+    QList<int> existing = graph.blockersOf(taskId);
+
+    QStringList items;
+    QList<int> ids;
+    for (const Task &task : m_taskModel->getAllTasks()) {
+        if (task.id == taskId || existing.contains(task.id)) continue;
+        items << QString("#%1 %2").arg(task.id).arg(task.title);
+        ids << task.id;
+    }
+
+    if (items.isEmpty()) {
+        QMessageBox::information(this, "提示", "没有可作为前置任务的任务");
+        return;
+    }
+
+    bool ok = false;
+    QString item = QInputDialog::getItem(this, "添加前置任务",
+                                         "选择必须先完成的任务：", items, 0, false, &ok);
+    if (!ok) return;
+
+    int blockerId = ids.value(items.indexOf(item), -1);
+    QString error;
+    if (blockerId == -1 || !m_taskModel->addDependency(blockerId, taskId, &error)) {
+        QMessageBox::warning(this, "错误", "无法添加依赖：" + error);
+        return;
+    }
+    ui->statusbar->showMessage("依赖已添加", 2000);
+}
+
+void MainWindow::removeDependencyForTask(int taskId)
+{
+    QStringList items;
+    QList<int> ids;
+    for (int blockerId : m_taskModel->dependencyGraph().blockersOf(taskId)) {
+        Task blocker = m_taskModel->getTaskById(blockerId);
+        items << QString("#%1 %2").arg(blockerId).arg(blocker.title);
+        ids << blockerId;
+    }
+    if (items.isEmpty()) return;
+
+    bool ok = false;
+    QString item = QInputDialog::getItem(this, "移除前置任务",
+                                         "选择要移除的前置任务：", items, 0, false, &ok);
+    if (!ok) return;
+
+    int blockerId = ids.value(items.indexOf(item), -1);
+    if (blockerId == -1 || !m_taskModel->removeDependency(blockerId, taskId)) {
+        QMessageBox::warning(this, "错误", "无法移除依赖");
+        return;
+    }
+    ui->statusbar->showMessage("依赖已移除", 2000);
+}
+
+void MainWindow::showCriticalPath(int taskId)
+{
+    const TaskDependencyGraph &graph = m_taskModel->dependencyGraph();
+    QStringList lines;
+    for (int id : graph.criticalPath(taskId)) {
+        Task task = m_taskModel->getTaskById(id);
+        lines << QString("%1（截止：%2）")
+                     .arg(task.title)
+                     .arg(task.deadline.toString("yyyy-MM-dd HH:mm"));
+    }
+
+    Task task = m_taskModel->getTaskById(taskId);
+    QString text = QString("关键路径：\n%1\n\n最早完成时间：%2%3")
+                       .arg(lines.join("\n  ↓\n"))
+                       .arg(graph.earliestFinish(taskId).toString("yyyy-MM-dd HH:mm"))
+                       .arg(graph.isLate(taskId) ? "\n（晚于该任务的截止时间）" : "");
+    QMessageBox::information(this, QString("关键路径 - %1").arg(task.title), text);
+}
+
+void MainWindow::onTreeContextMenu(const QPoint &pos)
+{
+    if (!m_treeModel) return;
+
+    int taskId = m_treeModel->taskIdAt(ui->treeView_Tasks->indexAt(pos));
+    if (taskId == -1) return;
+    Task task = m_taskModel->getTaskById(taskId);
+
+    QMenu menu(this);
+    QAction *subtaskAction = menu.addAction("添加子任务...");
+    QAction *moveUnderAction = menu.addAction("设为子任务...");
+    QAction *detachAction = menu.addAction("移出父任务");
+    detachAction->setEnabled(task.parentId != -1);
+    menu.addSeparator();
+    QAction *locateAction = menu.addAction("在列表中定位");
+
+    QAction *selected = menu.exec(ui->treeView_Tasks->viewport()->mapToGlobal(pos));
+    if (selected == subtaskAction) {
+        addSubtaskFor(taskId);
+    } else if (selected == moveUnderAction) {
+        moveTasksUnder({taskId});
+    } else if (selected == detachAction) {
+        updateSelectedTasks({taskId}, "移出父任务", [](Task &task) { task.parentId = -1; });
+    } else if (selected == locateAction) {
+        onTimelineTaskActivated(taskId);
+    }
+}
+
+// 新子任务沿用父任务的截止时间和优先级，之后可在列表中修改
+void MainWindow::addSubtaskFor(int parentId)
+{
+    Task parent = m_taskModel->getTaskById(parentId);
+    if (parent.id == -1) return;
+
+    bool ok = false;
+    QString title = QInputDialog::getText(this, "添加子任务",
+                                          QString("“%1”的子任务标题：").arg(parent.title),
+                                          QLineEdit::Normal, QString(), &ok).trimmed();
+    if (!ok || title.isEmpty()) return;
+
+    Task task;
+    task.title = title;
+    task.deadline = parent.deadline;
+    task.priority = parent.priority;
+    task.descriptionLoaded = true;
+    task.parentId = parentId;
+    m_taskModel->addTask(task);
+    ui->statusbar->showMessage(QString("已为“%1”添加子任务").arg(parent.title), 3000);
+}
+
+void MainWindow::moveTasksUnder(const QList<int> &taskIds)
+{
+    // 不能挂到自己或自己的子任务下面（数据库触发器也会拒绝）
+    const QList<int> descendants = DBManager::instance()->getDescendantIds(taskIds);
+    QSet<int> excluded(descendants.begin(), descendants.end());
+    excluded.unite(QSet<int>(taskIds.begin(), taskIds.end()));
+
+    QStringList items;
+    QList<int> ids;
+    for (const Task &task : m_taskModel->getAllTasks()) {
+        if (excluded.contains(task.id)) continue;
+        items << QString("#%1 %2").arg(task.id).arg(task.title);
+        ids << task.id;
+    }
+
+    if (items.isEmpty()) {
+        QMessageBox::information(this, "提示", "没有可作为父任务的任务");
+        return;
+    }
+
+    bool ok = false;
+    QString item = QInputDialog::getItem(this, "设为子任务",
+                                         "选择父任务：", items, 0, false, &ok);
+    if (!ok) return;
+
+    int parentId = ids.value(items.indexOf(item), -1);
+    if (parentId == -1) return;
+    updateSelectedTasks(taskIds, QString("设为 #%1 的子任务").arg(parentId),
+                        [parentId](Task &task) { task.parentId = parentId; });
+}
+
 int MainWindow::getSelectedTaskId() const
 {
     if (!m_taskModel) return -1;
@@ -458,24 +911,467 @@ int MainWindow::getSelectedTaskId() const
     QModelIndexList selectedRows = ui->tableView_Tasks->selectionModel()->selectedRows();
     if (selectedRows.isEmpty()) return -1;
 
-    QModelIndex index = selectedRows.first();
-    QList<Task> tasks = m_taskModel->getAllTasks();
+    // 视图经过过滤代理，行号与模型行号不一致，通过角色取任务ID
+    QVariant taskId = selectedRows.first().data(TaskModel::TaskIdRole);
+    return taskId.isValid() ? taskId.toInt() : -1;
+}
+
+QList<int> MainWindow::getSelectedTaskIds() const
+{
+    QList<int> taskIds;
+    if (!m_taskModel) return taskIds;
+
+    const QModelIndexList selectedRows = ui->tableView_Tasks->selectionModel()->selectedRows();
+    taskIds.reserve(selectedRows.size());
+    for (const QModelIndex &index : selectedRows) {
+        QVariant taskId = index.data(TaskModel::TaskIdRole);
+        if (taskId.isValid()) taskIds.append(taskId.toInt());
+    }
+    return taskIds;
+}
+
+void MainWindow::onTimelineTaskActivated(int taskId)
+{
+    if (!m_taskModel || !m_proxyModel) return;
 
-    if (index.row() >= tasks.size()) return -1;
-    return tasks[index.row()].id;
+    int row = m_taskModel->rowOfTask(taskId);
+    QModelIndex index = m_proxyModel->mapFromSource(m_taskModel->index(row, 0));
+    if (!index.isValid()) {
+        ui->statusbar->showMessage("该任务被当前标签过滤隐藏", 3000);
+        return;
+    }
+
+    ui->tabWidget_Views->setCurrentWidget(ui->tab_List);
+    ui->tableView_Tasks->selectRow(index.row());
+    ui->tableView_Tasks->scrollTo(index);
+}
+
+void MainWindow::on_lineEdit_TagFilter_textChanged(const QString &text)
+{
+    Q_UNUSED(text);
+    applyTagFilter();
+}
+
+void MainWindow::on_checkBox_HideCompleted_toggled(bool checked)
+{
+    Q_UNUSED(checked);
+    applyTagFilter();
+}
+
+void MainWindow::applyTagFilter()
+{
+    if (!m_proxyModel) return;
+
+    m_proxyModel->setTagFilter(ui->lineEdit_TagFilter->text(), ui->checkBox_HideCompleted->isChecked());
+    if (m_proxyModel->isFiltering()) {
+        ui->statusbar->showMessage(QString("显示 %1 / %2 个任务")
+                                       .arg(m_proxyModel->rowCount())
+                                       .arg(m_taskModel->rowCount()), 3000);
+    }
+}
+
+// 每次输入都在内存中的拼音索引上查找，不访问数据库
+void MainWindow::on_lineEdit_Search_textChanged(const QString &text)
+{
+    if (!m_proxyModel) return;
+
+    m_proxyModel->setTitleSearch(text);
+    if (m_proxyModel->isFiltering()) {
+        ui->statusbar->showMessage(QString("显示 %1 / %2 个任务")
+                                       .arg(m_proxyModel->rowCount())
+                                       .arg(m_taskModel->rowCount()), 3000);
+    }
+}
+
+void MainWindow::on_lineEdit_Query_returnPressed()
+{
+    applyQueryFilter();
+}
+
+void MainWindow::on_comboBox_SavedFilters_activated(int index)
+{
+    // 第0项为"（不筛选）"
+    ui->lineEdit_Query->setText(index > 0 ? ui->comboBox_SavedFilters->itemData(index).toString() : QString());
+    applyQueryFilter();
+}
+
+void MainWindow::on_btnSaveFilter_clicked()
+{
+    QString expression = ui->lineEdit_Query->text().trimmed();
+    QString error;
+    TaskFilter filter = TaskFilter::compile(expression, &error);
+    if (expression.isEmpty() || !filter.isValid()) {
+        QMessageBox::warning(this, "保存筛选", expression.isEmpty() ? "请先输入筛选表达式" : error);
+        return;
+    }
+
+    QString current = ui->comboBox_SavedFilters->currentIndex() > 0 ? ui->comboBox_SavedFilters->currentText()
+                                                                    : QString();
+    bool ok = false;
+    QString name = QInputDialog::getText(this, "保存筛选", "筛选名称：", QLineEdit::Normal, current, &ok).trimmed();
+    if (!ok || name.isEmpty()) return;
+
+    if (!DBManager::instance()->saveFilter(name, expression)) {
+        QMessageBox::critical(this, "保存筛选", "保存失败，请查看日志");
+        return;
+    }
+    reloadSavedFilters(name);
+    ui->statusbar->showMessage(QString("已保存筛选：%1").arg(name), 3000);
+}
+
+void MainWindow::on_btnDeleteFilter_clicked()
+{
+    int index = ui->comboBox_SavedFilters->currentIndex();
+    if (index <= 0) return;
+
+    QString name = ui->comboBox_SavedFilters->currentText();
+    if (QMessageBox::question(this, "删除筛选", QString("确定删除筛选“%1”吗？").arg(name)) != QMessageBox::Yes)
+        return;
+
+    if (DBManager::instance()->deleteSavedFilter(name)) {
+        reloadSavedFilters();
+    }
+}
+
+void MainWindow::reloadSavedFilters(const QString &current)
+{
+    ui->comboBox_SavedFilters->clear();
+    ui->comboBox_SavedFilters->addItem("（不筛选）");
+    for (const auto &filter : DBManager::instance()->getSavedFilters()) {
+        ui->comboBox_SavedFilters->addItem(filter.first, filter.second);
+        ui->comboBox_SavedFilters->setItemData(ui->comboBox_SavedFilters->count() - 1,
+                                               filter.second, Qt::ToolTipRole);
+    }
+    int index = current.isEmpty() ? 0 : ui->comboBox_SavedFilters->findText(current);
+    ui->comboBox_SavedFilters->setCurrentIndex(qMax(0, index));
+}
+
+// 表达式只在应用时解析一次，之后数据变化只重新执行已缓存的预编译语句
+void MainWindow::applyQueryFilter()
+{
+    if (!m_proxyModel) return;
+
+    QString error;
+    TaskFilter filter = TaskFilter::compile(ui->lineEdit_Query->text(), &error);
+    if (!filter.isValid()) {
+        ui->lineEdit_Query->setToolTip(error);
+        ui->statusbar->showMessage("筛选表达式有误：" + error, 5000);
+        return;
+    }
+
+    ui->lineEdit_Query->setToolTip(QString());
+    m_proxyModel->setQueryFilter(filter);
+    if (m_proxyModel->isFiltering()) {
+        ui->statusbar->showMessage(QString("显示 %1 / %2 个任务")
+                                       .arg(m_proxyModel->rowCount())
+                                       .arg(m_taskModel->rowCount()), 3000);
+    }
 }
 
 void MainWindow::clearInputForm()
 {
     ui->lineEdit_Title->clear();
-    ui->dateTimeEdit_Deadline->setDateTime(QDateTime::currentDateTime().addSecs(3600));
+    ui->dateTimeEdit_Deadline->setDateTime(m_clock->now().addSecs(3600));
     ui->comboBox_Priority->setCurrentIndex(1);
     ui->textEdit_Description->clear();
+    ui->lineEdit_Tags->clear();
     if (ui->tableView_Tasks->selectionModel()) {
         ui->tableView_Tasks->clearSelection();
     }
 }
 
+void MainWindow::on_actionSync_triggered()
+{
+    if (!m_taskModel) {
+        QMessageBox::warning(this, "错误", "数据库不可用，无法同步");
+        return;
+    }
+    if (m_syncJob) {
+        QMessageBox::information(this, "提示", "已有同步正在进行");
+        return;
+    }
+
+    // 允许选择不存在的文件：首次同步时会在对端创建数据库
+    QString fileName = QFileDialog::getSaveFileName(this, "选择要同步的数据库",
+                                                    QDir::homePath() + "/TaskManager.db",
+                                                    "SQLite数据库 (*.db)", nullptr,
+                                                    QFileDialog::DontConfirmOverwrite);
+    if (fileName.isEmpty()) return;
+
+    ui->statusbar->showMessage("正在同步...");
+    m_taskModel->flushPendingWrites();
+
+    // 同步在后台线程的独立连接上进行，界面不必等待
+    m_syncJob = new SyncJob(fileName, this);
+    connect(m_syncJob, &SyncJob::syncFinished, this, [this](bool ok, const QString &summary) {
+        // 同步写入的行都带有新的行版本号，增量应用即可
+        m_taskModel->applyDatabaseChanges();
+        if (ok) {
+            ui->statusbar->showMessage("同步完成", 2000);
+            QMessageBox::information(this, "同步完成", summary);
+        } else {
+            ui->statusbar->showMessage("同步失败", 2000);
+            QMessageBox::warning(this, "同步失败", summary);
+        }
+    });
+    connect(m_syncJob, &QThread::finished, m_syncJob, &QObject::deleteLater);
+    connect(m_syncJob, &QObject::destroyed, this, [this]() { m_syncJob = nullptr; });
+
+    m_syncJob->start();
+}
+
+void MainWindow::on_actionShowArchive_triggered()
+{
+    if (!m_taskModel) {
+        QMessageBox::warning(this, "错误", "数据库不可用");
+        return;
+    }
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("已归档任务");
+    dialog.resize(600, 450);
+
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    layout->addWidget(new QLabel(QString("共 %1 个已归档任务（滚动时按需加载）")
+                                     .arg(DBManager::instance()->archivedTaskCount()), &dialog));
+
+    // 模型按需分页读取，打开对话框时只加载第一页
+    ArchiveModel *model = new ArchiveModel(&dialog);
+    QTableView *view = new QTableView(&dialog);
+    view->setModel(model);
+    view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    view->horizontalHeader()->setStretchLastSection(true);
+    view->setColumnWidth(ArchiveModel::ColumnTitle, 300);
+    view->setColumnWidth(ArchiveModel::ColumnDeadline, 150);
+    layout->addWidget(view);
+
+    dialog.exec();
+}
+
+void MainWindow::on_actionArchiveSettings_triggered()
+{
+    if (!m_archiveManager) {
+        QMessageBox::warning(this, "错误", "数据库不可用");
+        return;
+    }
+
+    bool ok = false;
+    int days = QInputDialog::getInt(this, "归档设置",
+                                    "已完成任务保留天数（超过后在空闲时移入归档，0 表示不归档）：",
+                                    m_archiveManager->retentionDays(), 0, 3650, 1, &ok);
+    if (ok) {
+        m_archiveManager->setRetentionDays(days);
+        ui->statusbar->showMessage("归档设置已保存", 2000);
+    }
+}
+
+void MainWindow::on_actionBackupNow_triggered()
+{
+    if (!m_backupManager) {
+        QMessageBox::warning(this, "错误", "数据库不可用");
+        return;
+    }
+    if (m_taskModel) {
+        m_taskModel->flushPendingWrites();
+    }
+    if (m_backupManager->backupNow()) {
+        ui->statusbar->showMessage("正在后台备份...", 2000);
+    } else {
+        ui->statusbar->showMessage("已有备份正在进行", 2000);
+    }
+}
+
+void MainWindow::on_actionRestoreBackup_triggered()
+{
+    if (!m_backupManager || !m_taskModel) {
+        QMessageBox::warning(this, "错误", "数据库不可用");
+        return;
+    }
+
+    QString path = QFileDialog::getOpenFileName(this, "选择备份文件", m_backupManager->backupDirectory(),
+                                                "备份文件 (*.db *.qz);;所有文件 (*)");
+    if (path.isEmpty()) return;
+
+    if (QMessageBox::question(this, "从备份恢复",
+                              "恢复会用备份覆盖当前的全部数据，确定继续吗？") != QMessageBox::Yes) {
+        return;
+    }
+
+    // 恢复前提交排队的修改，避免之后写到恢复后的数据上
+    m_taskModel->flushPendingWrites();
+    // 后台迁移与恢复不能同时写同一个文件；恢复后按恢复的数据重新检查待迁移项
+    stopDataMigrations();
+    QString error;
+    bool restored = m_backupManager->restore(path, &error);
+    startDataMigrations();
+    if (!restored) {
+        QMessageBox::warning(this, "恢复失败", error);
+        return;
+    }
+
+    m_taskModel->refreshTasks();
+    reloadSavedFilters();
+    QMessageBox::information(this, "成功", "已从备份恢复：" + path);
+}
+
+void MainWindow::on_actionBackupSettings_triggered()
+{
+    if (!m_backupManager) {
+        QMessageBox::warning(this, "错误", "数据库不可用");
+        return;
+    }
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("备份设置");
+    QFormLayout *layout = new QFormLayout(&dialog);
+
+    QSpinBox *intervalSpin = new QSpinBox(&dialog);
+    intervalSpin->setRange(0, 24 * 30);
+    intervalSpin->setSuffix(" 小时");
+    intervalSpin->setSpecialValueText("不自动备份");
+    intervalSpin->setValue(m_backupManager->intervalHours());
+    layout->addRow("备份间隔：", intervalSpin);
+
+    QSpinBox *keepSpin = new QSpinBox(&dialog);
+    keepSpin->setRange(1, 365);
+    keepSpin->setValue(m_backupManager->keepCount());
+    layout->addRow("保留份数：", keepSpin);
+
+    QCheckBox *compressCheck = new QCheckBox("压缩备份文件", &dialog);
+    compressCheck->setChecked(m_backupManager->compress());
+    layout->addRow(QString(), compressCheck);
+
+    QHBoxLayout *dirLayout = new QHBoxLayout;
+    QLineEdit *dirEdit = new QLineEdit(m_backupManager->backupDirectory(), &dialog);
+    QPushButton *browseButton = new QPushButton("浏览...", &dialog);
+    dirLayout->addWidget(dirEdit);
+    dirLayout->addWidget(browseButton);
+    layout->addRow("备份目录：", dirLayout);
+    connect(browseButton, &QPushButton::clicked, &dialog, [&dialog, dirEdit]() {
+        QString dir = QFileDialog::getExistingDirectory(&dialog, "选择备份目录", dirEdit->text());
+        if (!dir.isEmpty()) dirEdit->setText(dir);
+    });
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    layout->addRow(buttons);
+
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    m_backupManager->setIntervalHours(intervalSpin->value());
+    m_backupManager->setCompress(compressCheck->isChecked());
+    if (dirEdit->text() != m_backupManager->backupDirectory()) {
+        m_backupManager->setBackupDirectory(dirEdit->text());
+    }
+    m_backupManager->setKeepCount(keepSpin->value());
+    ui->statusbar->showMessage("备份设置已保存", 2000);
+}
+
+void MainWindow::onBackupFinished(bool ok, const QString &message)
+{
+    if (ok) {
+        ui->statusbar->showMessage(message, 5000);
+    } else {
+        ui->statusbar->showMessage("备份失败：" + message, 10000);
+    }
+}
+
+void MainWindow::on_actionFindDuplicates_triggered()
+{
+    if (!m_taskModel) {
+        QMessageBox::warning(this, "错误", "数据库不可用，无法查找重复任务");
+        return;
+    }
+
+    DuplicatesDialog dialog(m_taskModel, this);
+    connect(&dialog, &DuplicatesDialog::taskActivated, this, &MainWindow::onTimelineTaskActivated);
+    dialog.exec();
+}
+
+void MainWindow::on_actionDiagnostics_triggered()
+{
+    DiagnosticsDialog dialog(m_metricsExporter, this);
+    dialog.exec();
+}
+
+void MainWindow::on_actionMaintenance_triggered()
+{
+    if (!m_maintenanceManager) {
+        QMessageBox::warning(this, "错误", "数据库不可用");
+        return;
+    }
+
+    DatabaseStats stats;
+    DBManager::instance()->getDatabaseStats(&stats);
+    QDateTime last = m_maintenanceManager->lastRun();
+    QString text = QString("文件大小：%1\n页数：%2（每页 %3 字节）\n空闲页：%4（%5%）\n增量回收：%6\n\n"
+                           "上次维护：%7\n%8")
+                       .arg(QLocale().formattedDataSize(stats.fileBytes))
+                       .arg(stats.pageCount)
+                       .arg(stats.pageSize)
+                       .arg(stats.freePages)
+                       .arg(stats.freeRatio() * 100, 0, 'f', 1)
+                       .arg(stats.autoVacuum == 2 ? "已启用" : "未启用（下次维护时若库较小会整库重建）")
+                       .arg(last.isValid() ? last.toString("yyyy-MM-dd HH:mm") : "从未")
+                       .arg(m_maintenanceManager->lastSummary());
+
+    QMessageBox box(QMessageBox::Information, "数据库维护", text, QMessageBox::Close, this);
+    QPushButton *runButton = box.addButton("立即维护", QMessageBox::ActionRole);
+    runButton->setEnabled(!m_maintenanceManager->isRunning());
+    box.exec();
+    if (box.clickedButton() == runButton) {
+        if (m_taskModel) m_taskModel->flushPendingWrites();
+        m_maintenanceManager->runNow();
+        ui->statusbar->showMessage("正在维护数据库...", 2000);
+    }
+}
+
+void MainWindow::startDataMigrations()
+{
+    if (m_migrationThread) return;
+
+    m_migrationThread = new MigrationThread(this);
+    connect(m_migrationThread, &MigrationThread::migrationProgress, this,
+            [this](const QString &description, qint64 rows) {
+                ui->statusbar->showMessage(QString("正在后台%1：已处理 %2 行").arg(description).arg(rows), 2000);
+            });
+    connect(m_migrationThread, &MigrationThread::migrationsFinished,
+            this, &MainWindow::onMigrationsFinished);
+    m_migrationThread->start(QThread::LowPriority);
+}
+
+void MainWindow::stopDataMigrations()
+{
+    if (!m_migrationThread) return;
+
+    // 未完成的批次会提交后停止，剩余部分下次启动时继续
+    m_migrationThread->stopThread();
+    m_migrationThread->wait();
+    delete m_migrationThread;
+    m_migrationThread = nullptr;
+}
+
+void MainWindow::onMigrationsFinished(bool ok, const QString &message)
+{
+    if (ok) {
+        // 迁移改写的行由 DbChangeWatcher 增量拉取，这里再补一次以免错过最后一批
+        if (m_taskModel) m_taskModel->applyDatabaseChanges();
+        ui->statusbar->showMessage(message, 5000);
+    } else {
+        ui->statusbar->showMessage("数据迁移失败（下次启动时重试）：" + message, 10000);
+    }
+}
+
+void MainWindow::onTasksArchived(int count)
+{
+    if (!m_taskModel) return;
+
+    // 归档通过本连接删除了行，data_version 不会变化，需要主动拉取增量
+    m_taskModel->applyDatabaseChanges();
+    ui->statusbar->showMessage(QString("已归档 %1 个已完成任务").arg(count), 3000);
+}
+
 void MainWindow::on_actionExit_triggered()
 {
     QApplication::quit();
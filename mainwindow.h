@@ -3,8 +3,20 @@
 
 #include <QMainWindow>
 #include <QItemSelection>
+#include <functional>
 #include "taskmodel.h"
+#include "taskfilterproxymodel.h"
+#include "tasktreemodel.h"
 #include "reminderthread.h"
+#include "dbchangewatcher.h"
+#include "archivemanager.h"
+#include "exportjob.h"
+#include "syncjob.h"
+#include "backupmanager.h"
+#include "migrationthread.h"
+#include "maintenancemanager.h"
+#include "metricsexporter.h"
+#include "clock.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -18,6 +30,9 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // 替换截止时间检查和提醒使用的时钟（如模拟时钟），需在初始化完成前调用
+    void setClock(Clock *clock);
+
 private slots:
     // 按钮点击事件
     void on_btnAddTask_clicked();    // 添加任务
@@ -25,20 +40,58 @@ private slots:
     void on_btnDeleteTask_clicked(); // 删除任务
     void on_btnRefresh_clicked();    // 刷新任务列表
     void on_btnStats_clicked();      // 显示统计信息
+    void on_btnTrends_clicked();     // 历史趋势
     void on_btnExport_clicked();     // 导出文件
+    // 标签过滤
+    void on_lineEdit_TagFilter_textChanged(const QString &text);
+    void on_checkBox_HideCompleted_toggled(bool checked);
+    // 标题搜索（拼音/首字母）
+    void on_lineEdit_Search_textChanged(const QString &text);
+    // 筛选表达式
+    void on_lineEdit_Query_returnPressed();
+    void on_comboBox_SavedFilters_activated(int index);
+    void on_btnSaveFilter_clicked();
+    void on_btnDeleteFilter_clicked();
     // 菜单栏事件
+    void on_actionSync_triggered();   // 与其他数据库同步
+    void on_actionShowArchive_triggered();     // 查看已归档任务
+    void on_actionArchiveSettings_triggered(); // 归档设置
+    void on_actionBackupNow_triggered();       // 立即备份
+    void on_actionRestoreBackup_triggered();   // 从备份恢复
+    void on_actionBackupSettings_triggered();  // 备份设置
+    void on_actionFindDuplicates_triggered();  // 查找并合并重复任务
+    void on_actionMaintenance_triggered();     // 数据库维护
+    void on_actionDiagnostics_triggered();     // 运行诊断（耗时与计数指标）
     void on_actionExit_triggered();   // 退出程序
     void on_actionAbout_triggered();  // 关于程序
     // 其他槽函数
     void onTaskReminder(const Task &task); // 接收任务提醒
-    void onTaskDataChanged();             // 任务数据变化（更新线程任务列表）
+    void onTaskWriteFailed(const QString &message); // 延迟写入提交失败
     void onSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected);
     void onTableDoubleClicked(const QModelIndex &index);
+    void onTableContextMenu(const QPoint &pos);
+    void onDatabaseChanged();             // 其他进程修改了数据库
+    void onTasksArchived(int count);      // 后台归档了一批任务
+    void onBackupFinished(bool ok, const QString &message); // 后台备份结束
+    void onMigrationsFinished(bool ok, const QString &message); // 后台数据迁移结束
+    void onTimelineTaskActivated(int taskId); // 在时间线中双击任务
+    void onTreeContextMenu(const QPoint &pos);
 
 private:
     Ui::MainWindow *ui;
+    Clock *m_clock;
     TaskModel *m_taskModel;
+    TaskFilterProxyModel *m_proxyModel;
+    TaskTreeModel *m_treeModel;
     ReminderThread *m_reminderThread;
+    DbChangeWatcher *m_dbWatcher;
+    ArchiveManager *m_archiveManager;
+    ExportJob *m_exportJob;
+    SyncJob *m_syncJob;
+    BackupManager *m_backupManager;
+    MigrationThread *m_migrationThread;
+    MaintenanceManager *m_maintenanceManager;
+    MetricsExporter *m_metricsExporter;
 
     // 新增方法
     void initializeApplication();
@@ -46,9 +99,21 @@ private:
 
     // 原有方法
     int getSelectedTaskId() const;
+    QList<int> getSelectedTaskIds() const;
+    void updateSelectedTasks(const QList<int> &taskIds, const QString &actionName,
+                             const std::function<void(Task &)> &change);
+    void applyTagFilter();
+    void applyQueryFilter();
+    void reloadSavedFilters(const QString &current = QString());
     void clearInputForm();
-    void exportToExcel();
-    void exportToText();
+    void addDependencyForTask(int taskId);
+    void removeDependencyForTask(int taskId);
+    void showCriticalPath(int taskId);
+    void addSubtaskFor(int parentId);
+    void moveTasksUnder(const QList<int> &taskIds);
+    void exportTasks(const QString &format);
+    void startDataMigrations();
+    void stopDataMigrations();
     void loadTasks() {}  // 空实现
     void addSampleTasks() {}  // 空实现
     void initApplication() {}  // 空实现
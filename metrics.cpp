@@ -0,0 +1,293 @@
+#include "metrics.h"
+#include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QTextStream>
+#include <memory>
+#include <vector>
+
+namespace {
+// Prometheus 直方图导出的桶上限：2^6-1 ~ 2^25-1 微秒（约 64us ~ 33.5s）
+const int kExportMinShift = 6;
+const int kExportMaxShift = 25;
+
+struct Quantile {
+    const char *suffix;
+    quint64 Histogram::Summary::*field;
+};
+const Quantile kQuantiles[] = {
+    {"p50", &Histogram::Summary::p50Micros},
+    {"p99", &Histogram::Summary::p99Micros},
+    {"max", &Histogram::Summary::maxMicros},
+};
+
+struct Entry {
+    QString name;
+    QString labels;
+    QString help;
+    Metrics::Type type;
+    std::unique_ptr<Counter> counter;
+    std::unique_ptr<Gauge> gauge;
+    std::unique_ptr<Histogram> histogram;
+};
+
+struct Registry {
+    QMutex mutex;
+    std::vector<std::unique_ptr<Entry>> entries;   // 按注册顺序
+    QHash<QString, Entry *> byKey;
+    QList<QPair<const void *, std::function<void()>>> collectors;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+Entry *findOrAdd(const QString &name, const QString &help, const QString &labels, Metrics::Type type)
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    const QString key = name + '{' + labels + '}';
+    Entry *entry = reg.byKey.value(key);
+    if (entry) {
+        if (entry->type != type)
+            qWarning() << "指标类型冲突：" << key;
+        return entry;
+    }
+
+    reg.entries.emplace_back(new Entry{name, labels, help, type, nullptr, nullptr, nullptr});
+    entry = reg.entries.back().get();
+    switch (type) {
+    case Metrics::CounterType: entry->counter.reset(new Counter); break;
+    case Metrics::GaugeType: entry->gauge.reset(new Gauge); break;
+    case Metrics::HistogramType: entry->histogram.reset(new Histogram); break;
+    }
+    reg.byKey.insert(key, entry);
+    return entry;
+}
+
+QString seconds(quint64 micros)
+{
+    return QString::number(micros / 1e6, 'g', 9);
+}
+
+// 在已有标签后追加一个标签
+QString withLabel(const QString &labels, const QString &extra)
+{
+    return '{' + (labels.isEmpty() ? extra : labels + ',' + extra) + '}';
+}
+}
+
+void Histogram::record(quint64 micros)
+{
+    m_buckets[bucketOf(micros)].fetchAndAddRelaxed(1);
+    m_count.fetchAndAddRelaxed(1);
+    m_sum.fetchAndAddRelaxed(micros);
+    quint64 current = m_max.loadRelaxed();
+    while (micros > current && !m_max.testAndSetRelaxed(current, micros, current)) {
+    }
+}
+
+int Histogram::bucketOf(quint64 micros)
+{
+    if (micros < quint64(kSubBuckets))
+        return int(micros);
+    // 最高位为 2^e 时，其后两位决定区间内的子桶
+    const int e = 63 - qCountLeadingZeroBits(micros);
+    const int sub = int((micros >> (e - 2)) & (kSubBuckets - 1));
+    return kSubBuckets + (e - 2) * kSubBuckets + sub;
+}
+
+quint64 Histogram::bucketUpperBound(int bucket)
+{
+    if (bucket < kSubBuckets)
+        return quint64(bucket);
+    const int e = (bucket - kSubBuckets) / kSubBuckets + 2;
+    const quint64 sub = quint64((bucket - kSubBuckets) % kSubBuckets);
+    const quint64 width = quint64(1) << (e - 2);
+    // 最后一个桶的上界会溢出，按最大值处理
+    return e == 63 && sub == kSubBuckets - 1 ? ~quint64(0) : (kSubBuckets + sub + 1) * width - 1;
+}
+
+Histogram::Summary Histogram::summary() const
+{
+    Summary result;
+    quint64 counts[kBucketCount];
+    for (int i = 0; i < kBucketCount; ++i) {
+        counts[i] = m_buckets[i].loadRelaxed();
+        result.count += counts[i];
+    }
+    result.sumMicros = m_sum.loadRelaxed();
+    result.maxMicros = m_max.loadRelaxed();
+    if (result.count == 0)
+        return result;
+
+    // 分位数取所在桶的上界，不超过记录到的最大值
+    const quint64 targets[3] = {(result.count + 1) / 2, (result.count * 9 + 9) / 10, (result.count * 99 + 99) / 100};
+    quint64 *outputs[3] = {&result.p50Micros, &result.p90Micros, &result.p99Micros};
+    quint64 seen = 0;
+    int next = 0;
+    for (int i = 0; i < kBucketCount && next < 3; ++i) {
+        seen += counts[i];
+        while (next < 3 && seen >= targets[next]) {
+            *outputs[next++] = qMin(bucketUpperBound(i), result.maxMicros);
+        }
+    }
+    return result;
+}
+
+quint64 Histogram::countAtMost(quint64 micros) const
+{
+    const int last = bucketOf(micros);
+    quint64 count = 0;
+    for (int i = 0; i <= last; ++i) {
+        count += m_buckets[i].loadRelaxed();
+    }
+    return count;
+}
+
+Counter *Metrics::counter(const QString &name, const QString &help, const QString &labels)
+{
+    return findOrAdd(name, help, labels, CounterType)->counter.get();
+}
+
+Gauge *Metrics::gauge(const QString &name, const QString &help, const QString &labels)
+{
+    return findOrAdd(name, help, labels, GaugeType)->gauge.get();
+}
+
+Histogram *Metrics::histogram(const QString &name, const QString &help, const QString &labels)
+{
+    return findOrAdd(name, help, labels, HistogramType)->histogram.get();
+}
+
+void Metrics::addCollector(const void *owner, const std::function<void()> &collect)
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    reg.collectors.append(qMakePair(owner, collect));
+}
+
+void Metrics::removeCollectors(const void *owner)
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (int i = reg.collectors.size() - 1; i >= 0; --i) {
+        if (reg.collectors.at(i).first == owner)
+            reg.collectors.removeAt(i);
+    }
+}
+
+QList<Metrics::Sample> Metrics::samples()
+{
+    Registry &reg = registry();
+
+    // 回调里会注册或更新指标，不能持锁调用
+    QList<QPair<const void *, std::function<void()>>> collectors;
+    {
+        QMutexLocker locker(&reg.mutex);
+        collectors = reg.collectors;
+    }
+    for (const auto &collector : collectors) {
+        collector.second();
+    }
+
+    QMutexLocker locker(&reg.mutex);
+    QList<Sample> result;
+    result.reserve(int(reg.entries.size()));
+    for (const auto &entry : reg.entries) {
+        Sample sample;
+        sample.name = entry->name;
+        sample.labels = entry->labels;
+        sample.help = entry->help;
+        sample.type = entry->type;
+        switch (entry->type) {
+        case CounterType: sample.value = qint64(entry->counter->value()); break;
+        case GaugeType: sample.value = entry->gauge->value(); break;
+        case HistogramType:
+            sample.summary = entry->histogram->summary();
+            sample.histogram = entry->histogram.get();
+            break;
+        }
+        result.append(sample);
+    }
+    return result;
+}
+
+QString Metrics::toPrometheusText()
+{
+    const QList<Sample> all = samples();
+
+    // 同一族的指标必须连续输出，HELP/TYPE 只写一次
+    QStringList order;
+    QHash<QString, QList<const Sample *>> families;
+    for (const Sample &sample : all) {
+        if (!families.contains(sample.name))
+            order.append(sample.name);
+        families[sample.name].append(&sample);
+    }
+
+    QString text;
+    QTextStream out(&text);
+    for (const QString &name : order) {
+        const QList<const Sample *> &family = families.value(name);
+        const Sample &first = *family.first();
+        static const char *const kTypeNames[] = {"counter", "gauge", "histogram"};
+        out << "# HELP " << name << ' ' << QString(first.help).replace('\\', "\\\\").replace('\n', "\\n") << '\n';
+        out << "# TYPE " << name << ' ' << kTypeNames[first.type] << '\n';
+
+        for (const Sample *sample : family) {
+            const QString labels = sample->labels.isEmpty() ? QString() : '{' + sample->labels + '}';
+            if (sample->type != HistogramType) {
+                out << name << labels << ' ' << sample->value << '\n';
+                continue;
+            }
+            // le 是“小于等于”：取 2 的幂之前那个桶的上界（含），计数与边界完全对应
+            for (int shift = kExportMinShift; shift <= kExportMaxShift; ++shift) {
+                const quint64 bound = (quint64(1) << shift) - 1;
+                out << name << "_bucket" << withLabel(sample->labels, QString("le=\"%1\"").arg(seconds(bound)))
+                    << ' ' << sample->histogram->countAtMost(bound) << '\n';
+            }
+            out << name << "_bucket" << withLabel(sample->labels, "le=\"+Inf\"") << ' ' << sample->summary.count << '\n';
+            out << name << "_sum" << labels << ' ' << seconds(sample->summary.sumMicros) << '\n';
+            out << name << "_count" << labels << ' ' << sample->summary.count << '\n';
+        }
+
+        // 分位数和最大值另作仪表导出，便于不做直方图计算的采集端直接使用
+        if (first.type == HistogramType) {
+            for (const Quantile &quantile : kQuantiles) {
+                out << "# TYPE " << name << '_' << quantile.suffix << " gauge\n";
+                for (const Sample *sample : family) {
+                    out << name << '_' << quantile.suffix
+                        << (sample->labels.isEmpty() ? QString() : '{' + sample->labels + '}')
+                        << ' ' << seconds(sample->summary.*quantile.field) << '\n';
+                }
+            }
+        }
+    }
+    out.flush();
+    return text;
+}
+
+bool Metrics::writePrometheusFile(const QString &path, QString *error)
+{
+    const QByteArray data = toPrometheusText().toUtf8();
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString Metrics::formatMicros(quint64 micros)
+{
+    if (micros < 1000)
+        return QString("%1 us").arg(micros);
+    if (micros < 1000 * 1000)
+        return QString::number(micros / 1000.0, 'f', micros < 10 * 1000 ? 2 : 1) + " ms";
+    return QString::number(micros / 1e6, 'f', 2) + " s";
+}
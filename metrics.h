@@ -0,0 +1,121 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+#include <functional>
+
+// 进程内运行指标：计数器、仪表和按对数分桶的耗时直方图
+// 指标在第一次取用时注册（只有这一步加锁），调用处用静态指针保存，之后的更新都是原子操作，
+// 任意线程都可以调用。例如：
+//     static Histogram *const latency = Metrics::histogram("zhsj_db_operation_seconds", "数据库操作耗时",
+//                                                           "op=\"addTask\"");
+//     MetricsTimer timer(latency);
+class Counter
+{
+public:
+    void add(quint64 n = 1) { m_value.fetchAndAddRelaxed(n); }
+    quint64 value() const { return m_value.loadRelaxed(); }
+
+private:
+    QAtomicInteger<quint64> m_value{0};
+};
+
+class Gauge
+{
+public:
+    void set(qint64 value) { m_value.storeRelaxed(value); }
+    void add(qint64 delta) { m_value.fetchAndAddRelaxed(delta); }
+    qint64 value() const { return m_value.loadRelaxed(); }
+
+private:
+    QAtomicInteger<qint64> m_value{0};
+};
+
+// 以微秒记录耗时。0~3 各占一个桶，之后每个 2 的幂区间再均分为 4 个桶，
+// 分位数的相对误差不超过 25%，最大值精确记录
+class Histogram
+{
+public:
+    static const int kSubBuckets = 4;
+    static const int kBucketCount = kSubBuckets + 62 * kSubBuckets;
+
+    struct Summary {
+        quint64 count = 0;
+        quint64 sumMicros = 0;
+        quint64 maxMicros = 0;
+        quint64 p50Micros = 0;
+        quint64 p90Micros = 0;
+        quint64 p99Micros = 0;
+    };
+
+    void record(quint64 micros);
+    // 各字段分别读取，与并发的 record() 之间可能相差几次记录
+    Summary summary() const;
+    quint64 countAtMost(quint64 micros) const;  // 不大于 micros（须为某个桶的上界）的记录数
+
+    static int bucketOf(quint64 micros);
+    static quint64 bucketUpperBound(int bucket);    // 桶内最大值（含）
+
+private:
+    QAtomicInteger<quint64> m_buckets[kBucketCount] = {};
+    QAtomicInteger<quint64> m_count{0};
+    QAtomicInteger<quint64> m_sum{0};
+    QAtomicInteger<quint64> m_max{0};
+};
+
+// 作用域计时：析构时把经过的时间记入直方图
+class MetricsTimer
+{
+public:
+    explicit MetricsTimer(Histogram *histogram) : m_histogram(histogram) { m_timer.start(); }
+    ~MetricsTimer() { m_histogram->record(quint64(m_timer.nsecsElapsed() / 1000)); }
+
+    MetricsTimer(const MetricsTimer &) = delete;
+    MetricsTimer &operator=(const MetricsTimer &) = delete;
+
+private:
+    Histogram *m_histogram;
+    QElapsedTimer m_timer;
+};
+
+// 指标注册表。名称遵循 Prometheus 规范（如 zhsj_db_operation_seconds），
+// labels 为已格式化的标签（如 op="addTask"），同名不同标签的指标属于同一族
+class Metrics
+{
+public:
+    enum Type { CounterType, GaugeType, HistogramType };
+
+    struct Sample {
+        QString name;
+        QString labels;
+        QString help;
+        Type type = CounterType;
+        qint64 value = 0;               // 计数器、仪表的当前值
+        Histogram::Summary summary;     // 直方图的汇总
+        const Histogram *histogram = nullptr;
+    };
+
+    // 同名同标签重复注册返回同一个对象；对象在进程结束前一直有效
+    static Counter *counter(const QString &name, const QString &help, const QString &labels = QString());
+    static Gauge *gauge(const QString &name, const QString &help, const QString &labels = QString());
+    static Histogram *histogram(const QString &name, const QString &help, const QString &labels = QString());
+
+    // 采集前调用的回调，用于更新需要现算的仪表（任务数、缓存占用等）。
+    // 回调在调用 samples() 的线程中执行，目前只有界面线程
+    static void addCollector(const void *owner, const std::function<void()> &collect);
+    static void removeCollectors(const void *owner);
+
+    // 按注册顺序返回全部指标的当前值
+    static QList<Sample> samples();
+    // Prometheus 文本格式（0.0.4）
+    static QString toPrometheusText();
+    // 先写临时文件再改名，采集程序不会读到写了一半的文件
+    static bool writePrometheusFile(const QString &path, QString *error = nullptr);
+
+    static QString formatMicros(quint64 micros);
+};
+
+#endif // METRICS_H
@@ -0,0 +1,66 @@
+#include "metricsexporter.h"
+#include "dbmanager.h"
+#include "metrics.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QSettings>
+
+MetricsExporter::MetricsExporter(QObject *parent)
+    : QObject(parent)
+{
+    QSettings settings;
+    m_intervalSecs = settings.value("metrics/intervalSecs", 15).toInt();
+    m_filePath = settings.value("metrics/file").toString();
+
+    connect(&m_timer, &QTimer::timeout, this, [this]() { writeNow(); });
+}
+
+void MetricsExporter::start()
+{
+    if (m_intervalSecs <= 0) {
+        m_timer.stop();
+        return;
+    }
+    m_timer.start(m_intervalSecs * 1000);
+    qDebug() << "运行指标每" << m_intervalSecs << "秒写入" << filePath();
+}
+
+// 未设置时写到数据库所在目录下的 metrics.prom
+QString MetricsExporter::filePath() const
+{
+    if (!m_filePath.isEmpty()) return m_filePath;
+    return QFileInfo(DBManager::instance()->getDatabasePath()).absolutePath() + "/metrics.prom";
+}
+
+bool MetricsExporter::writeNow(QString *error)
+{
+    static Histogram *const latency = Metrics::histogram("zhsj_metrics_write_seconds", "写出指标文件的耗时");
+    MetricsTimer timer(latency);
+
+    QString message;
+    if (!Metrics::writePrometheusFile(filePath(), &message)) {
+        if (!m_warned) {
+            qWarning() << "写入运行指标失败：" << filePath() << message;
+            m_warned = true;
+        }
+        if (error) *error = message;
+        return false;
+    }
+    m_warned = false;
+    return true;
+}
+
+void MetricsExporter::setIntervalSecs(int secs)
+{
+    m_intervalSecs = qMax(0, secs);
+    QSettings settings;
+    settings.setValue("metrics/intervalSecs", m_intervalSecs);
+    start();
+}
+
+void MetricsExporter::setFilePath(const QString &path)
+{
+    m_filePath = path;
+    QSettings settings;
+    settings.setValue("metrics/file", m_filePath);
+}
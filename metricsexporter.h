@@ -0,0 +1,30 @@
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QObject>
+#include <QTimer>
+
+// 定时把运行指标写成 Prometheus 文本文件，供本机的采集程序（如 node_exporter 的 textfile 收集器）读取
+// 配置保存在 QSettings 的 metrics/ 分组下
+class MetricsExporter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetricsExporter(QObject *parent = nullptr);
+
+    void start();
+    bool writeNow(QString *error = nullptr);
+
+    int intervalSecs() const { return m_intervalSecs; }
+    QString filePath() const;
+    void setIntervalSecs(int secs);     // 0 表示不写文件
+    void setFilePath(const QString &path);
+
+private:
+    QTimer m_timer;
+    int m_intervalSecs;
+    QString m_filePath;
+    bool m_warned = false;      // 写入失败只记录一次日志，避免刷屏
+};
+
+#endif // METRICSEXPORTER_H
@@ -0,0 +1,87 @@
+#include "migrationthread.h"
+#include "dbmanager.h"
+#include "schemamigrator.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+namespace {
+const int kBatchSize = 500;       // 每批扫描的行数，单批事务保持在几十毫秒以内
+const int kBatchDelayMs = 20;     // 两批之间让出写锁的时间
+}
+
+MigrationThread::MigrationThread(QObject *parent)
+    : QThread(parent)
+    , m_databasePath(DBManager::instance()->getDatabasePath())
+    , m_isRunning(true)
+{
+}
+
+MigrationThread::~MigrationThread()
+{
+    stopThread();
+    wait();
+}
+
+void MigrationThread::stopThread()
+{
+    m_isRunning = false;
+}
+
+void MigrationThread::run()
+{
+    QString connectionName = QString("migration_%1").arg(quintptr(this));
+    int completed = 0;
+    QString error;
+    bool ok = runPending(connectionName, &completed, &error);
+    QSqlDatabase::removeDatabase(connectionName);
+
+    if (!ok) {
+        qWarning() << "数据迁移失败：" << error;
+        emit migrationsFinished(false, error);
+    } else if (completed > 0) {
+        emit migrationsFinished(true, QString("已完成 %1 项数据迁移").arg(completed));
+    }
+}
+
+bool MigrationThread::runPending(const QString &connectionName, int *completed, QString *error)
+{
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    db.setDatabaseName(m_databasePath);
+    db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+    if (!db.open()) {
+        *error = "无法打开数据库：" + db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery query(db);
+    const QStringList pending = SchemaMigrator::pendingDataMigrations(query);
+    for (const QString &name : pending) {
+        const QString description = SchemaMigrator::dataMigrationDescription(name);
+        qDebug() << "开始后台数据迁移：" << description;
+
+        QElapsedTimer timer;
+        timer.start();
+        qint64 total = 0;
+        bool finished = false;
+        while (!finished) {
+            if (!m_isRunning) {
+                qDebug() << "数据迁移已暂停：" << description << "已处理" << total << "行";
+                return true;
+            }
+            int rows = 0;
+            if (!SchemaMigrator::runDataBatch(query, name, kBatchSize, &rows, &finished, error)) {
+                return false;
+            }
+            total += rows;
+            emit migrationProgress(description, total);
+            msleep(kBatchDelayMs);
+        }
+
+        qDebug() << "数据迁移完成：" << description << total << "行，用时" << timer.elapsed() << "ms";
+        ++*completed;
+    }
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef MIGRATIONTHREAD_H
+#define MIGRATIONTHREAD_H
+
+#include <QThread>
+#include <QString>
+
+// 后台数据迁移线程
+// 在独立连接上分批执行已登记的数据迁移，每批是一个短事务，批次之间让出写锁，
+// 界面可以在迁移期间正常读写；停止后未完成的迁移在下次启动时从已提交的位置继续。
+class MigrationThread : public QThread
+{
+    Q_OBJECT
+public:
+    explicit MigrationThread(QObject *parent = nullptr);
+    ~MigrationThread() override;
+
+    void stopThread();
+
+signals:
+    void migrationProgress(const QString &description, qint64 rows);
+    void migrationsFinished(bool ok, const QString &message);
+
+protected:
+    void run() override;
+
+private:
+    bool runPending(const QString &connectionName, int *completed, QString *error);
+
+    QString m_databasePath;
+    volatile bool m_isRunning;
+};
+
+#endif // MIGRATIONTHREAD_H
@@ -0,0 +1,72 @@
+#include "nextuppanel.h"
+#include "taskmodel.h"
+#include <QColor>
+#include <QDateTime>
+#include <QListWidget>
+
+namespace {
+const int kClockIntervalMs = 60 * 1000;
+
+// 距截止时间的相对描述
+QString dueText(qint64 secs)
+{
+    qint64 minutes = qAbs(secs) / 60;
+    QString amount;
+    if (minutes < 60) {
+        amount = QString("%1 分钟").arg(minutes);
+    } else if (minutes < 48 * 60) {
+        amount = QString("%1 小时").arg(minutes / 60);
+    } else {
+        amount = QString("%1 天").arg(minutes / (24 * 60));
+    }
+    return secs < 0 ? "已逾期 " + amount : "剩余 " + amount;
+}
+}
+
+NextUpPanel::NextUpPanel(TaskModel *model, QWidget *parent)
+    : QDockWidget("接下来", parent)
+    , m_model(model)
+    , m_list(new QListWidget(this))
+{
+    setObjectName("dockNextUp");
+    m_list->setAlternatingRowColors(true);
+    setWidget(m_list);
+
+    connect(m_model, &TaskModel::nextUpChanged, this, &NextUpPanel::refresh);
+    connect(m_model->clock(), &Clock::timeChanged, this, &NextUpPanel::refresh);
+    connect(m_list, &QListWidget::itemActivated, this, &NextUpPanel::onItemActivated);
+    connect(&m_clockTimer, &QTimer::timeout, this, &NextUpPanel::refresh);
+    m_clockTimer.start(kClockIntervalMs);
+    refresh();
+}
+
+void NextUpPanel::refresh()
+{
+    const qint64 now = m_model->clock()->nowSecs();
+    const UrgencyQueue &urgency = m_model->urgencyQueue();
+    const QVector<int> &top = urgency.top();
+
+    m_list->clear();
+    for (int taskId : top) {
+        Task task = m_model->getTaskById(taskId);
+        static const char *const priorityNames[] = {"低", "中", "高"};
+        QListWidgetItem *item = new QListWidgetItem(
+            QString("%1\n%2 · %3 · 优先级%4")
+                .arg(task.title)
+                .arg(task.deadline.toString("MM-dd HH:mm"))
+                .arg(dueText(task.deadline.toSecsSinceEpoch() - now))
+                .arg(priorityNames[qBound(0, task.priority, 2)]),
+            m_list);
+        item->setData(TaskModel::TaskIdRole, taskId);
+        item->setToolTip(QString("紧急度：%1 小时").arg(urgency.urgencyHours(taskId, now), 0, 'f', 1));
+        if (urgency.isOverdue(taskId)) {
+            item->setForeground(QColor(139, 0, 0));
+        }
+    }
+    setWindowTitle(QString("接下来（%1 个未完成）").arg(urgency.size()));
+}
+
+void NextUpPanel::onItemActivated(QListWidgetItem *item)
+{
+    emit taskActivated(item->data(TaskModel::TaskIdRole).toInt());
+}
@@ -0,0 +1,32 @@
+#ifndef NEXTUPPANEL_H
+#define NEXTUPPANEL_H
+
+#include <QDockWidget>
+#include <QTimer>
+
+class QListWidget;
+class QListWidgetItem;
+class TaskModel;
+
+// "接下来做什么"停靠面板：显示紧急度最高的若干个未完成任务
+// 列表只在前 K 名变化时重建；剩余时间文字每分钟刷新一次，开销只与 K 有关
+class NextUpPanel : public QDockWidget
+{
+    Q_OBJECT
+public:
+    explicit NextUpPanel(TaskModel *model, QWidget *parent = nullptr);
+
+signals:
+    void taskActivated(int taskId);
+
+private slots:
+    void refresh();
+    void onItemActivated(QListWidgetItem *item);
+
+private:
+    TaskModel *m_model;
+    QListWidget *m_list;
+    QTimer m_clockTimer;
+};
+
+#endif // NEXTUPPANEL_H
@@ -0,0 +1,19 @@
+#ifndef PINYIN_H
+#define PINYIN_H
+
+#include <QChar>
+#include <QString>
+#include <QStringList>
+
+// 汉字转拼音（不带声调，ü 写作 v）
+// 覆盖 GB2312 一级汉字（3755个常用字），常见多音字附带其他读音；不认识的字返回空列表
+class Pinyin
+{
+public:
+    // 第一个为主要读音
+    static QStringList readings(QChar c);
+    // 按主要读音转写：汉字转为拼音，字母转为小写，数字保留，其余字符丢弃
+    static QString toKey(const QString &text);
+};
+
+#endif // PINYIN_H
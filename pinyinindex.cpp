@@ -0,0 +1,304 @@
+#include "pinyinindex.h"
+#include "pinyin.h"
+#include <QtConcurrent>
+
+namespace {
+// 键只截取前 kMaxKeyLength 个字母建树，输入更长时对候选再按完整的键核对
+const int kMaxKeyLength = 12;
+// 多音字组合出的读法上限（全拼和首字母各自计算）
+const int kMaxVariants = 4;
+// 标题中作为起点的段数上限
+const int kMaxSegments = 4;
+// 不超过该长度的输入命中的任务很多，遍历子树较慢，结果缓存到相关的键变化为止
+const int kCachedDepth = 2;
+
+// tokens 为每个字的候选写法（第一个为主要读音），组合出不超过 kMaxVariants 个键；
+// maxLength > 0 时键截断到该长度
+QStringList expand(const QVector<QStringList> &tokens, int maxLength)
+{
+    QStringList keys{QString()};
+    for (const QStringList &choices : tokens) {
+        // 先保证每个已有前缀都接上主要读音，剩余名额再留给其他读音
+        QStringList next;
+        for (const QString &prefix : keys) {
+            next.append(prefix + choices.first());
+        }
+        for (int i = 1; i < choices.size() && next.size() < kMaxVariants; ++i) {
+            for (const QString &prefix : keys) {
+                if (next.size() >= kMaxVariants) break;
+                next.append(prefix + choices.at(i));
+            }
+        }
+        if (maxLength > 0) {
+            for (QString &key : next) {
+                if (key.size() > maxLength) key = key.left(maxLength);
+            }
+        }
+        next.removeDuplicates();
+        keys = next;
+    }
+    return keys;
+}
+
+// 从 start 开始到标题末尾的全拼和首字母键
+void segmentKeys(const QString &title, int start, int maxLength, QStringList *keys)
+{
+    QVector<QStringList> full;
+    QVector<QStringList> initials;
+    for (int i = start; i < title.size(); ++i) {
+        // 每个字至少产生一个字母，截断时后面的字不会进入键
+        if (maxLength > 0 && full.size() >= maxLength) break;
+        const QChar c = title.at(i);
+        if (c.unicode() < 0x80) {
+            if (!c.isLetterOrNumber()) continue;
+            QString lower = QString(c.toLower());
+            full.append(QStringList{lower});
+            initials.append(QStringList{lower});
+            continue;
+        }
+        QStringList readings = Pinyin::readings(c);
+        if (readings.isEmpty()) continue;
+        QStringList firstLetters;
+        for (const QString &reading : readings) {
+            if (!firstLetters.contains(reading.left(1))) firstLetters.append(reading.left(1));
+        }
+        full.append(readings);
+        initials.append(firstLetters);
+    }
+    if (full.isEmpty()) return;
+
+    *keys += expand(full, maxLength);
+    *keys += expand(initials, maxLength);
+}
+}
+
+PinyinIndex::PinyinIndex()
+{
+    clear();
+}
+
+void PinyinIndex::clear()
+{
+    m_nodes.clear();
+    m_nodes.append(Node());
+    m_freeNodes.clear();
+    m_entries.clear();
+    m_freeEntries.clear();
+    m_titles.clear();
+    m_cache.clear();
+}
+
+void PinyinIndex::rebuild(const QList<Task> &tasks)
+{
+    clear();
+    // 转写拼音占大部分时间，在线程池中并行计算各标题的键，再依次插入
+    const QVector<QStringList> keys = QtConcurrent::blockingMapped<QVector<QStringList>>(
+        tasks, [](const Task &task) { return keysFor(task.title, kMaxKeyLength); });
+    m_titles.reserve(tasks.size());
+    for (int i = 0; i < tasks.size(); ++i) {
+        m_titles.insert(tasks.at(i).id, tasks.at(i).title);
+        for (const QString &key : keys.at(i)) {
+            insertKey(key, tasks.at(i).id);
+        }
+    }
+}
+
+void PinyinIndex::updateTask(const Task &task)
+{
+    auto it = m_titles.find(task.id);
+    if (it != m_titles.end()) {
+        if (it.value() == task.title) return;
+        for (const QString &key : keysFor(it.value(), kMaxKeyLength)) {
+            removeKey(key, task.id);
+        }
+        it.value() = task.title;
+    } else {
+        m_titles.insert(task.id, task.title);
+    }
+
+    for (const QString &key : keysFor(task.title, kMaxKeyLength)) {
+        insertKey(key, task.id);
+    }
+}
+
+void PinyinIndex::removeTask(int taskId)
+{
+    auto it = m_titles.find(taskId);
+    if (it == m_titles.end()) return;
+    for (const QString &key : keysFor(it.value(), kMaxKeyLength)) {
+        removeKey(key, taskId);
+    }
+    m_titles.erase(it);
+}
+
+qint64 PinyinIndex::memoryUsage() const
+{
+    return qint64(m_nodes.capacity()) * qint64(sizeof(Node))
+           + qint64(m_entries.capacity()) * qint64(sizeof(Entry))
+           + qint64(m_freeNodes.capacity() + m_freeEntries.capacity()) * qint64(sizeof(int));
+}
+
+RoaringBitmap PinyinIndex::search(const QString &text) const
+{
+    RoaringBitmap result;
+    const QString query = Pinyin::toKey(text);
+    if (query.isEmpty()) return result;
+
+    int node = 0;
+    for (int i = 0; i < query.size() && i < kMaxKeyLength; ++i) {
+        node = childOf(node, char(query.at(i).unicode()));
+        if (node == -1) return result;
+    }
+    if (query.size() <= kCachedDepth) {
+        auto it = m_cache.constFind(node);
+        if (it == m_cache.constEnd()) {
+            collect(node, &result);
+            m_cache.insert(node, result);
+        } else {
+            result = it.value();
+        }
+    } else {
+        collect(node, &result);
+    }
+
+    if (query.size() > kMaxKeyLength) {
+        // 树中只有截断后的键，逐个核对候选的完整键
+        RoaringBitmap verified;
+        for (quint32 taskId : result.toVector()) {
+            for (const QString &key : keysFor(m_titles.value(int(taskId)))) {
+                if (key.startsWith(query)) {
+                    verified.add(taskId);
+                    break;
+                }
+            }
+        }
+        return verified;
+    }
+    return result;
+}
+
+QStringList PinyinIndex::keysFor(const QString &title, int maxLength)
+{
+    QStringList keys;
+    int segments = 0;
+    int start = -1;
+    for (int i = 0; i <= title.size() && segments < kMaxSegments; ++i) {
+        bool separator = i == title.size() || !title.at(i).isLetterOrNumber();
+        if (!separator && start == -1) {
+            start = i;
+        } else if (separator && start != -1) {
+            // 每段起点的键包含直到标题末尾的内容，可以跨段连续输入
+            segmentKeys(title, start, maxLength, &keys);
+            ++segments;
+            start = -1;
+        }
+    }
+    keys.removeDuplicates();
+    return keys;
+}
+
+int PinyinIndex::childOf(int node, char c) const
+{
+    for (int child = m_nodes.at(node).firstChild; child != -1; child = m_nodes.at(child).nextSibling) {
+        if (m_nodes.at(child).c == c) return child;
+    }
+    return -1;
+}
+
+int PinyinIndex::allocNode(char c)
+{
+    Node node;
+    node.c = c;
+    if (!m_freeNodes.isEmpty()) {
+        int index = m_freeNodes.takeLast();
+        m_nodes[index] = node;
+        return index;
+    }
+    m_nodes.append(node);
+    return m_nodes.size() - 1;
+}
+
+void PinyinIndex::insertKey(const QString &key, int taskId)
+{
+    int node = 0;
+    m_nodes[0].count++;
+    for (int i = 0; i < key.size() && i < kMaxKeyLength; ++i) {
+        const char c = char(key.at(i).unicode());
+        int child = childOf(node, c);
+        if (child == -1) {
+            child = allocNode(c);
+            m_nodes[child].nextSibling = m_nodes.at(node).firstChild;
+            m_nodes[node].firstChild = child;
+        }
+        node = child;
+        m_nodes[node].count++;
+        if (i < kCachedDepth) m_cache.remove(node);
+    }
+
+    Entry entry{taskId, m_nodes.at(node).entries};
+    int index;
+    if (!m_freeEntries.isEmpty()) {
+        index = m_freeEntries.takeLast();
+        m_entries[index] = entry;
+    } else {
+        index = m_entries.size();
+        m_entries.append(entry);
+    }
+    m_nodes[node].entries = index;
+}
+
+void PinyinIndex::removeKey(const QString &key, int taskId)
+{
+    QVector<int> path{0};
+    for (int i = 0; i < key.size() && i < kMaxKeyLength; ++i) {
+        int child = childOf(path.last(), char(key.at(i).unicode()));
+        if (child == -1) return;
+        path.append(child);
+    }
+
+    // 从结尾节点的链表中摘掉该任务的一条记录
+    int *link = &m_nodes[path.last()].entries;
+    while (*link != -1 && m_entries.at(*link).taskId != taskId) {
+        link = &m_entries[*link].next;
+    }
+    if (*link == -1) return;
+    int removed = *link;
+    *link = m_entries.at(removed).next;
+    m_freeEntries.append(removed);
+
+    for (int depth = 0; depth < path.size(); ++depth) {
+        m_nodes[path.at(depth)].count--;
+        if (depth <= kCachedDepth) m_cache.remove(path.at(depth));
+    }
+
+    // 计数归零的最浅节点连同其下的一条链一起回收（其下不会有其他分支）
+    for (int depth = 1; depth < path.size(); ++depth) {
+        if (m_nodes.at(path.at(depth)).count > 0) continue;
+
+        const int parent = path.at(depth - 1);
+        int *sibling = &m_nodes[parent].firstChild;
+        while (*sibling != path.at(depth)) {
+            sibling = &m_nodes[*sibling].nextSibling;
+        }
+        *sibling = m_nodes.at(path.at(depth)).nextSibling;
+        for (int i = depth; i < path.size(); ++i) {
+            m_freeNodes.append(path.at(i));
+        }
+        break;
+    }
+}
+
+void PinyinIndex::collect(int node, RoaringBitmap *result) const
+{
+    // 显式栈，避免长键导致递归过深
+    QVector<int> stack{node};
+    while (!stack.isEmpty()) {
+        const Node &current = m_nodes.at(stack.takeLast());
+        for (int entry = current.entries; entry != -1; entry = m_entries.at(entry).next) {
+            result->add(quint32(m_entries.at(entry).taskId));
+        }
+        for (int child = current.firstChild; child != -1; child = m_nodes.at(child).nextSibling) {
+            stack.append(child);
+        }
+    }
+}
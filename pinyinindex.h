@@ -0,0 +1,61 @@
+#ifndef PINYININDEX_H
+#define PINYININDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "roaringbitmap.h"
+#include "task.h"
+
+// 标题拼音前缀索引：每个标题的全拼和首字母（如"周报会议" -> zhoubaohuiyi、zbhy）
+// 插入一棵前缀树，输入 "zbhy"、"zhoub" 或直接输入汉字都能按前缀找到任务。
+// 标题中以空格、标点分开的每一段也各自作为起点。随模型增量更新，查找不访问数据库。
+class PinyinIndex
+{
+public:
+    PinyinIndex();
+
+    void clear();
+    void rebuild(const QList<Task> &tasks);
+    void updateTask(const Task &task);
+    void removeTask(int taskId);
+
+    RoaringBitmap search(const QString &text) const;
+    int nodeCount() const { return m_nodes.size() - m_freeNodes.size(); }
+    // 前缀树数组占用的字节数（不含标题副本和查询缓存）
+    qint64 memoryUsage() const;
+
+    // 标题对应的全部索引键，maxLength > 0 时截断到该长度
+    static QStringList keysFor(const QString &title, int maxLength = -1);
+
+private:
+    // 左孩子右兄弟表示，节点连续存放；count 为以子树中节点结尾的键数，为0时回收
+    struct Node {
+        int firstChild = -1;
+        int nextSibling = -1;
+        int entries = -1;       // 以本节点结尾的键对应的任务（m_entries 中的链表）
+        int count = 0;
+        char c = 0;
+    };
+    struct Entry {
+        int taskId;
+        int next;
+    };
+
+    void insertKey(const QString &key, int taskId);
+    void removeKey(const QString &key, int taskId);
+    int childOf(int node, char c) const;
+    int allocNode(char c);
+    void collect(int node, RoaringBitmap *result) const;
+
+    QVector<Node> m_nodes;          // m_nodes[0] 为根
+    QVector<int> m_freeNodes;
+    QVector<Entry> m_entries;
+    QVector<int> m_freeEntries;
+    QHash<int, QString> m_titles;   // 已索引的标题，用于增量更新时删除旧键
+    mutable QHash<int, RoaringBitmap> m_cache;  // 浅层节点 -> 子树中的任务
+};
+
+#endif // PINYININDEX_H
@@ -1,10 +1,26 @@
 #include "reminderthread.h"
+#include "clock.h"
+#include "metrics.h"
 #include <QDebug>
-#include <QMutexLocker>
-#include <QDateTime>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <limits>
+
+namespace {
+const qint64 kLeadSecs = 60;        // 截止前1分钟提醒
+const int kPollRealMs = 1000;       // 最长等待（真实时间），期间检查快照是否更新
+const int kMinCompactSize = 1024;   // 计划中的条目超过有效任务数的两倍加上该值时整体重建
+
+template <typename Entry>
+bool remindsLater(const Entry &a, const Entry &b)
+{
+    return a.remindAt > b.remindAt;
+}
+}
 
 ReminderThread::ReminderThread(QObject *parent)
     : QThread(parent)
+    , m_clock(Clock::system())
     , m_isRunning(true)
 {
     qDebug() << "ReminderThread构造函数";
@@ -16,55 +32,144 @@ ReminderThread::~ReminderThread()
     stopThread();
 }
 
-void ReminderThread::setTasks(const QList<Task> &tasks)
-{
-    QMutexLocker locker(&m_mutex);
-    m_tasks = tasks;
-}
-
 void ReminderThread::stopThread()
 {
     qDebug() << "请求停止线程";
     m_isRunning = false;
+    m_clock->interrupt();
+}
+
+qint64 ReminderThread::reminderLeadSecs()
+{
+    return kLeadSecs;
+}
+
+ReminderThread::Stats ReminderThread::stats() const
+{
+    QMutexLocker locker(&m_statsMutex);
+    return m_stats;
+}
+
+// 未完成且未过截止时间的任务加入计划；同一截止时间已在计划中时不重复加入
+void ReminderThread::schedule(const Task &task, qint64 now)
+{
+    if (task.isCompleted || !task.deadline.isValid()) return;
+    qint64 deadline = task.deadline.toMSecsSinceEpoch();
+    if (deadline < now || m_scheduled.value(task.id, -1) == deadline) return;
+    m_scheduled.insert(task.id, deadline);
+    m_schedule.append({deadline - kLeadSecs * 1000, deadline, task.id});
+    std::push_heap(m_schedule.begin(), m_schedule.end(), remindsLater<Entry>);
+}
+
+void ReminderThread::rebuildSchedule(const TaskSnapshot &snapshot, qint64 now)
+{
+    m_schedule.clear();
+    m_scheduled.clear();
+    m_schedule.reserve(snapshot.size());
+    snapshot.forEach([this, now](const Task &task) {
+        if (task.isCompleted || !task.deadline.isValid()) return;
+        qint64 deadline = task.deadline.toMSecsSinceEpoch();
+        if (deadline < now) return;
+        m_scheduled.insert(task.id, deadline);
+        m_schedule.append({deadline - kLeadSecs * 1000, deadline, task.id});
+    });
+    std::make_heap(m_schedule.begin(), m_schedule.end(), remindsLater<Entry>);
+    forgetPastReminders(now);
+}
+
+// 快照由上一版本 update() 得到时，未改动的块与上一版本共享，只需检查变化的块
+void ReminderThread::applySnapshotDelta(const TaskSnapshot &snapshot, qint64 now)
+{
+    snapshot.forEachChangedSince(*m_scheduleSnapshot, [this, now](const Task &task) { schedule(task, now); });
+    forgetPastReminders(now);
+}
+
+// 截止时间已过的提醒记录不会再用到
+void ReminderThread::forgetPastReminders(qint64 now)
+{
+    for (auto it = m_reminded.begin(); it != m_reminded.end();) {
+        if (it.value() < now)
+            it = m_reminded.erase(it);
+        else
+            ++it;
+    }
 }
 
 void ReminderThread::run()
 {
     qDebug() << "提醒线程开始运行";
 
-    int checkCounter = 0;
+    Histogram *const tickLatency = Metrics::histogram("zhsj_reminder_tick_seconds", "提醒线程每次检查的耗时");
+    Histogram *const reminderDelay = Metrics::histogram("zhsj_reminder_delay_seconds",
+                                                        "提醒实际发出时间与应提醒时间之差（时钟时间）");
+    Counter *const remindersSent = Metrics::counter("zhsj_reminders_total", "已发出的提醒数");
+    Counter *const remindersMissed = Metrics::counter("zhsj_reminders_missed_total", "错过提醒窗口的任务数");
 
+    QElapsedTimer busy;
     while (m_isRunning) {
-        // 每5秒检查一次
-        if (checkCounter % 5 == 0) {
-            QDateTime now = QDateTime::currentDateTime();
-            QList<Task> currentTasks;
-
-            {
-                QMutexLocker locker(&m_mutex);
-                currentTasks = m_tasks;
+        busy.start();
+        qint64 now = m_clock->nowMSecs();
+        TaskSnapshot::Ptr snapshot = m_source ? m_source->current() : TaskSnapshot::Ptr();
+        Stats delta;
+
+        if (snapshot && snapshot != m_scheduleSnapshot) {
+            // 过期条目（已完成、改期、删除的任务留下的）过多时整体重建，否则只看变化的块
+            if (!m_scheduleSnapshot || m_schedule.size() > 2 * m_scheduled.size() + kMinCompactSize) {
+                rebuildSchedule(*snapshot, now);
+                ++delta.rebuilds;
+            } else {
+                applySnapshotDelta(*snapshot, now);
+                ++delta.deltas;
             }
+            m_scheduleSnapshot = snapshot;
+        }
 
-            for (const Task &task : currentTasks) {
-                if (task.isCompleted) continue;
+        // 依次处理提醒时间已到的条目；每个任务的同一截止时间只提醒一次
+        while (snapshot && !m_schedule.isEmpty() && m_schedule.first().remindAt <= now) {
+            std::pop_heap(m_schedule.begin(), m_schedule.end(), remindsLater<Entry>);
+            const Entry entry = m_schedule.takeLast();
+            if (m_scheduled.value(entry.taskId, -1) == entry.deadline) m_scheduled.remove(entry.taskId);
 
-                qint64 remaining = now.secsTo(task.deadline);
-                if (remaining >= 0 && remaining <= 60) {
-                    qDebug() << "发送任务提醒:" << task.title;
-                    emit taskReminder(task);
-                }
+            // 与快照核对：任务被删除、已完成或改期后，旧条目作废
+            Task task = snapshot->task(entry.taskId);
+            if (task.id == -1 || task.isCompleted || !task.deadline.isValid()
+                || task.deadline.toMSecsSinceEpoch() != entry.deadline) continue;
+            if (m_reminded.value(entry.taskId, -1) == entry.deadline) continue;
+            if (entry.deadline < now) {
+                ++delta.missed;
+                continue;
             }
+
+            m_reminded.insert(entry.taskId, entry.deadline);
+            qint64 latency = now - entry.remindAt;
+            ++delta.reminders;
+            delta.totalLatencyMs += latency;
+            delta.maxLatencyMs = qMax(delta.maxLatencyMs, latency);
+            reminderDelay->record(quint64(latency) * 1000);
+            qDebug() << "发送任务提醒:" << task.title;
+            emit taskReminder(task);
         }
+        delta.busyMs = busy.elapsed();
+        tickLatency->record(quint64(busy.nsecsElapsed() / 1000));
+        remindersSent->add(quint64(delta.reminders));
+        remindersMissed->add(quint64(delta.missed));
 
-        checkCounter++;
+        {
+            QMutexLocker locker(&m_statsMutex);
+            m_stats.reminders += delta.reminders;
+            m_stats.missed += delta.missed;
+            m_stats.totalLatencyMs += delta.totalLatencyMs;
+            m_stats.maxLatencyMs = qMax(m_stats.maxLatencyMs, delta.maxLatencyMs);
+            m_stats.rebuilds += delta.rebuilds;
+            m_stats.deltas += delta.deltas;
+            m_stats.busyMs += delta.busyMs;
+        }
 
         if (!m_isRunning) break;
 
-        msleep(1000);
-
-        if (checkCounter > 86400) {
-            checkCounter = 0;
-        }
+        // 睡到下一个提醒时间；快照可能随时更新，最多等待 kPollRealMs 后重新检查
+        qint64 next = !m_schedule.isEmpty() ? m_schedule.first().remindAt : std::numeric_limits<qint64>::max();
+        m_clock->sleepUntil(next, kPollRealMs);
     }
 
     qDebug() << "提醒线程安全退出";
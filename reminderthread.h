@@ -2,21 +2,42 @@
 #define REMINDERTHREAD_H
 
 #include <QThread>
-#include <QList>
 #include <QDateTime>
+#include <QHash>
 #include <QMutex>
+#include <QVector>
 #include "task.h"
+#include "tasksnapshot.h"
+
+class Clock;
 
 class ReminderThread : public QThread
 {
     Q_OBJECT
 public:
+    // 运行统计，供模拟回放衡量提醒的延迟、遗漏和开销
+    struct Stats {
+        qint64 reminders = 0;
+        qint64 missed = 0;              // 提醒窗口在两次检查之间整个过去了
+        qint64 totalLatencyMs = 0;      // 实际发出时间与应提醒时间之差（时钟时间）
+        qint64 maxLatencyMs = 0;
+        qint64 rebuilds = 0;            // 整体重建提醒计划的次数
+        qint64 deltas = 0;              // 按快照中变化的块增量更新计划的次数
+        qint64 busyMs = 0;              // 线程实际工作（非等待）的真实时间
+    };
+
     explicit ReminderThread(QObject *parent = nullptr);
     ~ReminderThread() override;
 
-    void setTasks(const QList<Task> &tasks);
+    // 需在 start() 之前设置；每次检查时取发布点的当前快照，无需复制任务列表
+    void setSnapshotSource(const TaskSnapshotSource *source) { m_source = source; }
+    // 需在 start() 之前设置；默认使用系统时钟
+    void setClock(Clock *clock) { m_clock = clock; }
     void stopThread();
 
+    static qint64 reminderLeadSecs();   // 截止前多久提醒
+    Stats stats() const;
+
 signals:
     void taskReminder(const Task &task);
 
@@ -24,9 +45,30 @@ protected:
     void run() override;
 
 private:
-    QList<Task> m_tasks;
+    // 按提醒时间的最小堆。快照变化时只为变化块中的任务补充条目，旧条目不删除，
+    // 取出时与快照核对（任务仍在、未完成、截止时间未变）后才提醒；过期条目过多时整体重建
+    struct Entry {
+        qint64 remindAt;    // 毫秒
+        qint64 deadline;    // 毫秒
+        int taskId;
+    };
+
+    void rebuildSchedule(const TaskSnapshot &snapshot, qint64 now);
+    void applySnapshotDelta(const TaskSnapshot &snapshot, qint64 now);
+    void schedule(const Task &task, qint64 now);
+    void forgetPastReminders(qint64 now);
+
+    const TaskSnapshotSource *m_source = nullptr;
+    Clock *m_clock;
     volatile bool m_isRunning;
-    mutable QMutex m_mutex;
+
+    QVector<Entry> m_schedule;
+    QHash<int, qint64> m_scheduled;     // 任务ID -> 计划中最新条目的截止时间，用于去重
+    TaskSnapshot::Ptr m_scheduleSnapshot;  // 计划所对应的快照
+    QHash<int, qint64> m_reminded;      // 任务ID -> 已提醒过的截止时间，截止时间改变后会再次提醒
+
+    mutable QMutex m_statsMutex;
+    Stats m_stats;
 };
 
 #endif // REMINDERTHREAD_H
@@ -0,0 +1,281 @@
+#include "roaringbitmap.h"
+#include <QtAlgorithms>
+#include <algorithm>
+
+namespace {
+const int kArrayMaxSize = 4096;   // 超过该基数时数组不再比位图省空间
+const int kBitmapWords = 1024;    // 65536 位
+}
+
+bool RoaringBitmap::Container::contains(quint16 low) const
+{
+    if (isBitmap()) {
+        return (bits[low >> 6] >> (low & 63)) & 1;
+    }
+    return std::binary_search(array.begin(), array.end(), low);
+}
+
+bool RoaringBitmap::Container::add(quint16 low)
+{
+    if (isBitmap()) {
+        quint64 mask = quint64(1) << (low & 63);
+        if (bits[low >> 6] & mask) return false;
+        bits[low >> 6] |= mask;
+        cardinality++;
+        return true;
+    }
+
+    auto it = std::lower_bound(array.begin(), array.end(), low);
+    if (it != array.end() && *it == low) return false;
+    array.insert(it, low);
+    cardinality++;
+    if (cardinality > kArrayMaxSize) toBitmap();
+    return true;
+}
+
+bool RoaringBitmap::Container::remove(quint16 low)
+{
+    if (isBitmap()) {
+        quint64 mask = quint64(1) << (low & 63);
+        if (!(bits[low >> 6] & mask)) return false;
+        bits[low >> 6] &= ~mask;
+        cardinality--;
+        normalize();
+        return true;
+    }
+
+    auto it = std::lower_bound(array.begin(), array.end(), low);
+    if (it == array.end() || *it != low) return false;
+    array.erase(it);
+    cardinality--;
+    return true;
+}
+
+void RoaringBitmap::Container::toBitmap()
+{
+    if (isBitmap()) return;
+    bits = QVector<quint64>(kBitmapWords, 0);
+    for (quint16 low : array) {
+        bits[low >> 6] |= quint64(1) << (low & 63);
+    }
+    array.clear();
+    array.squeeze();
+}
+
+void RoaringBitmap::Container::normalize()
+{
+    if (isBitmap() && cardinality <= kArrayMaxSize) {
+        QVector<quint16> values;
+        values.reserve(cardinality);
+        for (int word = 0; word < kBitmapWords; ++word) {
+            quint64 w = bits[word];
+            while (w) {
+                int bit = 0;
+                while (!((w >> bit) & 1)) ++bit;
+                values.append(quint16(word * 64 + bit));
+                w &= w - 1;
+            }
+        }
+        array = values;
+        bits.clear();
+        bits.squeeze();
+    } else if (!isBitmap() && cardinality > kArrayMaxSize) {
+        toBitmap();
+    }
+}
+
+int RoaringBitmap::findContainer(quint16 key) const
+{
+    int lo = 0;
+    int hi = m_containers.size();
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (m_containers[mid].key < key) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo < m_containers.size() && m_containers[lo].key == key) return lo;
+    return -(lo + 1);
+}
+
+void RoaringBitmap::add(quint32 value)
+{
+    quint16 key = quint16(value >> 16);
+    int i = findContainer(key);
+    if (i < 0) {
+        i = -i - 1;
+        Container container;
+        container.key = key;
+        m_containers.insert(i, container);
+    }
+    m_containers[i].add(quint16(value & 0xFFFF));
+}
+
+void RoaringBitmap::remove(quint32 value)
+{
+    int i = findContainer(quint16(value >> 16));
+    if (i < 0) return;
+    m_containers[i].remove(quint16(value & 0xFFFF));
+    if (m_containers[i].cardinality == 0) {
+        m_containers.remove(i);
+    }
+}
+
+bool RoaringBitmap::contains(quint32 value) const
+{
+    int i = findContainer(quint16(value >> 16));
+    return i >= 0 && m_containers[i].contains(quint16(value & 0xFFFF));
+}
+
+qint64 RoaringBitmap::cardinality() const
+{
+    qint64 total = 0;
+    for (const Container &container : m_containers) {
+        total += container.cardinality;
+    }
+    return total;
+}
+
+QVector<quint32> RoaringBitmap::toVector() const
+{
+    QVector<quint32> values;
+    values.reserve(int(cardinality()));
+    for (const Container &container : m_containers) {
+        quint32 high = quint32(container.key) << 16;
+        if (container.isBitmap()) {
+            for (int word = 0; word < kBitmapWords; ++word) {
+                quint64 w = container.bits[word];
+                for (int bit = 0; w; ++bit, w >>= 1) {
+                    if (w & 1) values.append(high | quint32(word * 64 + bit));
+                }
+            }
+        } else {
+            for (quint16 low : container.array) {
+                values.append(high | low);
+            }
+        }
+    }
+    return values;
+}
+
+// 单个桶上的集合运算，结果按基数重新选择存储形式
+RoaringBitmap::Container RoaringBitmap::combine(const Container &a, const Container &b, Operation op)
+{
+    Container result;
+    result.key = a.key;
+
+    if (!a.isBitmap() && !b.isBitmap() && op != OpOr) {
+        // 两个有序数组：归并
+        result.array.reserve(op == OpAnd ? qMin(a.cardinality, b.cardinality) : a.cardinality);
+        if (op == OpAnd) {
+            std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                                  std::back_inserter(result.array));
+        } else {
+            std::set_difference(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                                std::back_inserter(result.array));
+        }
+        result.cardinality = result.array.size();
+        return result;
+    }
+
+    if (!a.isBitmap() && op != OpOr) {
+        // 数组与位图：逐个探测
+        for (quint16 low : a.array) {
+            if (b.contains(low) == (op == OpAnd)) result.array.append(low);
+        }
+        result.cardinality = result.array.size();
+        return result;
+    }
+
+    if (op == OpAnd && !b.isBitmap()) {
+        for (quint16 low : b.array) {
+            if (a.contains(low)) result.array.append(low);
+        }
+        result.cardinality = result.array.size();
+        return result;
+    }
+
+    if (op == OpOr && !a.isBitmap() && !b.isBitmap()
+        && a.cardinality + b.cardinality <= kArrayMaxSize) {
+        std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                       std::back_inserter(result.array));
+        result.cardinality = result.array.size();
+        return result;
+    }
+
+    // 其余情况按64位字运算
+    Container left = a;
+    left.toBitmap();
+    Container right = b;
+    right.toBitmap();
+    result.bits = QVector<quint64>(kBitmapWords, 0);
+    int count = 0;
+    for (int word = 0; word < kBitmapWords; ++word) {
+        quint64 w = 0;
+        switch (op) {
+        case OpAnd: w = left.bits[word] & right.bits[word]; break;
+        case OpOr: w = left.bits[word] | right.bits[word]; break;
+        case OpAndNot: w = left.bits[word] & ~right.bits[word]; break;
+        }
+        result.bits[word] = w;
+        count += qPopulationCount(w);
+    }
+    result.cardinality = count;
+    result.normalize();
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::operator&(const RoaringBitmap &other) const
+{
+    RoaringBitmap result;
+    int i = 0;
+    int j = 0;
+    while (i < m_containers.size() && j < other.m_containers.size()) {
+        const Container &a = m_containers[i];
+        const Container &b = other.m_containers[j];
+        if (a.key < b.key) {
+            ++i;
+        } else if (b.key < a.key) {
+            ++j;
+        } else {
+            Container c = combine(a, b, OpAnd);
+            if (c.cardinality > 0) result.m_containers.append(c);
+            ++i;
+            ++j;
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::operator|(const RoaringBitmap &other) const
+{
+    RoaringBitmap result;
+    int i = 0;
+    int j = 0;
+    while (i < m_containers.size() || j < other.m_containers.size()) {
+        if (j >= other.m_containers.size()
+            || (i < m_containers.size() && m_containers[i].key < other.m_containers[j].key)) {
+            result.m_containers.append(m_containers[i++]);
+        } else if (i >= m_containers.size() || other.m_containers[j].key < m_containers[i].key) {
+            result.m_containers.append(other.m_containers[j++]);
+        } else {
+            result.m_containers.append(combine(m_containers[i++], other.m_containers[j++], OpOr));
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::andNot(const RoaringBitmap &other) const
+{
+    RoaringBitmap result;
+    int j = 0;
+    for (const Container &a : m_containers) {
+        while (j < other.m_containers.size() && other.m_containers[j].key < a.key) ++j;
+        if (j < other.m_containers.size() && other.m_containers[j].key == a.key) {
+            Container c = combine(a, other.m_containers[j], OpAndNot);
+            if (c.cardinality > 0) result.m_containers.append(c);
+        } else {
+            result.m_containers.append(a);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,47 @@
+#ifndef ROARINGBITMAP_H
+#define ROARINGBITMAP_H
+
+#include <QVector>
+#include <QtGlobal>
+
+// 压缩位图（Roaring结构）：按高16位分桶，稀疏桶用有序数组、稠密桶用65536位的位图
+// 用于标签/完成状态等过滤条件的快速交集、并集和差集运算
+class RoaringBitmap
+{
+public:
+    void add(quint32 value);
+    void remove(quint32 value);
+    bool contains(quint32 value) const;
+    void clear() { m_containers.clear(); }
+
+    bool isEmpty() const { return m_containers.isEmpty(); }
+    qint64 cardinality() const;
+    QVector<quint32> toVector() const;
+
+    RoaringBitmap operator&(const RoaringBitmap &other) const;
+    RoaringBitmap operator|(const RoaringBitmap &other) const;
+    RoaringBitmap andNot(const RoaringBitmap &other) const;
+
+private:
+    struct Container {
+        quint16 key = 0;
+        int cardinality = 0;
+        QVector<quint16> array;     // 稀疏：有序数组
+        QVector<quint64> bits;      // 稠密：1024个64位字
+
+        bool isBitmap() const { return !bits.isEmpty(); }
+        bool contains(quint16 low) const;
+        bool add(quint16 low);
+        bool remove(quint16 low);
+        void toBitmap();
+        void normalize();   // 根据基数在数组/位图之间切换
+    };
+
+    enum Operation { OpAnd, OpOr, OpAndNot };
+    static Container combine(const Container &a, const Container &b, Operation op);
+    int findContainer(quint16 key) const;   // 返回下标，不存在时返回 -(插入位置 + 1)
+
+    QVector<Container> m_containers;   // 按 key 升序
+};
+
+#endif // ROARINGBITMAP_H
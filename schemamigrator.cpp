@@ -0,0 +1,500 @@
+#include "schemamigrator.h"
+#include "dbmanager.h"
+#include <QDebug>
+#include <QList>
+#include <QSqlError>
+
+namespace {
+// 结构迁移的一步。statements 中的 %1 为 schema 名；
+// dataMigrations 为本步登记的后台数据迁移，新建的数据库同样会登记（空表上立即完成）
+struct SchemaStep {
+    int version;
+    const char *description;
+    bool (*apply)(QSqlQuery &query, const QString &schema);
+    QStringList statements;
+    QStringList dataMigrations;
+};
+
+// 后台数据迁移：update 对 id 区间 (:from, :to] 内的行执行，必须可以重复执行；
+// 无法用一条 SQL 完成的（如需要 qCompress）改为提供 run，在同一事务中处理该区间
+struct DataMigration {
+    const char *name;
+    const char *description;
+    const char *table;
+    const char *update;
+    bool (*run)(QSqlQuery &query, qint64 from, qint64 to);
+};
+
+// ---- 子任务汇总 ----
+// task_rollups 保存每个任务子树（不含自身）的任务数、已完成数和未完成任务中最早的截止时间，
+// 由下面拼出的触发器在任务增删、移动、完成或改期时沿祖先链增量修改，任何写入方都能保持一致。
+// 参数是触发器中的表达式，如 NEW.parent_id、OLD
+
+// parent 及其全部祖先（parent 为空时为空集）。成环的修改会被 trg_tasks_parent_check 拒绝，
+// LIMIT 只防备数据库被其他程序改坏时无限递归
+QString ancestorsOf(const QString &parent)
+{
+    return QString("(WITH RECURSIVE chain(id) AS ("
+                   "SELECT %1 WHERE %1 IS NOT NULL "
+                   "UNION ALL SELECT t.parent_id FROM tasks t JOIN chain ON t.id = chain.id "
+                   "WHERE t.parent_id IS NOT NULL LIMIT 10000) "
+                   "SELECT id FROM chain)").arg(parent);
+}
+
+// column 属于 parent 的祖先链；给出 except 时去掉同为 except 祖先的部分（移动前后共同的祖先不受影响）
+QString onAncestors(const QString &column, const QString &parent, const QString &except = QString())
+{
+    QString condition = QString("%1 IN %2").arg(column, ancestorsOf(parent));
+    if (!except.isEmpty()) {
+        condition += QString(" AND %1 NOT IN %2").arg(column, ancestorsOf(except));
+    }
+    return condition;
+}
+
+// 任务 row 连同其子树计入祖先汇总的任务数、已完成数和最早截止时间
+QString subtreeCount(const QString &row)
+{
+    return QString("(1 + COALESCE((SELECT descendants FROM task_rollups WHERE task_id = %1.id), 0))").arg(row);
+}
+
+QString subtreeCompleted(const QString &row)
+{
+    return QString("(%1.isCompleted + COALESCE((SELECT completed FROM task_rollups WHERE task_id = %1.id), 0))")
+        .arg(row);
+}
+
+QString subtreeEarliest(const QString &row)
+{
+    return QString("(SELECT MIN(v) FROM (SELECT CASE WHEN %1.isCompleted = 0 THEN %1.deadline END AS v "
+                   "UNION ALL SELECT earliest_deadline FROM task_rollups WHERE task_id = %1.id))").arg(row);
+}
+
+QString addToAncestors(const QString &parent, const QString &count, const QString &completed,
+                       const QString &earliest, const QString &except = QString())
+{
+    return QString(R"(
+        INSERT OR IGNORE INTO task_rollups (task_id) SELECT %1 WHERE %1 IS NOT NULL;
+        UPDATE task_rollups
+        SET descendants = descendants + %2, completed = completed + %3,
+            earliest_deadline = CASE WHEN %4 IS NOT NULL AND (earliest_deadline IS NULL OR %4 < earliest_deadline)
+                                     THEN %4 ELSE earliest_deadline END
+        WHERE %5;
+    )").arg(parent, count, completed, earliest, onAncestors("task_id", parent, except));
+}
+
+// 祖先链上等于 removed 的最早截止时间（该任务已完成、改期或移走）自下而上重算：
+// 每层取直接子任务自身与其子树汇总中的最小值，路径上的子任务用刚算出的新值。
+// 只沿最早截止时间 >= removed 的祖先上行，这一条件在逐行更新过程中保持不变，各行求值结果一致
+QString recomputeEarliest(const QString &parent, const QString &removed, const QString &except = QString())
+{
+    const QString up = QString(R"(
+        WITH RECURSIVE up(id, parent, e) AS (
+            SELECT p.id, p.parent_id, (SELECT MIN(v) FROM (
+                    SELECT (SELECT c.deadline FROM tasks c WHERE c.parent_id = p.id AND c.isCompleted = 0
+                            ORDER BY c.deadline LIMIT 1) AS v
+                    UNION ALL
+                    SELECT r.earliest_deadline FROM tasks c JOIN task_rollups r ON r.task_id = c.id
+                    WHERE c.parent_id = p.id))
+            FROM tasks p JOIN task_rollups pr ON pr.task_id = p.id
+            WHERE p.id = %1 AND (pr.earliest_deadline IS NULL OR pr.earliest_deadline >= %2)
+            UNION ALL
+            SELECT g.id, g.parent_id, (SELECT MIN(v) FROM (
+                    SELECT (SELECT c.deadline FROM tasks c WHERE c.parent_id = g.id AND c.isCompleted = 0
+                            ORDER BY c.deadline LIMIT 1) AS v
+                    UNION ALL
+                    SELECT r.earliest_deadline FROM tasks c JOIN task_rollups r ON r.task_id = c.id
+                    WHERE c.parent_id = g.id AND c.id <> up.id
+                    UNION ALL
+                    SELECT up.e))
+            FROM up JOIN tasks g ON g.id = up.parent JOIN task_rollups gr ON gr.task_id = g.id
+            WHERE gr.earliest_deadline IS NULL OR gr.earliest_deadline >= %2)
+    )").arg(parent, removed);
+    return QString(R"(
+        UPDATE task_rollups SET earliest_deadline = (%1 SELECT e FROM up WHERE up.id = task_rollups.task_id)
+        WHERE earliest_deadline = %2 AND %3;
+    )").arg(up, removed, onAncestors("task_id", parent, except));
+}
+
+QString removeFromAncestors(const QString &parent, const QString &count, const QString &completed,
+                            const QString &earliest, const QString &except = QString())
+{
+    return QString(R"(
+        UPDATE task_rollups SET descendants = descendants - %1, completed = completed - %2
+        WHERE %3;
+    )").arg(count, completed, onAncestors("task_id", parent, except))
+        + recomputeEarliest(parent, earliest, except);
+}
+
+// 汇总变化的祖先刷新 row_version，增量刷新能读到新的进度
+QString touchAncestors(const QString &parent, const QString &except = QString())
+{
+    return QString("UPDATE tasks SET row_version = row_version WHERE %1;\n")
+        .arg(onAncestors("id", parent, except));
+}
+
+QStringList subtaskStatements()
+{
+    const QString pendingNew = "CASE WHEN NEW.isCompleted = 0 THEN NEW.deadline END";
+    const QString pendingOld = "CASE WHEN OLD.isCompleted = 0 THEN OLD.deadline END";
+    return {
+        "CREATE INDEX IF NOT EXISTS %1.idx_tasks_parent ON tasks (parent_id, deadline, id)",
+        R"(
+        CREATE TABLE IF NOT EXISTS %1.task_rollups (
+            task_id INTEGER PRIMARY KEY,
+            descendants INTEGER NOT NULL DEFAULT 0,
+            completed INTEGER NOT NULL DEFAULT 0,
+            earliest_deadline TEXT
+        )
+        )",
+        R"(
+        CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_parent_insert_check BEFORE INSERT ON tasks
+        WHEN NEW.parent_id IS NOT NULL AND NOT EXISTS (SELECT 1 FROM tasks WHERE id = NEW.parent_id)
+        BEGIN
+            SELECT RAISE(ABORT, '父任务不存在');
+        END
+        )",
+        // 新的父任务不能是自己或自己的后代（这里用 UNION 去重，遇到已有的环也能结束）
+        R"(
+        CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_parent_check BEFORE UPDATE OF parent_id ON tasks
+        WHEN NEW.parent_id IS NOT NULL AND NEW.parent_id IS NOT OLD.parent_id
+        BEGIN
+            SELECT RAISE(ABORT, '父任务不存在')
+            WHERE NOT EXISTS (SELECT 1 FROM tasks WHERE id = NEW.parent_id);
+            SELECT RAISE(ABORT, '不能把任务移到它自己或它的子任务下面')
+            WHERE NEW.id IN (WITH RECURSIVE chain(id) AS (
+                                 SELECT NEW.parent_id
+                                 UNION SELECT t.parent_id FROM tasks t JOIN chain ON t.id = chain.id
+                                 WHERE t.parent_id IS NOT NULL)
+                             SELECT id FROM chain);
+        END
+        )",
+        "CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_rollup_insert AFTER INSERT ON tasks\n"
+        "WHEN NEW.parent_id IS NOT NULL\nBEGIN"
+            + addToAncestors("NEW.parent_id", "1", "NEW.isCompleted", pendingNew)
+            + touchAncestors("NEW.parent_id")
+            + "END",
+        // 只移动：共同的祖先不变，只改动两条祖先链不重合的部分。
+        // 原父任务没有汇总行说明它正在被删除、子任务上移一级，删除触发器会处理
+        "CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_rollup_move AFTER UPDATE OF parent_id ON tasks\n"
+        "WHEN NEW.parent_id IS NOT OLD.parent_id\n"
+        " AND NEW.isCompleted IS OLD.isCompleted AND NEW.deadline IS OLD.deadline\n"
+        " AND (OLD.parent_id IS NULL OR EXISTS (SELECT 1 FROM task_rollups WHERE task_id = OLD.parent_id))\n"
+        "BEGIN"
+            + addToAncestors("NEW.parent_id", subtreeCount("NEW"), subtreeCompleted("NEW"),
+                             subtreeEarliest("NEW"), "OLD.parent_id")
+            + removeFromAncestors("OLD.parent_id", subtreeCount("OLD"), subtreeCompleted("OLD"),
+                                  subtreeEarliest("OLD"), "NEW.parent_id")
+            + touchAncestors("OLD.parent_id", "NEW.parent_id")
+            + touchAncestors("NEW.parent_id", "OLD.parent_id")
+            + "END",
+        // 移动的同时完成或改期（如同步写入）：从原祖先链整体减去，再整体加到新祖先链
+        "CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_rollup_move_state AFTER UPDATE OF parent_id ON tasks\n"
+        "WHEN NEW.parent_id IS NOT OLD.parent_id\n"
+        " AND (NEW.isCompleted IS NOT OLD.isCompleted OR NEW.deadline IS NOT OLD.deadline)\n"
+        "BEGIN"
+            + removeFromAncestors("OLD.parent_id", subtreeCount("OLD"), subtreeCompleted("OLD"),
+                                  subtreeEarliest("OLD"))
+            + touchAncestors("OLD.parent_id")
+            + addToAncestors("NEW.parent_id", subtreeCount("NEW"), subtreeCompleted("NEW"),
+                             subtreeEarliest("NEW"))
+            + touchAncestors("NEW.parent_id")
+            + "END",
+        "CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_rollup_state AFTER UPDATE OF isCompleted, deadline ON tasks\n"
+        "WHEN NEW.parent_id IS NOT NULL AND NEW.parent_id IS OLD.parent_id\n"
+        " AND (NEW.isCompleted IS NOT OLD.isCompleted OR NEW.deadline IS NOT OLD.deadline)\n"
+        "BEGIN"
+            + addToAncestors("NEW.parent_id", "0", "(NEW.isCompleted - OLD.isCompleted)", subtreeEarliest("NEW"))
+            + recomputeEarliest("NEW.parent_id", subtreeEarliest("OLD"))
+            + touchAncestors("NEW.parent_id")
+            + "END",
+        // 删除任务时子任务上移一级（不级联删除）。先删掉自身的汇总行，子任务逐个上移时不必再维护它
+        R"(
+        CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_rollup_promote BEFORE DELETE ON tasks
+        BEGIN
+            DELETE FROM task_rollups WHERE task_id = OLD.id;
+            UPDATE tasks SET parent_id = OLD.parent_id WHERE parent_id = OLD.id;
+        END
+        )",
+        "CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_rollup_delete AFTER DELETE ON tasks\n"
+        "WHEN OLD.parent_id IS NOT NULL\nBEGIN"
+            + removeFromAncestors("OLD.parent_id", "1", "OLD.isCompleted", pendingOld)
+            + touchAncestors("OLD.parent_id")
+            + "END"
+    };
+}
+
+bool addParentColumn(QSqlQuery &query, const QString &schema)
+{
+    return DBManager::ensureColumn(query, schema, "tasks", "parent_id", "INTEGER");
+}
+
+const QList<SchemaStep> &schemaSteps()
+{
+    static const QList<SchemaStep> steps = {
+        // 版本化之前的全部结构：createTables 是幂等的，已有数据库从0升级时只补齐缺少的部分
+        {1, "基础结构", &DBManager::createTables, {}, {}},
+        // 截止时间只改写格式（如 2024-05-01T09:00:00 -> 2024-05-01 09:00）时不记为改期
+        {2, "截止时间格式统一",
+         nullptr,
+         {
+             "DROP TRIGGER IF EXISTS %1.trg_tasks_event_deadline",
+             R"(
+             CREATE TRIGGER %1.trg_tasks_event_deadline AFTER UPDATE OF deadline ON tasks
+             WHEN NEW.deadline IS NOT OLD.deadline
+              AND COALESCE(strftime('%Y-%m-%d %H:%M', NEW.deadline), NEW.deadline)
+                  IS NOT COALESCE(strftime('%Y-%m-%d %H:%M', OLD.deadline), OLD.deadline)
+             BEGIN
+                 INSERT INTO task_events (task_id, event, at, old_value, new_value)
+                 VALUES (NEW.id, 'rescheduled', strftime('%Y-%m-%d %H:%M:%S', 'now', 'localtime'),
+                         OLD.deadline, NEW.deadline);
+             END
+             )"
+         },
+         {"normalize_deadlines", "normalize_archive_deadlines"}},
+        {3, "回填创建时间", nullptr, {}, {"backfill_created_at"}},
+        // 近似重复检测的 SimHash 指纹，每8位一段建表达式索引，按段精确查找候选。
+        // 指纹单独成表，后台重算时不会改动 tasks 的行版本；已有任务的指纹由查重扫描补齐
+        {4, "任务指纹",
+         nullptr,
+         {
+             R"(
+             CREATE TABLE IF NOT EXISTS %1.task_fingerprints (
+                 task_id INTEGER PRIMARY KEY,
+                 simhash INTEGER NOT NULL
+             )
+             )",
+             "CREATE INDEX IF NOT EXISTS %1.idx_task_fingerprints_b0 ON task_fingerprints ((simhash & 255))",
+             "CREATE INDEX IF NOT EXISTS %1.idx_task_fingerprints_b1 ON task_fingerprints (((simhash >> 8) & 255))",
+             "CREATE INDEX IF NOT EXISTS %1.idx_task_fingerprints_b2 ON task_fingerprints (((simhash >> 16) & 255))",
+             "CREATE INDEX IF NOT EXISTS %1.idx_task_fingerprints_b3 ON task_fingerprints (((simhash >> 24) & 255))",
+             "CREATE INDEX IF NOT EXISTS %1.idx_task_fingerprints_b4 ON task_fingerprints (((simhash >> 32) & 255))",
+             "CREATE INDEX IF NOT EXISTS %1.idx_task_fingerprints_b5 ON task_fingerprints (((simhash >> 40) & 255))",
+             "CREATE INDEX IF NOT EXISTS %1.idx_task_fingerprints_b6 ON task_fingerprints (((simhash >> 48) & 255))",
+             "CREATE INDEX IF NOT EXISTS %1.idx_task_fingerprints_b7 ON task_fingerprints (((simhash >> 56) & 255))",
+             R"(
+             CREATE TRIGGER IF NOT EXISTS %1.trg_tasks_delete_fingerprint AFTER DELETE ON tasks
+             BEGIN
+                 DELETE FROM task_fingerprints WHERE task_id = OLD.id;
+             END
+             )"
+         },
+         {}},
+        // 子任务：parent_id 指向父任务，子树的进度和最早截止时间汇总在 task_rollups。
+        // 已有任务都是顶层任务，汇总表从空开始
+        {5, "子任务", &addParentColumn, subtaskStatements(), {}},
+        // 描述压缩之前写入的长描述，原先在每次启动时扫描整表检查，现在升级时登记一次，在后台分批压缩
+        {6, "压缩长描述", nullptr, {}, {"compress_descriptions"}},
+        // 此前归档任务时没有一并删除依赖，清理指向已不在 tasks 中的任务的依赖
+        {7, "清理已归档任务的依赖",
+         nullptr,
+         {
+             R"(
+             DELETE FROM %1.task_dependencies
+             WHERE blocker_id NOT IN (SELECT id FROM %1.tasks) OR blocked_id NOT IN (SELECT id FROM %1.tasks)
+             )"
+         },
+         {}}
+    };
+    return steps;
+}
+
+const QList<DataMigration> &dataMigrations()
+{
+    static const QList<DataMigration> migrations = {
+        // 其他程序或旧版本写入的截止时间统一为 yyyy-MM-dd HH:mm，保证按字符串排序和比较正确
+        {"normalize_deadlines", "统一截止时间格式", "tasks", R"(
+            UPDATE tasks SET deadline = strftime('%Y-%m-%d %H:%M', deadline)
+            WHERE id > :from AND id <= :to
+              AND deadline NOT GLOB '[0-9][0-9][0-9][0-9]-[0-9][0-9]-[0-9][0-9] [0-9][0-9]:[0-9][0-9]'
+              AND strftime('%Y-%m-%d %H:%M', deadline) IS NOT NULL
+        )"},
+        {"normalize_archive_deadlines", "统一归档任务的截止时间格式", "tasks_archive", R"(
+            UPDATE tasks_archive SET deadline = strftime('%Y-%m-%d %H:%M', deadline)
+            WHERE id > :from AND id <= :to
+              AND deadline NOT GLOB '[0-9][0-9][0-9][0-9]-[0-9][0-9]-[0-9][0-9] [0-9][0-9]:[0-9][0-9]'
+              AND strftime('%Y-%m-%d %H:%M', deadline) IS NOT NULL
+        )"},
+        // 添加任务时所有字段以同一时间戳写入变更日志，以此推出 created_at 之前创建的任务的创建时间；
+        // 变更日志出现之前的任务（只有 stamp=0 的初始快照）无法推断，保持为空
+        {"backfill_created_at", "回填任务创建时间", "tasks", R"(
+            UPDATE tasks
+            SET created_at = (SELECT strftime('%Y-%m-%d %H:%M:%S', c.stamp / 1000, 'unixepoch', 'localtime')
+                              FROM change_log c
+                              WHERE c.task_uuid = tasks.uuid AND c.stamp > 0
+                              GROUP BY c.stamp
+                              HAVING COUNT(DISTINCT c.field) >= 5
+                              ORDER BY c.stamp
+                              LIMIT 1)
+            WHERE id > :from AND id <= :to AND created_at IS NULL
+        )"},
+        {"compress_descriptions", "压缩长描述", "tasks", nullptr, &DBManager::compressDescriptions}
+    };
+    return migrations;
+}
+
+const DataMigration *findDataMigration(const QString &name)
+{
+    for (const DataMigration &migration : dataMigrations()) {
+        if (name == migration.name) return &migration;
+    }
+    return nullptr;
+}
+
+QString progressKey(const QString &name)
+{
+    return "migration:" + name;
+}
+
+bool fail(QSqlQuery &query, const QString &what, QString *error)
+{
+    *error = what + "：" + query.lastError().text();
+    qCritical() << *error;
+    query.exec("ROLLBACK");
+    return false;
+}
+}
+
+int SchemaMigrator::latestVersion()
+{
+    return schemaSteps().last().version;
+}
+
+int SchemaMigrator::schemaVersion(QSqlQuery &query, const QString &schema)
+{
+    if (!query.exec(QString("PRAGMA %1.user_version").arg(schema)) || !query.next()) {
+        qCritical() << "读取数据库版本失败：" << query.lastError().text();
+        return -1;
+    }
+    int version = query.value(0).toInt();
+    query.finish();
+    return version;
+}
+
+bool SchemaMigrator::migrate(QSqlQuery &query, const QString &schema, QString *error)
+{
+    int version = schemaVersion(query, schema);
+    if (version < 0) {
+        *error = "无法读取数据库版本";
+        return false;
+    }
+    if (version > latestVersion()) {
+        *error = QString("数据库版本 %1 高于本程序支持的版本 %2，请升级程序").arg(version).arg(latestVersion());
+        qCritical() << *error;
+        return false;
+    }
+
+    for (const SchemaStep &step : schemaSteps()) {
+        if (step.version <= version) continue;
+
+        qDebug() << "数据库迁移：" << schema << "版本" << version << "->" << step.version << step.description;
+        if (!query.exec("BEGIN IMMEDIATE")) {
+            return fail(query, "无法开始迁移事务", error);
+        }
+        if (step.apply && !step.apply(query, schema)) {
+            return fail(query, QString("迁移到版本 %1 失败").arg(step.version), error);
+        }
+        for (const QString &statement : step.statements) {
+            if (!query.exec(statement.arg(schema))) {
+                return fail(query, QString("迁移到版本 %1 失败").arg(step.version), error);
+            }
+        }
+        for (const QString &name : step.dataMigrations) {
+            query.prepare(QString("INSERT OR IGNORE INTO %1.meta (key, value) VALUES (:key, '0')").arg(schema));
+            query.bindValue(":key", progressKey(name));
+            if (!query.exec()) {
+                return fail(query, "登记数据迁移失败", error);
+            }
+        }
+        // user_version 写在数据库头中，随事务一起提交或回滚
+        if (!query.exec(QString("PRAGMA %1.user_version = %2").arg(schema).arg(step.version))
+            || !query.exec("COMMIT")) {
+            return fail(query, QString("迁移到版本 %1 失败").arg(step.version), error);
+        }
+        version = step.version;
+    }
+    return true;
+}
+
+QStringList SchemaMigrator::pendingDataMigrations(QSqlQuery &query)
+{
+    QStringList pending;
+    query.prepare("SELECT value FROM meta WHERE key = :key");
+    for (const DataMigration &migration : dataMigrations()) {
+        query.bindValue(":key", progressKey(migration.name));
+        if (query.exec() && query.next() && query.value(0).toString() != "done") {
+            pending << migration.name;
+        }
+    }
+    query.finish();
+    return pending;
+}
+
+QString SchemaMigrator::dataMigrationDescription(const QString &name)
+{
+    const DataMigration *migration = findDataMigration(name);
+    return migration ? QString(migration->description) : name;
+}
+
+bool SchemaMigrator::runDataBatch(QSqlQuery &query, const QString &name, int batchSize,
+                                  int *rows, bool *finished, QString *error)
+{
+    *rows = 0;
+    *finished = false;
+    const DataMigration *migration = findDataMigration(name);
+    if (!migration) {
+        *error = "未知的数据迁移：" + name;
+        return false;
+    }
+
+    // 读取进度、执行本批和保存进度在同一个写事务中，中断后从上次提交的位置继续
+    if (!query.exec("BEGIN IMMEDIATE")) {
+        return fail(query, "无法开始数据迁移事务", error);
+    }
+
+    query.prepare("SELECT value FROM meta WHERE key = :key");
+    query.bindValue(":key", progressKey(name));
+    if (!query.exec() || !query.next()) {
+        return fail(query, "读取数据迁移进度失败", error);
+    }
+    const QString cursor = query.value(0).toString();
+    if (cursor == "done") {
+        *finished = true;
+        query.exec("COMMIT");
+        return true;
+    }
+    const qint64 from = cursor.toLongLong();
+
+    query.prepare(QString("SELECT MAX(id), COUNT(*) FROM (SELECT id FROM %1 WHERE id > :from ORDER BY id LIMIT :limit)")
+                      .arg(migration->table));
+    query.bindValue(":from", from);
+    query.bindValue(":limit", batchSize);
+    if (!query.exec() || !query.next()) {
+        return fail(query, "读取数据迁移范围失败", error);
+    }
+    const QVariant to = query.value(0);
+    *rows = query.value(1).toInt();
+
+    if (!to.isNull()) {
+        bool ok;
+        if (migration->run) {
+            ok = migration->run(query, from, to.toLongLong());
+        } else {
+            query.prepare(migration->update);
+            query.bindValue(":from", from);
+            query.bindValue(":to", to);
+            ok = query.exec();
+        }
+        if (!ok) {
+            return fail(query, QString("数据迁移 %1 失败").arg(name), error);
+        }
+    }
+
+    *finished = to.isNull() || *rows < batchSize;
+    query.prepare("UPDATE meta SET value = :value WHERE key = :key");
+    query.bindValue(":value", *finished ? QString("done") : to.toString());
+    query.bindValue(":key", progressKey(name));
+    if (!query.exec() || !query.exec("COMMIT")) {
+        return fail(query, "保存数据迁移进度失败", error);
+    }
+    return true;
+}
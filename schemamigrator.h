@@ -0,0 +1,29 @@
+#ifndef SCHEMAMIGRATOR_H
+#define SCHEMAMIGRATOR_H
+
+#include <QSqlQuery>
+#include <QString>
+#include <QStringList>
+
+// 数据库结构版本（PRAGMA user_version）与迁移
+// 结构迁移按版本号顺序在启动时同步执行，每一步与 user_version 的更新处于同一事务，
+// 中途失败不会留下半升级的结构。耗时的数据迁移（改写格式、回填列）由结构迁移登记到
+// meta 表，在后台连接上按 id 分批执行，进度随每批一起提交，程序退出后下次启动继续。
+class SchemaMigrator
+{
+public:
+    static int latestVersion();
+    static int schemaVersion(QSqlQuery &query, const QString &schema);
+
+    // 把 schema（main 或 ATTACH 的同步对端）升级到最新版本
+    static bool migrate(QSqlQuery &query, const QString &schema, QString *error);
+
+    // 已登记但尚未完成的数据迁移（按登记顺序）
+    static QStringList pendingDataMigrations(QSqlQuery &query);
+    static QString dataMigrationDescription(const QString &name);
+    // 执行一批，rows 返回本批扫描的行数；全部完成时 finished 为true
+    static bool runDataBatch(QSqlQuery &query, const QString &name, int batchSize,
+                             int *rows, bool *finished, QString *error);
+};
+
+#endif // SCHEMAMIGRATOR_H
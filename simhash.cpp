@@ -0,0 +1,193 @@
+#include "simhash.h"
+#include "metrics.h"
+#include <QAtomicInt>
+#include <QDebug>
+#include <QHash>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace {
+const int kShingleSize = 3;
+const int kTitleWeight = 2;         // 标题比描述更能代表任务
+
+// 小写，只保留字母和数字（包括汉字），其余字符视为单个空格
+QString normalize(const QString &text)
+{
+    QString result;
+    result.reserve(text.size());
+    bool space = true;
+    for (QChar c : text) {
+        if (c.isLetterOrNumber()) {
+            result.append(c.toLower());
+            space = false;
+        } else if (!space) {
+            result.append(QLatin1Char(' '));
+            space = true;
+        }
+    }
+    if (result.endsWith(QLatin1Char(' '))) result.chop(1);
+    return result;
+}
+
+// FNV-1a 再经 splitmix64 混合，使各位分布均匀
+quint64 hashShingle(const QChar *data, int length)
+{
+    quint64 h = 14695981039346656037ULL;
+    for (int i = 0; i < length; ++i) {
+        h ^= data[i].unicode();
+        h *= 1099511628211ULL;
+    }
+    h += 0x9e3779b97f4a7c15ULL;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+void accumulate(const QString &text, int weight, int votes[64])
+{
+    const QString normalized = normalize(text);
+    if (normalized.isEmpty()) return;
+
+    // 比 shingle 短的文本整体作为一个特征
+    const int count = qMax(1, normalized.size() - kShingleSize + 1);
+    const int length = qMin(kShingleSize, normalized.size());
+    for (int i = 0; i < count; ++i) {
+        quint64 h = hashShingle(normalized.constData() + i, length);
+        for (int bit = 0; bit < 64; ++bit) {
+            votes[bit] += (h >> bit) & 1 ? weight : -weight;
+        }
+    }
+}
+
+int findRoot(QVector<int> &parent, int x)
+{
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+}
+
+quint64 SimHash::compute(const QString &title, const QString &description)
+{
+    int votes[64] = {};
+    accumulate(title, kTitleWeight, votes);
+    accumulate(description, 1, votes);
+
+    quint64 fingerprint = 0;
+    for (int bit = 0; bit < 64; ++bit) {
+        if (votes[bit] > 0) fingerprint |= quint64(1) << bit;
+    }
+    return fingerprint;
+}
+
+int SimHash::distance(quint64 a, quint64 b)
+{
+    return qPopulationCount(a ^ b);
+}
+
+QList<QVector<int>> SimHash::findGroups(const QVector<QPair<int, quint64>> &fingerprints, int maxDistance,
+                                        int *truncatedBuckets)
+{
+    static Counter *const truncatedTotal = Metrics::counter("zhsj_simhash_truncated_buckets_total",
+                                                            "查重时超过上限、只比较了部分指纹的分桶数");
+    // 指纹完全相同的任务先合并，之后只对不同的指纹做分段比较
+    QHash<quint64, QVector<int>> idsByFingerprint;
+    idsByFingerprint.reserve(fingerprints.size());
+    for (const auto &item : fingerprints) {
+        idsByFingerprint[item.second].append(item.first);
+    }
+
+    QVector<quint64> unique;
+    unique.reserve(idsByFingerprint.size());
+    for (auto it = idsByFingerprint.constBegin(); it != idsByFingerprint.constEnd(); ++it) {
+        unique.append(it.key());
+    }
+
+    // 每种分桶方式取两段拼成16位键，按键计数排序后键相同的区间即为一个桶，桶内两两比较
+    QVector<QPair<int, int>> keyBands;
+    for (int i = 0; i < kBands; ++i) {
+        for (int j = i + 1; j < kBands; ++j) {
+            keyBands.append(qMakePair(i, j));
+        }
+    }
+
+    // 单个分桶内两两比较的次数是平方级的，病态数据（如大量几乎相同的任务）下只比较桶内前 kMaxBucketSize 个
+    QAtomicInt truncated;
+    QAtomicInt largestBucket;
+    const QVector<QVector<QPair<int, int>>> matches = QtConcurrent::blockingMapped<QVector<QVector<QPair<int, int>>>>(
+        keyBands, [&unique, maxDistance, &truncated, &largestBucket](const QPair<int, int> &bands) {
+            const int keyCount = 1 << (2 * kBandBits);
+            QVector<int> keys(unique.size());
+            QVector<int> bucketStart(keyCount + 1, 0);
+            for (int i = 0; i < unique.size(); ++i) {
+                keys[i] = (band(unique.at(i), bands.first) << kBandBits) | band(unique.at(i), bands.second);
+                ++bucketStart[keys.at(i) + 1];
+            }
+            for (int k = 0; k < keyCount; ++k) {
+                bucketStart[k + 1] += bucketStart.at(k);
+            }
+            QVector<int> order(unique.size());
+            QVector<int> fill = bucketStart;
+            for (int i = 0; i < unique.size(); ++i) {
+                order[fill[keys.at(i)]++] = i;
+            }
+
+            QVector<QPair<int, int>> pairs;
+            for (int k = 0; k < keyCount; ++k) {
+                const int start = bucketStart.at(k);
+                const int size = bucketStart.at(k + 1) - start;
+                if (size > kMaxBucketSize) {
+                    truncated.fetchAndAddRelaxed(1);
+                    int largest = largestBucket.loadRelaxed();
+                    while (size > largest && !largestBucket.testAndSetRelaxed(largest, size)) {
+                        largest = largestBucket.loadRelaxed();
+                    }
+                }
+                const int limit = start + qMin(size, kMaxBucketSize);
+                for (int i = start; i < limit; ++i) {
+                    for (int j = i + 1; j < limit; ++j) {
+                        int x = order.at(i);
+                        int y = order.at(j);
+                        if (distance(unique.at(x), unique.at(y)) <= maxDistance) {
+                            pairs.append(qMakePair(x, y));
+                        }
+                    }
+                }
+            }
+            return pairs;
+        });
+
+    const int truncatedCount = truncated.loadRelaxed();
+    if (truncatedCount > 0) {
+        qWarning() << "查重：" << truncatedCount << "个分桶超过" << kMaxBucketSize << "个指纹（最大"
+                   << largestBucket.loadRelaxed() << "个），只比较了其中一部分，可能漏掉相似任务";
+        truncatedTotal->add(quint64(truncatedCount));
+    }
+    if (truncatedBuckets) *truncatedBuckets = truncatedCount;
+
+    QVector<int> parent(unique.size());
+    for (int i = 0; i < parent.size(); ++i) parent[i] = i;
+    for (const auto &pairs : matches) {
+        for (const auto &pair : pairs) {
+            parent[findRoot(parent, pair.first)] = findRoot(parent, pair.second);
+        }
+    }
+
+    QHash<int, QVector<int>> groupsByRoot;
+    for (int i = 0; i < unique.size(); ++i) {
+        groupsByRoot[findRoot(parent, i)] += idsByFingerprint.value(unique.at(i));
+    }
+
+    QList<QVector<int>> groups;
+    for (auto it = groupsByRoot.begin(); it != groupsByRoot.end(); ++it) {
+        if (it.value().size() < 2) continue;
+        std::sort(it.value().begin(), it.value().end());
+        groups.append(it.value());
+    }
+    std::sort(groups.begin(), groups.end(), [](const QVector<int> &a, const QVector<int> &b) {
+        return a.size() > b.size() || (a.size() == b.size() && a.first() < b.first());
+    });
+    return groups;
+}
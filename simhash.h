@@ -0,0 +1,36 @@
+#ifndef SIMHASH_H
+#define SIMHASH_H
+
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+// 64位 SimHash 指纹：标题和描述规范化后取字符3-gram，各自哈希后按位加权投票。
+// 内容相近的任务指纹的汉明距离很小（任务标题较短，改几个字通常相差5~12位，无关任务在20位以上）。
+// 指纹分成 kBands 段，每段8位。距离为 d 的两个指纹至少有 kBands-d 段完全相同（抽屉原理）：
+// 数据库查找候选时只需任一段相同（d<=7），全库聚类时用两段拼成的16位键分桶（d<=6），都不用两两比较。
+class SimHash
+{
+public:
+    static const int kBands = 8;
+    static const int kBandBits = 8;
+    static const int kDefaultMaxDistance = 6;
+    static constexpr int kMaxBucketSize = 4096;     // 单个分桶内两两比较的指纹数上限，防止病态数据退化为平方复杂度
+
+    static quint64 compute(const QString &title, const QString &description);
+    static int distance(quint64 a, quint64 b);
+    static int band(quint64 fingerprint, int index)
+    {
+        return int((fingerprint >> (index * kBandBits)) & ((1 << kBandBits) - 1));
+    }
+
+    // 把 (任务ID, 指纹) 聚成近似重复组（每组至少2个任务，按组大小降序）；各分桶方式在线程池中并行。
+    // 单个分桶超过 kMaxBucketSize 个指纹时只比较其中前 kMaxBucketSize 个，
+    // truncatedBuckets 返回这样的分桶数（不为0时结果可能漏掉部分相似任务）
+    static QList<QVector<int>> findGroups(const QVector<QPair<int, quint64>> &fingerprints,
+                                          int maxDistance = kDefaultMaxDistance, int *truncatedBuckets = nullptr);
+};
+
+#endif // SIMHASH_H
@@ -0,0 +1,413 @@
+#include "slowquerylog.h"
+#include "metrics.h"
+#include "dbmanager.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSettings>
+#include <QSqlDriver>
+#include <QTextStream>
+#include <algorithm>
+#include <sqlite3.h>
+
+namespace {
+const int kMaxCachedPlans = 256;
+const char *const kStatementKinds[] = {"select", "insert", "update", "delete", "other"};
+
+// 语句的第一个关键字，对应 kStatementKinds 的下标
+int statementKind(const char *sql)
+{
+    while (*sql == ' ' || *sql == '\t' || *sql == '\n' || *sql == '\r') ++sql;
+    for (int i = 0; i < 4; ++i) {
+        if (qstrnicmp(sql, kStatementKinds[i], 6) == 0) return i;
+    }
+    // WITH ... SELECT 归入查询
+    return qstrnicmp(sql, "with", 4) == 0 ? 0 : 4;
+}
+
+bool isIdentifierChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'
+           || (static_cast<unsigned char>(c) & 0x80);
+}
+
+// 读取展开后 SQL 中 pos 处的字面量，返回其形态并前移 pos；无法识别时返回空
+QString literalShape(const QByteArray &expanded, int *pos)
+{
+    int i = *pos;
+    const int n = expanded.size();
+    if (expanded.mid(i, 4) == "NULL") {
+        *pos = i + 4;
+        return "NULL";
+    }
+    if (expanded.mid(i, 2) == "x'") {
+        int end = expanded.indexOf('\'', i + 2);
+        if (end < 0) return QString();
+        *pos = end + 1;
+        return QString("BLOB(%1)").arg((end - i - 2) / 2);
+    }
+    if (expanded.mid(i, 9) == "zeroblob(") {
+        int end = expanded.indexOf(')', i);
+        if (end < 0) return QString();
+        *pos = end + 1;
+        return QString("BLOB(%1)").arg(QString::fromLatin1(expanded.mid(i + 9, end - i - 9)));
+    }
+    if (expanded.at(i) == '\'') {
+        QByteArray text;
+        for (++i; i < n; ++i) {
+            if (expanded.at(i) == '\'') {
+                if (i + 1 < n && expanded.at(i + 1) == '\'') {
+                    text.append('\'');
+                    ++i;
+                    continue;
+                }
+                *pos = i + 1;
+                return QString("TEXT(%1)").arg(QString::fromUtf8(text).size());
+            }
+            text.append(expanded.at(i));
+        }
+        return QString();
+    }
+
+    bool real = false;
+    int start = i;
+    if (i < n && (expanded.at(i) == '-' || expanded.at(i) == '+')) ++i;
+    for (; i < n; ++i) {
+        const char c = expanded.at(i);
+        if (c == '.' || c == 'e' || c == 'E') {
+            real = true;
+        } else if (!(c >= '0' && c <= '9')
+                   && !((c == '-' || c == '+') && (expanded.at(i - 1) == 'e' || expanded.at(i - 1) == 'E'))) {
+            break;
+        }
+    }
+    if (i == start) return QString();
+    *pos = i;
+    return real ? "REAL" : "INTEGER";
+}
+
+// 参数形态：对照原始 SQL 与 sqlite3_expanded_sql 的结果，取出每个参数位置上的字面量类型。
+// 对照失败时只列出参数名
+QStringList parameterShapes(sqlite3_stmt *stmt)
+{
+    const int count = sqlite3_bind_parameter_count(stmt);
+    if (count == 0) return QStringList();
+
+    QStringList names;
+    for (int i = 1; i <= count; ++i) {
+        const char *name = sqlite3_bind_parameter_name(stmt, i);
+        names.append(name ? QString::fromUtf8(name) : QString("?%1").arg(i));
+    }
+
+    QVector<QString> shapes(count + 1);
+    char *expandedSql = sqlite3_expanded_sql(stmt);
+    const QByteArray sql(sqlite3_sql(stmt));
+    const QByteArray expanded(expandedSql ? expandedSql : "");
+    sqlite3_free(expandedSql);
+
+    bool matched = !expanded.isEmpty();
+    int i = 0;
+    int j = 0;
+    int maxIndex = 0;
+    while (matched && i < sql.size()) {
+        const char c = sql.at(i);
+        int end = i + 1;
+        // 字符串、带引号的标识符和注释原样出现在展开结果中
+        if (c == '\'' || c == '"' || c == '`' || c == '[') {
+            const char close = c == '[' ? ']' : c;
+            end = sql.indexOf(close, i + 1);
+            end = end < 0 ? sql.size() : end + 1;
+        } else if (c == '-' && sql.mid(i, 2) == "--") {
+            end = sql.indexOf('\n', i);
+            end = end < 0 ? sql.size() : end + 1;
+        } else if (c == '/' && sql.mid(i, 2) == "/*") {
+            end = sql.indexOf("*/", i + 2);
+            end = end < 0 ? sql.size() : end + 2;
+        } else if (c == '?' || ((c == ':' || c == '@' || c == '$') && i + 1 < sql.size()
+                                && isIdentifierChar(sql.at(i + 1)))) {
+            while (end < sql.size() && isIdentifierChar(sql.at(end))) ++end;
+            const QByteArray token = sql.mid(i, end - i);
+            // 与 SQLite 的编号规则一致："?" 取已用最大编号加一，"?NNN" 为指定编号，命名参数查表
+            int index = c == '?' ? (token.size() > 1 ? token.mid(1).toInt() : maxIndex + 1)
+                                 : sqlite3_bind_parameter_index(stmt, token.constData());
+            maxIndex = qMax(maxIndex, index);
+            const QString shape = literalShape(expanded, &j);
+            if (shape.isEmpty()) {
+                matched = false;
+            } else if (index >= 1 && index <= count && shapes.at(index).isEmpty()) {
+                shapes[index] = shape;
+            }
+            i = end;
+            continue;
+        }
+        if (expanded.mid(j, end - i) != sql.mid(i, end - i)) {
+            matched = false;
+            break;
+        }
+        j += end - i;
+        i = end;
+    }
+
+    QStringList result;
+    for (int k = 1; k <= count; ++k) {
+        result.append(matched && !shapes.at(k).isEmpty() ? names.at(k - 1) + ' ' + shapes.at(k) : names.at(k - 1));
+    }
+    return result;
+}
+
+// 与 sqlite3 命令行相同的树形缩进
+QString explainQueryPlan(sqlite3 *db, const QString &sql)
+{
+    sqlite3_stmt *stmt = nullptr;
+    const QByteArray text = "EXPLAIN QUERY PLAN " + sql.toUtf8();
+    if (sqlite3_prepare_v2(db, text.constData(), -1, &stmt, nullptr) != SQLITE_OK) {
+        const QString error = QString::fromUtf8(sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        return QString("（无法获取：%1）").arg(error);
+    }
+
+    QHash<int, int> depth;
+    QStringList lines;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const int id = sqlite3_column_int(stmt, 0);
+        const int parent = sqlite3_column_int(stmt, 1);
+        const int level = parent == 0 ? 0 : depth.value(parent, 0) + 1;
+        depth.insert(id, level);
+        lines.append(QString(level * 2, ' ')
+                     + QString::fromUtf8(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3))));
+    }
+    sqlite3_finalize(stmt);
+    return lines.isEmpty() ? QString("（无）") : lines.join('\n');
+}
+
+sqlite3 *sqliteHandle(const QSqlDatabase &db)
+{
+    const QVariant handle = db.driver() ? db.driver()->handle() : QVariant();
+    if (!handle.isValid() || qstrcmp(handle.typeName(), "sqlite3*") != 0) return nullptr;
+    return *static_cast<sqlite3 *const *>(handle.constData());
+}
+}
+
+SlowQueryLog::SlowQueryLog(QObject *parent)
+    : QObject(parent)
+{
+    QSettings settings;
+    m_thresholdMicros.storeRelaxed(qint64(qMax(0, settings.value("slowQuery/thresholdMs", 20).toInt())) * 1000);
+    m_capacity = qMax(1, settings.value("slowQuery/capacity", 200).toInt());
+
+    for (int i = 0; i < 5; ++i) {
+        m_latency[i] = Metrics::histogram("zhsj_sql_statement_seconds", "单条 SQL 语句的执行耗时（首次步进到执行完）",
+                                          QString("kind=\"%1\"").arg(kStatementKinds[i]));
+    }
+}
+
+bool SlowQueryLog::attach(const QSqlDatabase &db)
+{
+    m_attached = false;
+    sqlite3 *handle = sqliteHandle(db);
+    if (!handle) {
+        m_unavailableReason = "不是 SQLite 连接";
+        qWarning() << "慢语句日志：不是 SQLite 连接，无法跟踪" << db.connectionName();
+        return false;
+    }
+    // 句柄属于驱动自带的另一份 SQLite 时，交给这里链接的 C API 会直接崩溃
+    if (!DBManager::sameSqliteLibrary(db, &m_unavailableReason)) {
+        qCritical() << "慢语句日志不可用：" << m_unavailableReason;
+        return false;
+    }
+    m_unavailableReason.clear();
+    m_attached = true;
+    sqlite3_trace_v2(handle, SQLITE_TRACE_PROFILE, &SlowQueryLog::traceCallback, this);
+    qDebug() << "慢语句日志：阈值" << thresholdMs() << "ms，保留最近" << capacity() << "条";
+    return true;
+}
+
+int SlowQueryLog::traceCallback(unsigned type, void *context, void *statement, void *elapsed)
+{
+    if (type == SQLITE_TRACE_PROFILE) {
+        static_cast<SlowQueryLog *>(context)->record(statement, *static_cast<sqlite3_int64 *>(elapsed));
+    }
+    return 0;
+}
+
+// 在执行语句的线程中调用：快的语句只记一次直方图，慢语句才加锁写入缓冲区
+void SlowQueryLog::record(void *statement, qint64 nanos)
+{
+    sqlite3_stmt *stmt = static_cast<sqlite3_stmt *>(statement);
+    const char *sql = sqlite3_sql(stmt);
+    if (!sql) return;
+
+    const qint64 micros = nanos / 1000;
+    m_latency[statementKind(sql)]->record(quint64(qMax<qint64>(0, micros)));
+    if (micros < m_thresholdMicros.loadRelaxed() || qstrnicmp(sql, "EXPLAIN", 7) == 0)
+        return;
+
+    static Counter *const slowStatements = Metrics::counter("zhsj_sql_slow_statements_total", "超过阈值的 SQL 语句数");
+    slowStatements->add();
+
+    Entry entry;
+    entry.time = QDateTime::currentDateTime();
+    entry.micros = micros;
+    entry.sql = QString::fromUtf8(sql).trimmed();
+    entry.params = parameterShapes(stmt);
+
+    bool notify = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        entry.plan = m_plans.value(entry.sql);
+        if (entry.plan.isEmpty() && !m_pending.contains(entry.sql)) {
+            notify = m_pending.isEmpty();
+            m_pending.append(entry.sql);
+        }
+        if (m_ring.size() < m_capacity) {
+            m_ring.append(entry);
+        } else {
+            m_ring[m_next] = entry;
+        }
+        m_next = (m_next + 1) % m_capacity;
+    }
+    qDebug() << "慢语句：" << micros / 1000.0 << "ms" << entry.sql.left(120);
+    if (notify) emit planNeeded();
+}
+
+void SlowQueryLog::explainPending(const QSqlDatabase &db)
+{
+    QStringList pending;
+    {
+        QMutexLocker locker(&m_mutex);
+        pending.swap(m_pending);
+    }
+    sqlite3 *handle = m_attached ? sqliteHandle(db) : nullptr;
+    if (pending.isEmpty() || !handle) return;
+
+    QHash<QString, QString> plans;
+    for (const QString &sql : pending) {
+        plans.insert(sql, explainQueryPlan(handle, sql));
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_plans.size() + plans.size() > kMaxCachedPlans) {
+        m_plans.clear();
+    }
+    for (auto it = plans.constBegin(); it != plans.constEnd(); ++it) {
+        m_plans.insert(it.key(), it.value());
+    }
+    for (Entry &entry : m_ring) {
+        if (entry.plan.isEmpty()) entry.plan = plans.value(entry.sql);
+    }
+}
+
+void SlowQueryLog::setThresholdMs(int ms)
+{
+    m_thresholdMicros.storeRelaxed(qint64(qMax(0, ms)) * 1000);
+    QSettings settings;
+    settings.setValue("slowQuery/thresholdMs", qMax(0, ms));
+}
+
+int SlowQueryLog::capacity() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_capacity;
+}
+
+// 缩小容量时保留最新的记录
+void SlowQueryLog::setCapacity(int capacity)
+{
+    capacity = qMax(1, capacity);
+    const QList<Entry> kept = entries();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_capacity = capacity;
+        m_ring.clear();
+        for (int i = qMax(0, kept.size() - capacity); i < kept.size(); ++i) {
+            m_ring.append(kept.at(i));
+        }
+        m_next = m_ring.size() % m_capacity;
+    }
+    QSettings settings;
+    settings.setValue("slowQuery/capacity", capacity);
+}
+
+QList<SlowQueryLog::Entry> SlowQueryLog::entries() const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<Entry> result;
+    result.reserve(m_ring.size());
+    // 缓冲区写满后 m_next 处即最旧的一条
+    const int start = m_ring.size() < m_capacity ? 0 : m_next;
+    for (int i = 0; i < m_ring.size(); ++i) {
+        result.append(m_ring.at((start + i) % m_ring.size()));
+    }
+    return result;
+}
+
+int SlowQueryLog::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_ring.size();
+}
+
+void SlowQueryLog::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_ring.clear();
+    m_next = 0;
+}
+
+bool SlowQueryLog::dump(const QString &path, QString *error) const
+{
+    const QList<Entry> all = entries();
+
+    struct Group {
+        QString sql;
+        int count = 0;
+        qint64 totalMicros = 0;
+        qint64 maxMicros = 0;
+    };
+    QHash<QString, Group> groups;
+    for (const Entry &entry : all) {
+        Group &group = groups[entry.sql];
+        group.sql = entry.sql;
+        ++group.count;
+        group.totalMicros += entry.micros;
+        group.maxMicros = qMax(group.maxMicros, entry.micros);
+    }
+    QList<Group> ranked = groups.values();
+    std::sort(ranked.begin(), ranked.end(), [](const Group &a, const Group &b) {
+        return a.totalMicros > b.totalMicros;
+    });
+
+    QString text;
+    QTextStream out(&text);
+    out << "# 慢语句日志，导出于 " << QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss")
+        << "，阈值 " << thresholdMs() << " ms，共 " << all.size() << " 条\n\n";
+    out << "## 按语句汇总（总耗时降序）\n";
+    for (const Group &group : ranked) {
+        out << group.count << " 次  总计 " << Metrics::formatMicros(quint64(group.totalMicros))
+            << "  最大 " << Metrics::formatMicros(quint64(group.maxMicros)) << "\n    "
+            << group.sql.simplified() << '\n';
+    }
+    out << "\n## 明细（由旧到新）\n";
+    for (const Entry &entry : all) {
+        out << '[' << entry.time.toString("yyyy-MM-dd HH:mm:ss.zzz") << "] "
+            << Metrics::formatMicros(quint64(entry.micros)) << '\n';
+        out << "SQL: " << entry.sql << '\n';
+        if (!entry.params.isEmpty())
+            out << "参数: " << entry.params.join(", ") << '\n';
+        out << "查询计划:\n";
+        const QStringList lines = entry.plan.isEmpty() ? QStringList("（尚未获取）") : entry.plan.split('\n');
+        for (const QString &line : lines) {
+            out << "  " << line << '\n';
+        }
+        out << '\n';
+    }
+    out.flush();
+
+    const QByteArray data = text.toUtf8();
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
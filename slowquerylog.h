@@ -0,0 +1,73 @@
+#ifndef SLOWQUERYLOG_H
+#define SLOWQUERYLOG_H
+
+#include <QAtomicInteger>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QStringList>
+#include <QVector>
+
+class Histogram;
+
+// 慢语句日志
+// 通过 SQLite 的跟踪回调给连接上执行的每一条语句计时（按语句类型记入 zhsj_sql_statement_seconds），
+// 超过阈值的语句连同 SQL、绑定参数的形态（类型和长度，不记录值）保存在固定容量的环形缓冲区中。
+// 跟踪回调里不能在同一连接上再执行语句，EXPLAIN QUERY PLAN 由连接的所有者随后在事件循环中补上，
+// 同一条 SQL 的计划只取一次。配置保存在 QSettings 的 slowQuery/ 分组下
+class SlowQueryLog : public QObject
+{
+    Q_OBJECT
+public:
+    struct Entry {
+        QDateTime time;
+        qint64 micros = 0;
+        QString sql;            // 带占位符的原始语句
+        QStringList params;     // 如 ":deadline TEXT(16)"、"?2 INTEGER"
+        QString plan;           // 查询计划，尚未获取时为空
+    };
+
+    explicit SlowQueryLog(QObject *parent = nullptr);
+
+    // 开始跟踪该连接（每次打开连接后调用）；驱动不是 SQLite，或不是程序链接的那份 SQLite 时返回false
+    bool attach(const QSqlDatabase &db);
+    bool isAttached() const { return m_attached; }
+    QString unavailableReason() const { return m_unavailableReason; }
+
+    int thresholdMs() const { return int(m_thresholdMicros.loadRelaxed() / 1000); }
+    void setThresholdMs(int ms);
+    int capacity() const;
+    void setCapacity(int capacity);
+
+    QList<Entry> entries() const;   // 由旧到新
+    int size() const;
+    void clear();
+
+    // 为尚缺计划的语句执行 EXPLAIN QUERY PLAN；调用方须持有该连接的锁
+    void explainPending(const QSqlDatabase &db);
+    // 按 SQL 汇总（次数、总耗时、最大耗时，按总耗时排序）后附上每条记录
+    bool dump(const QString &path, QString *error = nullptr) const;
+
+signals:
+    void planNeeded();      // 有新的慢语句需要补查询计划（可能从执行语句的线程发出）
+
+private:
+    static int traceCallback(unsigned type, void *context, void *statement, void *elapsed);
+    void record(void *statement, qint64 nanos);
+
+    mutable QMutex m_mutex;
+    QAtomicInteger<qint64> m_thresholdMicros{0};
+    QVector<Entry> m_ring;
+    int m_next = 0;             // 下一条写入的位置
+    int m_capacity;
+    bool m_attached = false;
+    QString m_unavailableReason;        // 无法跟踪的原因
+    QHash<QString, QString> m_plans;    // SQL -> 查询计划
+    QStringList m_pending;              // 等待补计划的 SQL
+    Histogram *m_latency[5];            // select/insert/update/delete/其他
+};
+
+#endif // SLOWQUERYLOG_H
@@ -0,0 +1,23 @@
+#include "syncjob.h"
+#include "dbmanager.h"
+#include <QDebug>
+
+SyncJob::SyncJob(const QString &peerPath, QObject *parent)
+    : QThread(parent)
+    , m_peerPath(peerPath)
+{
+}
+
+SyncJob::~SyncJob()
+{
+    // 同步在一个事务中完成，中途无法取消，只能等它结束
+    wait();
+}
+
+void SyncJob::run()
+{
+    qDebug() << "同步线程开始：" << m_peerPath;
+    QString summary;
+    bool ok = DBManager::instance()->syncWithDatabase(m_peerPath, &summary);
+    emit syncFinished(ok, summary);
+}
@@ -0,0 +1,26 @@
+#ifndef SYNCJOB_H
+#define SYNCJOB_H
+
+#include <QThread>
+#include <QString>
+
+// 后台同步线程
+// 同步在独立连接上进行，期间界面照常响应；完成后由界面按行版本增量刷新。
+class SyncJob : public QThread
+{
+    Q_OBJECT
+public:
+    explicit SyncJob(const QString &peerPath, QObject *parent = nullptr);
+    ~SyncJob() override;
+
+signals:
+    void syncFinished(bool ok, const QString &summary);
+
+protected:
+    void run() override;
+
+private:
+    QString m_peerPath;
+};
+
+#endif // SYNCJOB_H
@@ -0,0 +1,127 @@
+#include "tagindex.h"
+#include <QRegularExpression>
+#include <algorithm>
+
+void TagIndex::clear()
+{
+    m_byTag.clear();
+    m_displayNames.clear();
+    m_tagsById.clear();
+    m_all.clear();
+    m_completed.clear();
+}
+
+void TagIndex::rebuild(const QList<Task> &tasks)
+{
+    clear();
+    for (const Task &task : tasks) {
+        updateTask(task);
+    }
+}
+
+void TagIndex::updateTask(const Task &task)
+{
+    if (task.id < 0) return;
+    quint32 id = quint32(task.id);
+
+    m_all.add(id);
+    if (task.isCompleted)
+        m_completed.add(id);
+    else
+        m_completed.remove(id);
+
+    const QStringList oldTags = m_tagsById.value(task.id);
+    if (oldTags == task.tags) return;
+
+    for (const QString &tag : oldTags) {
+        if (task.tags.contains(tag)) continue;
+        QString key = keyOf(tag);
+        auto it = m_byTag.find(key);
+        if (it == m_byTag.end()) continue;
+        it->remove(id);
+        if (it->isEmpty()) {
+            m_byTag.erase(it);
+            m_displayNames.remove(key);
+        }
+    }
+    for (const QString &tag : task.tags) {
+        if (oldTags.contains(tag)) continue;
+        QString key = keyOf(tag);
+        m_byTag[key].add(id);
+        if (!m_displayNames.contains(key)) m_displayNames.insert(key, tag.trimmed());
+    }
+
+    if (task.tags.isEmpty())
+        m_tagsById.remove(task.id);
+    else
+        m_tagsById.insert(task.id, task.tags);
+}
+
+void TagIndex::removeTask(int taskId)
+{
+    if (taskId < 0) return;
+    Task empty;
+    empty.id = taskId;
+    updateTask(empty);
+    m_all.remove(quint32(taskId));
+    m_completed.remove(quint32(taskId));
+}
+
+QStringList TagIndex::allTags() const
+{
+    QStringList tags = m_displayNames.values();
+    std::sort(tags.begin(), tags.end());
+    return tags;
+}
+
+RoaringBitmap TagIndex::filter(const QStringList &required, const QStringList &excluded,
+                               bool hideCompleted) const
+{
+    // 先与基数最小的标签求交，尽早缩小结果
+    QList<const RoaringBitmap *> positive;
+    for (const QString &tag : required) {
+        auto it = m_byTag.constFind(keyOf(tag));
+        if (it == m_byTag.constEnd()) return RoaringBitmap();
+        positive.append(&it.value());
+    }
+    std::sort(positive.begin(), positive.end(), [](const RoaringBitmap *a, const RoaringBitmap *b) {
+        return a->cardinality() < b->cardinality();
+    });
+
+    RoaringBitmap result = positive.isEmpty() ? m_all : *positive.first();
+    for (int i = 1; i < positive.size() && !result.isEmpty(); ++i) {
+        result = result & *positive.at(i);
+    }
+
+    for (const QString &tag : excluded) {
+        auto it = m_byTag.constFind(keyOf(tag));
+        if (it != m_byTag.constEnd()) result = result.andNot(it.value());
+    }
+    if (hideCompleted) {
+        result = result.andNot(m_completed);
+    }
+    return result;
+}
+
+void TagIndex::parseFilter(const QString &text, QStringList *required, QStringList *excluded)
+{
+    const QStringList tokens = text.split(QRegularExpression("[\\s,，、]+"), Qt::SkipEmptyParts);
+    for (const QString &token : tokens) {
+        if (token.startsWith('-') || token.startsWith('!')) {
+            QString tag = token.mid(1);
+            if (!tag.isEmpty()) excluded->append(tag);
+        } else {
+            required->append(token);
+        }
+    }
+}
+
+QStringList TagIndex::parseTags(const QString &text)
+{
+    QStringList tags;
+    const QStringList tokens = text.split(QRegularExpression("[\\s,，、]+"), Qt::SkipEmptyParts);
+    for (const QString &token : tokens) {
+        if (!tags.contains(token, Qt::CaseInsensitive)) tags.append(token);
+    }
+    return tags;
+}
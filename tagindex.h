@@ -0,0 +1,39 @@
+#ifndef TAGINDEX_H
+#define TAGINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include "roaringbitmap.h"
+#include "task.h"
+
+// 标签倒排索引：每个标签对应一个任务ID压缩位图，
+// 组合过滤（标签A 且 标签B 且 非已完成）直接做位图交集/差集，无需逐行扫描
+class TagIndex
+{
+public:
+    void clear();
+    void rebuild(const QList<Task> &tasks);
+    void updateTask(const Task &task);
+    void removeTask(int taskId);
+
+    QStringList allTags() const;
+    RoaringBitmap filter(const QStringList &required, const QStringList &excluded,
+                         bool hideCompleted) const;
+
+    // 解析形如 "工作 紧急 -会议" 的过滤文本，"-" 或 "!" 前缀表示排除
+    static void parseFilter(const QString &text, QStringList *required, QStringList *excluded);
+    // 解析用户输入的标签列表（逗号、顿号或空白分隔），去重并去掉空项
+    static QStringList parseTags(const QString &text);
+
+private:
+    static QString keyOf(const QString &tag) { return tag.trimmed().toCaseFolded(); }
+
+    QHash<QString, RoaringBitmap> m_byTag;   // 标签键 -> 任务ID位图
+    QHash<QString, QString> m_displayNames;  // 标签键 -> 显示名称
+    QHash<int, QStringList> m_tagsById;      // 任务当前标签，用于增量更新时求差
+    RoaringBitmap m_all;
+    RoaringBitmap m_completed;
+};
+
+#endif // TAGINDEX_H
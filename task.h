@@ -3,15 +3,28 @@
 
 #include <QString>
 #include <QDateTime>
+#include <QStringList>
 
 // 任务结构体（与数据库表字段对应）
 struct Task {
-    int id;                 // 唯一ID（数据库自增）
+    int id = -1;            // 唯一ID（数据库自增，-1表示无效）
     QString title;          // 任务标题
     QDateTime deadline;     // 截止时间
-    int priority;           // 优先级（0=低，1=中，2=高）
-    bool isCompleted;       // 是否完成
+    int priority = 0;       // 优先级（0=低，1=中，2=高）
+    bool isCompleted = false; // 是否完成
     QString description;    // 任务描述
+    bool descriptionLoaded = false; // 列表查询不加载描述，为false时更新任务不会改动描述
+    QStringList tags;       // 标签（多对多，存于 task_tags 表）
+    int parentId = -1;      // 父任务ID（-1表示顶层任务）
+};
+
+// 任务子树（不含任务自身）的汇总，对应 task_rollups 表，由触发器增量维护
+struct TaskRollup {
+    int descendants = 0;            // 后代任务数
+    int completed = 0;              // 其中已完成的
+    QDateTime earliestDeadline;     // 未完成后代中最早的截止时间，没有时无效
+
+    int percentComplete() const { return descendants > 0 ? completed * 100 / descendants : 0; }
 };
 
 #endif // TASK_H
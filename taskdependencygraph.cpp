@@ -0,0 +1,334 @@
+#include "taskdependencygraph.h"
+#include <QDebug>
+#include <QSet>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <vector>
+
+void TaskDependencyGraph::clear()
+{
+    m_nodes.clear();
+    m_indexById.clear();
+    m_edgeCount = 0;
+}
+
+int TaskDependencyGraph::addNode(const Task &task)
+{
+    Node node;
+    node.taskId = task.id;
+    node.deadline = task.deadline.isValid() ? task.deadline.toMSecsSinceEpoch() : 0;
+    node.completed = task.isCompleted;
+    node.order = m_nodes.size();
+    node.earliestFinish = node.deadline;
+
+    int n = m_nodes.size();
+    m_nodes.append(node);
+    m_indexById.insert(task.id, n);
+    return n;
+}
+
+// 全量重建：Kahn算法求初始拓扑序，再按拓扑序计算一遍
+void TaskDependencyGraph::rebuild(const QList<Task> &tasks, const QList<QPair<int, int>> &edges)
+{
+    clear();
+    m_nodes.reserve(tasks.size());
+    for (const Task &task : tasks) {
+        addNode(task);
+    }
+
+    for (const auto &edge : edges) {
+        int x = nodeIndex(edge.first);
+        int y = nodeIndex(edge.second);
+        if (x == -1 || y == -1 || x == y) continue;
+        m_nodes[x].successors.append(y);
+        m_nodes[y].predecessors.append(x);
+        m_edgeCount++;
+    }
+
+    QVector<int> inDegree(m_nodes.size(), 0);
+    for (const Node &node : m_nodes) {
+        for (int s : node.successors) inDegree[s]++;
+    }
+
+    QVector<int> queue;
+    queue.reserve(m_nodes.size());
+    for (int n = 0; n < m_nodes.size(); ++n) {
+        if (inDegree[n] == 0) queue.append(n);
+    }
+    for (int head = 0; head < queue.size(); ++head) {
+        int n = queue[head];
+        for (int s : m_nodes[n].successors) {
+            if (--inDegree[s] == 0) queue.append(s);
+        }
+    }
+
+    if (queue.size() != m_nodes.size()) {
+        // 数据库中的环在插入时就会被拒绝，这里只做兜底：剩余节点排在最后
+        qWarning() << "依赖数据中存在环，涉及任务数：" << m_nodes.size() - queue.size();
+        for (int n = 0; n < m_nodes.size(); ++n) {
+            if (inDegree[n] > 0) queue.append(n);
+        }
+    }
+
+    for (int i = 0; i < queue.size(); ++i) {
+        m_nodes[queue[i]].order = i;
+    }
+    for (int n : queue) {
+        recomputeNode(n);
+    }
+}
+
+bool TaskDependencyGraph::wouldCreateCycle(int blockerId, int blockedId) const
+{
+    int x = nodeIndex(blockerId);
+    int y = nodeIndex(blockedId);
+    if (x == -1 || y == -1) return false;
+    if (x == y) return true;
+
+    // 拓扑序保证：只有 order[y] < order[x] 时才可能存在 y ->* x 的路径
+    int upper = m_nodes[x].order;
+    if (m_nodes[y].order > upper) return false;
+
+    QVector<int> stack{y};
+    QSet<int> visited{y};
+    while (!stack.isEmpty()) {
+        int n = stack.takeLast();
+        for (int s : m_nodes[n].successors) {
+            if (s == x) return true;
+            if (m_nodes[s].order < upper && !visited.contains(s)) {
+                visited.insert(s);
+                stack.append(s);
+            }
+        }
+    }
+    return false;
+}
+
+// Pearce-Kelly：插入边 x->y 后只重排 [order[y], order[x]] 区间内受影响的节点
+bool TaskDependencyGraph::reorder(int x, int y)
+{
+    int lower = m_nodes[y].order;
+    int upper = m_nodes[x].order;
+    if (lower > upper) return true;
+
+    QVector<int> forward;
+    QSet<int> visited{y};
+    QVector<int> stack{y};
+    while (!stack.isEmpty()) {
+        int n = stack.takeLast();
+        forward.append(n);
+        for (int s : m_nodes[n].successors) {
+            if (s == x) return false;
+            if (m_nodes[s].order < upper && !visited.contains(s)) {
+                visited.insert(s);
+                stack.append(s);
+            }
+        }
+    }
+
+    QVector<int> backward;
+    visited = {x};
+    stack = {x};
+    while (!stack.isEmpty()) {
+        int n = stack.takeLast();
+        backward.append(n);
+        for (int p : m_nodes[n].predecessors) {
+            if (m_nodes[p].order > lower && !visited.contains(p)) {
+                visited.insert(p);
+                stack.append(p);
+            }
+        }
+    }
+
+    auto byOrder = [this](int a, int b) { return m_nodes[a].order < m_nodes[b].order; };
+    std::sort(backward.begin(), backward.end(), byOrder);
+    std::sort(forward.begin(), forward.end(), byOrder);
+
+    QVector<int> affectedNodes = backward + forward;
+    QVector<int> positions;
+    positions.reserve(affectedNodes.size());
+    for (int n : affectedNodes) positions.append(m_nodes[n].order);
+    std::sort(positions.begin(), positions.end());
+
+    for (int i = 0; i < affectedNodes.size(); ++i) {
+        m_nodes[affectedNodes[i]].order = positions[i];
+    }
+    return true;
+}
+
+bool TaskDependencyGraph::addEdge(int blockerId, int blockedId, QList<int> *affected)
+{
+    int x = nodeIndex(blockerId);
+    int y = nodeIndex(blockedId);
+    if (x == -1 || y == -1 || x == y) return false;
+    if (m_nodes[x].successors.contains(y)) return true;
+
+    if (!reorder(x, y)) {
+        qWarning() << "添加依赖会形成环：" << blockerId << "->" << blockedId;
+        return false;
+    }
+
+    m_nodes[x].successors.append(y);
+    m_nodes[y].predecessors.append(x);
+    m_edgeCount++;
+    propagate({y}, affected);
+    return true;
+}
+
+bool TaskDependencyGraph::removeEdge(int blockerId, int blockedId, QList<int> *affected)
+{
+    int x = nodeIndex(blockerId);
+    int y = nodeIndex(blockedId);
+    if (x == -1 || y == -1) return false;
+    if (!m_nodes[x].successors.removeOne(y)) return false;
+
+    m_nodes[y].predecessors.removeOne(x);
+    m_edgeCount--;
+    // 删除边不会破坏已有拓扑序，只需更新下游
+    propagate({y}, affected);
+    return true;
+}
+
+void TaskDependencyGraph::updateTask(const Task &task, QList<int> *affected)
+{
+    int n = nodeIndex(task.id);
+    if (n == -1) {
+        n = addNode(task);
+        recomputeNode(n);
+        if (affected) affected->append(task.id);
+        return;
+    }
+
+    Node &node = m_nodes[n];
+    qint64 deadline = task.deadline.isValid() ? task.deadline.toMSecsSinceEpoch() : 0;
+    if (node.deadline == deadline && node.completed == task.isCompleted) return;
+
+    node.deadline = deadline;
+    node.completed = task.isCompleted;
+    propagate({n}, affected);
+}
+
+// 删除节点及其所有边；节点槽位保留但不再可查
+void TaskDependencyGraph::removeTask(int taskId, QList<int> *affected)
+{
+    int n = nodeIndex(taskId);
+    if (n == -1) return;
+
+    QVector<int> successors = m_nodes[n].successors;
+    for (int p : m_nodes[n].predecessors) {
+        m_nodes[p].successors.removeOne(n);
+        m_edgeCount--;
+    }
+    for (int s : successors) {
+        m_nodes[s].predecessors.removeOne(n);
+        m_edgeCount--;
+    }
+    m_nodes[n].predecessors.clear();
+    m_nodes[n].successors.clear();
+    m_indexById.remove(taskId);
+
+    if (!successors.isEmpty()) {
+        propagate(successors, affected);
+    }
+}
+
+// 根据前置节点重新计算，返回对后继有影响的结果是否变化
+bool TaskDependencyGraph::recomputeNode(int n)
+{
+    Node &node = m_nodes[n];
+    qint64 earliest = node.deadline;
+    int critical = -1;
+    int open = 0;
+
+    for (int p : node.predecessors) {
+        const Node &pred = m_nodes[p];
+        if (pred.completed) continue;
+        open++;
+        if (pred.earliestFinish > earliest) {
+            earliest = pred.earliestFinish;
+            critical = p;
+        }
+    }
+
+    bool changed = node.earliestFinish != earliest
+                   || node.criticalPred != critical
+                   || node.openBlockers != open;
+    node.earliestFinish = earliest;
+    node.criticalPred = critical;
+    node.openBlockers = open;
+    return changed;
+}
+
+// 按拓扑序从种子节点向下游传播，结果不变的分支立即停止
+void TaskDependencyGraph::propagate(const QVector<int> &seeds, QList<int> *affected)
+{
+    using Entry = std::pair<int, int>; // (拓扑序, 节点)
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    QSet<int> queued;
+
+    for (int n : seeds) {
+        queue.push({m_nodes[n].order, n});
+        queued.insert(n);
+    }
+
+    while (!queue.empty()) {
+        int n = queue.top().second;
+        queue.pop();
+        queued.remove(n);
+
+        bool isSeed = seeds.contains(n);
+        bool changed = recomputeNode(n);
+        if (changed || isSeed) {
+            if (affected) affected->append(m_nodes[n].taskId);
+            for (int s : m_nodes[n].successors) {
+                if (!queued.contains(s)) {
+                    queue.push({m_nodes[s].order, s});
+                    queued.insert(s);
+                }
+            }
+        }
+    }
+}
+
+bool TaskDependencyGraph::isBlocked(int taskId) const
+{
+    int n = nodeIndex(taskId);
+    return n != -1 && m_nodes[n].openBlockers > 0;
+}
+
+bool TaskDependencyGraph::isLate(int taskId) const
+{
+    int n = nodeIndex(taskId);
+    return n != -1 && m_nodes[n].earliestFinish > m_nodes[n].deadline;
+}
+
+QDateTime TaskDependencyGraph::earliestFinish(int taskId) const
+{
+    int n = nodeIndex(taskId);
+    if (n == -1) return QDateTime();
+    return QDateTime::fromMSecsSinceEpoch(m_nodes[n].earliestFinish);
+}
+
+QList<int> TaskDependencyGraph::blockersOf(int taskId) const
+{
+    QList<int> result;
+    int n = nodeIndex(taskId);
+    if (n == -1) return result;
+    for (int p : m_nodes[n].predecessors) {
+        result.append(m_nodes[p].taskId);
+    }
+    return result;
+}
+
+// 沿关键前置节点回溯，返回从链首到该任务的任务ID序列
+QList<int> TaskDependencyGraph::criticalPath(int taskId) const
+{
+    QList<int> path;
+    int n = nodeIndex(taskId);
+    while (n != -1) {
+        path.prepend(m_nodes[n].taskId);
+        n = m_nodes[n].criticalPred;
+    }
+    return path;
+}
@@ -0,0 +1,59 @@
+#ifndef TASKDEPENDENCYGRAPH_H
+#define TASKDEPENDENCYGRAPH_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <QDateTime>
+#include "task.h"
+
+// 任务依赖图（前置任务 -> 被阻塞任务）
+// 在内存中维护增量拓扑序（Pearce-Kelly算法），并据此计算最早完成时间与关键路径。
+// 单个任务的截止时间或完成状态变化时，只重新计算受影响的后继子图。
+class TaskDependencyGraph
+{
+public:
+    void clear();
+    void rebuild(const QList<Task> &tasks, const QList<QPair<int, int>> &edges);
+
+    // affected 返回计算结果发生变化的任务ID
+    bool wouldCreateCycle(int blockerId, int blockedId) const;
+    bool addEdge(int blockerId, int blockedId, QList<int> *affected = nullptr);
+    bool removeEdge(int blockerId, int blockedId, QList<int> *affected = nullptr);
+    void updateTask(const Task &task, QList<int> *affected = nullptr);
+    void removeTask(int taskId, QList<int> *affected = nullptr);
+
+    bool contains(int taskId) const { return m_indexById.contains(taskId); }
+    bool isBlocked(int taskId) const;
+    bool isLate(int taskId) const;
+    QDateTime earliestFinish(int taskId) const;
+    QList<int> blockersOf(int taskId) const;
+    QList<int> criticalPath(int taskId) const;
+    int edgeCount() const { return m_edgeCount; }
+
+private:
+    struct Node {
+        int taskId = -1;
+        qint64 deadline = 0;        // 截止时间（毫秒时间戳）
+        bool completed = false;
+        int order = 0;              // 拓扑序位置
+        qint64 earliestFinish = 0;  // 考虑未完成前置任务后的最早完成时间
+        int criticalPred = -1;      // 决定最早完成时间的前置节点
+        int openBlockers = 0;       // 未完成的前置任务数
+        QVector<int> successors;
+        QVector<int> predecessors;
+    };
+
+    int nodeIndex(int taskId) const { return m_indexById.value(taskId, -1); }
+    int addNode(const Task &task);
+    bool recomputeNode(int n);
+    void propagate(const QVector<int> &seeds, QList<int> *affected);
+    bool reorder(int x, int y);
+
+    QVector<Node> m_nodes;
+    QHash<int, int> m_indexById;
+    int m_edgeCount = 0;
+};
+
+#endif // TASKDEPENDENCYGRAPH_H
@@ -0,0 +1,406 @@
+#include "taskexporter.h"
+#include "zipwriter.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScopedPointer>
+
+namespace {
+const char *const kDateFormat = "yyyy-MM-dd HH:mm";
+
+QString priorityText(int priority)
+{
+    return priority == 0 ? "低" : (priority == 1 ? "中" : "高");
+}
+
+QString completedText(bool completed)
+{
+    return completed ? "已完成" : "未完成";
+}
+
+// ---------------- CSV ----------------
+
+// RFC 4180：字段用双引号包围，内部的双引号写两次
+QByteArray csvField(const QString &text)
+{
+    QString escaped = text;
+    escaped.replace('"', "\"\"");
+    return '"' + escaped.toUtf8() + '"';
+}
+
+class CsvExporter : public TaskExporter
+{
+public:
+    QString name() const override { return "CSV"; }
+    QString fileFilter() const override { return "CSV文件 (*.csv)"; }
+    QString defaultSuffix() const override { return "csv"; }
+
+    bool begin(QIODevice *device, QString *error) override
+    {
+        // 带BOM，Excel打开时才能识别为UTF-8
+        return writeAll(device, "\xEF\xBB\xBF" + QString("ID,标题,截止时间,优先级,完成状态,标签,描述\r\n").toUtf8(),
+                        error);
+    }
+
+    QByteArray formatChunk(const QList<Task> &tasks, qint64) const override
+    {
+        QByteArray out;
+        out.reserve(tasks.size() * 64);
+        for (const Task &task : tasks) {
+            out += QByteArray::number(task.id) + ','
+                   + csvField(task.title) + ','
+                   + task.deadline.toString(kDateFormat).toUtf8() + ','
+                   + QByteArray::number(task.priority) + ','
+                   + completedText(task.isCompleted).toUtf8() + ','
+                   + csvField(task.tags.join(' ')) + ','
+                   + csvField(task.description) + "\r\n";
+        }
+        return out;
+    }
+};
+
+// ---------------- 文本报表 ----------------
+
+class TextExporter : public TaskExporter
+{
+public:
+    QString name() const override { return "文本"; }
+    QString fileFilter() const override { return "文本文件 (*.txt)"; }
+    QString defaultSuffix() const override { return "txt"; }
+
+    bool begin(QIODevice *device, QString *error) override
+    {
+        QString header = QString("任务列表报表\n生成时间：%1\n=================================\n\n")
+                             .arg(QDateTime::currentDateTime().toString(kDateFormat));
+        return writeAll(device, header.toUtf8(), error);
+    }
+
+    QByteArray formatChunk(const QList<Task> &tasks, qint64) const override
+    {
+        QString out;
+        for (const Task &task : tasks) {
+            out += QString("ID: %1\n").arg(task.id);
+            out += "标题: " + task.title + "\n";
+            out += "截止时间: " + task.deadline.toString(kDateFormat) + "\n";
+            out += "优先级: " + priorityText(task.priority) + "\n";
+            out += "完成状态: " + completedText(task.isCompleted) + "\n";
+            if (!task.tags.isEmpty()) {
+                out += "标签: " + task.tags.join(' ') + "\n";
+            }
+            if (!task.description.isEmpty()) {
+                out += "描述: " + task.description + "\n";
+            }
+            out += "---------------------------------\n";
+        }
+        return out.toUtf8();
+    }
+};
+
+// ---------------- JSON Lines ----------------
+
+// 每行一个紧凑的JSON对象，便于流式处理和导入其他工具
+class JsonLinesExporter : public TaskExporter
+{
+public:
+    QString name() const override { return "JSON Lines"; }
+    QString fileFilter() const override { return "JSON Lines文件 (*.jsonl)"; }
+    QString defaultSuffix() const override { return "jsonl"; }
+
+    QByteArray formatChunk(const QList<Task> &tasks, qint64) const override
+    {
+        QByteArray out;
+        for (const Task &task : tasks) {
+            QJsonObject object;
+            object.insert("id", task.id);
+            object.insert("title", task.title);
+            object.insert("deadline", task.deadline.toString(Qt::ISODate));
+            object.insert("priority", task.priority);
+            object.insert("completed", task.isCompleted);
+            object.insert("tags", QJsonArray::fromStringList(task.tags));
+            object.insert("description", task.description);
+            out += QJsonDocument(object).toJson(QJsonDocument::Compact);
+            out += '\n';
+        }
+        return out;
+    }
+};
+
+// ---------------- iCalendar ----------------
+
+// TEXT值需转义反斜杠、分号、逗号和换行（RFC 5545 3.3.11）
+QByteArray icsText(const QString &text)
+{
+    QString escaped;
+    escaped.reserve(text.size());
+    for (QChar ch : text) {
+        if (ch == '\\' || ch == ';' || ch == ',') {
+            escaped += '\\';
+            escaped += ch;
+        } else if (ch == '\n') {
+            escaped += "\\n";
+        } else if (ch != '\r') {
+            escaped += ch;
+        }
+    }
+    return escaped.toUtf8();
+}
+
+// 每行不超过75字节，续行以空格开头；不能从UTF-8多字节字符中间断开
+void appendIcsLine(QByteArray &out, const QByteArray &line)
+{
+    int limit = 75;
+    int start = 0;
+    while (line.size() - start > limit) {
+        int end = start + limit;
+        while (end > start && (quint8(line.at(end)) & 0xC0) == 0x80) {
+            --end;
+        }
+        out += line.mid(start, end - start);
+        out += "\r\n ";
+        start = end;
+        limit = 74;     // 续行开头的空格也计入长度
+    }
+    out += line.mid(start);
+    out += "\r\n";
+}
+
+QByteArray icsTime(const QDateTime &time)
+{
+    return time.toUTC().toString("yyyyMMdd'T'HHmmss'Z'").toLatin1();
+}
+
+// 每个任务一个VTODO；未完成的任务附带与应用内提醒一致的到期前1分钟提醒
+class ICalendarExporter : public TaskExporter
+{
+public:
+    QString name() const override { return "iCalendar"; }
+    QString fileFilter() const override { return "iCalendar文件 (*.ics)"; }
+    QString defaultSuffix() const override { return "ics"; }
+
+    bool begin(QIODevice *device, QString *error) override
+    {
+        m_stamp = icsTime(QDateTime::currentDateTimeUtc());
+        return writeAll(device,
+                        "BEGIN:VCALENDAR\r\n"
+                        "VERSION:2.0\r\n"
+                        "PRODID:-//zhsj//TaskManager//CN\r\n"
+                        "CALSCALE:GREGORIAN\r\n",
+                        error);
+    }
+
+    QByteArray formatChunk(const QList<Task> &tasks, qint64) const override
+    {
+        QByteArray out;
+        for (const Task &task : tasks) {
+            out += "BEGIN:VTODO\r\n";
+            out += "UID:task-" + QByteArray::number(task.id) + "@zhsj\r\n";
+            out += "DTSTAMP:" + m_stamp + "\r\n";
+            appendIcsLine(out, "SUMMARY:" + icsText(task.title));
+            if (task.deadline.isValid()) {
+                out += "DUE:" + icsTime(task.deadline) + "\r\n";
+            }
+            // iCalendar中1最高、9最低
+            out += task.priority >= 2 ? "PRIORITY:1\r\n" : (task.priority == 1 ? "PRIORITY:5\r\n" : "PRIORITY:9\r\n");
+            out += task.isCompleted ? "STATUS:COMPLETED\r\n" : "STATUS:NEEDS-ACTION\r\n";
+            if (!task.tags.isEmpty()) {
+                QByteArray categories;
+                for (const QString &tag : task.tags) {
+                    if (!categories.isEmpty()) categories += ',';
+                    categories += icsText(tag);
+                }
+                appendIcsLine(out, "CATEGORIES:" + categories);
+            }
+            if (!task.description.isEmpty()) {
+                appendIcsLine(out, "DESCRIPTION:" + icsText(task.description));
+            }
+            if (!task.isCompleted && task.deadline.isValid()) {
+                out += "BEGIN:VALARM\r\n"
+                       "ACTION:DISPLAY\r\n"
+                       "TRIGGER;RELATED=END:-PT1M\r\n";
+                appendIcsLine(out, "DESCRIPTION:" + icsText(task.title));
+                out += "END:VALARM\r\n";
+            }
+            out += "END:VTODO\r\n";
+        }
+        return out;
+    }
+
+    bool finish(QIODevice *device, QString *error) override
+    {
+        return writeAll(device, "END:VCALENDAR\r\n", error);
+    }
+
+private:
+    QByteArray m_stamp;
+};
+
+// ---------------- XLSX ----------------
+
+// XML文本转义，并去掉XML 1.0不允许出现的控制字符
+QByteArray xmlText(const QString &text)
+{
+    QString escaped;
+    escaped.reserve(text.size());
+    for (QChar ch : text) {
+        ushort c = ch.unicode();
+        if (c == '&') escaped += "&amp;";
+        else if (c == '<') escaped += "&lt;";
+        else if (c == '>') escaped += "&gt;";
+        else if (c == '"') escaped += "&quot;";
+        else if (c >= 0x20 || c == '\t' || c == '\n' || c == '\r') {
+            if (c != 0xFFFE && c != 0xFFFF) escaped += ch;
+        }
+    }
+    return escaped.toUtf8();
+}
+
+QByteArray inlineCell(const QString &text)
+{
+    if (text.isEmpty()) return "<c/>";
+    // 首尾空白需要 xml:space="preserve" 才不会被Excel裁掉
+    const bool preserve = text.at(0).isSpace() || text.at(text.size() - 1).isSpace();
+    return QByteArray("<c t=\"inlineStr\"><is><t") + (preserve ? " xml:space=\"preserve\"" : "")
+           + ">" + xmlText(text) + "</t></is></c>";
+}
+
+QByteArray numberCell(qint64 value)
+{
+    return "<c><v>" + QByteArray::number(value) + "</v></c>";
+}
+
+// 直接写 SpreadsheetML：单个工作表，单元格使用内联字符串，避免共享字符串表需要全量驻留内存
+class XlsxExporter : public TaskExporter
+{
+public:
+    QString name() const override { return "Excel工作簿"; }
+    QString fileFilter() const override { return "Excel工作簿 (*.xlsx)"; }
+    QString defaultSuffix() const override { return "xlsx"; }
+    int maxRows() const override { return 1048576 - 1; }   // 扣除表头
+
+    bool begin(QIODevice *device, QString *error) override
+    {
+        m_zip.reset(new ZipWriter(device));
+        bool ok = m_zip->addFile("[Content_Types].xml",
+                        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                        "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+                        "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+                        "<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+                        "<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+                        "<Override PartName=\"/xl/worksheets/sheet1.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>"
+                        "</Types>")
+                  && m_zip->addFile("_rels/.rels",
+                        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                        "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+                        "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>"
+                        "</Relationships>")
+                  && m_zip->addFile("xl/workbook.xml",
+                        QString("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                        "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" "
+                        "xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\">"
+                        "<sheets><sheet name=\"任务列表\" sheetId=\"1\" r:id=\"rId1\"/></sheets>"
+                        "</workbook>").toUtf8())
+                  && m_zip->addFile("xl/_rels/workbook.xml.rels",
+                        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                        "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+                        "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet1.xml\"/>"
+                        "</Relationships>")
+                  && m_zip->beginEntry("xl/worksheets/sheet1.xml");
+
+        QByteArray header = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                            "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">"
+                            "<sheetData><row r=\"1\">";
+        for (const char *title : {"ID", "标题", "截止时间", "优先级", "完成状态", "标签", "描述"}) {
+            header += inlineCell(QString::fromUtf8(title));
+        }
+        header += "</row>";
+
+        if (!ok || !m_zip->write(header)) {
+            if (error) *error = m_zip->errorString();
+            return false;
+        }
+        return true;
+    }
+
+    QByteArray formatChunk(const QList<Task> &tasks, qint64 firstRow) const override
+    {
+        QByteArray out;
+        qint64 row = firstRow + 2;      // 第1行是表头
+        for (const Task &task : tasks) {
+            out += "<row r=\"" + QByteArray::number(row++) + "\">"
+                   + numberCell(task.id)
+                   + inlineCell(task.title)
+                   + inlineCell(task.deadline.toString(kDateFormat))
+                   + inlineCell(priorityText(task.priority))
+                   + inlineCell(completedText(task.isCompleted))
+                   + inlineCell(task.tags.join(' '))
+                   + inlineCell(task.description)
+                   + "</row>";
+        }
+        return out;
+    }
+
+    bool writeChunk(QIODevice *, const QByteArray &chunk, QString *error) override
+    {
+        if (!m_zip->write(chunk)) {
+            if (error) *error = m_zip->errorString();
+            return false;
+        }
+        return true;
+    }
+
+    bool finish(QIODevice *, QString *error) override
+    {
+        if (!m_zip->write("</sheetData></worksheet>") || !m_zip->endEntry() || !m_zip->close()) {
+            if (error) *error = m_zip->errorString();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    QScopedPointer<ZipWriter> m_zip;
+};
+}
+
+bool TaskExporter::begin(QIODevice *, QString *)
+{
+    return true;
+}
+
+bool TaskExporter::writeChunk(QIODevice *device, const QByteArray &chunk, QString *error)
+{
+    return writeAll(device, chunk, error);
+}
+
+bool TaskExporter::finish(QIODevice *, QString *)
+{
+    return true;
+}
+
+bool TaskExporter::writeAll(QIODevice *device, const QByteArray &data, QString *error)
+{
+    if (device->write(data) != data.size()) {
+        if (error) *error = device->errorString();
+        return false;
+    }
+    return true;
+}
+
+QStringList TaskExporter::formats()
+{
+    return {"csv", "xlsx", "jsonl", "ics", "txt"};
+}
+
+TaskExporter *TaskExporter::create(const QString &format)
+{
+    if (format == "csv") return new CsvExporter;
+    if (format == "xlsx") return new XlsxExporter;
+    if (format == "jsonl") return new JsonLinesExporter;
+    if (format == "ics") return new ICalendarExporter;
+    if (format == "txt") return new TextExporter;
+    qWarning() << "未知的导出格式：" << format;
+    return nullptr;
+}
@@ -0,0 +1,39 @@
+#ifndef TASKEXPORTER_H
+#define TASKEXPORTER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "task.h"
+
+class QIODevice;
+
+// 导出格式接口
+// 导出分三步：begin 写文件头，formatChunk 把一批任务格式化为字节（在线程池中并行调用，
+// 必须是线程安全的，只能读取 begin 之后不再变化的成员），writeChunk 按原顺序写入，最后 finish 写文件尾。
+class TaskExporter
+{
+public:
+    virtual ~TaskExporter() = default;
+
+    virtual QString name() const = 0;           // 菜单中显示的名称
+    virtual QString fileFilter() const = 0;     // 文件对话框过滤器
+    virtual QString defaultSuffix() const = 0;
+    virtual bool needsDescriptions() const { return true; }
+    virtual int maxRows() const { return 0; }   // 格式本身的行数上限，0表示不限
+
+    virtual bool begin(QIODevice *device, QString *error);
+    virtual QByteArray formatChunk(const QList<Task> &tasks, qint64 firstRow) const = 0;
+    virtual bool writeChunk(QIODevice *device, const QByteArray &chunk, QString *error);
+    virtual bool finish(QIODevice *device, QString *error);
+
+    // 已注册的格式（按菜单顺序）与工厂函数
+    static QStringList formats();
+    static TaskExporter *create(const QString &format);
+
+protected:
+    static bool writeAll(QIODevice *device, const QByteArray &data, QString *error);
+};
+
+#endif // TASKEXPORTER_H
@@ -0,0 +1,436 @@
+#include "taskfilter.h"
+#include <QHash>
+#include <QRegularExpression>
+#include <QStringList>
+
+namespace {
+const char *const kDeadlineFormat = "yyyy-MM-dd HH:mm";
+const qint64 kMinute = 60 * 1000LL;
+const qint64 kDay = 24 * 60 * kMinute;
+const QString kOperatorChars = ":=<>!~";
+
+struct Token {
+    enum Type { Word, Term, LParen, RParen, Not, End };
+    Type type = End;
+    QString field;      // Term：字段名；Word：词本身
+    QString op;
+    QString value;
+    int pos = 0;
+};
+
+// 截止时间的取值：一个时刻，或一整天 [start, end)
+struct TimeValue {
+    TaskFilter::Binding start;
+    TaskFilter::Binding end;
+    bool isDay = false;
+    bool isRelative = false;
+};
+}
+
+// 递归下降解析，边解析边生成 SQL
+class TaskFilterParser
+{
+public:
+    TaskFilterParser(const QString &text, TaskFilter *filter)
+        : m_text(text)
+        , m_filter(filter)
+    {
+    }
+
+    bool run(QString *error)
+    {
+        if (!tokenize()) {
+            if (error) *error = m_error;
+            return false;
+        }
+        if (peek().type == Token::End) {
+            return true;
+        }
+
+        QString where = parseOr();
+        if (m_error.isEmpty() && peek().type != Token::End) {
+            fail(peek().pos, "多余的内容");
+        }
+        if (!m_error.isEmpty()) {
+            if (error) *error = m_error;
+            return false;
+        }
+        m_filter->m_where = where;
+        return true;
+    }
+
+private:
+    const Token &peek() const { return m_tokens.at(m_index); }
+    Token next() { return m_tokens.at(m_index < m_tokens.size() - 1 ? m_index++ : m_index); }
+
+    bool isKeyword(const Token &token, const char *keyword) const
+    {
+        return token.type == Token::Word && token.field.compare(keyword, Qt::CaseInsensitive) == 0;
+    }
+
+    QString fail(int pos, const QString &message)
+    {
+        if (m_error.isEmpty()) {
+            m_error = QString("第 %1 个字符附近：%2").arg(pos + 1).arg(message);
+        }
+        return QString();
+    }
+
+    QString readValue(int &i)
+    {
+        QString value;
+        if (i < m_text.size() && m_text.at(i) == '"') {
+            int close = m_text.indexOf('"', i + 1);
+            if (close == -1) {
+                fail(i, "引号没有闭合");
+                i = m_text.size();
+                return QString();
+            }
+            value = m_text.mid(i + 1, close - i - 1);
+            i = close + 1;
+            return value;
+        }
+        while (i < m_text.size() && !m_text.at(i).isSpace() && m_text.at(i) != '(' && m_text.at(i) != ')'
+               && !kOperatorChars.contains(m_text.at(i))) {
+            value += m_text.at(i++);
+        }
+        return value;
+    }
+
+    bool tokenize()
+    {
+        int i = 0;
+        while (i < m_text.size() && m_error.isEmpty()) {
+            QChar c = m_text.at(i);
+            Token token;
+            token.pos = i;
+            if (c.isSpace()) {
+                ++i;
+                continue;
+            }
+            if (c == '(' || c == ')') {
+                token.type = c == '(' ? Token::LParen : Token::RParen;
+                m_tokens.append(token);
+                ++i;
+                continue;
+            }
+            if ((c == '-' || c == '!') && i + 1 < m_text.size() && !m_text.at(i + 1).isSpace()) {
+                token.type = Token::Not;
+                m_tokens.append(token);
+                ++i;
+                continue;
+            }
+
+            token.field = readValue(i);
+            if (i < m_text.size() && kOperatorChars.contains(m_text.at(i))) {
+                QString twoChars = m_text.mid(i, 2);
+                if (twoChars == "!=" || twoChars == "<=" || twoChars == ">=") {
+                    token.op = twoChars;
+                    i += 2;
+                } else {
+                    token.op = m_text.at(i++);
+                }
+                if (token.field.isEmpty()) {
+                    fail(token.pos, "运算符前缺少字段名");
+                    break;
+                }
+                token.value = i < m_text.size() && m_text.at(i) == '"' ? readValue(i) : readTermValue(i);
+                if (token.value.isEmpty() && m_error.isEmpty()) {
+                    fail(i, QString("%1 缺少取值").arg(token.field));
+                }
+                token.type = Token::Term;
+            } else {
+                if (token.field.isEmpty()) {
+                    fail(token.pos, "空的引号");
+                    break;
+                }
+                token.type = Token::Word;
+            }
+            m_tokens.append(token);
+        }
+
+        Token end;
+        end.type = Token::End;
+        end.pos = m_text.size();
+        m_tokens.append(end);
+        return m_error.isEmpty();
+    }
+
+    // 取值中允许出现运算符字符（如 2024-05-01T09:00）
+    QString readTermValue(int &i)
+    {
+        QString value;
+        while (i < m_text.size() && !m_text.at(i).isSpace() && m_text.at(i) != '(' && m_text.at(i) != ')') {
+            value += m_text.at(i++);
+        }
+        return value;
+    }
+
+    QString parseOr()
+    {
+        QString left = parseAnd();
+        while (m_error.isEmpty() && isKeyword(peek(), "or")) {
+            next();
+            QString right = parseAnd();
+            left = QString("(%1 OR %2)").arg(left, right);
+        }
+        return left;
+    }
+
+    QString parseAnd()
+    {
+        QString left = parseUnary();
+        while (m_error.isEmpty() && peek().type != Token::End && peek().type != Token::RParen
+               && !isKeyword(peek(), "or")) {
+            if (isKeyword(peek(), "and")) next();
+            QString right = parseUnary();
+            left = QString("%1 AND %2").arg(left, right);
+        }
+        return left;
+    }
+
+    QString parseUnary()
+    {
+        const Token token = next();
+        if (token.type == Token::Not || isKeyword(token, "not")) {
+            return QString("NOT (%1)").arg(parseUnary());
+        }
+        if (token.type == Token::LParen) {
+            QString inner = parseOr();
+            if (next().type != Token::RParen) {
+                return fail(token.pos, "括号没有闭合");
+            }
+            return QString("(%1)").arg(inner);
+        }
+        if (token.type == Token::Term) {
+            return compileTerm(token);
+        }
+        if (token.type == Token::Word) {
+            return compileWord(token);
+        }
+        return fail(token.pos, token.type == Token::End ? "表达式不完整" : "多余的右括号");
+    }
+
+    QString bind(const QVariant &value)
+    {
+        TaskFilter::Binding binding;
+        binding.value = value;
+        return bind(binding);
+    }
+
+    QString bind(const TaskFilter::Binding &binding)
+    {
+        m_filter->m_bindings.append(binding);
+        return QString(":f%1").arg(m_filter->m_bindings.size() - 1);
+    }
+
+    static QString escapeLike(QString text)
+    {
+        text.replace("\\", "\\\\").replace("%", "\\%").replace("_", "\\_");
+        return "%" + text + "%";
+    }
+
+    QString compileWord(const Token &token)
+    {
+        const QString word = token.field.toLower();
+        if (word == "done" || word == "已完成") {
+            return "isCompleted = 1";
+        }
+        if (word == "overdue" || word == "逾期") {
+            TaskFilter::Binding now;
+            now.kind = TaskFilter::Binding::FromNow;
+            return QString("(isCompleted = 0 AND deadline < %1)").arg(bind(now));
+        }
+        return QString("title LIKE %1 ESCAPE '\\'").arg(bind(escapeLike(token.field)));
+    }
+
+    QString compileTerm(const Token &token)
+    {
+        const QString field = token.field.toLower();
+        const QString &op = token.op;
+
+        if (field == "title" || field == "标题") {
+            if (op == ":" || op == "~") return QString("title LIKE %1 ESCAPE '\\'").arg(bind(escapeLike(token.value)));
+            if (op == "=") return QString("title = %1").arg(bind(token.value));
+            if (op == "!=") return QString("title <> %1").arg(bind(token.value));
+            return fail(token.pos, QString("标题不支持运算符 %1").arg(op));
+        }
+
+        if (field == "priority" || field == "p" || field == "优先级") {
+            static const QStringList names[] = {
+                {"low", "l", "低", "0"}, {"medium", "mid", "m", "中", "1"}, {"high", "h", "高", "2"}
+            };
+            int priority = -1;
+            for (int p = 0; p < 3; ++p) {
+                if (names[p].contains(token.value, Qt::CaseInsensitive)) priority = p;
+            }
+            if (priority == -1) return fail(token.pos, QString("无效的优先级 %1").arg(token.value));
+            if (op == "~") return fail(token.pos, "优先级不支持运算符 ~");
+            return QString("priority %1 %2").arg(sqlOperator(op), bind(priority));
+        }
+
+        if (field == "done" || field == "completed" || field == "完成") {
+            static const QStringList yes = {"yes", "y", "true", "1", "是"};
+            static const QStringList no = {"no", "n", "false", "0", "否"};
+            bool value = yes.contains(token.value, Qt::CaseInsensitive);
+            if (!value && !no.contains(token.value, Qt::CaseInsensitive))
+                return fail(token.pos, QString("无效的完成状态 %1").arg(token.value));
+            if (op != ":" && op != "=" && op != "!=") return fail(token.pos, QString("完成状态不支持运算符 %1").arg(op));
+            return QString("isCompleted %1 %2").arg(sqlOperator(op), bind(value ? 1 : 0));
+        }
+
+        if (field == "tag" || field == "标签") {
+            if (op != ":" && op != "=" && op != "!=") return fail(token.pos, QString("标签不支持运算符 %1").arg(op));
+            // 写成 IN 子查询，可以走 task_tags 的 tag_id 索引
+            return QString("id %1 (SELECT tt.task_id FROM task_tags tt JOIN tags g ON g.id = tt.tag_id "
+                           "WHERE g.name = %2)").arg(op == "!=" ? "NOT IN" : "IN", bind(token.value));
+        }
+
+        if (field == "due" || field == "deadline" || field == "截止") {
+            TimeValue time;
+            if (!parseTime(token, &time)) return QString();
+            return compileDue(token, time);
+        }
+
+        return fail(token.pos, QString("未知字段 %1").arg(token.field));
+    }
+
+    static QString sqlOperator(const QString &op)
+    {
+        if (op == ":" || op == "=") return "=";
+        if (op == "!=") return "<>";
+        return op;
+    }
+
+    bool parseTime(const Token &token, TimeValue *time)
+    {
+        const QString value = token.value.toLower();
+        auto relative = [](TaskFilter::Binding::Kind kind, qint64 offset) {
+            TaskFilter::Binding binding;
+            binding.kind = kind;
+            binding.offsetMs = offset;
+            return binding;
+        };
+
+        static const QStringList dayWords = {"yesterday", "昨天", "today", "今天", "tomorrow", "明天"};
+        int dayIndex = dayWords.indexOf(value);
+        if (dayIndex != -1) {
+            qint64 day = dayIndex / 2 - 1;
+            time->isDay = true;
+            time->isRelative = true;
+            time->start = relative(TaskFilter::Binding::FromToday, day * kDay);
+            time->end = relative(TaskFilter::Binding::FromToday, (day + 1) * kDay);
+            return true;
+        }
+        if (value == "now" || value == "现在") {
+            time->start = relative(TaskFilter::Binding::FromNow, 0);
+            return true;
+        }
+
+        static const QRegularExpression durationPattern("^([+-]?)(\\d+)(m|h|d|w|分钟|小时|天|周)$");
+        QRegularExpressionMatch match = durationPattern.match(value);
+        if (match.hasMatch()) {
+            static const QHash<QString, qint64> units = {
+                {"m", kMinute}, {"分钟", kMinute}, {"h", 60 * kMinute}, {"小时", 60 * kMinute},
+                {"d", kDay}, {"天", kDay}, {"w", 7 * kDay}, {"周", 7 * kDay}
+            };
+            qint64 offset = match.captured(2).toLongLong() * units.value(match.captured(3));
+            if (match.captured(1) == "-") offset = -offset;
+            time->start = relative(TaskFilter::Binding::FromNow, offset);
+            time->isRelative = true;
+            return true;
+        }
+
+        QDate date = QDate::fromString(token.value, "yyyy-MM-dd");
+        if (date.isValid()) {
+            time->isDay = true;
+            time->start.value = QDateTime(date, QTime(0, 0)).toString(kDeadlineFormat);
+            time->end.value = QDateTime(date.addDays(1), QTime(0, 0)).toString(kDeadlineFormat);
+            return true;
+        }
+        QDateTime dateTime = QDateTime::fromString(token.value, "yyyy-MM-ddTHH:mm");
+        if (!dateTime.isValid()) dateTime = QDateTime::fromString(token.value, kDeadlineFormat);
+        if (dateTime.isValid()) {
+            time->start.value = dateTime.toString(kDeadlineFormat);
+            return true;
+        }
+
+        fail(token.pos, QString("无法识别的时间 %1（可用 today、3d、-12h、2024-05-01 等）").arg(token.value));
+        return false;
+    }
+
+    QString compileDue(const Token &token, const TimeValue &time)
+    {
+        const QString &op = token.op;
+        if (op == "~") return fail(token.pos, "截止时间不支持运算符 ~");
+
+        if (time.isDay) {
+            if (op == ":" || op == "=")
+                return QString("(deadline >= %1 AND deadline < %2)").arg(bind(time.start), bind(time.end));
+            if (op == "!=")
+                return QString("(deadline < %1 OR deadline >= %2)").arg(bind(time.start), bind(time.end));
+            if (op == "<") return QString("deadline < %1").arg(bind(time.start));
+            if (op == "<=") return QString("deadline < %1").arg(bind(time.end));
+            if (op == ">") return QString("deadline >= %1").arg(bind(time.end));
+            return QString("deadline >= %1").arg(bind(time.start));
+        }
+
+        // due:3d 表示从现在到3天后之间到期，due:-2d 表示过去2天内到期
+        if ((op == ":" || op == "=") && time.isRelative) {
+            TaskFilter::Binding now;
+            now.kind = TaskFilter::Binding::FromNow;
+            bool future = time.start.offsetMs >= 0;
+            return QString("(deadline >= %1 AND deadline <= %2)")
+                .arg(bind(future ? now : time.start), bind(future ? time.start : now));
+        }
+        return QString("deadline %1 %2").arg(sqlOperator(op), bind(time.start));
+    }
+
+    QString m_text;
+    TaskFilter *m_filter;
+    QVector<Token> m_tokens;
+    int m_index = 0;
+    QString m_error;
+};
+
+TaskFilter TaskFilter::compile(const QString &expression, QString *error)
+{
+    TaskFilter filter;
+    filter.m_expression = expression.trimmed();
+    TaskFilterParser parser(filter.m_expression, &filter);
+    filter.m_valid = parser.run(error);
+    if (!filter.m_valid) {
+        filter.m_where.clear();
+        filter.m_bindings.clear();
+    }
+    return filter;
+}
+
+bool TaskFilter::isTimeRelative() const
+{
+    for (const Binding &binding : m_bindings) {
+        if (binding.kind != Binding::Literal) return true;
+    }
+    return false;
+}
+
+QVariantList TaskFilter::bindValues(const QDateTime &now) const
+{
+    QVariantList values;
+    values.reserve(m_bindings.size());
+    const QDateTime today(now.date(), QTime(0, 0));
+    for (const Binding &binding : m_bindings) {
+        switch (binding.kind) {
+        case Binding::Literal:
+            values.append(binding.value);
+            break;
+        case Binding::FromNow:
+            values.append(now.addMSecs(binding.offsetMs).toString(kDeadlineFormat));
+            break;
+        case Binding::FromToday:
+            values.append(today.addMSecs(binding.offsetMs).toString(kDeadlineFormat));
+            break;
+        }
+    }
+    return values;
+}
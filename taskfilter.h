@@ -0,0 +1,51 @@
+#ifndef TASKFILTER_H
+#define TASKFILTER_H
+
+#include <QDateTime>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+// 任务筛选表达式，编译为参数化的 SQL WHERE 子句。例如：
+//   priority:high due:3d title~release      高优先级、3天内到期、标题含 release
+//   tag:工作 and not done                   带"工作"标签且未完成
+//   (due<today or overdue) -tag:个人        已过期且不带"个人"标签
+// 字段：title（标题）、priority（优先级）、due（截止时间）、done（完成）、tag（标签）
+// 运算符：: = != < <= > >= ~，条件之间默认"且"，可用 and / or / not / - / 括号组合；
+// 单独的词按标题包含处理，done、overdue 为关键字。
+// 相对时间（3d、-12h、today 等）编译为占位符，每次执行时按当前时间重新绑定。
+class TaskFilter
+{
+public:
+    struct Binding {
+        enum Kind {
+            Literal,    // 固定值
+            FromNow,    // 当前时间 + offsetMs
+            FromToday   // 今天0点 + offsetMs
+        };
+        Kind kind = Literal;
+        QVariant value;
+        qint64 offsetMs = 0;
+    };
+
+    static TaskFilter compile(const QString &expression, QString *error = nullptr);
+
+    bool isValid() const { return m_valid; }
+    bool isEmpty() const { return m_where.isEmpty(); }
+    QString expression() const { return m_expression; }
+    // 占位符依次为 :f0、:f1 ...，同一表达式总是生成相同的子句，可作为预编译语句的缓存键
+    QString whereClause() const { return m_where; }
+    QVariantList bindValues(const QDateTime &now) const;
+    // 含相对时间：结果会随时间变化，即使任务没有修改
+    bool isTimeRelative() const;
+
+private:
+    friend class TaskFilterParser;
+
+    QString m_expression;
+    QString m_where;
+    QVector<Binding> m_bindings;
+    bool m_valid = false;
+};
+
+#endif // TASKFILTER_H
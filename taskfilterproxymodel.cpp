@@ -0,0 +1,121 @@
+#include "taskfilterproxymodel.h"
+#include "dbmanager.h"
+#include <QDebug>
+#include <QElapsedTimer>
+
+TaskFilterProxyModel::TaskFilterProxyModel(TaskModel *model, QObject *parent)
+    : QSortFilterProxyModel(parent)
+    , m_model(model)
+{
+    setSourceModel(model);
+    setSortRole(TaskModel::SortRole);
+    // 标签或完成状态变化后重新求值（标签索引已在模型中增量更新）；
+    // 筛选表达式只对数据库中修改过的任务重新执行，整表重载后整体重新执行
+    connect(model, &TaskModel::tasksChanged, this, &TaskFilterProxyModel::updateQueryMatches);
+    connect(model, &TaskModel::modelReset, this, &TaskFilterProxyModel::reloadQueryMatches);
+    connect(model, &TaskModel::taskDataChanged, this, &TaskFilterProxyModel::recompute);
+    m_relativeTimer.setInterval(60 * 1000);
+    connect(&m_relativeTimer, &QTimer::timeout, this, [this]() {
+        reloadQueryMatches();
+        recompute();
+    });
+}
+
+void TaskFilterProxyModel::setTagFilter(const QString &text, bool hideCompleted)
+{
+    m_required.clear();
+    m_excluded.clear();
+    TagIndex::parseFilter(text, &m_required, &m_excluded);
+    m_hideCompleted = hideCompleted;
+    recompute();
+}
+
+void TaskFilterProxyModel::setQueryFilter(const TaskFilter &filter)
+{
+    m_queryFilter = filter;
+    reloadQueryMatches();
+    if (m_queryFilter.isValid() && m_queryFilter.isTimeRelative()) {
+        m_relativeTimer.start();
+    } else {
+        m_relativeTimer.stop();
+    }
+    recompute();
+}
+
+void TaskFilterProxyModel::reloadQueryMatches()
+{
+    m_queryMatched.clear();
+    if (!m_queryFilter.isValid() || m_queryFilter.isEmpty()) return;
+
+    QElapsedTimer timer;
+    timer.start();
+    QVector<int> ids;
+    if (DBManager::instance()->queryTaskIds(m_queryFilter, &ids)) {
+        for (int id : ids) m_queryMatched.add(quint32(id));
+    }
+    qDebug() << "筛选表达式：匹配" << ids.size() << "个任务，耗时" << timer.nsecsElapsed() / 1000 << "us";
+}
+
+void TaskFilterProxyModel::updateQueryMatches(const QList<int> &taskIds)
+{
+    if (!m_queryFilter.isValid() || m_queryFilter.isEmpty() || taskIds.isEmpty()) return;
+
+    QVector<int> ids;
+    if (!DBManager::instance()->queryTaskIds(m_queryFilter, taskIds, &ids)) return;
+    for (int id : taskIds) m_queryMatched.remove(quint32(id));
+    for (int id : ids) m_queryMatched.add(quint32(id));
+}
+
+void TaskFilterProxyModel::setTitleSearch(const QString &text)
+{
+    const QString search = text.trimmed();
+    if (search == m_titleSearch) return;
+    m_titleSearch = search;
+    recompute();
+}
+
+void TaskFilterProxyModel::recompute()
+{
+    bool tagActive = m_hideCompleted || !m_required.isEmpty() || !m_excluded.isEmpty();
+    bool queryActive = m_queryFilter.isValid() && !m_queryFilter.isEmpty();
+    bool searchActive = !m_titleSearch.isEmpty();
+    bool active = tagActive || queryActive || searchActive;
+    if (!active && !m_active) return;
+
+    m_active = active;
+    m_accepted.clear();
+    if (tagActive) {
+        QElapsedTimer timer;
+        timer.start();
+        m_accepted = m_model->tagIndex().filter(m_required, m_excluded, m_hideCompleted);
+        qDebug() << "标签过滤：匹配" << m_accepted.cardinality() << "个任务，耗时"
+                 << timer.nsecsElapsed() / 1000 << "us";
+    }
+    if (queryActive) {
+        m_accepted = tagActive ? (m_accepted & m_queryMatched) : m_queryMatched;
+    }
+    if (searchActive) {
+        QElapsedTimer timer;
+        timer.start();
+        RoaringBitmap matched = m_model->pinyinIndex().search(m_titleSearch);
+        qDebug() << "标题搜索：" << m_titleSearch << "匹配" << matched.cardinality() << "个任务，耗时"
+                 << timer.nsecsElapsed() / 1000 << "us";
+        m_accepted = (tagActive || queryActive) ? (m_accepted & matched) : matched;
+    }
+    invalidateFilter();
+}
+
+bool TaskFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    Q_UNUSED(sourceParent);
+    if (!m_active) return true;
+    int taskId = m_model->taskIdAt(sourceRow);
+    return taskId >= 0 && m_accepted.contains(quint32(taskId));
+}
+
+bool TaskFilterProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+{
+    if (left.column() == TaskModel::ColumnTitle && right.column() == TaskModel::ColumnTitle)
+        return m_model->titleLessThan(left.row(), right.row());
+    return QSortFilterProxyModel::lessThan(left, right);
+}
@@ -0,0 +1,50 @@
+#ifndef TASKFILTERPROXYMODEL_H
+#define TASKFILTERPROXYMODEL_H
+
+#include <QSortFilterProxyModel>
+#include <QTimer>
+#include "roaringbitmap.h"
+#include "taskfilter.h"
+#include "taskmodel.h"
+
+// 过滤任务列表：标签条件在标签索引上求位图，筛选表达式由数据库按索引查出任务ID，
+// 标题搜索在拼音前缀索引上求位图，三者求交后每行只做一次位图查找。点击表头排序时标题按拼音顺序
+class TaskFilterProxyModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+public:
+    explicit TaskFilterProxyModel(TaskModel *model, QObject *parent = nullptr);
+
+    // 例如 "工作 紧急 -会议"：同时带"工作"和"紧急"标签、且不带"会议"标签
+    void setTagFilter(const QString &text, bool hideCompleted);
+    // 已编译的筛选表达式；结果缓存为位图，任务修改后只对修改过的任务重新求值，
+    // 含相对时间的表达式另外每分钟整体重新执行一次（只重新绑定参数）
+    void setQueryFilter(const TaskFilter &filter);
+    // 标题搜索，支持汉字、全拼和首字母前缀（如 "zbhy" 匹配"周报会议"）
+    void setTitleSearch(const QString &text);
+    bool isFiltering() const { return m_active; }
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+    // 标题列比较源模型中预先计算的排序键，其余列比较 SortRole 的值
+    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+
+private slots:
+    void recompute();
+    void reloadQueryMatches();
+    void updateQueryMatches(const QList<int> &taskIds);
+
+private:
+    TaskModel *m_model;
+    QStringList m_required;
+    QStringList m_excluded;
+    bool m_hideCompleted = false;
+    TaskFilter m_queryFilter;
+    RoaringBitmap m_queryMatched;   // 筛选表达式匹配的任务
+    QTimer m_relativeTimer;
+    QString m_titleSearch;
+    bool m_active = false;
+    RoaringBitmap m_accepted;
+};
+
+#endif // TASKFILTERPROXYMODEL_H
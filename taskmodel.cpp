@@ -1,16 +1,43 @@
 #include "taskmodel.h"
 #include <QColor>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QLocale>
 #include <QMutexLocker>
+#include <QSet>
+#include <QStringList>
+#include <algorithm>
+#include "metrics.h"
 
 TaskModel::TaskModel(QObject *parent)
     : QAbstractTableModel(parent)
+    , m_clock(Clock::system())
+    , m_titleCollator(QLocale(QLocale::Chinese, QLocale::China))
 {
     qDebug() << "TaskModel构造函数开始";
+    // 标题以中文为主，不论系统语言都按中文规则排序（ICU 及 Windows 下即拼音顺序）；
+    // 数字按数值比较，"第2周" 排在 "第10周" 之前
+    m_titleCollator.setCaseSensitivity(Qt::CaseInsensitive);
+    m_titleCollator.setNumericMode(true);
+    m_urgencyTimer.setSingleShot(true);
+    connect(&m_urgencyTimer, &QTimer::timeout, this, &TaskModel::onUrgencyTimer);
     refreshTasks();
+    connect(&m_writeQueue, &TaskWriteQueue::flushFailed, this, &TaskModel::onWriteFailed);
+    // 数据库落盘后依赖数据库的视图（如筛选表达式）需要重新计算
+    connect(&m_writeQueue, &TaskWriteQueue::flushed, this, [this](const QList<int> &taskIds) {
+        emit tasksChanged(taskIds);
+        emit taskDataChanged();
+    });
+    Metrics::addCollector(this, [this]() { collectMetrics(); });
     qDebug() << "TaskModel构造函数结束，任务数：" << m_cachedTasks.size();
 }
 
+TaskModel::~TaskModel()
+{
+    Metrics::removeCollectors(this);
+    flushPendingWrites();
+}
+
 int TaskModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
@@ -25,34 +52,166 @@ int TaskModel::columnCount(const QModelIndex &parent) const
 
 QVariant TaskModel::data(const QModelIndex &index, int role) const
 {
-    if (!index.isValid() || index.row() >= m_cachedTasks.size())
+    if (!index.isValid() || index.row() >= m_rowCache.size())
         return QVariant();
 
-    const Task &task = m_cachedTasks[index.row()];
+    // 直接返回预先格式化的隐式共享值，避免每次重绘都格式化字符串
+    const RowCache &cache = m_rowCache.at(index.row());
 
     switch (role) {
     case Qt::DisplayRole:
     case Qt::EditRole:
-        switch (index.column()) {
-        case ColumnTitle: return task.title;
-        case ColumnDeadline: return task.deadline.toString("yyyy-MM-dd HH:mm");
-        case ColumnPriority:
-            return (task.priority == 0 ? "低" : (task.priority == 1 ? "中" : "高"));
-        case ColumnCompleted: return task.isCompleted ? "已完成" : "未完成";
-        default: return QVariant();
-        }
+        if (index.column() < ColumnCount)
+            return cache.display[index.column()];
+        return QVariant();
     case Qt::ForegroundRole:
-        if (task.isCompleted) return QColor(Qt::gray);
-        if (task.priority == 2) return QColor(Qt::red);
-        return QColor(Qt::black);
+        return cache.foreground;
+    case Qt::ToolTipRole:
+        return cache.toolTip;
     case Qt::CheckStateRole:
         if (index.column() == ColumnCompleted)
-            return task.isCompleted ? Qt::Checked : Qt::Unchecked;
+            return cache.checkState;
+        return QVariant();
+    case TaskIdRole:
+        return m_cachedTasks.at(index.row()).id;
+    case SortRole:
+        if (index.column() == ColumnPriority)
+            return m_cachedTasks.at(index.row()).priority;
+        if (index.column() == ColumnCompleted)
+            return int(m_cachedTasks.at(index.row()).isCompleted);
+        if (index.column() < ColumnCount)
+            return cache.display[index.column()];
+        return QVariant();
     default:
         return QVariant();
     }
 }
 
+// previous 为该行原来的缓存，标题未变时沿用其排序键
+TaskModel::RowCache TaskModel::buildRowCache(const Task &task, const RowCache *previous) const
+{
+    // 常用取值只构造一次，各行共享同一份数据
+    static const QVariant priorityTexts[] = {
+        QVariant(QString("低")), QVariant(QString("中")), QVariant(QString("高"))
+    };
+    static const QVariant completedText(QString("已完成"));
+    static const QVariant pendingText(QString("未完成"));
+    static const QVariant blockedText(QString("未完成（阻塞）"));
+    static const QVariant grayColor(QColor(Qt::gray));
+    static const QVariant redColor(QColor(Qt::red));
+    static const QVariant blackColor(QColor(Qt::black));
+    static const QVariant orangeColor(QColor(255, 140, 0));
+    static const QVariant overdueColor(QColor(139, 0, 0));
+    static const QVariant checked(int(Qt::Checked));
+    static const QVariant unchecked(int(Qt::Unchecked));
+
+    RowCache cache;
+    cache.display[ColumnTitle] = task.title;
+    cache.display[ColumnDeadline] = task.deadline.toString("yyyy-MM-dd HH:mm");
+    cache.display[ColumnPriority] = priorityTexts[qBound(0, task.priority, 2)];
+    if (!task.tags.isEmpty())
+        cache.display[ColumnTags] = task.tags.join(", ");
+    bool blocked = !task.isCompleted && m_dependencyGraph.isBlocked(task.id);
+    bool overdue = !task.isCompleted && m_urgency.isOverdue(task.id);
+    if (task.isCompleted)
+        cache.display[ColumnCompleted] = completedText;
+    else
+        cache.display[ColumnCompleted] = blocked ? blockedText : pendingText;
+
+    if (task.isCompleted)
+        cache.foreground = grayColor;
+    else if (blocked)
+        cache.foreground = orangeColor;
+    else if (overdue)
+        cache.foreground = overdueColor;
+    else if (task.priority == 2)
+        cache.foreground = redColor;
+    else
+        cache.foreground = blackColor;
+
+    cache.checkState = task.isCompleted ? checked : unchecked;
+
+    if (previous && previous->titleKey && previous->display[ColumnTitle].toString() == task.title)
+        cache.titleKey = previous->titleKey;
+    else
+        cache.titleKey = m_titleCollator.sortKey(task.title);
+
+    if (blocked) {
+        QStringList blockers;
+        for (int blockerId : m_dependencyGraph.blockersOf(task.id)) {
+            int row = m_rowById.value(blockerId, -1);
+            if (row != -1 && !m_cachedTasks.at(row).isCompleted)
+                blockers << m_cachedTasks.at(row).title;
+        }
+        QString tip = QString("被以下任务阻塞：\n%1").arg(blockers.join("\n"));
+        if (m_dependencyGraph.isLate(task.id)) {
+            tip += QString("\n预计最早完成：%1（晚于截止时间）")
+                       .arg(m_dependencyGraph.earliestFinish(task.id).toString("yyyy-MM-dd HH:mm"));
+        }
+        cache.toolTip = tip;
+    } else if (overdue) {
+        cache.toolTip = QString("已逾期");
+    }
+    return cache;
+}
+
+void TaskModel::rebuildRowCache()
+{
+    // 同一行标题未变（如时钟跳变后整体重建）时沿用原来的排序键
+    QVector<RowCache> previous;
+    previous.swap(m_rowCache);
+    m_rowCache.reserve(m_cachedTasks.size());
+    for (int row = 0; row < m_cachedTasks.size(); ++row) {
+        m_rowCache.append(buildRowCache(m_cachedTasks.at(row), row < previous.size() ? &previous.at(row) : nullptr));
+    }
+}
+
+void TaskModel::updateRowCache(int row)
+{
+    if (row < 0 || row >= m_cachedTasks.size() || row >= m_rowCache.size())
+        return;
+    m_rowCache[row] = buildRowCache(m_cachedTasks.at(row), &m_rowCache.at(row));
+}
+
+bool TaskModel::titleLessThan(int leftRow, int rightRow) const
+{
+    if (leftRow < 0 || rightRow < 0 || leftRow >= m_rowCache.size() || rightRow >= m_rowCache.size())
+        return false;
+    const RowCache &left = m_rowCache.at(leftRow);
+    const RowCache &right = m_rowCache.at(rightRow);
+    if (!left.titleKey || !right.titleKey)
+        return m_titleCollator.compare(m_cachedTasks.at(leftRow).title, m_cachedTasks.at(rightRow).title) < 0;
+    return left.titleKey->compare(*right.titleKey) < 0;
+}
+
+// 拼音索引在整表重载后失效，下次搜索时才重建；增量变化直接更新已建好的索引
+const PinyinIndex &TaskModel::pinyinIndex() const
+{
+    if (!m_pinyinIndexValid) {
+        static Histogram *const latency = Metrics::histogram("zhsj_index_build_seconds", "内存索引重建耗时",
+                                                             "index=\"pinyin\"");
+        QElapsedTimer timer;
+        timer.start();
+        m_pinyinIndex.rebuild(m_cachedTasks);
+        latency->record(quint64(timer.nsecsElapsed() / 1000));
+        m_pinyinIndexValid = true;
+        qDebug() << "建立拼音索引：" << m_cachedTasks.size() << "个任务，" << m_pinyinIndex.nodeCount()
+                 << "个节点，耗时" << timer.elapsed() << "ms";
+    }
+    return m_pinyinIndex;
+}
+
+// 依赖图增量计算后，只刷新受影响的行
+void TaskModel::updateRowsForTasks(const QList<int> &taskIds)
+{
+    for (int taskId : taskIds) {
+        int row = m_rowById.value(taskId, -1);
+        if (row == -1) continue;
+        updateRowCache(row);
+        emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+    }
+}
+
 QVariant TaskModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
     if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
@@ -61,6 +220,7 @@ QVariant TaskModel::headerData(int section, Qt::Orientation orientation, int rol
         case ColumnDeadline: return "截止时间";
         case ColumnPriority: return "优先级";
         case ColumnCompleted: return "完成状态";
+        case ColumnTags: return "标签";
         default: return QVariant();
         }
     }
@@ -73,6 +233,7 @@ bool TaskModel::setData(const QModelIndex &index, const QVariant &value, int rol
         return false;
 
     Task &task = m_cachedTasks[index.row()];
+    const Task original = task;
     bool changed = false;
 
     if (role == Qt::CheckStateRole && index.column() == ColumnCompleted) {
@@ -81,8 +242,19 @@ bool TaskModel::setData(const QModelIndex &index, const QVariant &value, int rol
     }
 
     if (changed) {
-        DBManager::instance()->updateTask(task);
-        emit dataChanged(index, index, {role});
+        // 先更新界面，数据库写入排队合并后批量提交
+        m_writeQueue.enqueueCompletion(task.id, task.isCompleted, original);
+        publishChanges({task});
+
+        QList<int> affected;
+        m_dependencyGraph.updateTask(task, &affected);
+        m_tagIndex.updateTask(task);
+        if (m_pinyinIndexValid) m_pinyinIndex.updateTask(task);
+        updateUrgency({task});
+        if (!affected.contains(task.id))
+            affected.append(task.id);
+        // 完成状态会影响整行的前景色以及下游任务的阻塞状态
+        updateRowsForTasks(affected);
         emit taskDataChanged();
         return true;
     }
@@ -103,32 +275,87 @@ Qt::ItemFlags TaskModel::flags(const QModelIndex &index) const
 
 void TaskModel::addTask(const Task &task)
 {
+    m_writeQueue.flush();
     qDebug() << "添加任务：" << task.title;
 
+    // 写入的行都带新的行版本号，增量应用即可：只移动/插入这一行，依赖图只重算它的后继
     if (DBManager::instance()->addTask(task)) {
-        refreshTasks();
-        emit taskDataChanged();
+        applyDatabaseChanges();
     }
 }
 
 void TaskModel::updateTask(const Task &task)
 {
+    m_writeQueue.flush();
     qDebug() << "更新任务：" << task.title;
 
     if (DBManager::instance()->updateTask(task)) {
-        refreshTasks();
-        emit taskDataChanged();
+        applyDatabaseChanges();
     }
 }
 
 void TaskModel::removeTask(int taskId)
 {
+    m_writeQueue.flush();
     qDebug() << "删除任务ID：" << taskId;
 
     if (DBManager::instance()->deleteTask(taskId)) {
-        refreshTasks();
-        emit taskDataChanged();
+        applyDatabaseChanges();
+    }
+}
+
+bool TaskModel::updateTasks(const QList<Task> &tasks, QString *error)
+{
+    m_writeQueue.flush();
+    if (!DBManager::instance()->updateTasks(tasks, error))
+        return false;
+
+    // 写入的行都带新的行版本号，增量应用即可，不必整表重载
+    applyDatabaseChanges();
+    return true;
+}
+
+bool TaskModel::removeTasks(const QList<int> &taskIds, QString *error)
+{
+    m_writeQueue.flush();
+    if (!DBManager::instance()->deleteTasks(taskIds, error))
+        return false;
+
+    applyDatabaseChanges();
+    return true;
+}
+
+bool TaskModel::mergeTasks(int keepId, const QList<int> &mergedIds, QString *error)
+{
+    m_writeQueue.flush();
+
+    // 在图的副本上逐条改挂被合并任务的依赖，跳过自环和会形成循环的边
+    TaskDependencyGraph graph = m_dependencyGraph;
+    QList<QPair<int, int>> moved;
+    for (int taskId : mergedIds) {
+        graph.removeTask(taskId);
+    }
+    const QList<QPair<int, int>> edges = DBManager::instance()->getAllDependencies();
+    for (const auto &edge : edges) {
+        if (!mergedIds.contains(edge.first) && !mergedIds.contains(edge.second)) continue;
+        int blocker = mergedIds.contains(edge.first) ? keepId : edge.first;
+        int blocked = mergedIds.contains(edge.second) ? keepId : edge.second;
+        if (blocker == blocked || !graph.addEdge(blocker, blocked)) continue;
+        moved.append(qMakePair(blocker, blocked));
+    }
+
+    if (!DBManager::instance()->mergeTasks(keepId, mergedIds, moved, error))
+        return false;
+
+    // 被合并的任务随删除增量移除（连同它们的边），再补上改挂到保留任务的边
+    applyDatabaseChanges();
+    QList<int> affected;
+    for (const auto &edge : moved) {
+        m_dependencyGraph.addEdge(edge.first, edge.second, &affected);
     }
+    updateRowsForTasks(affected);
+    if (!affected.isEmpty()) emit taskDataChanged();
+    return true;
 }
 
 void TaskModel::toggleTaskCompleted(int taskId)
@@ -142,15 +369,228 @@ void TaskModel::toggleTaskCompleted(int taskId)
 
 void TaskModel::refreshTasks()
 {
+    static Histogram *const latency = Metrics::histogram("zhsj_model_update_seconds", "任务模型更新耗时",
+                                                         "kind=\"full\"");
+    MetricsTimer timer(latency);
     qDebug() << "刷新任务列表...";
+    m_writeQueue.flush();
 
     beginResetModel();
+    // 先记录版本号，加载期间的并发修改会在下次增量中再次应用
+    m_rowVersion = DBManager::instance()->currentRowVersion();
     m_cachedTasks = DBManager::instance()->getAllTasks();
+    m_rowById.clear();
+    m_rowById.reserve(m_cachedTasks.size());
+    for (int row = 0; row < m_cachedTasks.size(); ++row) {
+        m_rowById.insert(m_cachedTasks.at(row).id, row);
+    }
+    m_dependencyGraph.rebuild(m_cachedTasks, DBManager::instance()->getAllDependencies());
+    m_tagIndex.rebuild(m_cachedTasks);
+    // 拼音索引建立代价较高，等到下次搜索时再重建
+    m_pinyinIndex.clear();
+    m_pinyinIndexValid = false;
+    m_urgency.reset(m_cachedTasks, m_clock->nowSecs());
+    rebuildRowCache();
     endResetModel();
+    m_snapshots.publish(TaskSnapshot::create(m_cachedTasks, ++m_snapshotVersion));
+    scheduleUrgencyTimer();
+    emit nextUpChanged();
 
     qDebug() << "刷新完成，任务数：" << m_cachedTasks.size();
 }
 
+// 增量应用自上次加载以来数据库中的变化（包括其他进程的写入），返回是否有变化
+bool TaskModel::applyDatabaseChanges()
+{
+    // 变化量很大时整表重载反而更快
+    static const int kFullReloadThreshold = 5000;
+    // 超过该数量时不再逐行发出插入/删除信号，而是一次追加、一次重排、一次删除
+    static const int kRowSignalThreshold = 64;
+    static Histogram *const latency = Metrics::histogram("zhsj_model_update_seconds", "任务模型更新耗时",
+                                                         "kind=\"incremental\"");
+    MetricsTimer timer(latency);
+
+    m_writeQueue.flush();
+
+    QList<Task> changed;
+    QList<int> deletedIds;
+    qint64 newVersion = m_rowVersion;
+    if (!DBManager::instance()->getChangesSince(m_rowVersion, &changed, &deletedIds, &newVersion))
+        return false;
+
+    if (changed.isEmpty() && deletedIds.isEmpty()) {
+        m_rowVersion = newVersion;
+        return false;
+    }
+
+    if (changed.size() + deletedIds.size() > kFullReloadThreshold) {
+        refreshTasks();
+        emit taskDataChanged();
+        return true;
+    }
+
+    m_rowVersion = newVersion;
+    QList<int> affected;
+
+    // 批量修改时逐行插入/删除的代价是 O(变化数×行数)，改为一次重排
+    const bool onePass = changed.size() + deletedIds.size() > kRowSignalThreshold;
+    if (onePass) {
+        regroupRows(changed, deletedIds);
+    }
+
+    for (int taskId : deletedIds) {
+        if (!onePass) {
+            int row = m_rowById.value(taskId, -1);
+            if (row == -1) continue;
+            removeRowAt(row);
+        }
+        m_dependencyGraph.removeTask(taskId, &affected);
+        m_tagIndex.removeTask(taskId);
+        if (m_pinyinIndexValid) m_pinyinIndex.removeTask(taskId);
+    }
+
+    for (const Task &task : changed) {
+        if (!onePass) {
+            int row = m_rowById.value(task.id, -1);
+            if (row != -1 && m_cachedTasks.at(row).deadline == task.deadline) {
+                m_cachedTasks[row] = task;
+            } else {
+                // 截止时间变化或新任务：移动到按截止时间排序的位置
+                if (row != -1) removeRowAt(row);
+                insertSorted(task);
+            }
+        }
+        m_dependencyGraph.updateTask(task, &affected);
+        m_tagIndex.updateTask(task);
+        if (m_pinyinIndexValid) m_pinyinIndex.updateTask(task);
+        affected.append(task.id);
+    }
+
+    updateUrgency(changed, deletedIds);
+    updateRowsForTasks(affected);
+    publishChanges(changed, deletedIds);
+    QList<int> changedIds = deletedIds;
+    for (const Task &task : changed) {
+        changedIds.append(task.id);
+    }
+    emit tasksChanged(changedIds);
+    emit taskDataChanged();
+    qDebug() << "增量更新完成：" << changed.size() << "个修改，" << deletedIds.size() << "个删除";
+    return true;
+}
+
+void TaskModel::removeRowAt(int row)
+{
+    beginRemoveRows(QModelIndex(), row, row);
+    m_rowById.remove(m_cachedTasks.at(row).id);
+    m_cachedTasks.removeAt(row);
+    m_rowCache.remove(row);
+    endRemoveRows();
+    reindexRows(row);
+}
+
+// 批量变化时用固定次数的信号完成删除、原位更新和按截止时间插入，不重置模型：
+// 新任务一次追加到末尾，再一次重排（删除的行排到末尾），最后一次删除末尾的行。
+// 重排时更新持久索引，选中和当前行跟随任务移动。变化行的显示缓存由调用方随后重建
+void TaskModel::regroupRows(const QList<Task> &changed, const QList<int> &deletedIds)
+{
+    QSet<int> removed;
+    for (int taskId : deletedIds) {
+        if (m_rowById.contains(taskId)) removed.insert(taskId);
+    }
+
+    QSet<int> moved;        // 截止时间变化或新增的行，与 insertSorted 一致排在截止时间相同的行之后
+    QList<Task> inserted;
+    for (const Task &task : changed) {
+        int row = m_rowById.value(task.id, -1);
+        if (row == -1) {
+            inserted.append(task);
+        } else {
+            if (m_cachedTasks.at(row).deadline != task.deadline) moved.insert(task.id);
+            m_cachedTasks[row] = task;
+        }
+    }
+
+    if (!inserted.isEmpty()) {
+        const int first = m_cachedTasks.size();
+        beginInsertRows(QModelIndex(), first, first + inserted.size() - 1);
+        for (const Task &task : inserted) {
+            m_cachedTasks.append(task);
+            m_rowCache.append(RowCache());
+            moved.insert(task.id);
+        }
+        endInsertRows();
+        reindexRows(first);
+    }
+
+    emit layoutAboutToBeChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+    const int count = m_cachedTasks.size();
+    QVector<int> order(count);
+    for (int row = 0; row < count; ++row) order[row] = row;
+    std::stable_sort(order.begin(), order.end(), [this, &removed, &moved](int a, int b) {
+        const Task &x = m_cachedTasks.at(a);
+        const Task &y = m_cachedTasks.at(b);
+        const bool xRemoved = removed.contains(x.id);
+        const bool yRemoved = removed.contains(y.id);
+        if (xRemoved != yRemoved) return yRemoved;
+        if (x.deadline != y.deadline) return x.deadline < y.deadline;
+        return !moved.contains(x.id) && moved.contains(y.id);
+    });
+
+    QList<Task> tasks;
+    QVector<RowCache> caches;
+    QVector<int> newRowOf(count);
+    tasks.reserve(count);
+    caches.reserve(count);
+    for (int row = 0; row < count; ++row) {
+        newRowOf[order.at(row)] = row;
+        tasks.append(m_cachedTasks.at(order.at(row)));
+        caches.append(m_rowCache.at(order.at(row)));
+    }
+    const QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const QModelIndex &index : from) {
+        to.append(index.row() < count ? createIndex(newRowOf.at(index.row()), index.column()) : QModelIndex());
+    }
+    m_cachedTasks = tasks;
+    m_rowCache = caches;
+    reindexRows(0);
+    changePersistentIndexList(from, to);
+    emit layoutChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+
+    if (!removed.isEmpty()) {
+        const int first = count - removed.size();
+        beginRemoveRows(QModelIndex(), first, count - 1);
+        for (int row = first; row < count; ++row) {
+            m_rowById.remove(m_cachedTasks.at(row).id);
+        }
+        m_cachedTasks.erase(m_cachedTasks.begin() + first, m_cachedTasks.end());
+        m_rowCache.resize(first);
+        endRemoveRows();
+    }
+}
+
+void TaskModel::insertSorted(const Task &task)
+{
+    auto it = std::upper_bound(m_cachedTasks.begin(), m_cachedTasks.end(), task,
+                               [](const Task &a, const Task &b) { return a.deadline < b.deadline; });
+    int row = int(it - m_cachedTasks.begin());
+
+    beginInsertRows(QModelIndex(), row, row);
+    m_cachedTasks.insert(row, task);
+    m_rowCache.insert(row, buildRowCache(task));
+    endInsertRows();
+    reindexRows(row);
+}
+
+void TaskModel::reindexRows(int fromRow)
+{
+    for (int row = fromRow; row < m_cachedTasks.size(); ++row) {
+        m_rowById.insert(m_cachedTasks.at(row).id, row);
+    }
+}
+
 QList<Task> TaskModel::getAllTasks() const
 {
     return m_cachedTasks;
@@ -158,10 +598,173 @@ QList<Task> TaskModel::getAllTasks() const
 
 Task TaskModel::getTaskById(int taskId) const
 {
-    for (const auto &task : m_cachedTasks) {
-        if (task.id == taskId) {
-            return task;
-        }
+    int row = m_rowById.value(taskId, -1);
+    if (row == -1) {
+        return Task();
+    }
+    return m_cachedTasks.at(row);
+}
+
+// 在当前快照上应用变化并发布新版本，未改动的部分与旧版本共享
+void TaskModel::publishChanges(const QList<Task> &changed, const QList<int> &removedIds)
+{
+    m_snapshots.publish(m_snapshots.current()->update(changed, removedIds, ++m_snapshotVersion));
+}
+
+void TaskModel::updateUrgency(const QList<Task> &changed, const QList<int> &removedIds)
+{
+    const qint64 now = m_clock->nowSecs();
+    bool topChanged = false;
+    for (int taskId : removedIds) {
+        topChanged = m_urgency.remove(taskId) || topChanged;
+    }
+    for (const Task &task : changed) {
+        topChanged = m_urgency.update(task, now) || topChanged;
+    }
+    scheduleUrgencyTimer();
+    if (topChanged) emit nextUpChanged();
+}
+
+void TaskModel::scheduleUrgencyTimer()
+{
+    // 定时器间隔有上限，且休眠唤醒后可能不准，远的逾期时间分段等待
+    static const qint64 kMaxWaitMs = 60 * 60 * 1000;
+    qint64 next = m_urgency.nextTransition();
+    if (next < 0) {
+        m_urgencyTimer.stop();
+        return;
+    }
+    qint64 waitMs = m_clock->realMsFor((next - m_clock->nowSecs()) * 1000 + 500);
+    if (waitMs < 0) {
+        m_urgencyTimer.stop();      // 模拟时钟暂停，等跳变通知
+        return;
+    }
+    m_urgencyTimer.start(int(qMin(waitMs, kMaxWaitMs)));
+}
+
+// 有任务越过截止时间：只重新计算这些任务的紧急度和行颜色
+void TaskModel::onUrgencyTimer()
+{
+    QList<int> overdue;
+    bool topChanged = m_urgency.advanceTo(m_clock->nowSecs(), &overdue);
+    if (!overdue.isEmpty()) {
+        updateRowsForTasks(overdue);
+    }
+    scheduleUrgencyTimer();
+    if (topChanged) emit nextUpChanged();
+}
+
+void TaskModel::setClock(Clock *clock)
+{
+    if (m_clock == clock) return;
+    disconnect(m_clock, &Clock::timeChanged, this, &TaskModel::onClockChanged);
+    m_clock = clock;
+    connect(m_clock, &Clock::timeChanged, this, &TaskModel::onClockChanged);
+    onClockChanged();
+}
+
+// 时钟跳变（可能向回）：逾期状态整体重新计算
+void TaskModel::onClockChanged()
+{
+    m_urgency.reset(m_cachedTasks, m_clock->nowSecs());
+    rebuildRowCache();
+    if (!m_cachedTasks.isEmpty()) {
+        emit dataChanged(index(0, 0), index(m_cachedTasks.size() - 1, ColumnCount - 1));
+    }
+    scheduleUrgencyTimer();
+    emit nextUpChanged();
+}
+
+// 采集时现算：任务数和各内存缓存的估算占用（字符串按标题长度计，不含 Qt 容器的额外开销）
+void TaskModel::collectMetrics() const
+{
+    static Gauge *const allTasks = Metrics::gauge("zhsj_tasks", "当前任务数", "state=\"all\"");
+    static Gauge *const completedTasks = Metrics::gauge("zhsj_tasks", "当前任务数", "state=\"completed\"");
+    static Gauge *const overdueTasks = Metrics::gauge("zhsj_tasks", "当前任务数", "state=\"overdue\"");
+    static Gauge *const rowBytes = Metrics::gauge("zhsj_cache_bytes", "内存缓存估算占用", "cache=\"rows\"");
+    static Gauge *const pinyinBytes = Metrics::gauge("zhsj_cache_bytes", "内存缓存估算占用", "cache=\"pinyin\"");
+    static Gauge *const pendingWrites = Metrics::gauge("zhsj_pending_writes", "尚未提交到数据库的修改数");
+
+    int completed = 0;
+    int overdue = 0;
+    qint64 textBytes = 0;
+    for (const Task &task : m_cachedTasks) {
+        if (task.isCompleted) ++completed;
+        if (m_urgency.isOverdue(task.id)) ++overdue;
+        // 标题在任务和显示缓存中各有一份
+        textBytes += 2 * qint64(task.title.size()) * qint64(sizeof(QChar));
+    }
+    allTasks->set(m_cachedTasks.size());
+    completedTasks->set(completed);
+    overdueTasks->set(overdue);
+    rowBytes->set(qint64(m_cachedTasks.size()) * qint64(sizeof(Task) + sizeof(RowCache) + 2 * sizeof(int))
+                  + textBytes);
+    pinyinBytes->set(m_pinyinIndexValid ? m_pinyinIndex.memoryUsage() : 0);
+    pendingWrites->set(m_writeQueue.size());
+}
+
+bool TaskModel::flushPendingWrites()
+{
+    return m_writeQueue.flush();
+}
+
+// 批量提交失败：数据库已整体回滚，把这些任务恢复为修改前的状态
+void TaskModel::onWriteFailed(const QList<Task> &originals, const QString &error)
+{
+    QList<int> affected;
+    QList<Task> restored;
+    for (const Task &original : originals) {
+        int row = m_rowById.value(original.id, -1);
+        if (row == -1) continue;
+        m_cachedTasks[row] = original;
+        m_dependencyGraph.updateTask(original, &affected);
+        m_tagIndex.updateTask(original);
+        if (m_pinyinIndexValid) m_pinyinIndex.updateTask(original);
+        restored.append(original);
+        if (!affected.contains(original.id))
+            affected.append(original.id);
+    }
+    updateUrgency(restored);
+    updateRowsForTasks(affected);
+    publishChanges(originals);
+    emit taskDataChanged();
+
+    emit writeFailed(QString("%1 个任务的修改未能保存，已恢复为修改前的状态。\n原因：%2")
+                         .arg(originals.size()).arg(error));
+}
+
+bool TaskModel::addDependency(int blockerId, int blockedId, QString *error)
+{
+    if (m_dependencyGraph.wouldCreateCycle(blockerId, blockedId)) {
+        if (error) *error = "添加该依赖会形成循环依赖";
+        return false;
+    }
+
+    if (!DBManager::instance()->addDependency(blockerId, blockedId)) {
+        if (error) *error = "写入数据库失败";
+        return false;
+    }
+
+    QList<int> affected;
+    if (!m_dependencyGraph.addEdge(blockerId, blockedId, &affected)) {
+        DBManager::instance()->removeDependency(blockerId, blockedId);
+        if (error) *error = "添加该依赖会形成循环依赖";
+        return false;
     }
-    return Task();
+
+    updateRowsForTasks(affected);
+    emit taskDataChanged();
+    return true;
+}
+
+bool TaskModel::removeDependency(int blockerId, int blockedId)
+{
+    if (!DBManager::instance()->removeDependency(blockerId, blockedId))
+        return false;
+
+    QList<int> affected;
+    m_dependencyGraph.removeEdge(blockerId, blockedId, &affected);
+    updateRowsForTasks(affected);
+    emit taskDataChanged();
+    return true;
 }
@@ -2,8 +2,20 @@
 #define TASKMODEL_H
 
 #include <QAbstractTableModel>
+#include <QCollator>
+#include <QHash>
+#include <QTimer>
+#include <QVector>
+#include <optional>
 #include "dbmanager.h"
 #include "task.h"
+#include "taskdependencygraph.h"
+#include "tagindex.h"
+#include "pinyinindex.h"
+#include "taskwritequeue.h"
+#include "tasksnapshot.h"
+#include "urgencyqueue.h"
+#include "clock.h"
 
 class TaskModel : public QAbstractTableModel
 {
@@ -14,10 +26,17 @@ public:
         ColumnDeadline,
         ColumnPriority,
         ColumnCompleted,
+        ColumnTags,
         ColumnCount
     };
 
+    enum TaskRole {
+        TaskIdRole = Qt::UserRole + 1,
+        SortRole                    // 代理模型排序用的原始值（优先级、完成状态按数值比较）
+    };
+
     explicit TaskModel(QObject *parent = nullptr);
+    ~TaskModel() override;
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     int columnCount(const QModelIndex &parent = QModelIndex()) const override;
@@ -29,16 +48,92 @@ public:
     void addTask(const Task &task);
     void updateTask(const Task &task);
     void removeTask(int taskId);
+    // 批量操作：一个事务提交，模型按增量一次性更新
+    bool updateTasks(const QList<Task> &tasks, QString *error = nullptr);
+    bool removeTasks(const QList<int> &taskIds, QString *error = nullptr);
+    // 近似重复合并：mergedIds 并入 keepId 后删除，依赖改挂到 keepId（会成环的丢弃）
+    bool mergeTasks(int keepId, const QList<int> &mergedIds, QString *error = nullptr);
     void toggleTaskCompleted(int taskId);
     void refreshTasks();
+    bool applyDatabaseChanges();
     QList<Task> getAllTasks() const;
     Task getTaskById(int taskId) const;
+    // 当前任务的不可变快照（可在任意线程无锁读取），以及供后台线程持有的发布点
+    TaskSnapshot::Ptr snapshot() const { return m_snapshots.current(); }
+    const TaskSnapshotSource *snapshotSource() const { return &m_snapshots; }
+    // 立即提交列表中勾选等尚未写入数据库的修改（直接读数据库之前调用）
+    bool flushPendingWrites();
+
+    // 任务依赖
+    bool addDependency(int blockerId, int blockedId, QString *error = nullptr);
+    bool removeDependency(int blockerId, int blockedId);
+    const TaskDependencyGraph &dependencyGraph() const { return m_dependencyGraph; }
+
+    // 标签索引（与模型行同步增量维护）
+    const TagIndex &tagIndex() const { return m_tagIndex; }
+    // 标题拼音前缀索引：首次搜索时才建立，之后与模型行同步增量维护
+    const PinyinIndex &pinyinIndex() const;
+    int taskIdAt(int row) const { return row >= 0 && row < m_cachedTasks.size() ? m_cachedTasks.at(row).id : -1; }
+    int rowOfTask(int taskId) const { return m_rowById.value(taskId, -1); }
+    // 按预先计算的排序键比较两行标题（中文按拼音），供代理模型排序
+    bool titleLessThan(int leftRow, int rightRow) const;
+
+    // 未完成任务的紧急度排序（前 K 名变化时发出 nextUpChanged）
+    const UrgencyQueue &urgencyQueue() const { return m_urgency; }
+    // 判断逾期使用的时钟，默认为系统时钟
+    Clock *clock() const { return m_clock; }
+    void setClock(Clock *clock);
 
 signals:
     void taskDataChanged();
+    // 数据库中这些任务的行已修改或删除（在 taskDataChanged 之前发出）；整表重载时只有 modelReset
+    void tasksChanged(const QList<int> &taskIds);
+    void writeFailed(const QString &message);
+    void nextUpChanged();
+
+private slots:
+    void onWriteFailed(const QList<Task> &originals, const QString &error);
+    void onUrgencyTimer();
+    void onClockChanged();
 
 private:
+    // 每行预先格式化好的显示数据，与m_cachedTasks按行一一对应
+    struct RowCache {
+        QVariant display[ColumnCount];
+        QVariant foreground;
+        QVariant checkState;
+        QVariant toolTip;
+        std::optional<QCollatorSortKey> titleKey;   // 标题的排序键，只在标题变化时重新计算
+    };
+
+    RowCache buildRowCache(const Task &task, const RowCache *previous = nullptr) const;
+    void rebuildRowCache();
+    void updateRowCache(int row);
+    void updateRowsForTasks(const QList<int> &taskIds);
+    void removeRowAt(int row);
+    void insertSorted(const Task &task);
+    void regroupRows(const QList<Task> &changed, const QList<int> &deletedIds);
+    void reindexRows(int fromRow);
+    void publishChanges(const QList<Task> &changed, const QList<int> &removedIds = QList<int>());
+    void updateUrgency(const QList<Task> &changed, const QList<int> &removedIds = QList<int>());
+    void scheduleUrgencyTimer();
+    void collectMetrics() const;
+
     QList<Task> m_cachedTasks;
+    QVector<RowCache> m_rowCache;
+    QHash<int, int> m_rowById;
+    TaskDependencyGraph m_dependencyGraph;
+    TagIndex m_tagIndex;
+    mutable PinyinIndex m_pinyinIndex;
+    mutable bool m_pinyinIndexValid = false;
+    TaskWriteQueue m_writeQueue;
+    TaskSnapshotSource m_snapshots;
+    qint64 m_snapshotVersion = 0;
+    Clock *m_clock;
+    UrgencyQueue m_urgency;
+    QTimer m_urgencyTimer;      // 下一个任务逾期时触发
+    QCollator m_titleCollator;
+    qint64 m_rowVersion = 0;    // 已加载到的数据库行版本号
 };
 
 #endif // TASKMODEL_H
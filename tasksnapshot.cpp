@@ -0,0 +1,97 @@
+#include "tasksnapshot.h"
+#include <QHash>
+#include <algorithm>
+
+namespace {
+bool idLessThan(const Task &task, int taskId)
+{
+    return task.id < taskId;
+}
+}
+
+TaskSnapshot::Ptr TaskSnapshot::create(const QList<Task> &tasks, qint64 version)
+{
+    QVector<Chunk> chunks;
+    for (const Task &task : tasks) {
+        if (task.id < 0) continue;
+        int index = task.id >> kChunkBits;
+        if (index >= chunks.size()) chunks.resize(index + 1);
+        chunks[index].append(task);
+    }
+
+    auto snapshot = std::make_shared<TaskSnapshot>();
+    snapshot->m_version = version;
+    snapshot->m_chunks.resize(chunks.size());
+    for (int i = 0; i < chunks.size(); ++i) {
+        Chunk &chunk = chunks[i];
+        if (chunk.isEmpty()) continue;
+        std::sort(chunk.begin(), chunk.end(), [](const Task &a, const Task &b) { return a.id < b.id; });
+        snapshot->m_size += chunk.size();
+        snapshot->m_chunks[i] = std::make_shared<const Chunk>(std::move(chunk));
+    }
+    return snapshot;
+}
+
+TaskSnapshot::Ptr TaskSnapshot::update(const QList<Task> &changed, const QList<int> &removedIds,
+                                       qint64 version) const
+{
+    // 受影响的块各复制一次
+    QHash<int, Chunk> copies;
+    auto chunkFor = [&](int taskId) -> Chunk & {
+        int index = taskId >> kChunkBits;
+        auto it = copies.find(index);
+        if (it == copies.end()) {
+            const ChunkPtr &shared = m_chunks.value(index);
+            it = copies.insert(index, shared ? *shared : Chunk());
+        }
+        return it.value();
+    };
+
+    auto snapshot = std::make_shared<TaskSnapshot>();
+    snapshot->m_version = version;
+    snapshot->m_size = m_size;
+
+    for (int taskId : removedIds) {
+        if (taskId < 0) continue;
+        Chunk &chunk = chunkFor(taskId);
+        auto it = std::lower_bound(chunk.begin(), chunk.end(), taskId, idLessThan);
+        if (it != chunk.end() && it->id == taskId) {
+            chunk.erase(it);
+            --snapshot->m_size;
+        }
+    }
+
+    for (const Task &task : changed) {
+        if (task.id < 0) continue;
+        Chunk &chunk = chunkFor(task.id);
+        auto it = std::lower_bound(chunk.begin(), chunk.end(), task.id, idLessThan);
+        if (it != chunk.end() && it->id == task.id) {
+            *it = task;
+        } else {
+            chunk.insert(it, task);
+            ++snapshot->m_size;
+        }
+    }
+
+    // 外层只复制块指针，未改动的块与当前版本共享
+    snapshot->m_chunks = m_chunks;
+    for (auto it = copies.begin(); it != copies.end(); ++it) {
+        if (it.key() >= snapshot->m_chunks.size()) {
+            snapshot->m_chunks.resize(it.key() + 1);
+        }
+        snapshot->m_chunks[it.key()] = it.value().isEmpty()
+                                           ? ChunkPtr()
+                                           : std::make_shared<const Chunk>(std::move(it.value()));
+    }
+    return snapshot;
+}
+
+Task TaskSnapshot::task(int taskId) const
+{
+    if (taskId < 0) return Task();
+    const ChunkPtr &chunk = m_chunks.value(taskId >> kChunkBits);
+    if (!chunk) return Task();
+
+    auto it = std::lower_bound(chunk->begin(), chunk->end(), taskId, idLessThan);
+    return it != chunk->end() && it->id == taskId ? *it : Task();
+}
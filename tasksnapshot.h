@@ -0,0 +1,73 @@
+#ifndef TASKSNAPSHOT_H
+#define TASKSNAPSHOT_H
+
+#include <QList>
+#include <QVector>
+#include <memory>
+#include "task.h"
+
+// 不可变的任务快照
+// 任务按 id 分块存放（每块512个id），更新时只复制受影响的块，其余块与旧版本共享。
+// 快照一经发布不再修改，任意线程都可以无锁读取。
+class TaskSnapshot
+{
+public:
+    typedef std::shared_ptr<const TaskSnapshot> Ptr;
+
+    TaskSnapshot() = default;
+
+    static Ptr create(const QList<Task> &tasks, qint64 version);
+    // 在当前版本基础上应用修改和删除，生成新版本
+    Ptr update(const QList<Task> &changed, const QList<int> &removedIds, qint64 version) const;
+
+    qint64 version() const { return m_version; }
+    int size() const { return m_size; }
+    Task task(int taskId) const;    // 不存在时返回 id 为 -1 的任务
+
+    template <typename Func>
+    void forEach(Func func) const
+    {
+        for (const ChunkPtr &chunk : m_chunks) {
+            if (!chunk) continue;
+            for (const Task &task : *chunk) {
+                func(task);
+            }
+        }
+    }
+
+    // 只遍历与 older 不共享的块：自 older 以来修改或新增的任务都在其中（同块中未修改的任务也会出现），
+    // 已删除的任务不会出现。由 update() 得到的版本只需检查少数块
+    template <typename Func>
+    void forEachChangedSince(const TaskSnapshot &older, Func func) const
+    {
+        for (int i = 0; i < m_chunks.size(); ++i) {
+            const ChunkPtr &chunk = m_chunks.at(i);
+            if (!chunk || chunk == older.m_chunks.value(i)) continue;
+            for (const Task &task : *chunk) {
+                func(task);
+            }
+        }
+    }
+
+private:
+    typedef QVector<Task> Chunk;                    // 块内按 id 升序
+    typedef std::shared_ptr<const Chunk> ChunkPtr;
+    static const int kChunkBits = 9;
+
+    QVector<ChunkPtr> m_chunks;
+    qint64 m_version = 0;
+    int m_size = 0;
+};
+
+// 快照的发布点：写入方（界面线程）发布新版本，读取方取得当前版本的引用计数指针
+class TaskSnapshotSource
+{
+public:
+    TaskSnapshot::Ptr current() const { return std::atomic_load(&m_current); }
+    void publish(TaskSnapshot::Ptr snapshot) { std::atomic_store(&m_current, std::move(snapshot)); }
+
+private:
+    TaskSnapshot::Ptr m_current = std::make_shared<const TaskSnapshot>();
+};
+
+#endif // TASKSNAPSHOT_H
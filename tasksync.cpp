@@ -0,0 +1,307 @@
+#include "tasksync.h"
+#include "dbmanager.h"
+#include "schemamigrator.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QSqlError>
+#include <QStringList>
+
+namespace {
+// 允许通过同步修改的任务列
+const QStringList kSyncedFields = {"title", "deadline", "priority", "isCompleted", "description", "tags"};
+}
+
+TaskSync::TaskSync(const QSqlDatabase &db, const QString &localReplica)
+    : m_db(db)
+    , m_localReplica(localReplica)
+{
+}
+
+bool TaskSync::run(const QString &peerPath, Result *result)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QSqlQuery query(m_db);
+    query.prepare("ATTACH DATABASE :path AS peer");
+    query.bindValue(":path", peerPath);
+    if (!query.exec()) {
+        result->error = "无法打开对端数据库：" + query.lastError().text();
+        qCritical() << result->error;
+        return false;
+    }
+
+    bool ok = false;
+    do {
+        QString migrateError;
+        if (!SchemaMigrator::migrate(query, "peer", &migrateError)) {
+            result->error = "无法初始化对端数据库结构：" + migrateError;
+            break;
+        }
+
+        QString peerReplica = DBManager::loadReplicaId(query, "peer");
+        if (peerReplica.isEmpty()) {
+            result->error = "无法读取对端副本ID";
+            break;
+        }
+        if (peerReplica == m_localReplica) {
+            result->error = "对端与本地是同一个数据库副本（是否直接复制了数据库文件？）";
+            break;
+        }
+
+        // 立即取得本地和对端的写锁：延迟事务在读完变更日志后才升级写锁，期间其他连接的写入会使升级失败
+        if (!query.exec("BEGIN IMMEDIATE")) {
+            result->error = "无法开启事务：" + query.lastError().text();
+            break;
+        }
+
+        // 先拉取再推送；推送时跳过源自对端的变更，避免回传
+        bool transferred =
+            transfer("peer", "main", peerReplica, m_localReplica,
+                     &result->pulled, &result->appliedLocal, result)
+            && transfer("main", "peer", m_localReplica, peerReplica,
+                        &result->pushed, &result->appliedRemote, result);
+
+        // 事务内没有其他写入者，双方当前的最大版本即为新的水位线
+        if (transferred
+            && setPulledVersion(query, "main", peerReplica, maxVersion(query, "peer"))
+            && setPulledVersion(query, "peer", m_localReplica, maxVersion(query, "main"))
+            && query.exec("COMMIT")) {
+            ok = true;
+        } else {
+            if (result->error.isEmpty()) {
+                result->error = "同步失败：" + query.lastError().text();
+            }
+            query.exec("ROLLBACK");
+        }
+    } while (false);
+
+    query.finish();
+    if (!query.exec("DETACH DATABASE peer")) {
+        qWarning() << "卸载对端数据库失败：" << query.lastError().text();
+    }
+
+    qDebug() << "同步" << (ok ? "完成" : "失败") << "，耗时" << timer.elapsed() << "ms"
+             << "拉取" << result->pulled << "推送" << result->pushed
+             << "冲突" << result->conflicts;
+    return ok;
+}
+
+// 把 from 中水位线之后、且不是源自 to 的变更应用到 to
+bool TaskSync::transfer(const QString &from, const QString &to, const QString &fromReplica,
+                        const QString &toReplica, int *read, int *applied, Result *result)
+{
+    QSqlQuery query(m_db);
+    qint64 watermark = pulledVersion(query, to, fromReplica);
+
+    QSqlQuery changes(m_db);
+    changes.setForwardOnly(true);
+    changes.prepare(QString(R"(
+        SELECT origin_replica, origin_version, task_uuid, field, value, stamp
+        FROM %1.change_log
+        WHERE version > :watermark AND origin_replica <> :target
+        ORDER BY version
+    )").arg(from));
+    changes.bindValue(":watermark", watermark);
+    changes.bindValue(":target", toReplica);
+    if (!changes.exec()) {
+        result->error = "读取变更日志失败：" + changes.lastError().text();
+        return false;
+    }
+
+    while (changes.next()) {
+        Change change;
+        change.originReplica = changes.value(0).toString();
+        change.originVersion = changes.value(1).toLongLong();
+        change.taskUuid = changes.value(2).toString();
+        change.field = changes.value(3).toString();
+        change.value = changes.value(4);
+        change.stamp = changes.value(5).toLongLong();
+        (*read)++;
+
+        bool changedTask = false;
+        bool conflict = false;
+        if (!applyChange(query, to, change, &changedTask, &conflict)) {
+            result->error = "应用变更失败：" + query.lastError().text();
+            return false;
+        }
+        if (changedTask) (*applied)++;
+        if (conflict) result->conflicts++;
+    }
+
+    return true;
+}
+
+bool TaskSync::applyChange(QSqlQuery &query, const QString &schema, const Change &change,
+                           bool *applied, bool *conflict)
+{
+    query.prepare(QString(R"(
+        INSERT OR IGNORE INTO %1.change_log
+            (origin_replica, origin_version, task_uuid, field, value, stamp)
+        VALUES (:replica, :originVersion, :uuid, :field, :value, :stamp)
+    )").arg(schema));
+    query.bindValue(":replica", change.originReplica);
+    query.bindValue(":originVersion", change.originVersion);
+    query.bindValue(":uuid", change.taskUuid);
+    query.bindValue(":field", change.field);
+    query.bindValue(":value", change.value);
+    query.bindValue(":stamp", change.stamp);
+    if (!query.exec()) return false;
+
+    // 已经有这条变更（经由其他副本收到过）
+    if (query.numRowsAffected() == 0) return true;
+
+    bool isDelete = change.field == "deleted";
+    if (!isDelete && !kSyncedFields.contains(change.field)) return true;
+
+    // 同一字段上存在更新的写入，则本条变更失效
+    query.prepare(QString(R"(
+        SELECT 1 FROM %1.change_log
+        WHERE task_uuid = :uuid AND field = :field
+          AND (stamp > :stamp OR (stamp = :stamp2 AND origin_replica > :replica))
+        LIMIT 1
+    )").arg(schema));
+    query.bindValue(":uuid", change.taskUuid);
+    query.bindValue(":field", change.field);
+    query.bindValue(":stamp", change.stamp);
+    query.bindValue(":stamp2", change.stamp);
+    query.bindValue(":replica", change.originReplica);
+    if (!query.exec()) return false;
+    if (query.next()) {
+        *conflict = true;
+        return true;
+    }
+
+    if (isDelete) {
+        query.prepare(QString("DELETE FROM %1.task_dependencies WHERE blocker_id IN "
+                              "(SELECT id FROM %1.tasks WHERE uuid = :uuid) OR blocked_id IN "
+                              "(SELECT id FROM %1.tasks WHERE uuid = :uuid2)").arg(schema));
+        query.bindValue(":uuid", change.taskUuid);
+        query.bindValue(":uuid2", change.taskUuid);
+        if (!query.exec()) return false;
+
+        query.prepare(QString("DELETE FROM %1.tasks WHERE uuid = :uuid").arg(schema));
+        query.bindValue(":uuid", change.taskUuid);
+        if (!query.exec()) return false;
+        *applied = query.numRowsAffected() > 0;
+
+        query.prepare(QString("DELETE FROM %1.tasks_archive WHERE uuid = :uuid").arg(schema));
+        query.bindValue(":uuid", change.taskUuid);
+        if (!query.exec()) return false;
+        *applied = *applied || query.numRowsAffected() > 0;
+        return true;
+    }
+
+    // 已删除的任务不再复活
+    query.prepare(QString("SELECT 1 FROM %1.change_log WHERE task_uuid = :uuid AND field = 'deleted' LIMIT 1")
+                      .arg(schema));
+    query.bindValue(":uuid", change.taskUuid);
+    if (!query.exec()) return false;
+    if (query.next()) return true;
+
+    if (change.field == "tags") {
+        return applyTags(query, schema, change, applied);
+    }
+
+    // 变更日志中的长描述已是压缩后的 BLOB，原样写入 description_z；文本按本地规则决定是否压缩存储
+    QString setClause = QString("%1 = :value").arg(change.field);
+    QVariant value = change.value;
+    QVariant compressed;
+    bool isDescription = change.field == "description";
+    if (isDescription) {
+        if (change.value.type() == QVariant::ByteArray) {
+            value = QVariant();
+            compressed = change.value;
+        } else {
+            DBManager::encodeDescription(change.value.toString(), &value, &compressed);
+        }
+        setClause = "description = :value, description_z = :compressed";
+    }
+
+    // 本地已归档的任务直接更新归档表，不要重新建行
+    query.prepare(QString("UPDATE %1.tasks_archive SET %2 WHERE uuid = :uuid").arg(schema, setClause));
+    query.bindValue(":value", value);
+    if (isDescription) query.bindValue(":compressed", compressed);
+    query.bindValue(":uuid", change.taskUuid);
+    if (!query.exec()) return false;
+    if (query.numRowsAffected() > 0) {
+        *applied = true;
+        return true;
+    }
+
+    // 对端新建的任务：先建空行，其余字段随后续变更填入
+    query.prepare(QString("INSERT OR IGNORE INTO %1.tasks (uuid, title, deadline) VALUES (:uuid, '', '')")
+                      .arg(schema));
+    query.bindValue(":uuid", change.taskUuid);
+    if (!query.exec()) return false;
+
+    query.prepare(QString("UPDATE %1.tasks SET %2 WHERE uuid = :uuid").arg(schema, setClause));
+    query.bindValue(":value", value);
+    if (isDescription) query.bindValue(":compressed", compressed);
+    query.bindValue(":uuid", change.taskUuid);
+    if (!query.exec()) return false;
+
+    *applied = true;
+    return true;
+}
+
+// 标签存于 task_tags 关联表，归档任务则存于 tasks_archive.tags
+bool TaskSync::applyTags(QSqlQuery &query, const QString &schema, const Change &change, bool *applied)
+{
+    query.prepare(QString("UPDATE %1.tasks_archive SET tags = :value WHERE uuid = :uuid").arg(schema));
+    query.bindValue(":value", change.value);
+    query.bindValue(":uuid", change.taskUuid);
+    if (!query.exec()) return false;
+    if (query.numRowsAffected() > 0) {
+        *applied = true;
+        return true;
+    }
+
+    query.prepare(QString("INSERT OR IGNORE INTO %1.tasks (uuid, title, deadline) VALUES (:uuid, '', '')")
+                      .arg(schema));
+    query.bindValue(":uuid", change.taskUuid);
+    if (!query.exec()) return false;
+
+    query.prepare(QString("SELECT id FROM %1.tasks WHERE uuid = :uuid").arg(schema));
+    query.bindValue(":uuid", change.taskUuid);
+    if (!query.exec() || !query.next()) return false;
+    int taskId = query.value(0).toInt();
+
+    if (!DBManager::writeTaskTags(query, schema, taskId, DBManager::splitTags(change.value.toString()))) {
+        return false;
+    }
+    *applied = true;
+    return true;
+}
+
+qint64 TaskSync::pulledVersion(QSqlQuery &query, const QString &schema, const QString &peerReplica)
+{
+    query.prepare(QString("SELECT pulled_version FROM %1.sync_peers WHERE peer_replica = :peer").arg(schema));
+    query.bindValue(":peer", peerReplica);
+    if (query.exec() && query.next()) {
+        return query.value(0).toLongLong();
+    }
+    return 0;
+}
+
+bool TaskSync::setPulledVersion(QSqlQuery &query, const QString &schema, const QString &peerReplica,
+                                qint64 version)
+{
+    query.prepare(QString("INSERT OR REPLACE INTO %1.sync_peers (peer_replica, pulled_version) "
+                          "VALUES (:peer, :version)").arg(schema));
+    query.bindValue(":peer", peerReplica);
+    query.bindValue(":version", version);
+    if (!query.exec()) {
+        qCritical() << "更新同步水位线失败：" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+qint64 TaskSync::maxVersion(QSqlQuery &query, const QString &schema)
+{
+    if (query.exec(QString("SELECT IFNULL(MAX(version), 0) FROM %1.change_log").arg(schema)) && query.next()) {
+        return query.value(0).toLongLong();
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#ifndef TASKSYNC_H
+#define TASKSYNC_H
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QVariant>
+
+// 基于变更日志的双向增量同步
+// 对端数据库通过ATTACH挂载到当前连接，只交换双方水位线之后的变更日志，
+// 冲突按字段以 (stamp, origin_replica) 最大者为准（后写者胜），删除记录为墓碑。
+class TaskSync
+{
+public:
+    struct Result {
+        int pulled = 0;         // 从对端读取的变更数
+        int pushed = 0;         // 写入对端的变更数
+        int appliedLocal = 0;   // 实际改动本地任务的变更数
+        int appliedRemote = 0;  // 实际改动对端任务的变更数
+        int conflicts = 0;      // 因时间戳较旧而被丢弃的变更数
+        QString error;
+    };
+
+    TaskSync(const QSqlDatabase &db, const QString &localReplica);
+
+    // db 为同步专用的连接；同步期间以 BEGIN IMMEDIATE 持有写锁，其他连接的写入等待同步提交
+    bool run(const QString &peerPath, Result *result);
+
+private:
+    struct Change {
+        QString originReplica;
+        qint64 originVersion = 0;
+        QString taskUuid;
+        QString field;
+        QVariant value;
+        qint64 stamp = 0;
+    };
+
+    bool transfer(const QString &from, const QString &to, const QString &fromReplica,
+                  const QString &toReplica, int *read, int *applied, Result *result);
+    bool applyChange(QSqlQuery &query, const QString &schema, const Change &change,
+                     bool *applied, bool *conflict);
+    bool applyTags(QSqlQuery &query, const QString &schema, const Change &change, bool *applied);
+    qint64 pulledVersion(QSqlQuery &query, const QString &schema, const QString &peerReplica);
+    bool setPulledVersion(QSqlQuery &query, const QString &schema, const QString &peerReplica,
+                          qint64 version);
+    qint64 maxVersion(QSqlQuery &query, const QString &schema);
+
+    QSqlDatabase m_db;
+    QString m_localReplica;
+};
+
+#endif // TASKSYNC_H
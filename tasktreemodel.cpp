@@ -0,0 +1,361 @@
+#include "tasktreemodel.h"
+#include "taskmodel.h"
+#include "dbmanager.h"
+#include <QColor>
+#include <QDebug>
+
+namespace {
+const int kPageSize = 200;
+// 一次同步的变化超过这个数量时直接重建，比逐行调整更快
+const int kResetThreshold = 2000;
+
+QString deadlineKey(const Task &task)
+{
+    return task.deadline.toString("yyyy-MM-dd HH:mm");
+}
+
+// 与 getChildTasks 的 ORDER BY deadline, id 一致
+bool keyLess(const QString &deadline, int id, const QString &otherDeadline, int otherId)
+{
+    return deadline != otherDeadline ? deadline < otherDeadline : id < otherId;
+}
+}
+
+TaskTreeModel::TaskTreeModel(TaskModel *source, QObject *parent)
+    : QAbstractItemModel(parent)
+{
+    m_rowVersion = DBManager::instance()->currentRowVersion();
+
+    m_syncTimer.setSingleShot(true);
+    m_syncTimer.setInterval(0);
+    connect(&m_syncTimer, &QTimer::timeout, this, &TaskTreeModel::sync);
+    connect(source, &TaskModel::taskDataChanged, &m_syncTimer, QOverload<>::of(&QTimer::start));
+}
+
+TaskTreeModel::~TaskTreeModel() = default;
+
+TaskTreeModel::Node *TaskTreeModel::nodeOf(const QModelIndex &index) const
+{
+    if (!index.isValid()) return const_cast<Node *>(&m_root);
+    return static_cast<Node *>(index.internalPointer());
+}
+
+QModelIndex TaskTreeModel::indexOf(const Node *node, int column) const
+{
+    if (node == &m_root) return QModelIndex();
+    return createIndex(node->row, column, const_cast<Node *>(node));
+}
+
+QModelIndex TaskTreeModel::index(int row, int column, const QModelIndex &parent) const
+{
+    const Node *node = nodeOf(parent);
+    if (row < 0 || row >= int(node->children.size()) || column < 0 || column >= ColumnCount)
+        return QModelIndex();
+    return createIndex(row, column, node->children[row].get());
+}
+
+QModelIndex TaskTreeModel::parent(const QModelIndex &child) const
+{
+    if (!child.isValid()) return QModelIndex();
+    return indexOf(nodeOf(child)->parent);
+}
+
+int TaskTreeModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) return 0;
+    return int(nodeOf(parent)->children.size());
+}
+
+int TaskTreeModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return ColumnCount;
+}
+
+bool TaskTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) return false;
+    // 未展开的节点按汇总判断，不为了显示展开箭头去读子任务
+    const Node *node = nodeOf(parent);
+    return !node->children.empty() || !node->complete;
+}
+
+QVariant TaskTreeModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) return QVariant();
+
+    const Node *node = nodeOf(index);
+    const Task &task = node->task;
+    const TaskRollup &rollup = node->rollup;
+
+    switch (role) {
+    case TaskIdRole:
+        return task.id;
+    case Qt::ForegroundRole:
+        if (task.isCompleted) return QColor(Qt::gray);
+        return QVariant();
+    case Qt::ToolTipRole:
+        if (index.column() == ColumnProgress && rollup.descendants > 0)
+            return QString("共 %1 个子任务（含各级），已完成 %2 个").arg(rollup.descendants).arg(rollup.completed);
+        return QVariant();
+    case Qt::DisplayRole:
+        break;
+    default:
+        return QVariant();
+    }
+
+    switch (index.column()) {
+    case ColumnTitle: return task.title;
+    case ColumnDeadline: return task.deadline.toString("yyyy-MM-dd HH:mm");
+    case ColumnPriority:
+        return (task.priority == 0 ? "低" : (task.priority == 1 ? "中" : "高"));
+    case ColumnProgress:
+        if (rollup.descendants == 0) return task.isCompleted ? "已完成" : "未完成";
+        return QString("%1/%2（%3%）").arg(rollup.completed).arg(rollup.descendants).arg(rollup.percentComplete());
+    case ColumnEarliest:
+        return rollup.earliestDeadline.isValid() ? rollup.earliestDeadline.toString("yyyy-MM-dd HH:mm") : QString();
+    default: return QVariant();
+    }
+}
+
+QVariant TaskTreeModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+        switch (section) {
+        case ColumnTitle: return "任务标题";
+        case ColumnDeadline: return "截止时间";
+        case ColumnPriority: return "优先级";
+        case ColumnProgress: return "进度";
+        case ColumnEarliest: return "子任务最早截止";
+        default: return QVariant();
+        }
+    }
+    return QVariant();
+}
+
+bool TaskTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) return false;
+    return !nodeOf(parent)->complete;
+}
+
+void TaskTreeModel::fetchMore(const QModelIndex &parent)
+{
+    Node *node = nodeOf(parent);
+    if (parent.column() > 0 || node->complete) return;
+
+    // 以已加载的最后一个子节点为锚点继续读取，只读这一层
+    const int parentId = node == &m_root ? -1 : node->task.id;
+    const QList<QPair<Task, TaskRollup>> page =
+        DBManager::instance()->getChildTasks(parentId, kPageSize, node->afterDeadline, node->afterId);
+    node->complete = page.size() < kPageSize;
+    if (page.isEmpty()) return;
+
+    // 同步还没赶上时，页中的任务可能仍挂在别处（被移动过来的），先从原位置摘下
+    for (const auto &entry : page) {
+        if (Node *stale = m_nodes.value(entry.first.id)) removeNode(stale);
+    }
+
+    const int first = int(node->children.size());
+    beginInsertRows(indexOf(node), first, first + page.size() - 1);
+    for (const auto &entry : page) {
+        std::unique_ptr<Node> child = createNode(entry.first, entry.second);
+        child->parent = node;
+        child->row = int(node->children.size());
+        node->children.push_back(std::move(child));
+    }
+    endInsertRows();
+
+    node->afterDeadline = deadlineKey(page.last().first);
+    node->afterId = page.last().first.id;
+    qDebug() << "加载子任务" << parentId << page.size() << "个，树中已加载" << m_nodes.size();
+}
+
+void TaskTreeModel::fetchMoreAround(const QModelIndex &index)
+{
+    for (QModelIndex parent = index.parent(); ; parent = parent.parent()) {
+        if (canFetchMore(parent)) {
+            fetchMore(parent);
+            return;
+        }
+        if (!parent.isValid()) return;
+    }
+}
+
+int TaskTreeModel::taskIdAt(const QModelIndex &index) const
+{
+    return index.isValid() ? nodeOf(index)->task.id : -1;
+}
+
+std::unique_ptr<TaskTreeModel::Node> TaskTreeModel::createNode(const Task &task, const TaskRollup &rollup)
+{
+    std::unique_ptr<Node> node(new Node);
+    node->task = task;
+    node->rollup = rollup;
+    node->complete = rollup.descendants == 0;
+    m_nodes.insert(task.id, node.get());
+    return node;
+}
+
+// 任务的位置是否落在父节点已加载的范围内（超出范围的留给后续分页读取）
+bool TaskTreeModel::isLoadedRange(const Node *parent, const Task &task) const
+{
+    if (parent->complete) return true;
+    return keyLess(deadlineKey(task), task.id, parent->afterDeadline, parent->afterId);
+}
+
+// 按新的排序键在父节点中的插入位置，skip 为正在移动的节点本身（不参与比较）
+int TaskTreeModel::insertPosition(const Node *parent, const Task &task, const Node *skip) const
+{
+    const QString key = deadlineKey(task);
+    int position = 0;
+    for (const auto &child : parent->children) {
+        if (child.get() == skip) continue;
+        if (!keyLess(deadlineKey(child->task), child->task.id, key, task.id)) break;
+        ++position;
+    }
+    return position;
+}
+
+// 把一条变更放到树中：原地更新、移动、插入或移出已加载范围。
+// 同一批变更还没全部应用时，目标父节点可能暂时还在本节点的子树里，这时返回 false 留到最后再放
+bool TaskTreeModel::placeTask(const Task &task, const TaskRollup &rollup)
+{
+    Node *node = m_nodes.value(task.id);
+    Node *target = task.parentId == -1 ? &m_root : m_nodes.value(task.parentId);
+
+    if (!target || !isLoadedRange(target, task)) {
+        // 新位置还没加载，等展开或滚动到那里时再读
+        if (node) removeNode(node);
+        return true;
+    }
+
+    if (node) {
+        for (const Node *ancestor = target; ancestor; ancestor = ancestor->parent) {
+            if (ancestor == node) {
+                removeNode(node);
+                return false;
+            }
+        }
+    }
+
+    const int position = insertPosition(target, task, node);
+
+    if (!node) {
+        beginInsertRows(indexOf(target), position, position);
+        std::unique_ptr<Node> child = createNode(task, rollup);
+        child->parent = target;
+        target->children.insert(target->children.begin() + position, std::move(child));
+        reindexChildren(target, position);
+        endInsertRows();
+        return true;
+    }
+
+    Node *source = node->parent;
+    const int row = node->row;
+    node->task = task;
+    if (source == target && row == position) return true;
+
+    // 用 move 而不是删除再插入，视图中的展开状态和选中项随节点一起移动
+    const int destination = (source == target && position > row) ? position + 1 : position;
+    beginMoveRows(indexOf(source), row, row, indexOf(target), destination);
+    std::unique_ptr<Node> moving = std::move(source->children[row]);
+    source->children.erase(source->children.begin() + row);
+    moving->parent = target;
+    target->children.insert(target->children.begin() + position, std::move(moving));
+    reindexChildren(source, row);
+    reindexChildren(target, source == target ? qMin(row, position) : position);
+    endMoveRows();
+    return true;
+}
+
+void TaskTreeModel::removeNode(Node *node)
+{
+    Node *parent = node->parent;
+    const int row = node->row;
+    beginRemoveRows(indexOf(parent), row, row);
+    forgetSubtree(node);
+    parent->children.erase(parent->children.begin() + row);
+    reindexChildren(parent, row);
+    endRemoveRows();
+}
+
+void TaskTreeModel::forgetSubtree(const Node *node)
+{
+    m_nodes.remove(node->task.id);
+    for (const auto &child : node->children) {
+        forgetSubtree(child.get());
+    }
+}
+
+void TaskTreeModel::reindexChildren(Node *parent, int fromRow)
+{
+    for (int i = fromRow; i < int(parent->children.size()); ++i) {
+        parent->children[i]->row = i;
+    }
+}
+
+void TaskTreeModel::sync()
+{
+    QList<Task> changed;
+    QList<int> deletedIds;
+    qint64 newVersion = m_rowVersion;
+    if (!DBManager::instance()->getChangesSince(m_rowVersion, &changed, &deletedIds, &newVersion)) {
+        qWarning() << "任务树同步失败，保留当前内容";
+        return;
+    }
+    m_rowVersion = newVersion;
+    if (changed.isEmpty() && deletedIds.isEmpty()) return;
+
+    if (changed.size() + deletedIds.size() > kResetThreshold) {
+        reset();
+        return;
+    }
+
+    // 先删除：被删任务的子任务已被提升一级，随后作为变更重新放置
+    for (int taskId : deletedIds) {
+        if (Node *node = m_nodes.value(taskId)) removeNode(node);
+    }
+
+    // 触发器更新汇总时会一并更新祖先的行版本，所以变更中已包含所有汇总有变化的任务
+    QList<int> changedIds;
+    changedIds.reserve(changed.size());
+    for (const Task &task : changed) {
+        changedIds.append(task.id);
+    }
+    const QHash<int, TaskRollup> rollups = DBManager::instance()->getRollups(changedIds);
+
+    QList<Task> deferred;
+    for (const Task &task : changed) {
+        if (!placeTask(task, rollups.value(task.id))) deferred.append(task);
+    }
+    for (const Task &task : deferred) {
+        placeTask(task, rollups.value(task.id));
+    }
+
+    for (int taskId : changedIds) {
+        Node *node = m_nodes.value(taskId);
+        if (!node) continue;
+        node->rollup = rollups.value(taskId);
+        // 没有加载子节点时按汇总决定是否还需要读取（子任务全部移走，或从别处移来了整棵子树）
+        if (node->children.empty()) {
+            node->complete = node->rollup.descendants == 0;
+            node->afterDeadline.clear();
+            node->afterId = -1;
+        }
+        emit dataChanged(indexOf(node), indexOf(node, ColumnCount - 1));
+    }
+}
+
+void TaskTreeModel::reset()
+{
+    beginResetModel();
+    m_nodes.clear();
+    m_root.children.clear();
+    m_root.complete = false;
+    m_root.afterDeadline.clear();
+    m_root.afterId = -1;
+    m_rowVersion = DBManager::instance()->currentRowVersion();
+    endResetModel();
+    qDebug() << "任务树已重建";
+}
@@ -0,0 +1,85 @@
+#ifndef TASKTREEMODEL_H
+#define TASKTREEMODEL_H
+
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QTimer>
+#include <memory>
+#include <vector>
+#include "task.h"
+
+class TaskModel;
+
+// 按父子关系（parent_id）展示任务的树模型，与 TaskModel 并列使用。
+// 每层按截止时间排序，节点展开或滚动到底部时才按页读取它的直接子任务，
+// 进度和最早截止时间取自数据库中由触发器维护的汇总，不需要加载子树。
+// TaskModel 有变化时按行版本读取变更，只调整已加载的节点
+class TaskTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    enum TreeColumn {
+        ColumnTitle = 0,
+        ColumnDeadline,
+        ColumnPriority,
+        ColumnProgress,         // 子任务完成情况（叶子任务显示自身状态）
+        ColumnEarliest,         // 未完成子任务中最早的截止时间
+        ColumnCount
+    };
+
+    enum TreeRole {
+        TaskIdRole = Qt::UserRole + 1
+    };
+
+    explicit TaskTreeModel(TaskModel *source, QObject *parent = nullptr);
+    ~TaskTreeModel() override;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    // 视图只会自动加载顶层的下一页：为 index 所在的最内层尚未加载完的父节点加载下一页
+    void fetchMoreAround(const QModelIndex &index);
+
+    int taskIdAt(const QModelIndex &index) const;
+    int loadedCount() const { return m_nodes.size(); }
+
+private slots:
+    void sync();
+
+private:
+    struct Node {
+        Task task;
+        TaskRollup rollup;
+        Node *parent = nullptr;
+        int row = 0;                                // 在父节点 children 中的位置
+        std::vector<std::unique_ptr<Node>> children; // 已加载的子节点，按 (截止时间, ID) 排序
+        bool complete = false;                      // 子节点已全部加载
+        QString afterDeadline;                      // 已加载的最后一个子节点，下一页从这里继续
+        int afterId = -1;
+    };
+
+    Node *nodeOf(const QModelIndex &index) const;
+    QModelIndex indexOf(const Node *node, int column = 0) const;
+    std::unique_ptr<Node> createNode(const Task &task, const TaskRollup &rollup);
+    bool isLoadedRange(const Node *parent, const Task &task) const;
+    int insertPosition(const Node *parent, const Task &task, const Node *skip) const;
+    bool placeTask(const Task &task, const TaskRollup &rollup);
+    void removeNode(Node *node);
+    void forgetSubtree(const Node *node);
+    void reindexChildren(Node *parent, int fromRow);
+    void reset();
+
+    Node m_root;
+    QHash<int, Node *> m_nodes;     // 已加载的节点
+    qint64 m_rowVersion = 0;        // 已同步到的数据库行版本号
+    QTimer m_syncTimer;             // 合并同一轮事件循环中的多次变化通知
+};
+
+#endif // TASKTREEMODEL_H
@@ -0,0 +1,68 @@
+#include "taskwritequeue.h"
+#include "dbmanager.h"
+#include <QDebug>
+
+namespace {
+const int kFlushDelayMs = 300;   // 第一次修改后多久提交
+}
+
+TaskWriteQueue::TaskWriteQueue(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &TaskWriteQueue::flush);
+}
+
+TaskWriteQueue::~TaskWriteQueue()
+{
+    if (!isEmpty()) {
+        // 接收方可能已在析构，不再发出信号
+        qDebug() << "退出前提交" << m_order.size() << "个待写入任务";
+        blockSignals(true);
+        flush();
+    }
+}
+
+void TaskWriteQueue::enqueueCompletion(int taskId, bool completed, const Task &original)
+{
+    auto it = m_pending.find(taskId);
+    if (it != m_pending.end()) {
+        it->completed = completed;
+    } else {
+        m_pending.insert(taskId, Pending{completed, original});
+        m_order.append(taskId);
+    }
+
+    // 不随后续修改顺延，连续操作时也能在固定延迟内落盘
+    if (!m_timer.isActive()) {
+        m_timer.start(kFlushDelayMs);
+    }
+}
+
+bool TaskWriteQueue::flush()
+{
+    m_timer.stop();
+    if (m_order.isEmpty()) return true;
+
+    QList<QPair<int, bool>> states;
+    QList<Task> originals;
+    states.reserve(m_order.size());
+    originals.reserve(m_order.size());
+    for (int taskId : m_order) {
+        const Pending &pending = m_pending.value(taskId);
+        states.append(qMakePair(taskId, pending.completed));
+        originals.append(pending.original);
+    }
+    const QList<int> taskIds = m_order;
+    m_pending.clear();
+    m_order.clear();
+
+    QString error;
+    if (!DBManager::instance()->updateCompletion(states, &error)) {
+        emit flushFailed(originals, error);
+        return false;
+    }
+
+    emit flushed(taskIds);
+    return true;
+}
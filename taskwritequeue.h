@@ -0,0 +1,42 @@
+#ifndef TASKWRITEQUEUE_H
+#define TASKWRITEQUEUE_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+#include "task.h"
+
+// 延迟写入队列（write-behind）
+// 模型先更新内存中的任务，写入排队；同一任务的多次修改合并为最后一次，
+// 短暂延迟后在一个事务中批量提交。只排队被修改的列（完成状态），提交时不会用内存中的旧值
+// 覆盖排队期间其他进程或同步写入的其他字段。提交失败时给出修改前的任务，由模型回滚。
+class TaskWriteQueue : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TaskWriteQueue(QObject *parent = nullptr);
+    ~TaskWriteQueue() override;
+
+    // original 为任务在第一次排队修改前的状态（同一任务再次排队时忽略）
+    void enqueueCompletion(int taskId, bool completed, const Task &original);
+    bool flush();       // 立即提交；无待写入时直接返回true
+    bool isEmpty() const { return m_order.isEmpty(); }
+    int size() const { return m_order.size(); }
+
+signals:
+    void flushed(const QList<int> &taskIds);
+    void flushFailed(const QList<Task> &originals, const QString &error);
+
+private:
+    struct Pending {
+        bool completed;
+        Task original;
+    };
+
+    QHash<int, Pending> m_pending;
+    QList<int> m_order;     // 按第一次修改的顺序写入
+    QTimer m_timer;
+};
+
+#endif // TASKWRITEQUEUE_H
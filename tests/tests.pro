@@ -0,0 +1,4 @@
+TEMPLATE = subdirs
+
+# 每个测试一个工程，make check 依次运行
+SUBDIRS += tst_paging
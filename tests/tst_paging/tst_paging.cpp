@@ -0,0 +1,187 @@
+#include <QtTest>
+#include <QSet>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include "dbmanager.h"
+#include "taskmodel.h"
+#include "tasktreemodel.h"
+
+// 键集分页：第一页不带锚点，之后每页从上一页最后一行继续，按 (截止时间, ID) 不漏行、不重复
+class TestPaging : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void exportPagesCoverAllTasks_data();
+    void exportPagesCoverAllTasks();
+    void benchmarkExportPaging();
+    void childPagesStartWithoutAnchor();
+    void treeLoadsFirstPage();
+
+private:
+    int taskCount() const;
+    int addParentWithChildren(int childCount);
+
+    static constexpr int kPageSize = 200;
+    QTemporaryDir m_dir;
+};
+
+void TestPaging::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    DBManager *db = DBManager::instance();
+    db->setDatabasePath(m_dir.filePath("paging.db"));
+    QVERIFY(db->initDatabase());
+
+    // 每三个任务共用一个截止时间，跨页的锚点要靠 ID 区分
+    const QDateTime base(QDate(2024, 1, 1), QTime(9, 0));
+    for (int i = 0; i < 2 * kPageSize + 50; ++i) {
+        Task task;
+        task.title = QString("任务%1").arg(i);
+        task.deadline = base.addSecs(60 * ((i * 7) % 150));
+        task.description = QString("描述%1").arg(i);
+        QVERIFY(db->addTask(task));
+    }
+}
+
+int TestPaging::taskCount() const
+{
+    QSqlQuery query;
+    if (!query.exec("SELECT COUNT(*) FROM tasks") || !query.next()) return -1;
+    return query.value(0).toInt();
+}
+
+void TestPaging::exportPagesCoverAllTasks_data()
+{
+    QTest::addColumn<bool>("withDescriptions");
+    QTest::newRow("列表") << false;
+    QTest::newRow("含描述") << true;
+}
+
+void TestPaging::exportPagesCoverAllTasks()
+{
+    QFETCH(bool, withDescriptions);
+
+    QSqlQuery query;
+    QString afterDeadline;
+    int afterId = -1;
+    QList<Task> all;
+    QSet<int> seen;
+    for (int pageNo = 0; ; ++pageNo) {
+        QList<Task> page;
+        QVERIFY2(DBManager::fetchTaskPage(query, kPageSize, withDescriptions, &afterDeadline, &afterId, &page),
+                 qPrintable(query.lastError().text()));
+        if (pageNo == 0) {
+            QCOMPARE(page.size(), kPageSize);    // 第一页不能因为空锚点而为空
+        }
+        if (page.isEmpty()) break;
+        QVERIFY(page.size() <= kPageSize);
+        for (const Task &task : page) {
+            QVERIFY2(!seen.contains(task.id), qPrintable(QString("任务 %1 重复出现").arg(task.id)));
+            seen.insert(task.id);
+            QCOMPARE(task.descriptionLoaded, withDescriptions);
+            if (withDescriptions) {
+                QCOMPARE(task.description, "描述" + task.title.mid(2));
+            }
+            all.append(task);
+        }
+    }
+
+    QCOMPARE(all.size(), taskCount());
+    for (int i = 1; i < all.size(); ++i) {
+        const Task &prev = all.at(i - 1);
+        const Task &cur = all.at(i);
+        QVERIFY(prev.deadline < cur.deadline || (prev.deadline == cur.deadline && prev.id < cur.id));
+    }
+}
+
+void TestPaging::benchmarkExportPaging()
+{
+    QSqlQuery query;
+    QBENCHMARK {
+        QString afterDeadline;
+        int afterId = -1;
+        int rows = 0;
+        QList<Task> page;
+        do {
+            page.clear();
+            QVERIFY(DBManager::fetchTaskPage(query, kPageSize, false, &afterDeadline, &afterId, &page));
+            rows += page.size();
+        } while (!page.isEmpty());
+        QCOMPARE(rows, taskCount());
+    }
+}
+
+// 截止时间早于其他任务的顶层任务，带 childCount 个子任务，返回它的 ID
+int TestPaging::addParentWithChildren(int childCount)
+{
+    DBManager *db = DBManager::instance();
+    Task parent;
+    parent.title = "父任务";
+    parent.deadline = QDateTime(QDate(2023, 12, 1), QTime(9, 0));
+    if (!db->addTask(parent)) return -1;
+
+    QSqlQuery query;
+    if (!query.exec("SELECT MAX(id) FROM tasks") || !query.next()) return -1;
+    const int parentId = query.value(0).toInt();
+
+    for (int i = 0; i < childCount; ++i) {
+        Task child;
+        child.title = QString("子任务%1").arg(i);
+        child.deadline = parent.deadline.addSecs(3600 * (i % 40));
+        child.parentId = parentId;
+        if (!db->addTask(child)) return -1;
+    }
+    return parentId;
+}
+
+void TestPaging::childPagesStartWithoutAnchor()
+{
+    const int parentId = addParentWithChildren(kPageSize + 50);
+    QVERIFY(parentId > 0);
+    DBManager *db = DBManager::instance();
+
+    const auto roots = db->getChildTasks(-1, kPageSize);
+    QCOMPARE(roots.size(), kPageSize);
+    QCOMPARE(roots.first().first.id, parentId);
+    QCOMPARE(roots.first().second.descendants, kPageSize + 50);
+
+    const auto first = db->getChildTasks(parentId, kPageSize);
+    QCOMPARE(first.size(), kPageSize);
+    const Task &last = first.last().first;
+    const auto second = db->getChildTasks(parentId, kPageSize, last.deadline.toString("yyyy-MM-dd HH:mm"), last.id);
+    QCOMPARE(second.size(), 50);
+    for (const auto &entry : second) {
+        QCOMPARE(entry.first.parentId, parentId);
+    }
+}
+
+void TestPaging::treeLoadsFirstPage()
+{
+    TaskModel source;
+    TaskTreeModel tree(&source);
+
+    // 顶层第一页
+    QVERIFY(tree.canFetchMore(QModelIndex()));
+    tree.fetchMore(QModelIndex());
+    QCOMPARE(tree.rowCount(), kPageSize);
+    QVERIFY(tree.canFetchMore(QModelIndex()));
+
+    // 展开父任务：两页读完它的子任务
+    const QModelIndex parent = tree.index(0, TaskTreeModel::ColumnTitle);
+    QCOMPARE(tree.data(parent).toString(), QString("父任务"));
+    QVERIFY(tree.hasChildren(parent));
+    QVERIFY(tree.canFetchMore(parent));
+    tree.fetchMore(parent);
+    QCOMPARE(tree.rowCount(parent), kPageSize);
+    tree.fetchMore(parent);
+    QCOMPARE(tree.rowCount(parent), kPageSize + 50);
+    QVERIFY(!tree.canFetchMore(parent));
+    QCOMPARE(tree.loadedCount(), 2 * kPageSize + 50);
+}
+
+QTEST_GUILESS_MAIN(TestPaging)
+
+#include "tst_paging.moc"
@@ -0,0 +1,15 @@
+QT       += core gui widgets sql concurrent testlib
+CONFIG += c++17 testcase console
+CONFIG -= app_bundle
+TARGET = tst_paging
+TEMPLATE = app
+
+SOURCES += tst_paging.cpp
+
+# 被测代码：主程序除主窗口外的全部源文件
+include(../../zhsj.pri)
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# 设置UTF-8编码
+win32: QMAKE_CXXFLAGS += /utf-8
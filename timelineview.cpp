@@ -0,0 +1,390 @@
+#include "timelineview.h"
+#include "taskmodel.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHelpEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTimer>
+#include <QToolTip>
+#include <QWheelEvent>
+
+namespace {
+const int kHeaderHeight = 24;
+const int kLaneHeight = 20;
+const int kLanePadding = 3;
+const int kMinBarWidth = 6;                     // 缩小时每个任务至少占的像素，也是查询的分辨率
+const qint64 kTaskSpan = 3600 * 1000;           // 横条长度：截止前一小时
+const qint64 kLaneGap = 10 * 60 * 1000;         // 同一行相邻任务之间至少间隔10分钟
+const qint64 kMargin = 24 * 3600 * 1000LL;      // 时间轴两端留白
+const double kMinMsPerPixel = 1000.0;           // 最大放大：每像素1秒
+const double kMaxMsPerPixel = 24 * 3600 * 1000.0; // 最大缩小：每像素1天
+const double kZoomStep = 1.25;
+}
+
+TimelineView::TimelineView(QWidget *parent)
+    : QAbstractScrollArea(parent)
+{
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    viewport()->setMouseTracking(true);
+    viewport()->setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void TimelineView::setModel(TaskModel *model)
+{
+    if (m_model) {
+        disconnect(m_model, nullptr, this, nullptr);
+    }
+    m_model = model;
+    if (m_model) {
+        connect(m_model, &QAbstractItemModel::modelReset, this, &TimelineView::scheduleRebuild);
+        connect(m_model, &QAbstractItemModel::rowsInserted, this, &TimelineView::scheduleRebuild);
+        connect(m_model, &QAbstractItemModel::rowsRemoved, this, &TimelineView::scheduleRebuild);
+        connect(m_model, &QAbstractItemModel::layoutChanged, this, &TimelineView::scheduleRebuild);
+        connect(m_model, &QAbstractItemModel::dataChanged, this, &TimelineView::onDataChanged);
+    }
+    rebuildIndex();
+}
+
+// 多个行变化合并为一次重建；视图不可见时推迟到显示时再建
+void TimelineView::scheduleRebuild()
+{
+    if (m_rebuildPending) return;
+    m_rebuildPending = true;
+    QTimer::singleShot(0, this, [this]() {
+        if (m_rebuildPending && isVisible()) rebuildIndex();
+    });
+}
+
+// 只有截止时间或延期区间变化才需要重新布局，其余变化（完成状态、标题等）直接重绘
+void TimelineView::onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    if (!m_model || m_rebuildPending) return;
+
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        int taskId = m_model->taskIdAt(row);
+        IntervalIndex::Interval interval;
+        bool hasInterval = intervalOf(m_model->getTaskById(taskId), &interval);
+        auto it = m_intervalById.constFind(taskId);
+        if (hasInterval != (it != m_intervalById.constEnd())
+            || (hasInterval && (it->first != interval.start || it->second != interval.end))) {
+            scheduleRebuild();
+            return;
+        }
+    }
+    viewport()->update();
+}
+
+bool TimelineView::intervalOf(const Task &task, IntervalIndex::Interval *interval) const
+{
+    if (task.id == -1 || !task.deadline.isValid()) return false;
+
+    qint64 deadline = task.deadline.toMSecsSinceEpoch();
+    interval->id = task.id;
+    interval->start = deadline - kTaskSpan;
+    interval->end = deadline;
+    if (!task.isCompleted && m_model->dependencyGraph().isLate(task.id)) {
+        interval->end = qMax(deadline, m_model->dependencyGraph().earliestFinish(task.id).toMSecsSinceEpoch());
+    }
+    return true;
+}
+
+void TimelineView::rebuildIndex()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // 重建前后保持视口左边缘的时间不变
+    bool hadLayout = m_index.size() > 0;
+    qint64 leftTime = hadLayout ? timeAt(0)
+                                : QDateTime::currentMSecsSinceEpoch()
+                                      - qint64(viewport()->width() / 4 * m_msPerPixel);
+
+    m_rebuildPending = false;
+    m_intervalById.clear();
+    QVector<IntervalIndex::Interval> intervals;
+    if (m_model) {
+        const QList<Task> tasks = m_model->getAllTasks();
+        intervals.reserve(tasks.size());
+        m_intervalById.reserve(tasks.size());
+        for (const Task &task : tasks) {
+            IntervalIndex::Interval interval;
+            if (intervalOf(task, &interval)) {
+                intervals.append(interval);
+                m_intervalById.insert(task.id, qMakePair(interval.start, interval.end));
+            }
+        }
+    }
+    m_index.build(intervals, kLaneGap);
+
+    m_origin = (m_index.size() > 0 ? qMin(m_index.minStart(), leftTime) : leftTime) - kMargin;
+    updateScrollBars();
+    horizontalScrollBar()->setValue(int((leftTime - m_origin) / m_msPerPixel));
+    viewport()->update();
+
+    qDebug() << "时间线布局完成：" << m_index.size() << "个任务，" << m_index.laneCount()
+             << "行，耗时" << timer.elapsed() << "ms";
+}
+
+void TimelineView::updateScrollBars()
+{
+    // 内容宽度受 int 范围限制，时间跨度很大时限制最大放大倍数
+    qint64 span = qMax(m_index.maxEnd(), QDateTime::currentMSecsSinceEpoch()) + kMargin - m_origin;
+    m_msPerPixel = qMax(m_msPerPixel, double(span) / 1.0e9);
+
+    int contentWidth = int(span / m_msPerPixel);
+    horizontalScrollBar()->setRange(0, qMax(0, contentWidth - viewport()->width()));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setSingleStep(20);
+
+    int visibleLanes = qMax(1, (viewport()->height() - kHeaderHeight) / kLaneHeight);
+    verticalScrollBar()->setRange(0, qMax(0, m_index.laneCount() - visibleLanes));
+    verticalScrollBar()->setPageStep(visibleLanes);
+    verticalScrollBar()->setSingleStep(1);
+}
+
+void TimelineView::setMsPerPixel(double msPerPixel, int anchorX)
+{
+    qint64 anchorTime = timeAt(anchorX);
+    m_msPerPixel = qBound(kMinMsPerPixel, msPerPixel, kMaxMsPerPixel);
+    updateScrollBars();
+    horizontalScrollBar()->setValue(int((anchorTime - m_origin) / m_msPerPixel) - anchorX);
+    viewport()->update();
+}
+
+void TimelineView::scrollToTask(int taskId)
+{
+    int lane = m_index.laneOf(taskId);
+    auto it = m_intervalById.constFind(taskId);
+    if (lane == -1 || it == m_intervalById.constEnd()) return;
+
+    int visibleLanes = qMax(1, (viewport()->height() - kHeaderHeight) / kLaneHeight);
+    verticalScrollBar()->setValue(lane - visibleLanes / 2);
+    horizontalScrollBar()->setValue(int((it->first - m_origin) / m_msPerPixel) - viewport()->width() / 2);
+}
+
+qint64 TimelineView::timeAt(int x) const
+{
+    return m_origin + qint64((horizontalScrollBar()->value() + x) * m_msPerPixel);
+}
+
+int TimelineView::xOf(qint64 time) const
+{
+    double x = (time - m_origin) / m_msPerPixel - horizontalScrollBar()->value();
+    // 远在视口外的坐标截断，避免整数溢出
+    return int(qBound(-10000.0, x, viewport()->width() + 10000.0));
+}
+
+int TimelineView::laneAt(int y) const
+{
+    if (y < kHeaderHeight) return -1;
+    return verticalScrollBar()->value() + (y - kHeaderHeight) / kLaneHeight;
+}
+
+int TimelineView::taskAt(const QPoint &pos) const
+{
+    const IntervalIndex::Interval *interval =
+        m_index.itemAt(laneAt(pos.y()), timeAt(pos.x()), qint64(kMinBarWidth * m_msPerPixel / 2));
+    return interval ? interval->id : -1;
+}
+
+void TimelineView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(viewport());
+    painter.fillRect(viewport()->rect(), palette().base());
+    if (!m_model) return;
+
+    const int width = viewport()->width();
+    const qint64 from = timeAt(0);
+    const qint64 to = timeAt(width);
+    paintHeader(painter, from, to);
+
+    static const QColor completedColor(200, 200, 200);
+    static const QColor blockedColor(255, 140, 0);
+    static const QColor highColor(220, 60, 60);
+    static const QColor normalColor(70, 130, 180);
+    static const QColor lowColor(140, 170, 200);
+    static const QColor lateColor(255, 0, 0, 110);
+
+    const QFontMetrics metrics(font());
+    const qint64 resolution = qint64(kMinBarWidth * m_msPerPixel);
+    const int firstLane = verticalScrollBar()->value();
+    const int lastLane = qMin(m_index.laneCount() - 1, laneAt(viewport()->height()));
+    const TaskDependencyGraph &graph = m_model->dependencyGraph();
+
+    painter.setClipRect(0, kHeaderHeight, width, viewport()->height() - kHeaderHeight);
+    QVector<IntervalIndex::Interval> visible;
+    for (int lane = firstLane; lane <= lastLane; ++lane) {
+        visible.clear();
+        m_index.query(lane, from, to, resolution, &visible);
+        int top = kHeaderHeight + (lane - firstLane) * kLaneHeight + kLanePadding;
+        int height = kLaneHeight - 2 * kLanePadding;
+
+        for (const IntervalIndex::Interval &interval : visible) {
+            Task task = m_model->getTaskById(interval.id);
+            if (task.id == -1) continue;   // 已删除，等待重建
+
+            qint64 deadline = task.deadline.toMSecsSinceEpoch();
+            int x1 = xOf(interval.start);
+            int xDeadline = qMax(xOf(deadline), x1 + kMinBarWidth);
+            int x2 = qMax(xOf(interval.end), xDeadline);
+
+            QColor color;
+            if (task.isCompleted) color = completedColor;
+            else if (graph.isBlocked(task.id)) color = blockedColor;
+            else if (task.priority == 2) color = highColor;
+            else if (task.priority == 1) color = normalColor;
+            else color = lowColor;
+
+            QRect bar(x1, top, xDeadline - x1, height);
+            painter.fillRect(bar, color);
+            if (x2 > xDeadline) {
+                painter.fillRect(QRect(xDeadline, top, x2 - xDeadline, height), lateColor);
+            }
+            if (bar.width() > 40) {
+                painter.setPen(task.isCompleted ? Qt::darkGray : Qt::white);
+                painter.drawText(bar.adjusted(3, 0, -2, 0), Qt::AlignVCenter | Qt::AlignLeft,
+                                 metrics.elidedText(task.title, Qt::ElideRight, bar.width() - 5));
+            }
+        }
+    }
+
+    // 当前时间线
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now >= from && now <= to) {
+        painter.setPen(QPen(Qt::red, 1));
+        int x = xOf(now);
+        painter.drawLine(x, kHeaderHeight, x, viewport()->height());
+    }
+}
+
+// 顶部刻度：根据缩放级别选择刻度间隔，使相邻刻度至少相距约90像素
+void TimelineView::paintHeader(QPainter &painter, qint64 from, qint64 to)
+{
+    static const qint64 hour = 3600 * 1000LL;
+    static const qint64 day = 24 * hour;
+    static const qint64 steps[] = {
+        hour, 2 * hour, 3 * hour, 6 * hour, 12 * hour,
+        day, 2 * day, 7 * day, 14 * day, 30 * day, 91 * day, 365 * day
+    };
+
+    qint64 step = steps[sizeof(steps) / sizeof(steps[0]) - 1];
+    for (qint64 candidate : steps) {
+        if (candidate / m_msPerPixel >= 90) {
+            step = candidate;
+            break;
+        }
+    }
+    const char *format = step < day ? "MM-dd HH:mm" : (step < 30 * day ? "yyyy-MM-dd" : "yyyy-MM");
+
+    painter.fillRect(0, 0, viewport()->width(), kHeaderHeight, palette().window());
+    // 刻度对齐到本地时间
+    qint64 offset = QDateTime::currentDateTime().offsetFromUtc() * 1000LL;
+    qint64 tick = ((from + offset) / step) * step - offset;
+    for (; tick <= to; tick += step) {
+        int x = xOf(tick);
+        painter.setPen(palette().mid().color());
+        painter.drawLine(x, kHeaderHeight, x, viewport()->height());
+        painter.setPen(palette().windowText().color());
+        painter.drawText(x + 3, 0, 120, kHeaderHeight, Qt::AlignVCenter | Qt::AlignLeft,
+                         QDateTime::fromMSecsSinceEpoch(tick).toString(format));
+    }
+    painter.setPen(palette().mid().color());
+    painter.drawLine(0, kHeaderHeight - 1, viewport()->width(), kHeaderHeight - 1);
+}
+
+void TimelineView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+// Ctrl+滚轮以鼠标位置为中心缩放，Shift+滚轮横向平移
+void TimelineView::wheelEvent(QWheelEvent *event)
+{
+    int delta = event->angleDelta().y();
+    if (event->modifiers() & Qt::ControlModifier) {
+        if (delta != 0) {
+            setMsPerPixel(delta > 0 ? m_msPerPixel / kZoomStep : m_msPerPixel * kZoomStep,
+                          int(event->position().x()));
+        }
+        event->accept();
+    } else if (event->modifiers() & Qt::ShiftModifier) {
+        horizontalScrollBar()->setValue(horizontalScrollBar()->value() - delta);
+        event->accept();
+    } else {
+        QAbstractScrollArea::wheelEvent(event);
+    }
+}
+
+void TimelineView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        m_dragging = true;
+        m_dragStart = event->pos();
+        m_dragScroll = QPoint(horizontalScrollBar()->value(), verticalScrollBar()->value());
+        viewport()->setCursor(Qt::ClosedHandCursor);
+    }
+    QAbstractScrollArea::mousePressEvent(event);
+}
+
+void TimelineView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (m_dragging) {
+        QPoint delta = event->pos() - m_dragStart;
+        horizontalScrollBar()->setValue(m_dragScroll.x() - delta.x());
+        verticalScrollBar()->setValue(m_dragScroll.y() - delta.y() / kLaneHeight);
+    }
+    QAbstractScrollArea::mouseMoveEvent(event);
+}
+
+void TimelineView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton && m_dragging) {
+        m_dragging = false;
+        viewport()->unsetCursor();
+    }
+    QAbstractScrollArea::mouseReleaseEvent(event);
+}
+
+void TimelineView::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    int taskId = taskAt(event->pos());
+    if (taskId != -1) {
+        emit taskActivated(taskId);
+    }
+}
+
+bool TimelineView::viewportEvent(QEvent *event)
+{
+    if (event->type() == QEvent::Show && m_rebuildPending) {
+        rebuildIndex();
+    } else if (event->type() == QEvent::ToolTip && m_model) {
+        QHelpEvent *helpEvent = static_cast<QHelpEvent *>(event);
+        Task task = m_model->getTaskById(taskAt(helpEvent->pos()));
+        if (task.id == -1) {
+            QToolTip::hideText();
+            event->ignore();
+            return true;
+        }
+
+        QString text = QString("%1\n截止时间：%2").arg(task.title, task.deadline.toString("yyyy-MM-dd HH:mm"));
+        if (!task.isCompleted && m_model->dependencyGraph().isLate(task.id)) {
+            text += QString("\n预计最早完成：%1（晚于截止时间）")
+                        .arg(m_model->dependencyGraph().earliestFinish(task.id).toString("yyyy-MM-dd HH:mm"));
+        }
+        QToolTip::showText(helpEvent->globalPos(), text, viewport());
+        return true;
+    }
+    return QAbstractScrollArea::viewportEvent(event);
+}
+
+void TimelineView::scrollContentsBy(int dx, int dy)
+{
+    Q_UNUSED(dx);
+    Q_UNUSED(dy);
+    viewport()->update();
+}
@@ -0,0 +1,67 @@
+#ifndef TIMELINEVIEW_H
+#define TIMELINEVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QHash>
+#include <QPair>
+#include <QPoint>
+#include "intervalindex.h"
+#include "task.h"
+
+class TaskModel;
+
+// 时间线（甘特图式）视图：横轴为时间，任务按截止时间排成互不重叠的行。
+// 每个任务画为截止前一小时到截止时间的横条；受前置任务拖累而延期的部分（截止时间到预计最早完成）另画红色。
+// 绘制时只向区间索引查询可见行、可见时间段内的任务，缩放和平移的开销与任务总数无关。
+class TimelineView : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    explicit TimelineView(QWidget *parent = nullptr);
+
+    void setModel(TaskModel *model);
+    void scrollToTask(int taskId);
+
+signals:
+    void taskActivated(int taskId);   // 双击任务
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    bool viewportEvent(QEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private slots:
+    void scheduleRebuild();
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+private:
+    bool intervalOf(const Task &task, IntervalIndex::Interval *interval) const;
+    void rebuildIndex();
+    void updateScrollBars();
+    void setMsPerPixel(double msPerPixel, int anchorX);
+    void paintHeader(QPainter &painter, qint64 from, qint64 to);
+
+    qint64 timeAt(int x) const;
+    int xOf(qint64 time) const;
+    int laneAt(int y) const;
+    int taskAt(const QPoint &pos) const;
+
+    TaskModel *m_model = nullptr;
+    IntervalIndex m_index;
+    QHash<int, QPair<qint64, qint64>> m_intervalById;   // 已索引的区间，用于判断数据变化是否影响布局
+    bool m_rebuildPending = false;
+
+    qint64 m_origin = 0;          // 水平滚动条为0时视口左边缘对应的时间
+    double m_msPerPixel = 60.0 * 1000;
+    QPoint m_dragStart;
+    QPoint m_dragScroll;
+    bool m_dragging = false;
+};
+
+#endif // TIMELINEVIEW_H
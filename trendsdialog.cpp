@@ -0,0 +1,211 @@
+#include "trendsdialog.h"
+#include <QComboBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPainter>
+#include <QPainterPath>
+#include <QVBoxLayout>
+#include <QDialogButtonBox>
+#include <cmath>
+#include <functional>
+
+namespace {
+// 一个绘图桶（若干天合并）
+struct Bucket {
+    QDate first;
+    int created = 0;
+    int completed = 0;
+    int overdue = -1;
+    qint64 leadTimeTotal = 0;
+    int leadTimeCount = 0;
+
+    double leadHours() const { return leadTimeCount > 0 ? leadTimeTotal / 3600.0 / leadTimeCount : -1; }
+};
+
+typedef std::function<double(const Bucket &)> Series;   // 返回负数表示该桶无数据
+
+const int kMinBucketWidth = 3;   // 每个桶至少占的像素
+const int kPanelMargin = 30;
+}
+
+// 三个上下排列的小图：每桶完成/新建数、逾期数、平均完成用时
+class TrendChart : public QWidget
+{
+public:
+    explicit TrendChart(QWidget *parent = nullptr) : QWidget(parent)
+    {
+        setMinimumSize(600, 420);
+        setBackgroundRole(QPalette::Base);
+        setAutoFillBackground(true);
+    }
+
+    // days 为连续的日期范围内有记录的天，缺失的天按0处理
+    void setData(const QList<DailyStats> &days, const QDate &from, const QDate &to)
+    {
+        m_days = days;
+        m_from = from;
+        m_to = to;
+        update();
+    }
+
+protected:
+    void paintEvent(QPaintEvent *) override
+    {
+        QPainter painter(this);
+        painter.setRenderHint(QPainter::Antialiasing);
+
+        const int dayCount = m_from.isValid() ? int(m_from.daysTo(m_to)) + 1 : 0;
+        if (dayCount <= 0) {
+            painter.drawText(rect(), Qt::AlignCenter, "暂无数据");
+            return;
+        }
+
+        // 天数多于可用像素时合并为桶，绘制开销只与宽度有关
+        const int plotWidth = width() - 2 * kPanelMargin;
+        const int daysPerBucket = qMax(1, int(std::ceil(dayCount * double(kMinBucketWidth) / qMax(1, plotWidth))));
+        const int bucketCount = (dayCount + daysPerBucket - 1) / daysPerBucket;
+        QVector<Bucket> buckets(bucketCount);
+        for (int i = 0; i < bucketCount; ++i) {
+            buckets[i].first = m_from.addDays(qint64(i) * daysPerBucket);
+        }
+        for (const DailyStats &day : m_days) {
+            int index = int(m_from.daysTo(day.day)) / daysPerBucket;
+            if (index < 0 || index >= bucketCount) continue;
+            Bucket &bucket = buckets[index];
+            bucket.created += day.created;
+            bucket.completed += day.completed;
+            if (day.overdue >= 0) bucket.overdue = day.overdue;   // 取桶内最后一次采样
+            bucket.leadTimeTotal += day.leadTimeTotalSecs;
+            bucket.leadTimeCount += day.leadTimeCount;
+        }
+
+        const int panelHeight = (height() - 20) / 3;
+        const QString unit = daysPerBucket == 1 ? "每天" : QString("每%1天").arg(daysPerBucket);
+        drawPanel(painter, 0, panelHeight, buckets, QString("完成（柱）/ 新建（线），%1").arg(unit),
+                  [](const Bucket &b) { return double(b.completed); },
+                  [](const Bucket &b) { return double(b.created); }, QColor(76, 175, 80), QColor(33, 150, 243));
+        drawPanel(painter, panelHeight, panelHeight, buckets, "逾期未完成任务数",
+                  Series(), [](const Bucket &b) { return double(b.overdue); }, QColor(), QColor(229, 57, 53));
+        drawPanel(painter, 2 * panelHeight, panelHeight, buckets, "平均完成用时（小时）",
+                  Series(), [](const Bucket &b) { return b.leadHours(); }, QColor(), QColor(142, 36, 170));
+
+        // 底部日期刻度
+        painter.setPen(palette().color(QPalette::Text));
+        const int y = height() - 4;
+        painter.drawText(kPanelMargin, y, m_from.toString("yyyy-MM-dd"));
+        QString last = m_to.toString("yyyy-MM-dd");
+        painter.drawText(width() - kPanelMargin - painter.fontMetrics().horizontalAdvance(last), y, last);
+    }
+
+private:
+    // bars 为空时只画折线
+    void drawPanel(QPainter &painter, int top, int height, const QVector<Bucket> &buckets, const QString &title,
+                   const Series &bars, const Series &line, const QColor &barColor, const QColor &lineColor)
+    {
+        const QRect area(kPanelMargin, top + 20, width() - 2 * kPanelMargin, height - 30);
+        double maxValue = 1;
+        for (const Bucket &bucket : buckets) {
+            if (bars) maxValue = qMax(maxValue, bars(bucket));
+            maxValue = qMax(maxValue, line(bucket));
+        }
+
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(area.left(), top + 14, QString("%1（最大 %2）").arg(title).arg(maxValue, 0, 'g', 4));
+        painter.setPen(palette().color(QPalette::Mid));
+        painter.drawLine(area.bottomLeft(), area.bottomRight());
+
+        const double step = double(area.width()) / buckets.size();
+        auto yOf = [&](double value) { return area.bottom() - value / maxValue * area.height(); };
+
+        if (bars) {
+            for (int i = 0; i < buckets.size(); ++i) {
+                double value = bars(buckets.at(i));
+                if (value <= 0) continue;
+                QRectF bar(area.left() + i * step, yOf(value), qMax(1.0, step - 1), area.bottom() - yOf(value));
+                painter.fillRect(bar, barColor);
+            }
+        }
+
+        QPainterPath path;
+        bool drawing = false;
+        for (int i = 0; i < buckets.size(); ++i) {
+            double value = line(buckets.at(i));
+            if (value < 0) {
+                drawing = false;
+                continue;
+            }
+            QPointF point(area.left() + (i + 0.5) * step, yOf(value));
+            if (drawing) path.lineTo(point);
+            else path.moveTo(point);
+            drawing = true;
+        }
+        painter.setPen(QPen(lineColor, 1.5));
+        painter.drawPath(path);
+    }
+
+    QList<DailyStats> m_days;
+    QDate m_from;
+    QDate m_to;
+};
+
+TrendsDialog::TrendsDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("任务趋势");
+    resize(800, 560);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    QHBoxLayout *topLayout = new QHBoxLayout;
+    m_rangeCombo = new QComboBox(this);
+    m_rangeCombo->addItem("最近30天", 30);
+    m_rangeCombo->addItem("最近90天", 90);
+    m_rangeCombo->addItem("最近一年", 365);
+    m_rangeCombo->addItem("全部", 0);
+    topLayout->addWidget(new QLabel("范围：", this));
+    topLayout->addWidget(m_rangeCombo);
+    topLayout->addStretch();
+    layout->addLayout(topLayout);
+
+    m_summaryLabel = new QLabel(this);
+    layout->addWidget(m_summaryLabel);
+
+    m_chart = new TrendChart(this);
+    layout->addWidget(m_chart, 1);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    layout->addWidget(buttons);
+
+    connect(m_rangeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &TrendsDialog::reload);
+    reload();
+}
+
+void TrendsDialog::reload()
+{
+    const int days = m_rangeCombo->currentData().toInt();
+    const QDate to = QDate::currentDate();
+    QDate from = days > 0 ? to.addDays(1 - days) : QDate();
+
+    QList<DailyStats> stats = DBManager::instance()->getDailyStats(from, to);
+    if (!from.isValid()) {
+        from = stats.isEmpty() ? to : stats.first().day;
+    }
+
+    int created = 0;
+    int completed = 0;
+    int rescheduled = 0;
+    qint64 leadTotal = 0;
+    int leadCount = 0;
+    for (const DailyStats &day : stats) {
+        created += day.created;
+        completed += day.completed;
+        rescheduled += day.rescheduled;
+        leadTotal += day.leadTimeTotalSecs;
+        leadCount += day.leadTimeCount;
+    }
+    m_summaryLabel->setText(QString("新建 %1 个，完成 %2 个，改期 %3 次，平均完成用时 %4")
+                                .arg(created).arg(completed).arg(rescheduled)
+                                .arg(leadCount > 0 ? QString("%1 小时").arg(leadTotal / 3600.0 / leadCount, 0, 'f', 1)
+                                                   : QString("—")));
+    m_chart->setData(stats, from, to);
+}
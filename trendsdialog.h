@@ -0,0 +1,28 @@
+#ifndef TRENDSDIALOG_H
+#define TRENDSDIALOG_H
+
+#include <QDialog>
+#include <QList>
+#include "dbmanager.h"
+
+class QComboBox;
+class QLabel;
+class TrendChart;
+
+// 任务趋势：只读取 daily_stats 汇总表，跨多年的范围也无需扫描事件日志
+class TrendsDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit TrendsDialog(QWidget *parent = nullptr);
+
+private slots:
+    void reload();
+
+private:
+    QComboBox *m_rangeCombo;
+    QLabel *m_summaryLabel;
+    TrendChart *m_chart;
+};
+
+#endif // TRENDSDIALOG_H
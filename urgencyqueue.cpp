@@ -0,0 +1,245 @@
+#include "urgencyqueue.h"
+#include <QDateTime>
+#include <algorithm>
+#include <queue>
+
+namespace {
+const qint64 kHour = 3600;
+const qint64 kDay = 24 * kHour;
+// 优先级相当于把截止时间提前多少：中=1天，高=3天
+const qint64 kPriorityLead[] = {0, kDay, 3 * kDay};
+// 逾期的任务再提前一周，排在所有未逾期任务的前面（除非后者的截止时间还要更早）
+const qint64 kOverdueBoost = 7 * kDay;
+}
+
+UrgencyQueue::UrgencyQueue(int topCount)
+    : m_topCount(qMax(1, topCount))
+{
+}
+
+qint64 UrgencyQueue::priorityLeadSecs(int priority)
+{
+    return kPriorityLead[qBound(0, priority, 2)];
+}
+
+qint64 UrgencyQueue::effectiveDeadline(qint64 deadline, int priority, bool overdue)
+{
+    return deadline - priorityLeadSecs(priority) - (overdue ? kOverdueBoost : 0);
+}
+
+bool UrgencyQueue::reset(const QList<Task> &tasks, qint64 now)
+{
+    m_items.clear();
+    QVector<IndexedHeap::Entry> urgency;
+    QVector<IndexedHeap::Entry> pending;
+    for (const Task &task : tasks) {
+        if (task.isCompleted || !task.deadline.isValid()) continue;
+        Item item;
+        item.deadline = task.deadline.toSecsSinceEpoch();
+        item.priority = task.priority;
+        item.overdue = item.deadline <= now;
+        item.key = effectiveDeadline(item.deadline, item.priority, item.overdue);
+        m_items.insert(task.id, item);
+        urgency.append({item.key, task.id});
+        if (!item.overdue) pending.append({item.deadline, task.id});
+    }
+    m_urgency.build(urgency);
+    m_pending.build(pending);
+    rebuildTop();
+    return true;
+}
+
+bool UrgencyQueue::update(const Task &task, qint64 now)
+{
+    if (task.isCompleted || !task.deadline.isValid()) {
+        return remove(task.id);
+    }
+
+    Item item;
+    item.deadline = task.deadline.toSecsSinceEpoch();
+    item.priority = task.priority;
+    item.overdue = item.deadline <= now;
+    item.key = effectiveDeadline(item.deadline, item.priority, item.overdue);
+
+    // 标题等不影响排序的修改也要通知前 K 名的显示
+    bool affected = touchesTop(task.id, item.key);
+    m_items.insert(task.id, item);
+    m_urgency.set(task.id, item.key);
+    if (item.overdue) {
+        m_pending.remove(task.id);
+    } else {
+        m_pending.set(task.id, item.deadline);
+    }
+
+    if (affected) rebuildTop();
+    return affected;
+}
+
+bool UrgencyQueue::remove(int taskId)
+{
+    if (!m_items.remove(taskId)) return false;
+    m_urgency.remove(taskId);
+    m_pending.remove(taskId);
+
+    bool affected = m_topIds.contains(taskId);
+    if (affected) rebuildTop();
+    return affected;
+}
+
+bool UrgencyQueue::advanceTo(qint64 now, QList<int> *becameOverdue)
+{
+    bool affected = false;
+    while (!m_pending.isEmpty() && m_pending.top().key <= now) {
+        int taskId = m_pending.top().id;
+        m_pending.remove(taskId);
+
+        Item &item = m_items[taskId];
+        item.overdue = true;
+        item.key = effectiveDeadline(item.deadline, item.priority, true);
+        affected = touchesTop(taskId, item.key) || affected;
+        m_urgency.set(taskId, item.key);
+        if (becameOverdue) becameOverdue->append(taskId);
+    }
+    if (affected) rebuildTop();
+    return affected;
+}
+
+qint64 UrgencyQueue::nextTransition() const
+{
+    return m_pending.isEmpty() ? -1 : m_pending.top().key;
+}
+
+bool UrgencyQueue::isOverdue(int taskId) const
+{
+    auto it = m_items.constFind(taskId);
+    return it != m_items.constEnd() && it->overdue;
+}
+
+double UrgencyQueue::urgencyHours(int taskId, qint64 now) const
+{
+    auto it = m_items.constFind(taskId);
+    if (it == m_items.constEnd()) return 0.0;
+    return double(now - it->key) / kHour;
+}
+
+// 任务原来在前 K 名中、前 K 名未满，或新位置排进前 K 名时，前 K 名需要重取
+bool UrgencyQueue::touchesTop(int taskId, qint64 key) const
+{
+    return m_topIds.contains(taskId) || m_top.size() < m_topCount
+           || IndexedHeap::less({key, taskId}, m_topBound);
+}
+
+void UrgencyQueue::rebuildTop()
+{
+    const QVector<IndexedHeap::Entry> entries = m_urgency.smallest(m_topCount);
+    m_top.clear();
+    m_topIds.clear();
+    for (const IndexedHeap::Entry &entry : entries) {
+        m_top.append(entry.id);
+        m_topIds.insert(entry.id);
+    }
+    m_topBound = entries.isEmpty() ? IndexedHeap::Entry() : entries.last();
+}
+
+void UrgencyQueue::IndexedHeap::build(const QVector<Entry> &entries)
+{
+    m_heap = entries;
+    m_pos.clear();
+    m_pos.reserve(m_heap.size());
+    for (int i = 0; i < m_heap.size(); ++i) {
+        m_pos.insert(m_heap.at(i).id, i);
+    }
+    // 自底向上建堆，O(n)
+    for (int i = m_heap.size() / 2 - 1; i >= 0; --i) {
+        siftDown(i);
+    }
+}
+
+void UrgencyQueue::IndexedHeap::set(int id, qint64 key)
+{
+    auto it = m_pos.constFind(id);
+    if (it == m_pos.constEnd()) {
+        m_heap.append({key, id});
+        m_pos.insert(id, m_heap.size() - 1);
+        siftUp(m_heap.size() - 1);
+        return;
+    }
+
+    int index = it.value();
+    qint64 old = m_heap.at(index).key;
+    m_heap[index].key = key;
+    if (key < old) {
+        siftUp(index);
+    } else if (key > old) {
+        siftDown(index);
+    }
+}
+
+bool UrgencyQueue::IndexedHeap::remove(int id)
+{
+    auto it = m_pos.find(id);
+    if (it == m_pos.end()) return false;
+
+    int index = it.value();
+    m_pos.erase(it);
+    Entry last = m_heap.takeLast();
+    if (index < m_heap.size()) {
+        place(index, last);
+        siftUp(index);
+        siftDown(m_pos.value(last.id));
+    }
+    return true;
+}
+
+// 最小的 k 个，按顺序返回：沿堆向下扩展候选，只访问 O(k) 个节点
+QVector<UrgencyQueue::IndexedHeap::Entry> UrgencyQueue::IndexedHeap::smallest(int k) const
+{
+    QVector<Entry> result;
+    if (m_heap.isEmpty() || k <= 0) return result;
+
+    auto greater = [this](int a, int b) { return less(m_heap.at(b), m_heap.at(a)); };
+    std::priority_queue<int, std::vector<int>, decltype(greater)> candidates(greater);
+    candidates.push(0);
+    while (!candidates.empty() && result.size() < k) {
+        int index = candidates.top();
+        candidates.pop();
+        result.append(m_heap.at(index));
+        for (int child = 2 * index + 1; child <= 2 * index + 2 && child < m_heap.size(); ++child) {
+            candidates.push(child);
+        }
+    }
+    return result;
+}
+
+void UrgencyQueue::IndexedHeap::place(int index, const Entry &entry)
+{
+    m_heap[index] = entry;
+    m_pos[entry.id] = index;
+}
+
+void UrgencyQueue::IndexedHeap::siftUp(int index)
+{
+    Entry entry = m_heap.at(index);
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!less(entry, m_heap.at(parent))) break;
+        place(index, m_heap.at(parent));
+        index = parent;
+    }
+    place(index, entry);
+}
+
+void UrgencyQueue::IndexedHeap::siftDown(int index)
+{
+    Entry entry = m_heap.at(index);
+    const int count = m_heap.size();
+    while (true) {
+        int child = 2 * index + 1;
+        if (child >= count) break;
+        if (child + 1 < count && less(m_heap.at(child + 1), m_heap.at(child))) ++child;
+        if (!less(m_heap.at(child), entry)) break;
+        place(index, m_heap.at(child));
+        index = child;
+    }
+    place(index, entry);
+}
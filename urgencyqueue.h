@@ -0,0 +1,92 @@
+#ifndef URGENCYQUEUE_H
+#define URGENCYQUEUE_H
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QVector>
+#include <QtGlobal>
+#include "task.h"
+
+// 未完成任务的紧急度排序
+// 紧急度以"有效截止时间"表示：截止时间按优先级提前，逾期后再额外提前一段，越早越紧急。
+// 所有任务的紧急度随时间以相同速度增长，任务之间的先后只在某个任务越过截止时间（获得逾期加成）
+// 时改变。因此一个堆按有效截止时间维护全部未完成任务，另一个堆按截止时间记录尚未逾期的任务；
+// 时间推进时只处理刚逾期的那几个，编辑一个任务是 O(log n)，无需全量重算。
+// 前 K 名缓存在 top() 中，只有修改可能影响前 K 名时才重新取，取一次是 O(K log K)。
+class UrgencyQueue
+{
+public:
+    explicit UrgencyQueue(int topCount = 10);
+
+    static qint64 priorityLeadSecs(int priority);
+    static qint64 effectiveDeadline(qint64 deadline, int priority, bool overdue);
+
+    // 以下修改函数返回前 K 名（顺序或其中任务的内容）是否可能变化
+    bool reset(const QList<Task> &tasks, qint64 now);
+    bool update(const Task &task, qint64 now);   // 已完成或没有截止时间的任务会被移除
+    bool remove(int taskId);
+    bool advanceTo(qint64 now, QList<int> *becameOverdue = nullptr);
+    qint64 nextTransition() const;               // 下一个任务逾期的时间，没有时返回 -1
+
+    const QVector<int> &top() const { return m_top; }
+    int topCount() const { return m_topCount; }
+    int size() const { return m_urgency.size(); }
+    bool contains(int taskId) const { return m_items.contains(taskId); }
+    bool isOverdue(int taskId) const;
+    // 当前时间超过有效截止时间的小时数，越大越紧急（可为负）
+    double urgencyHours(int taskId, qint64 now) const;
+
+private:
+    // 支持按ID修改和删除的二叉最小堆，按 (key, id) 排序
+    class IndexedHeap
+    {
+    public:
+        struct Entry {
+            qint64 key = 0;
+            int id = -1;
+        };
+
+        void build(const QVector<Entry> &entries);
+        void set(int id, qint64 key);
+        bool remove(int id);
+        bool contains(int id) const { return m_pos.contains(id); }
+        bool isEmpty() const { return m_heap.isEmpty(); }
+        int size() const { return m_heap.size(); }
+        const Entry &top() const { return m_heap.first(); }
+        QVector<Entry> smallest(int k) const;
+
+        static bool less(const Entry &a, const Entry &b)
+        {
+            return a.key < b.key || (a.key == b.key && a.id < b.id);
+        }
+
+    private:
+        void place(int index, const Entry &entry);
+        void siftUp(int index);
+        void siftDown(int index);
+
+        QVector<Entry> m_heap;
+        QHash<int, int> m_pos;      // 任务ID -> 堆中下标
+    };
+
+    struct Item {
+        qint64 deadline = 0;
+        int priority = 0;
+        bool overdue = false;
+        qint64 key = 0;
+    };
+
+    bool touchesTop(int taskId, qint64 key) const;
+    void rebuildTop();
+
+    int m_topCount;
+    QHash<int, Item> m_items;
+    IndexedHeap m_urgency;          // 全部未完成任务，按有效截止时间
+    IndexedHeap m_pending;          // 尚未逾期的任务，按截止时间
+    QVector<int> m_top;
+    QSet<int> m_topIds;
+    IndexedHeap::Entry m_topBound;  // 第 K 名，前 K 名不足 K 个时无意义
+};
+
+#endif // URGENCYQUEUE_H
@@ -0,0 +1,90 @@
+# 除主窗口外的全部源文件，主程序和 tests/ 下的测试工程共用
+INCLUDEPATH += $$PWD
+
+SOURCES += $$PWD/taskmodel.cpp \
+           $$PWD/reminderthread.cpp \
+           $$PWD/dbmanager.cpp \
+           $$PWD/taskdependencygraph.cpp \
+           $$PWD/tasksync.cpp \
+           $$PWD/dbchangewatcher.cpp \
+           $$PWD/idlemonitor.cpp \
+           $$PWD/archivemanager.cpp \
+           $$PWD/archivemodel.cpp \
+           $$PWD/roaringbitmap.cpp \
+           $$PWD/tagindex.cpp \
+           $$PWD/taskfilterproxymodel.cpp \
+           $$PWD/intervalindex.cpp \
+           $$PWD/timelineview.cpp \
+           $$PWD/taskfilter.cpp \
+           $$PWD/taskexporter.cpp \
+           $$PWD/zipwriter.cpp \
+           $$PWD/exportjob.cpp \
+           $$PWD/syncjob.cpp \
+           $$PWD/backupthread.cpp \
+           $$PWD/backupmanager.cpp \
+           $$PWD/taskwritequeue.cpp \
+           $$PWD/tasksnapshot.cpp \
+           $$PWD/trendsdialog.cpp \
+           $$PWD/schemamigrator.cpp \
+           $$PWD/migrationthread.cpp \
+           $$PWD/maintenancemanager.cpp \
+           $$PWD/urgencyqueue.cpp \
+           $$PWD/nextuppanel.cpp \
+           $$PWD/clock.cpp \
+           $$PWD/simhash.cpp \
+           $$PWD/duplicatescanjob.cpp \
+           $$PWD/duplicatesdialog.cpp \
+           $$PWD/pinyin.cpp \
+           $$PWD/pinyinindex.cpp \
+           $$PWD/metrics.cpp \
+           $$PWD/metricsexporter.cpp \
+           $$PWD/diagnosticsdialog.cpp \
+           $$PWD/slowquerylog.cpp \
+           $$PWD/tasktreemodel.cpp
+
+HEADERS += $$PWD/taskmodel.h \
+           $$PWD/reminderthread.h \
+           $$PWD/dbmanager.h \
+           $$PWD/taskdependencygraph.h \
+           $$PWD/tasksync.h \
+           $$PWD/dbchangewatcher.h \
+           $$PWD/idlemonitor.h \
+           $$PWD/archivemanager.h \
+           $$PWD/archivemodel.h \
+           $$PWD/roaringbitmap.h \
+           $$PWD/tagindex.h \
+           $$PWD/taskfilterproxymodel.h \
+           $$PWD/intervalindex.h \
+           $$PWD/timelineview.h \
+           $$PWD/taskfilter.h \
+           $$PWD/taskexporter.h \
+           $$PWD/zipwriter.h \
+           $$PWD/exportjob.h \
+           $$PWD/syncjob.h \
+           $$PWD/backupthread.h \
+           $$PWD/backupmanager.h \
+           $$PWD/taskwritequeue.h \
+           $$PWD/tasksnapshot.h \
+           $$PWD/trendsdialog.h \
+           $$PWD/schemamigrator.h \
+           $$PWD/migrationthread.h \
+           $$PWD/maintenancemanager.h \
+           $$PWD/urgencyqueue.h \
+           $$PWD/nextuppanel.h \
+           $$PWD/clock.h \
+           $$PWD/simhash.h \
+           $$PWD/duplicatescanjob.h \
+           $$PWD/duplicatesdialog.h \
+           $$PWD/pinyin.h \
+           $$PWD/pinyinindex.h \
+           $$PWD/metrics.h \
+           $$PWD/metricsexporter.h \
+           $$PWD/diagnosticsdialog.h \
+           $$PWD/slowquerylog.h \
+           $$PWD/tasktreemodel.h \
+           $$PWD/task.h
+
+# 在线备份/恢复（sqlite3_backup_*）和慢查询跟踪（sqlite3_trace_v2）要直接调用 SQLite C API，
+# Qt 的 QSQLITE 插件不导出这些符号，只能链接系统的 SQLite。
+# Qt 的驱动应使用同一份库（-system-sqlite）；否则 DBManager 检测到后不使用 C API，备份改用 VACUUM INTO
+LIBS += -lsqlite3
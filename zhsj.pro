@@ -1,21 +1,17 @@
-QT       += core gui widgets sql
+QT       += core gui widgets sql concurrent
 CONFIG += c++17
 TARGET = TaskManager
 TEMPLATE = app
 
 # 源文件
 SOURCES += main.cpp \
-           mainwindow.cpp \
-           taskmodel.cpp \
-           reminderthread.cpp \
-           dbmanager.cpp
+           mainwindow.cpp
 
 # 头文件
-HEADERS  += mainwindow.h \
-            taskmodel.h \
-            reminderthread.h \
-            dbmanager.h \
-            task.h  # 新增task.h
+HEADERS  += mainwindow.h
+
+# 其余源文件
+include(zhsj.pri)
 
 # UI文件
 FORMS    += mainwindow.ui
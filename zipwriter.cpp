@@ -0,0 +1,170 @@
+#include "zipwriter.h"
+#include <QIODevice>
+#include <QtEndian>
+
+namespace {
+const quint32 kLocalHeaderSignature = 0x04034b50;
+const quint32 kCentralHeaderSignature = 0x02014b50;
+const quint32 kEndOfCentralDirSignature = 0x06054b50;
+const quint16 kVersion = 20;
+const quint16 kUtf8NameFlag = 0x0800;
+const qint64 kMaxSize = 0xFFFFFFFFLL;
+
+// 标准CRC-32（多项式 0xEDB88320）
+quint32 crc32Update(quint32 crc, const char *data, qint64 size)
+{
+    static quint32 table[256];
+    static bool initialized = false;
+    if (!initialized) {
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        initialized = true;
+    }
+
+    crc = ~crc;
+    for (qint64 i = 0; i < size; ++i) {
+        crc = table[(crc ^ quint8(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void put16(QByteArray &out, quint16 value)
+{
+    char buffer[2];
+    qToLittleEndian(value, buffer);
+    out.append(buffer, 2);
+}
+
+void put32(QByteArray &out, quint32 value)
+{
+    char buffer[4];
+    qToLittleEndian(value, buffer);
+    out.append(buffer, 4);
+}
+
+// 本地文件头与中央目录共用的字段（版本之后到文件名长度之前）
+void putEntryFields(QByteArray &out, quint32 crc, quint32 size, int nameLength)
+{
+    put16(out, kUtf8NameFlag);
+    put16(out, 0);              // 压缩方式：stored
+    put16(out, 0);              // 修改时间
+    put16(out, (1 << 5) | 1);   // 修改日期：1980-01-01
+    put32(out, crc);
+    put32(out, size);           // 压缩后大小
+    put32(out, size);           // 原始大小
+    put16(out, quint16(nameLength));
+    put16(out, 0);              // 扩展字段长度
+}
+}
+
+ZipWriter::ZipWriter(QIODevice *device)
+    : m_device(device)
+{
+}
+
+bool ZipWriter::fail(const QString &message)
+{
+    if (m_error.isEmpty()) m_error = message;
+    return false;
+}
+
+bool ZipWriter::addFile(const QString &name, const QByteArray &data)
+{
+    return beginEntry(name) && write(data) && endEntry();
+}
+
+bool ZipWriter::beginEntry(const QString &name)
+{
+    if (m_inEntry) return fail("上一个ZIP条目尚未结束");
+    if (m_device->isSequential()) return fail("ZIP输出必须写入可随机访问的文件");
+    if (m_device->pos() > kMaxSize) return fail("文件超过4GB，不支持");
+
+    Entry entry;
+    entry.name = name.toUtf8();
+    entry.offset = quint32(m_device->pos());
+
+    // CRC和长度先写0，结束条目时回填
+    QByteArray header;
+    put32(header, kLocalHeaderSignature);
+    put16(header, kVersion);
+    putEntryFields(header, 0, 0, entry.name.size());
+    header.append(entry.name);
+    if (m_device->write(header) != header.size()) return fail(m_device->errorString());
+
+    m_entries.append(entry);
+    m_inEntry = true;
+    m_crc = 0;
+    m_entrySize = 0;
+    return true;
+}
+
+bool ZipWriter::write(const QByteArray &data)
+{
+    if (!m_inEntry) return fail("没有打开的ZIP条目");
+    m_crc = crc32Update(m_crc, data.constData(), data.size());
+    m_entrySize += data.size();
+    if (m_entrySize > kMaxSize) return fail("单个条目超过4GB，不支持");
+    if (m_device->write(data) != data.size()) return fail(m_device->errorString());
+    return true;
+}
+
+bool ZipWriter::endEntry()
+{
+    if (!m_inEntry) return fail("没有打开的ZIP条目");
+    m_inEntry = false;
+
+    Entry &entry = m_entries.last();
+    entry.crc = m_crc;
+    entry.size = quint32(m_entrySize);
+
+    // 回填本地文件头中的 CRC 与两个长度字段（位于头部第14字节起）
+    QByteArray fields;
+    put32(fields, entry.crc);
+    put32(fields, entry.size);
+    put32(fields, entry.size);
+    qint64 end = m_device->pos();
+    if (!m_device->seek(entry.offset + 14) || m_device->write(fields) != fields.size()
+        || !m_device->seek(end)) {
+        return fail(m_device->errorString());
+    }
+    return true;
+}
+
+bool ZipWriter::close()
+{
+    if (m_inEntry && !endEntry()) return false;
+    if (m_device->pos() > kMaxSize) return fail("文件超过4GB，不支持");
+
+    quint32 directoryOffset = quint32(m_device->pos());
+    QByteArray directory;
+    for (const Entry &entry : m_entries) {
+        put32(directory, kCentralHeaderSignature);
+        put16(directory, kVersion);   // 创建版本
+        put16(directory, kVersion);   // 解压所需版本
+        putEntryFields(directory, entry.crc, entry.size, entry.name.size());
+        put16(directory, 0);          // 注释长度
+        put16(directory, 0);          // 磁盘号
+        put16(directory, 0);          // 内部属性
+        put32(directory, 0);          // 外部属性
+        put32(directory, entry.offset);
+        directory.append(entry.name);
+    }
+
+    quint32 directorySize = quint32(directory.size());
+    put32(directory, kEndOfCentralDirSignature);
+    put16(directory, 0);
+    put16(directory, 0);
+    put16(directory, quint16(m_entries.size()));
+    put16(directory, quint16(m_entries.size()));
+    put32(directory, directorySize);
+    put32(directory, directoryOffset);
+    put16(directory, 0);
+
+    if (m_device->write(directory) != directory.size()) return fail(m_device->errorString());
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef ZIPWRITER_H
+#define ZIPWRITER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+class QIODevice;
+
+// 最简单的ZIP写入器：只支持不压缩（stored）的条目，足够生成 .xlsx 容器。
+// 条目内容可以分多次流式写入；结束条目时回填本地文件头中的CRC和长度，因此输出设备必须可随机访问。
+// 不支持ZIP64，单个条目和整个文件都不能超过4GB。
+class ZipWriter
+{
+public:
+    explicit ZipWriter(QIODevice *device);
+
+    bool addFile(const QString &name, const QByteArray &data);
+
+    bool beginEntry(const QString &name);
+    bool write(const QByteArray &data);
+    bool endEntry();
+
+    bool close();   // 写中央目录
+    QString errorString() const { return m_error; }
+
+private:
+    struct Entry {
+        QByteArray name;
+        quint32 crc = 0;
+        quint32 size = 0;
+        quint32 offset = 0;
+    };
+
+    bool fail(const QString &message);
+
+    QIODevice *m_device;
+    QList<Entry> m_entries;
+    bool m_inEntry = false;
+    quint32 m_crc = 0;
+    qint64 m_entrySize = 0;
+    QString m_error;
+};
+
+#endif // ZIPWRITER_H